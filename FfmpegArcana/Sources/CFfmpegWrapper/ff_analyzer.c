@@ -0,0 +1,361 @@
+/**
+ * ff_analyzer.c
+ *
+ * Packet-walk stream analysis. Frame types come from av_parser_parse2 in
+ * complete-frames mode, which inspects slice/picture headers only; no
+ * decoder is ever opened.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_analyzer.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANALYZER_MAX_WINDOWS    (1 << 22)   // Guards against wild timestamps
+
+// -----------------------------------------------------------------------------
+// Internal structures
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    FFStreamStats stats;
+    AVRational time_base;
+
+    AVCodecParserContext *parser;
+    AVCodecContext *parser_ctx;
+
+    int64_t first_ts;           // First known timestamp (dts, else pts)
+    int64_t last_ts;            // Latest timestamp plus duration
+    int64_t last_dts;
+    int64_t last_dts_delta;
+    int64_t last_key_ts;
+    int gop_packets;            // Packets in the running GOP
+    int b_run;
+    double keyframe_interval_sum;
+    int64_t keyframe_intervals;
+
+    int *gops;                  // Completed GOP lengths
+    size_t gop_capacity;
+    int64_t *windows;           // Bytes per bit rate window
+    size_t window_count;
+    size_t window_capacity;
+} AnalyzerStream;
+
+struct FFStreamAnalyzer {
+    AnalyzerStream *streams;
+    int stream_count;
+    double window;              // Seconds
+    uint32_t flags;
+};
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static int grow(void **array, size_t *capacity, size_t needed, size_t element_size) {
+    if (needed <= *capacity) return 0;
+    size_t capacity_new = FFMAX(*capacity * 2, FFMAX(needed, 64));
+    void *grown = realloc(*array, capacity_new * element_size);
+    if (!grown) return AVERROR(ENOMEM);
+    memset((uint8_t *)grown + *capacity * element_size, 0, (capacity_new - *capacity) * element_size);
+    *array = grown;
+    *capacity = capacity_new;
+    return 0;
+}
+
+static double stream_seconds(AnalyzerStream *st, int64_t ts) {
+    return ts * av_q2d(st->time_base);
+}
+
+static void stream_open_parser(AnalyzerStream *st, const AVCodecParameters *par) {
+    if (par->codec_type != AVMEDIA_TYPE_VIDEO) return;
+
+    st->parser = av_parser_init(par->codec_id);
+    if (!st->parser) return;
+
+    // Parsers read extradata (avcC/hvcC) through a codec context; it is never opened
+    st->parser_ctx = avcodec_alloc_context3(NULL);
+    if (!st->parser_ctx || avcodec_parameters_to_context(st->parser_ctx, par) < 0) {
+        av_parser_close(st->parser);
+        st->parser = NULL;
+        avcodec_free_context(&st->parser_ctx);
+        return;
+    }
+    st->parser->flags |= PARSER_FLAG_COMPLETE_FRAMES;
+}
+
+static void stream_free(AnalyzerStream *st) {
+    if (st->parser) av_parser_close(st->parser);
+    avcodec_free_context(&st->parser_ctx);
+    free(st->gops);
+    free(st->windows);
+}
+
+// -----------------------------------------------------------------------------
+// Per-packet accounting
+// -----------------------------------------------------------------------------
+
+static int stream_frame_type(FFStreamAnalyzer *analyzer, AnalyzerStream *st, const AVPacket *pkt,
+                             bool key) {
+    int pict_type = AV_PICTURE_TYPE_NONE;
+
+    if (st->parser && pkt->size > 0) {
+        uint8_t *out = NULL;
+        int out_size = 0;
+        av_parser_parse2(st->parser, st->parser_ctx, &out, &out_size,
+                         pkt->data, pkt->size, pkt->pts, pkt->dts, pkt->pos);
+        pict_type = st->parser->pict_type;
+    }
+
+    // Without a usable parser, a keyframe is still known to be intra
+    if (pict_type == AV_PICTURE_TYPE_NONE && key && !(analyzer->flags & FF_ANALYZER_NO_PARSE))
+        pict_type = AV_PICTURE_TYPE_I;
+    return pict_type;
+}
+
+static void stream_count_frame(AnalyzerStream *st, int pict_type) {
+    FFStreamStats *s = &st->stats;
+
+    switch (pict_type) {
+    case AV_PICTURE_TYPE_I: s->i_frames++; break;
+    case AV_PICTURE_TYPE_P: s->p_frames++; break;
+    case AV_PICTURE_TYPE_B: s->b_frames++; break;
+    case AV_PICTURE_TYPE_NONE: s->unknown_frames++; break;
+    default: s->other_frames++; break;
+    }
+
+    st->b_run = (pict_type == AV_PICTURE_TYPE_B) ? st->b_run + 1 : 0;
+    s->max_b_run = FFMAX(s->max_b_run, st->b_run);
+}
+
+static int stream_close_gop(AnalyzerStream *st) {
+    FFStreamStats *s = &st->stats;
+    int ret = grow((void **)&st->gops, &st->gop_capacity, (size_t)s->gop_count + 1, sizeof(int));
+    if (ret < 0) return ret;
+    st->gops[s->gop_count++] = st->gop_packets;
+    st->gop_packets = 0;
+    return 0;
+}
+
+static void stream_check_timestamps(AnalyzerStream *st, const AVPacket *pkt) {
+    FFStreamStats *s = &st->stats;
+
+    if (pkt->pts == AV_NOPTS_VALUE) s->missing_pts++;
+    if (pkt->dts == AV_NOPTS_VALUE) {
+        s->missing_dts++;
+        return;
+    }
+    if (pkt->pts != AV_NOPTS_VALUE && pkt->pts < pkt->dts) s->pts_before_dts++;
+
+    if (st->last_dts != AV_NOPTS_VALUE) {
+        int64_t delta = pkt->dts - st->last_dts;
+        int64_t expected = pkt->duration > 0 ? pkt->duration : st->last_dts_delta;
+
+        if (delta <= 0) s->dts_not_increasing++;
+        else if (expected > 0 && delta > 2 * expected) s->timestamp_gaps++;
+        if (delta > 0) st->last_dts_delta = delta;
+    }
+    st->last_dts = pkt->dts;
+}
+
+static int stream_count_bytes(FFStreamAnalyzer *analyzer, AnalyzerStream *st, int64_t ts, int size) {
+    if (ts == AV_NOPTS_VALUE) return 0;
+    if (st->first_ts == AV_NOPTS_VALUE) st->first_ts = ts;
+
+    double offset = stream_seconds(st, ts - st->first_ts) / analyzer->window;
+    if (offset < 0 || offset >= ANALYZER_MAX_WINDOWS) return 0;
+
+    size_t index = (size_t)offset;
+    int ret = grow((void **)&st->windows, &st->window_capacity, index + 1, sizeof(int64_t));
+    if (ret < 0) return ret;
+    st->windows[index] += size;
+    st->window_count = FFMAX(st->window_count, index + 1);
+    return 0;
+}
+
+int ff_analyzer_add_packet(FFStreamAnalyzer *analyzer, const AVPacket *pkt) {
+    if (!analyzer || !pkt) return AVERROR(EINVAL);
+    if (pkt->stream_index < 0 || pkt->stream_index >= analyzer->stream_count) return 0;
+
+    AnalyzerStream *st = &analyzer->streams[pkt->stream_index];
+    FFStreamStats *s = &st->stats;
+
+    s->packets++;
+    s->bytes += pkt->size;
+    if (pkt->flags & AV_PKT_FLAG_CORRUPT) s->corrupt_packets++;
+    stream_check_timestamps(st, pkt);
+
+    int64_t ts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    int ret = stream_count_bytes(analyzer, st, ts, pkt->size);
+    if (ret < 0) return ret;
+    if (ts != AV_NOPTS_VALUE)
+        st->last_ts = FFMAX(st->last_ts, ts + FFMAX(pkt->duration, 0));
+
+    if (s->media_type != AVMEDIA_TYPE_VIDEO) return 0;
+
+    bool key = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+    int pict_type = stream_frame_type(analyzer, st, pkt, key);
+    stream_count_frame(st, pict_type);
+
+    if (key) {
+        if (s->keyframes > 0) {
+            ret = stream_close_gop(st);
+            if (ret < 0) return ret;
+        }
+        s->keyframes++;
+
+        int64_t key_ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+        if (key_ts != AV_NOPTS_VALUE) {
+            if (st->last_key_ts != AV_NOPTS_VALUE && key_ts > st->last_key_ts) {
+                double interval = stream_seconds(st, key_ts - st->last_key_ts);
+                s->min_keyframe_interval = st->keyframe_intervals
+                    ? FFMIN(s->min_keyframe_interval, interval) : interval;
+                s->max_keyframe_interval = FFMAX(s->max_keyframe_interval, interval);
+                st->keyframe_interval_sum += interval;
+                st->keyframe_intervals++;
+            }
+            st->last_key_ts = key_ts;
+        }
+    }
+    // Packets before the first keyframe belong to no GOP
+    if (s->keyframes > 0) st->gop_packets++;
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+FFStreamAnalyzer* ff_analyzer_create(FFDemuxContext *demux_ctx, double window_seconds,
+                                     uint32_t flags) {
+    if (!demux_ctx || !demux_ctx->fmt_ctx) return NULL;
+    AVFormatContext *fmt_ctx = demux_ctx->fmt_ctx;
+
+    FFStreamAnalyzer *analyzer = calloc(1, sizeof(FFStreamAnalyzer));
+    if (!analyzer) return NULL;
+
+    analyzer->window = window_seconds > 0 ? window_seconds : FF_ANALYZER_DEFAULT_WINDOW;
+    analyzer->flags = flags;
+    analyzer->stream_count = (int)fmt_ctx->nb_streams;
+    analyzer->streams = calloc(FFMAX(fmt_ctx->nb_streams, 1), sizeof(AnalyzerStream));
+    if (!analyzer->streams) {
+        free(analyzer);
+        return NULL;
+    }
+
+    for (int i = 0; i < analyzer->stream_count; i++) {
+        AVStream *stream = fmt_ctx->streams[i];
+        AnalyzerStream *st = &analyzer->streams[i];
+
+        st->stats.stream_index = i;
+        st->stats.media_type = stream->codecpar->codec_type;
+        st->stats.codec_id = stream->codecpar->codec_id;
+        st->time_base = stream->time_base;
+        st->first_ts = st->last_ts = AV_NOPTS_VALUE;
+        st->last_dts = st->last_key_ts = AV_NOPTS_VALUE;
+
+        if (!(flags & FF_ANALYZER_NO_PARSE))
+            stream_open_parser(st, stream->codecpar);
+    }
+    return analyzer;
+}
+
+void ff_analyzer_destroy(FFStreamAnalyzer *analyzer) {
+    if (!analyzer) return;
+    for (int i = 0; i < analyzer->stream_count; i++)
+        stream_free(&analyzer->streams[i]);
+    free(analyzer->streams);
+    free(analyzer);
+}
+
+int ff_analyzer_run(FFStreamAnalyzer *analyzer, FFDemuxContext *demux_ctx) {
+    if (!analyzer || !demux_ctx) return AVERROR(EINVAL);
+
+    AVPacket *pkt = av_packet_alloc();
+    if (!pkt) return AVERROR(ENOMEM);
+
+    int ret;
+    while ((ret = ff_demux_read_packet(demux_ctx, pkt)) >= 0) {
+        ret = ff_analyzer_add_packet(analyzer, pkt);
+        av_packet_unref(pkt);
+        if (ret < 0) break;
+    }
+
+    av_packet_free(&pkt);
+    return ret == AVERROR_EOF ? 0 : ret;
+}
+
+// -----------------------------------------------------------------------------
+// Results
+// -----------------------------------------------------------------------------
+
+static AnalyzerStream* analyzer_stream(FFStreamAnalyzer *analyzer, int stream_index) {
+    if (!analyzer || stream_index < 0 || stream_index >= analyzer->stream_count) return NULL;
+    return &analyzer->streams[stream_index];
+}
+
+int ff_analyzer_stream_count(FFStreamAnalyzer *analyzer) {
+    return analyzer ? analyzer->stream_count : 0;
+}
+
+int ff_analyzer_get_stats(FFStreamAnalyzer *analyzer, int stream_index, FFStreamStats *stats) {
+    AnalyzerStream *st = analyzer_stream(analyzer, stream_index);
+    if (!st || !stats) return AVERROR(EINVAL);
+
+    *stats = st->stats;
+
+    if (st->first_ts != AV_NOPTS_VALUE && st->last_ts > st->first_ts)
+        stats->duration = stream_seconds(st, st->last_ts - st->first_ts);
+    if (stats->duration > 0)
+        stats->avg_bit_rate = stats->bytes * 8.0 / stats->duration;
+    for (size_t i = 0; i < st->window_count; i++)
+        stats->peak_bit_rate = FFMAX(stats->peak_bit_rate, st->windows[i] * 8.0 / analyzer->window);
+
+    // Completed GOPs plus the one still running
+    int64_t gop_total = 0;
+    stats->min_gop_length = INT_MAX;
+    for (int64_t i = 0; i < st->stats.gop_count; i++) {
+        stats->min_gop_length = FFMIN(stats->min_gop_length, st->gops[i]);
+        stats->max_gop_length = FFMAX(stats->max_gop_length, st->gops[i]);
+        gop_total += st->gops[i];
+    }
+    if (st->gop_packets > 0) {
+        stats->gop_count++;
+        stats->min_gop_length = FFMIN(stats->min_gop_length, st->gop_packets);
+        stats->max_gop_length = FFMAX(stats->max_gop_length, st->gop_packets);
+        gop_total += st->gop_packets;
+    }
+    if (stats->gop_count > 0) {
+        stats->avg_gop_length = (double)gop_total / stats->gop_count;
+    } else {
+        stats->min_gop_length = 0;
+    }
+
+    if (st->keyframe_intervals > 0)
+        stats->avg_keyframe_interval = st->keyframe_interval_sum / st->keyframe_intervals;
+    return 0;
+}
+
+int ff_analyzer_get_bitrate(FFStreamAnalyzer *analyzer, int stream_index,
+                            double *bit_rates, int max_count) {
+    AnalyzerStream *st = analyzer_stream(analyzer, stream_index);
+    if (!st) return AVERROR(EINVAL);
+
+    int count = (int)st->window_count;
+    for (int i = 0; bit_rates && i < FFMIN(count, max_count); i++)
+        bit_rates[i] = st->windows[i] * 8.0 / analyzer->window;
+    return count;
+}
+
+int ff_analyzer_get_gop_lengths(FFStreamAnalyzer *analyzer, int stream_index,
+                                int *lengths, int max_count) {
+    AnalyzerStream *st = analyzer_stream(analyzer, stream_index);
+    if (!st) return AVERROR(EINVAL);
+
+    int completed = (int)st->stats.gop_count;
+    int count = completed + (st->gop_packets > 0 ? 1 : 0);
+    for (int i = 0; lengths && i < FFMIN(count, max_count); i++)
+        lengths[i] = i < completed ? st->gops[i] : st->gop_packets;
+    return count;
+}
@@ -0,0 +1,197 @@
+/**
+ * ff_arena.c
+ *
+ * Block-based bump allocator with deferred cleanups.
+ */
+
+#include "include/ff_arena.h"
+#include "include/ff_numa.h"
+#include <libavutil/avutil.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define ARENA_ALIGN     ((size_t)alignof(max_align_t))
+
+// -----------------------------------------------------------------------------
+// Internal structures
+// -----------------------------------------------------------------------------
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;            // Usable bytes after the header
+    size_t used;
+} ArenaBlock;
+
+#define ARENA_HEADER_SIZE   FFALIGN(sizeof(ArenaBlock), ARENA_ALIGN)
+
+typedef struct ArenaCleanup {
+    struct ArenaCleanup *next;
+    FFArenaCleanupFunc fn;
+    void *opaque;
+} ArenaCleanup;
+
+struct FFArena {
+    pthread_mutex_t mutex;
+    size_t block_size;
+    int numa_node;
+    ArenaBlock *blocks;     // Current block first
+    ArenaCleanup *cleanups; // Most recent first
+    ArenaCleanup *finals;   // Run after every cleanup, most recent first
+    size_t bytes_used;
+    size_t bytes_reserved;
+};
+
+// -----------------------------------------------------------------------------
+// Blocks
+// -----------------------------------------------------------------------------
+
+static ArenaBlock *arena_block_alloc(FFArena *arena, size_t size) {
+    size_t total = ARENA_HEADER_SIZE + size;
+    ArenaBlock *block;
+
+    if (arena->numa_node == FF_NUMA_NODE_ANY)
+        block = calloc(1, total);
+    else
+        block = ff_numa_alloc(total, arena->numa_node);
+    if (!block) return NULL;
+
+    block->size = size;
+    arena->bytes_reserved += size;
+    return block;
+}
+
+static void arena_block_free(FFArena *arena, ArenaBlock *block) {
+    if (arena->numa_node == FF_NUMA_NODE_ANY)
+        free(block);
+    else
+        ff_numa_free(block, ARENA_HEADER_SIZE + block->size);
+}
+
+// Caller holds arena->mutex
+static void *arena_alloc_locked(FFArena *arena, size_t size) {
+    size = FFALIGN(FFMAX(size, 1), ARENA_ALIGN);
+
+    ArenaBlock *block = arena->blocks;
+    if (!block || block->size - block->used < size) {
+        if (size > arena->block_size / 4) {
+            // Large request: give it its own block behind the current one so
+            // the current block's remaining space is not wasted
+            ArenaBlock *big = arena_block_alloc(arena, size);
+            if (!big) return NULL;
+            big->used = size;
+            if (block) {
+                big->next = block->next;
+                block->next = big;
+            } else {
+                arena->blocks = big;
+            }
+            arena->bytes_used += size;
+            return (uint8_t *)big + ARENA_HEADER_SIZE;
+        }
+
+        block = arena_block_alloc(arena, arena->block_size);
+        if (!block) return NULL;
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+
+    void *p = (uint8_t *)block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+    arena->bytes_used += size;
+    return p;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+FFArena* ff_arena_create(size_t block_size) {
+    return ff_arena_create_on_node(block_size, FF_NUMA_NODE_ANY);
+}
+
+FFArena* ff_arena_create_on_node(size_t block_size, int numa_node) {
+    FFArena *arena = calloc(1, sizeof(FFArena));
+    if (!arena) return NULL;
+
+    if (pthread_mutex_init(&arena->mutex, NULL) != 0) {
+        free(arena);
+        return NULL;
+    }
+
+    arena->block_size = FFALIGN(block_size ? block_size : FF_ARENA_DEFAULT_BLOCK_SIZE, ARENA_ALIGN);
+    arena->numa_node = numa_node;
+    return arena;
+}
+
+void ff_arena_destroy(FFArena* arena) {
+    if (!arena) return;
+
+    // Cleanups may still touch arena memory, so run them all before freeing
+    for (ArenaCleanup *cleanup = arena->cleanups; cleanup; cleanup = cleanup->next)
+        cleanup->fn(cleanup->opaque);
+    for (ArenaCleanup *cleanup = arena->finals; cleanup; cleanup = cleanup->next)
+        cleanup->fn(cleanup->opaque);
+
+    ArenaBlock *block = arena->blocks;
+    while (block) {
+        ArenaBlock *next = block->next;
+        arena_block_free(arena, block);
+        block = next;
+    }
+
+    pthread_mutex_destroy(&arena->mutex);
+    free(arena);
+}
+
+void* ff_arena_alloc(FFArena* arena, size_t size) {
+    if (!arena) return NULL;
+
+    pthread_mutex_lock(&arena->mutex);
+    void *p = arena_alloc_locked(arena, size);
+    pthread_mutex_unlock(&arena->mutex);
+    return p;
+}
+
+static int arena_defer(FFArena *arena, ArenaCleanup **list, FFArenaCleanupFunc fn, void *opaque) {
+    if (!arena || !fn) return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&arena->mutex);
+    ArenaCleanup *cleanup = arena_alloc_locked(arena, sizeof(ArenaCleanup));
+    if (cleanup) {
+        cleanup->fn = fn;
+        cleanup->opaque = opaque;
+        cleanup->next = *list;
+        *list = cleanup;
+    }
+    pthread_mutex_unlock(&arena->mutex);
+
+    return cleanup ? 0 : AVERROR(ENOMEM);
+}
+
+int ff_arena_defer(FFArena* arena, FFArenaCleanupFunc fn, void* opaque) {
+    return arena ? arena_defer(arena, &arena->cleanups, fn, opaque) : AVERROR(EINVAL);
+}
+
+int ff_arena_defer_final(FFArena* arena, FFArenaCleanupFunc fn, void* opaque) {
+    return arena ? arena_defer(arena, &arena->finals, fn, opaque) : AVERROR(EINVAL);
+}
+
+size_t ff_arena_bytes_used(FFArena* arena) {
+    if (!arena) return 0;
+    pthread_mutex_lock(&arena->mutex);
+    size_t used = arena->bytes_used;
+    pthread_mutex_unlock(&arena->mutex);
+    return used;
+}
+
+size_t ff_arena_bytes_reserved(FFArena* arena) {
+    if (!arena) return 0;
+    pthread_mutex_lock(&arena->mutex);
+    size_t reserved = arena->bytes_reserved;
+    pthread_mutex_unlock(&arena->mutex);
+    return reserved;
+}
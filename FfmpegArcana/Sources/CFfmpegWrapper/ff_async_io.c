@@ -0,0 +1,785 @@
+/**
+ * ff_async_io.c
+ *
+ * Block-windowed asynchronous file I/O. The io_uring rings are driven
+ * through the raw system calls, so there is no liburing dependency.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE     // O_DIRECT
+#endif
+
+#include "ff_internal.h"
+#include "include/ff_async_io.h"
+#include "include/ff_numa.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        #include <sys/syscall.h>
+        #define ASYNC_IO_HAVE_URING 1
+    #endif
+#endif
+
+#define ASYNC_IO_MAX_DEPTH      64
+#define ASYNC_IO_AVIO_BUFFER    (256 * 1024)
+#define ASYNC_IO_DIRECT_ALIGN   4096        // Covers the logical block size of common devices
+#define ASYNC_IO_DIRECT_DEPTH   2           // Double buffering: one block consumed, one landing
+
+// -----------------------------------------------------------------------------
+// Internal structures
+// -----------------------------------------------------------------------------
+
+typedef enum {
+    SLOT_IDLE = 0,
+    SLOT_INFLIGHT,          // Owned by the kernel
+    SLOT_QUEUED,            // Reads, pread backend: runs when the data is needed
+    SLOT_COMPLETE,          // Result available, not yet checked
+    SLOT_FILLED             // Reads: data checked and usable
+} AsyncSlotState;
+
+typedef struct AsyncSlot {
+    uint8_t *data;
+    int64_t offset;         // File offset of data[0]
+    int32_t length;         // Reads: valid bytes; writes: bytes gathered
+    int32_t result;         // Completion result (bytes or -errno)
+    AsyncSlotState state;
+    bool direct;            // Reads: submitted while bypassing the page cache
+    struct iovec iov;       // For unregistered io_uring requests
+} AsyncSlot;
+
+#if defined(ASYNC_IO_HAVE_URING)
+typedef struct AsyncRing {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_size, cq_size, sqes_size;
+    unsigned pending;       // Queued but not yet submitted
+    unsigned inflight;      // Submitted or queued, not yet completed
+} AsyncRing;
+#endif
+
+struct FFAsyncIO {
+    int fd;                 // Buffered descriptor, always open
+    int direct_fd;          // O_DIRECT descriptor for block requests, -1 if none
+    bool direct;            // Block requests bypass the page cache
+    bool writing;
+    uint32_t flags;
+    FFAsyncIOBackend backend;
+
+    size_t block_size;
+    uint32_t depth;
+    uint8_t *buffers;       // One page-aligned region split into slots
+    size_t buffers_size;
+    AsyncSlot slots[ASYNC_IO_MAX_DEPTH];
+
+    int64_t pos;            // Logical AVIO position
+    int64_t file_size;      // Reads: size at open; writes: furthest byte written
+    int64_t window;         // Reads: first block of the in-flight window
+    uint32_t current;       // Writes: slot being gathered into
+    int error;              // Writes: first error (sticky)
+
+    AVIOContext *avio;
+
+#if defined(ASYNC_IO_HAVE_URING)
+    AsyncRing ring;
+#endif
+};
+
+// Descriptor block requests go to; unaligned fix-ups always use aio->fd
+static int async_fd(FFAsyncIO *aio) {
+    return (aio->direct && aio->direct_fd >= 0) ? aio->direct_fd : aio->fd;
+}
+
+// -----------------------------------------------------------------------------
+// io_uring
+// -----------------------------------------------------------------------------
+
+#if defined(ASYNC_IO_HAVE_URING)
+
+static int ring_enter(AsyncRing *ring, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    for (;;) {
+        long ret = syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, NULL, 0);
+        if (ret >= 0) return (int)ret;
+        if (errno != EINTR) return AVERROR(errno);
+    }
+}
+
+static void ring_unmap(AsyncRing *ring) {
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr) munmap(ring->cq_ptr, ring->cq_size);
+    if (ring->sq_ptr) munmap(ring->sq_ptr, ring->sq_size);
+    if (ring->fd >= 0) close(ring->fd);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+static int ring_init(FFAsyncIO *aio) {
+    AsyncRing *ring = &aio->ring;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, aio->depth, &params);
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        return AVERROR(errno);
+    }
+
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->sq_size = ring->cq_size = FFMAX(ring->sq_size, ring->cq_size);
+
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        ring->sq_ptr = NULL;
+        ring_unmap(ring);
+        return AVERROR(ENOMEM);
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            ring->cq_ptr = NULL;
+            ring_unmap(ring);
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        ring_unmap(ring);
+        return AVERROR(ENOMEM);
+    }
+
+    uint8_t *sq = ring->sq_ptr;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+
+    uint8_t *cq = ring->cq_ptr;
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    // Registered buffers save the per-request page pinning; they count
+    // against RLIMIT_MEMLOCK, so failing here only loses that optimisation
+    struct iovec iovs[ASYNC_IO_MAX_DEPTH];
+    for (uint32_t i = 0; i < aio->depth; i++) {
+        iovs[i].iov_base = aio->slots[i].data;
+        iovs[i].iov_len = aio->block_size;
+    }
+    aio->backend = (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, iovs, aio->depth) == 0)
+        ? FF_ASYNC_IO_BACKEND_URING_FIXED
+        : FF_ASYNC_IO_BACKEND_URING;
+    return 0;
+}
+
+static void ring_queue(FFAsyncIO *aio, uint32_t index, uint32_t length) {
+    AsyncRing *ring = &aio->ring;
+    AsyncSlot *slot = &aio->slots[index];
+
+    unsigned tail = *ring->sq_tail;
+    unsigned sq_index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[sq_index];
+    memset(sqe, 0, sizeof(*sqe));
+
+    sqe->fd = async_fd(aio);
+    sqe->off = (uint64_t)slot->offset;
+    sqe->user_data = index;
+
+    if (aio->backend == FF_ASYNC_IO_BACKEND_URING_FIXED) {
+        sqe->opcode = aio->writing ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->addr = (uint64_t)(uintptr_t)slot->data;
+        sqe->len = length;
+        sqe->buf_index = (uint16_t)index;
+    } else {
+        slot->iov.iov_base = slot->data;
+        slot->iov.iov_len = length;
+        sqe->opcode = aio->writing ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->addr = (uint64_t)(uintptr_t)&slot->iov;
+        sqe->len = 1;
+    }
+
+    ring->sq_array[sq_index] = sq_index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->pending++;
+    ring->inflight++;
+}
+
+static int ring_submit(AsyncRing *ring) {
+    while (ring->pending) {
+        int ret = ring_enter(ring, ring->pending, 0, 0);
+        if (ret < 0) return ret;
+        ring->pending -= FFMIN((unsigned)ret, ring->pending);
+    }
+    return 0;
+}
+
+// Collect completions; with wait set, block until at least one arrives
+static int ring_reap(FFAsyncIO *aio, bool wait) {
+    AsyncRing *ring = &aio->ring;
+
+    int ret = ring_submit(ring);
+    if (ret < 0) return ret;
+
+    unsigned head = *ring->cq_head;
+    if (wait && head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        ret = ring_enter(ring, 0, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0) return ret;
+    }
+
+    while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        if (cqe->user_data < aio->depth) {
+            AsyncSlot *slot = &aio->slots[cqe->user_data];
+            slot->result = cqe->res;
+            slot->state = SLOT_COMPLETE;
+        }
+        ring->inflight--;
+        head++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return 0;
+}
+
+#endif // ASYNC_IO_HAVE_URING
+
+// -----------------------------------------------------------------------------
+// Request dispatch
+// -----------------------------------------------------------------------------
+
+static bool async_uring(FFAsyncIO *aio) {
+    return aio->backend != FF_ASYNC_IO_BACKEND_PREAD;
+}
+
+// Start a transfer of length bytes between a slot and its file offset
+static void async_start(FFAsyncIO *aio, uint32_t index, uint32_t length) {
+    AsyncSlot *slot = &aio->slots[index];
+    slot->direct = !aio->writing && aio->direct;
+
+#if defined(ASYNC_IO_HAVE_URING)
+    if (async_uring(aio)) {
+        slot->state = SLOT_INFLIGHT;
+        ring_queue(aio, index, length);
+        return;
+    }
+#endif
+
+    // A synchronous read has nothing to overlap with: leave it until the
+    // block is needed, so a seek does not pay for a window it skips
+    if (!aio->writing) {
+        slot->state = SLOT_QUEUED;
+        return;
+    }
+
+    ssize_t ret = pwrite(aio->fd, slot->data, length, slot->offset);
+    slot->result = ret < 0 ? -errno : (int32_t)ret;
+    slot->state = SLOT_COMPLETE;
+}
+
+// Run a queued read (pread backend) with the descriptor in use now
+static void async_run_queued(FFAsyncIO *aio, AsyncSlot *slot) {
+    ssize_t ret;
+    slot->direct = aio->direct;
+    do {
+        ret = pread(async_fd(aio), slot->data, aio->block_size, slot->offset);
+    } while (ret < 0 && errno == EINTR);
+    slot->result = ret < 0 ? -errno : (int32_t)ret;
+    slot->state = SLOT_COMPLETE;
+}
+
+static int async_flush_queue(FFAsyncIO *aio) {
+#if defined(ASYNC_IO_HAVE_URING)
+    if (async_uring(aio)) return ring_submit(&aio->ring);
+#endif
+    (void)aio;
+    return 0;
+}
+
+static int async_wait_slot(FFAsyncIO *aio, AsyncSlot *slot) {
+#if defined(ASYNC_IO_HAVE_URING)
+    while (slot->state == SLOT_INFLIGHT) {
+        int ret = ring_reap(aio, true);
+        if (ret < 0) return ret;
+    }
+#endif
+    (void)aio; (void)slot;
+    return 0;
+}
+
+static int async_drain(FFAsyncIO *aio) {
+#if defined(ASYNC_IO_HAVE_URING)
+    while (async_uring(aio) && aio->ring.inflight) {
+        int ret = ring_reap(aio, true);
+        if (ret < 0) return ret;
+    }
+#endif
+    (void)aio;
+    return 0;
+}
+
+// Finish a completed write: retry short writes synchronously
+static int async_complete_write(FFAsyncIO *aio, AsyncSlot *slot) {
+    if (slot->state != SLOT_COMPLETE) return 0;
+    slot->state = SLOT_IDLE;
+
+    int32_t done = slot->result;
+    if (done < 0) return AVERROR(-done);
+
+    while (done < slot->length) {
+        ssize_t ret = pwrite(aio->fd, slot->data + done, slot->length - done, slot->offset + done);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return AVERROR(errno);
+        }
+        done += (int32_t)ret;
+    }
+    slot->length = 0;
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Read side
+// -----------------------------------------------------------------------------
+
+static int read_start_block(FFAsyncIO *aio, int64_t block) {
+    uint32_t index = (uint32_t)(block % aio->depth);
+    AsyncSlot *slot = &aio->slots[index];
+
+    // A skipped-over block may still be landing in this buffer
+    int ret = async_wait_slot(aio, slot);
+    if (ret < 0) return ret;
+
+    slot->offset = block * (int64_t)aio->block_size;
+    slot->length = 0;
+
+    if (slot->offset >= aio->file_size) {
+        // Past the end: nothing to fetch
+        slot->result = 0;
+        slot->state = SLOT_FILLED;
+        return 0;
+    }
+    async_start(aio, index, (uint32_t)aio->block_size);
+    return 0;
+}
+
+// Restart the window at block; anything in flight is waited out first
+static int read_restart(FFAsyncIO *aio, int64_t block) {
+    int ret = async_drain(aio);
+    if (ret < 0) return ret;
+
+    aio->window = block;
+    for (uint32_t i = 0; i < aio->depth; i++) {
+        ret = read_start_block(aio, block + i);
+        if (ret < 0) return ret;
+    }
+    return async_flush_queue(aio);
+}
+
+// Ingest without O_DIRECT: drop blocks from the page cache once consumed
+static void read_release_block(FFAsyncIO *aio, int64_t block) {
+#if defined(POSIX_FADV_DONTNEED)
+    if ((aio->flags & FF_ASYNC_IO_DIRECT) && !aio->direct)
+        posix_fadvise(aio->fd, block * (int64_t)aio->block_size, (off_t)aio->block_size,
+                      POSIX_FADV_DONTNEED);
+#else
+    (void)aio; (void)block;
+#endif
+}
+
+// Slide the window forward so it starts at block, refilling freed slots
+static int read_advance(FFAsyncIO *aio, int64_t block) {
+    while (aio->window < block) {
+        read_release_block(aio, aio->window);
+        int ret = read_start_block(aio, aio->window + aio->depth);
+        if (ret < 0) return ret;
+        aio->window++;
+    }
+    return async_flush_queue(aio);
+}
+
+// Make a slot's data usable: surface errors and fill in short reads
+static int read_finish_slot(FFAsyncIO *aio, AsyncSlot *slot) {
+    int ret = async_wait_slot(aio, slot);
+    if (ret < 0) return ret;
+    if (slot->state == SLOT_QUEUED) async_run_queued(aio, slot);
+
+    // The filesystem rejected the direct request after all: carry on
+    // buffered. Slots still in flight from before the switch fall back too,
+    // and an EINVAL from a buffered request is a real error
+    if (slot->result == -EINVAL && slot->direct) {
+        aio->direct = false;
+        slot->direct = false;
+        slot->result = 0;
+    }
+    if (slot->result < 0) return AVERROR(-slot->result);
+
+    int64_t expected = FFMIN((int64_t)aio->block_size, aio->file_size - slot->offset);
+    int32_t got = slot->result;
+    while (got < expected) {
+        ssize_t n = pread(aio->fd, slot->data + got, (size_t)(expected - got), slot->offset + got);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return AVERROR(errno);
+        }
+        if (n == 0) break;      // File shrank
+        got += (int32_t)n;
+    }
+    slot->length = got;
+    slot->state = SLOT_FILLED;
+    return 0;
+}
+
+static int async_read_packet(void *opaque, uint8_t *buf, int buf_size) {
+    FFAsyncIO *aio = opaque;
+    if (aio->pos >= aio->file_size) return AVERROR_EOF;
+
+    int64_t block = aio->pos / (int64_t)aio->block_size;
+    int ret = (block < aio->window || block >= aio->window + aio->depth)
+        ? read_restart(aio, block)
+        : read_advance(aio, block);
+    if (ret < 0) return ret;
+
+    AsyncSlot *slot = &aio->slots[block % aio->depth];
+    if (slot->state != SLOT_FILLED) {
+        ret = read_finish_slot(aio, slot);
+        if (ret < 0) return ret;
+    }
+
+    int64_t offset = aio->pos - slot->offset;
+    int64_t avail = slot->length - offset;
+    if (avail <= 0) return AVERROR_EOF;
+
+    int n = (int)FFMIN((int64_t)buf_size, avail);
+    memcpy(buf, slot->data + offset, n);
+    aio->pos += n;
+    return n;
+}
+
+static int64_t async_read_seek(void *opaque, int64_t offset, int whence) {
+    FFAsyncIO *aio = opaque;
+
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE: return aio->file_size;
+    case SEEK_SET: break;
+    case SEEK_CUR: offset += aio->pos; break;
+    case SEEK_END: offset += aio->file_size; break;
+    default: return AVERROR(EINVAL);
+    }
+    if (offset < 0) return AVERROR(EINVAL);
+
+    // The window follows lazily on the next read
+    aio->pos = offset;
+    return offset;
+}
+
+// -----------------------------------------------------------------------------
+// Write side
+// -----------------------------------------------------------------------------
+
+// Submit the slot being gathered (if it holds anything) and move to the next
+static int write_rotate(FFAsyncIO *aio) {
+    AsyncSlot *slot = &aio->slots[aio->current];
+    if (slot->length == 0) return 0;
+
+    async_start(aio, aio->current, (uint32_t)slot->length);
+    if (!async_uring(aio)) {
+        int ret = async_complete_write(aio, slot);
+        if (ret < 0) return ret;
+    }
+
+    aio->current = (aio->current + 1) % aio->depth;
+    AsyncSlot *next = &aio->slots[aio->current];
+
+    // Submit in batches of half the queue; block only when the ring is full
+    if (async_uring(aio) && (next->state == SLOT_INFLIGHT || aio->current % FFMAX(aio->depth / 2, 1) == 0)) {
+        int ret = async_flush_queue(aio);
+        if (ret < 0) return ret;
+    }
+
+    int ret = async_wait_slot(aio, next);
+    if (ret < 0) return ret;
+    return async_complete_write(aio, next);
+}
+
+// Push out everything gathered so far and wait for all of it; needed before
+// any seek so rewrites of the same region cannot be reordered
+static int write_sync(FFAsyncIO *aio) {
+    int ret = write_rotate(aio);
+    if (ret < 0) return ret;
+
+    ret = async_drain(aio);
+    if (ret < 0) return ret;
+
+    for (uint32_t i = 0; i < aio->depth; i++) {
+        ret = async_complete_write(aio, &aio->slots[i]);
+        if (ret < 0) return ret;
+    }
+    return 0;
+}
+
+static int async_write_packet(void *opaque, const uint8_t *buf, int buf_size) {
+    FFAsyncIO *aio = opaque;
+    if (aio->error < 0) return aio->error;
+
+    int remaining = buf_size;
+    while (remaining > 0) {
+        AsyncSlot *slot = &aio->slots[aio->current];
+        if (slot->length == 0) slot->offset = aio->pos;
+
+        int n = (int)FFMIN((size_t)remaining, aio->block_size - (size_t)slot->length);
+        memcpy(slot->data + slot->length, buf, n);
+        slot->length += n;
+        buf += n;
+        remaining -= n;
+        aio->pos += n;
+        aio->file_size = FFMAX(aio->file_size, aio->pos);
+
+        if ((size_t)slot->length == aio->block_size) {
+            int ret = write_rotate(aio);
+            if (ret < 0) return aio->error = ret;
+        }
+    }
+    return buf_size;
+}
+
+static int64_t async_write_seek(void *opaque, int64_t offset, int whence) {
+    FFAsyncIO *aio = opaque;
+
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE: return aio->file_size;
+    case SEEK_SET: break;
+    case SEEK_CUR: offset += aio->pos; break;
+    case SEEK_END: offset += aio->file_size; break;
+    default: return AVERROR(EINVAL);
+    }
+    if (offset < 0) return AVERROR(EINVAL);
+    if (offset == aio->pos) return offset;
+
+    if (aio->error < 0) return aio->error;
+    int ret = write_sync(aio);
+    if (ret < 0) return aio->error = ret;
+
+    aio->pos = offset;
+    return offset;
+}
+
+// -----------------------------------------------------------------------------
+// Open / close
+// -----------------------------------------------------------------------------
+
+static void async_free(FFAsyncIO *aio) {
+#if defined(ASYNC_IO_HAVE_URING)
+    if (async_uring(aio)) ring_unmap(&aio->ring);
+#endif
+    if (aio->avio) {
+        av_freep(&aio->avio->buffer);
+        avio_context_free(&aio->avio);
+    }
+    if (aio->buffers) ff_numa_free(aio->buffers, aio->buffers_size);
+    if (aio->direct_fd >= 0) close(aio->direct_fd);
+    if (aio->fd >= 0) close(aio->fd);
+    free(aio);
+}
+
+// Set up page-cache bypass for block requests. Slots, block size and block
+// offsets are already aligned; a probe read catches filesystems with stricter
+// rules (or no O_DIRECT support at all), which leave the handle buffered.
+static void async_open_direct(FFAsyncIO *aio, const char *path) {
+#if defined(O_DIRECT)
+    int fd = open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+    if (fd < 0) return;
+
+    ssize_t probe;
+    do {
+        probe = pread(fd, aio->slots[0].data, ASYNC_IO_DIRECT_ALIGN, 0);
+    } while (probe < 0 && errno == EINTR);
+    if (probe < 0) {
+        close(fd);
+        return;
+    }
+    aio->direct_fd = fd;
+    aio->direct = true;
+#elif defined(F_NOCACHE)
+    // No alignment rules to meet; the buffered descriptor simply stops caching
+    (void)path;
+    aio->direct = fcntl(aio->fd, F_NOCACHE, 1) == 0;
+#else
+    (void)aio; (void)path;
+#endif
+}
+
+// Open into *out, returning the AVERROR of the step that failed so callers
+// need not trust errno after the cleanup calls
+static int async_open(const char *path, bool writing, uint32_t block_size,
+                      uint32_t queue_depth, uint32_t flags, FFAsyncIO **out) {
+    *out = NULL;
+    if (!path) return AVERROR(EINVAL);
+
+    FFAsyncIO *aio = calloc(1, sizeof(FFAsyncIO));
+    if (!aio) return AVERROR(ENOMEM);
+
+    // Direct I/O is an ingest (read) mode only
+    if (writing) flags &= ~FF_ASYNC_IO_DIRECT;
+    if (!queue_depth)
+        queue_depth = (flags & FF_ASYNC_IO_DIRECT) ? ASYNC_IO_DIRECT_DEPTH : FF_ASYNC_IO_DEFAULT_DEPTH;
+
+    aio->writing = writing;
+    aio->flags = flags;
+    aio->direct_fd = -1;
+    aio->backend = FF_ASYNC_IO_BACKEND_PREAD;
+    aio->block_size = FFALIGN(block_size ? block_size : FF_ASYNC_IO_DEFAULT_BLOCK_SIZE, ASYNC_IO_DIRECT_ALIGN);
+    aio->depth = FFMIN(FFMAX(queue_depth, 2), ASYNC_IO_MAX_DEPTH);
+    aio->window = -(int64_t)aio->depth;     // Forces a restart on first read
+
+    aio->fd = writing
+        ? open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)
+        : open(path, O_RDONLY | O_CLOEXEC);
+    if (aio->fd < 0) {
+        int ret = AVERROR(errno);
+        free(aio);
+        return ret;
+    }
+
+    if (!writing) {
+        struct stat st;
+        if (fstat(aio->fd, &st) != 0) {
+            int ret = AVERROR(errno);
+            async_free(aio);
+            return ret;
+        }
+        aio->file_size = st.st_size;
+    }
+
+    // Page-aligned slab shared by all slots (and registered with the ring)
+    aio->buffers_size = aio->block_size * aio->depth;
+    aio->buffers = ff_numa_alloc(aio->buffers_size, FF_NUMA_NODE_ANY);
+    if (!aio->buffers) {
+        async_free(aio);
+        return AVERROR(ENOMEM);
+    }
+    for (uint32_t i = 0; i < aio->depth; i++)
+        aio->slots[i].data = aio->buffers + (size_t)i * aio->block_size;
+
+    if (flags & FF_ASYNC_IO_DIRECT)
+        async_open_direct(aio, path);
+
+#if defined(ASYNC_IO_HAVE_URING)
+    if (!(flags & FF_ASYNC_IO_SYNC) && ring_init(aio) < 0)
+        aio->backend = FF_ASYNC_IO_BACKEND_PREAD;
+#endif
+
+    int avio_size = (int)FFMIN(aio->block_size, ASYNC_IO_AVIO_BUFFER);
+    uint8_t *avio_buffer = av_malloc(avio_size);
+    if (!avio_buffer) {
+        async_free(aio);
+        return AVERROR(ENOMEM);
+    }
+
+    aio->avio = writing
+        ? avio_alloc_context(avio_buffer, avio_size, 1, aio, NULL, async_write_packet, async_write_seek)
+        : avio_alloc_context(avio_buffer, avio_size, 0, aio, async_read_packet, NULL, async_read_seek);
+    if (!aio->avio) {
+        av_free(avio_buffer);
+        async_free(aio);
+        return AVERROR(ENOMEM);
+    }
+
+    *out = aio;
+    return 0;
+}
+
+FFAsyncIO* ff_async_io_open_read(const char *path, uint32_t block_size,
+                                 uint32_t queue_depth, uint32_t flags) {
+    FFAsyncIO *aio;
+    async_open(path, false, block_size, queue_depth, flags, &aio);
+    return aio;
+}
+
+FFAsyncIO* ff_async_io_open_write(const char *path, uint32_t block_size,
+                                  uint32_t queue_depth, uint32_t flags) {
+    FFAsyncIO *aio;
+    async_open(path, true, block_size, queue_depth, flags, &aio);
+    return aio;
+}
+
+int ff_async_io_close(FFAsyncIO *aio) {
+    if (!aio) return 0;
+
+    int ret = 0;
+    if (aio->writing) {
+        avio_flush(aio->avio);
+        ret = aio->error < 0 ? aio->error : write_sync(aio);
+    }
+
+    // Never unmap buffers the kernel may still be filling
+    async_drain(aio);
+    async_free(aio);
+    return ret;
+}
+
+AVIOContext* ff_async_io_avio(FFAsyncIO *aio) {
+    return aio ? aio->avio : NULL;
+}
+
+FFAsyncIOBackend ff_async_io_backend(FFAsyncIO *aio) {
+    return aio ? aio->backend : FF_ASYNC_IO_BACKEND_PREAD;
+}
+
+bool ff_async_io_is_direct(FFAsyncIO *aio) {
+    return aio ? aio->direct : false;
+}
+
+// -----------------------------------------------------------------------------
+// Demuxer integration
+// -----------------------------------------------------------------------------
+
+int ff_demux_open_async(FFDemuxContext *ctx, const char *path, uint32_t block_size,
+                        uint32_t queue_depth, uint32_t flags) {
+    if (!ctx || !path || ctx->fmt_ctx) return AVERROR(EINVAL);
+
+    FFAsyncIO *aio;
+    int ret = async_open(path, false, block_size, queue_depth, flags, &aio);
+    if (ret < 0) return ret;
+
+    AVFormatContext *fmt_ctx = avformat_alloc_context();
+    if (!fmt_ctx) {
+        ff_async_io_close(aio);
+        return AVERROR(ENOMEM);
+    }
+    fmt_ctx->pb = ff_async_io_avio(aio);
+    fmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    // On failure avformat_open_input frees fmt_ctx but leaves custom I/O alone
+    ret = avformat_open_input(&fmt_ctx, path, NULL, NULL);
+    if (ret < 0) {
+        ff_async_io_close(aio);
+        return ret;
+    }
+
+    ctx->fmt_ctx = fmt_ctx;
+    ctx->aio = aio;
+    return ff_demux_finish_open(ctx);
+}
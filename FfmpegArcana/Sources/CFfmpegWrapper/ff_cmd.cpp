@@ -5,7 +5,10 @@
  */
 
 #include "include/ff_cmd.h"
+#include "include/ff_numa.h"
+#include "include/ff_arena.h"
 #include "fifo/bound_fifo_impl.hpp"
+#include "fifo/static_circular_fifo.hpp"
 #include "fifo/default_semaphore_impl.hpp"
 
 extern "C" {
@@ -14,10 +17,13 @@ extern "C" {
     #include <libavutil/frame.h>
 }
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <cstdlib>
 #include <cstring>
+#include <new>
+#include <optional>
 
 // -----------------------------------------------------------------------------
 // Command ref counting implementation
@@ -57,18 +63,11 @@ static IFFRefCounted cmd_ref_vtable = {
 // AVFrame ref counting adapter
 // -----------------------------------------------------------------------------
 
+// An AVFrame's references live in its buffers, so a second owner needs a
+// second AVFrame; that cannot be returned through AddRef(self).
+// ff_cmd_set_data clones instead, and AddRef only confirms the object.
 static int32_t frame_addref(void* self) {
-    AVFrame* frame = static_cast<AVFrame*>(self);
-    if (!frame) return 0;
-    
-    // Create a new reference
-    AVFrame* ref = av_frame_clone(frame);
-    if (ref) {
-        // This is a bit weird - we can't actually track refcount externally
-        // The frame itself tracks refs internally
-        return 1;
-    }
-    return 0;
+    return self ? 1 : 0;
 }
 
 static int32_t frame_release(void* self) {
@@ -92,15 +91,9 @@ IFFRefCounted* ff_frame_ref_interface(void) {
 // AVPacket ref counting adapter
 // -----------------------------------------------------------------------------
 
+// See frame_addref
 static int32_t packet_addref(void* self) {
-    AVPacket* packet = static_cast<AVPacket*>(self);
-    if (!packet) return 0;
-    
-    AVPacket* ref = av_packet_clone(packet);
-    if (ref) {
-        return 1;
-    }
-    return 0;
+    return self ? 1 : 0;
 }
 
 static int32_t packet_release(void* self) {
@@ -120,26 +113,56 @@ IFFRefCounted* ff_packet_ref_interface(void) {
     return &packet_ref_vtable;
 }
 
+// -----------------------------------------------------------------------------
+// AVCodecParameters adapter
+// -----------------------------------------------------------------------------
+
+static int32_t codecpar_release(void* self) {
+    AVCodecParameters* par = static_cast<AVCodecParameters*>(self);
+    if (!par) return 0;
+
+    avcodec_parameters_free(&par);
+    return 0;
+}
+
+// Single owner: no AddRef, the command frees its copy
+static IFFRefCounted codecpar_ref_vtable = {
+    .AddRef = nullptr,
+    .Release = codecpar_release
+};
+
+IFFRefCounted* ff_codecpar_ref_interface(void) {
+    return &codecpar_ref_vtable;
+}
+
 // -----------------------------------------------------------------------------
 // Command pool implementation
 // -----------------------------------------------------------------------------
 
+#define CMD_POOL_GROW_COUNT 16     // Commands per slab when the pool grows
+
+// Commands are carved out of slabs so a pool's commands share pages, which
+// can then be placed on the NUMA node of the pipeline that uses them
+struct FFCmdSlab {
+    FFCmdSlab* next;
+    FFCmd* cmds;
+    size_t bytes;
+};
+
 struct FFCmdPool {
     std::mutex mutex;
     FFCmd* free_list;
-    FFCmd* all_cmds;        // Linked list of all allocated cmd blocks
+    FFCmdSlab* slabs;       // Linked list of all allocated cmd blocks
     uint32_t total_count;
     uint32_t free_count;
     uint32_t max_size;
+    int numa_node;
+    FFArena* arena;         // Owning arena, NULL if heap allocated
+    bool destroyed;
 };
 
-// Internal: return a command to the pool
-void ff_cmd_pool_return(FFCmdPool* pool, FFCmd* cmd) {
-    if (!pool || !cmd) return;
-    
-    std::lock_guard<std::mutex> lock(pool->mutex);
-    
-    // Reset the command
+// Internal: reset a command on its way back to the free list
+static void cmd_pool_reset(FFCmd* cmd) {
     cmd->type = FF_CMD_NONE;
     cmd->data = nullptr;
     cmd->data_ref = nullptr;
@@ -148,6 +171,15 @@ void ff_cmd_pool_return(FFCmdPool* pool, FFCmd* cmd) {
     cmd->flags = 0;
     cmd->stream_index = 0;
     cmd->user_data = nullptr;
+}
+
+// Internal: return a command to the pool
+void ff_cmd_pool_return(FFCmdPool* pool, FFCmd* cmd) {
+    if (!pool || !cmd) return;
+    
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    
+    cmd_pool_reset(cmd);
     
     // Add to free list
     cmd->_next = pool->free_list;
@@ -155,43 +187,158 @@ void ff_cmd_pool_return(FFCmdPool* pool, FFCmd* cmd) {
     pool->free_count++;
 }
 
-FFCmdPool* ff_cmd_pool_create(uint32_t initial_size, uint32_t max_size) {
-    FFCmdPool* pool = new FFCmdPool();
-    pool->free_list = nullptr;
-    pool->all_cmds = nullptr;
-    pool->total_count = 0;
-    pool->free_count = 0;
-    pool->max_size = max_size;
+// Internal: return a chain of reset commands linked through _next in one lock
+static void cmd_pool_return_chain(FFCmdPool* pool, FFCmd* head, FFCmd* tail, uint32_t count) {
+    if (!pool || !head) return;
     
-    // Pre-allocate initial commands
-    for (uint32_t i = 0; i < initial_size; i++) {
-        FFCmd* cmd = static_cast<FFCmd*>(calloc(1, sizeof(FFCmd)));
-        if (!cmd) break;
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    tail->_next = pool->free_list;
+    pool->free_list = head;
+    pool->free_count += count;
+}
+
+// Internal: drop one reference from each command. Commands that reach zero
+// are cleared and go back to their pool a run at a time, so a batch from a
+// single pool costs one lock instead of one per command.
+static void cmd_release_batch(FFCmd** cmds, size_t count) {
+    FFCmdPool* pool = nullptr;
+    FFCmd* head = nullptr;
+    FFCmd* tail = nullptr;
+    uint32_t run = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        FFCmd* cmd = cmds[i];
+        if (!cmd || __sync_sub_and_fetch(&cmd->_refcount, 1) != 0) continue;
+        
+        ff_cmd_clear_data(cmd);
+        if (!cmd->_pool) continue;
         
+        if (cmd->_pool != pool) {
+            cmd_pool_return_chain(pool, head, tail, run);
+            pool = cmd->_pool;
+            head = nullptr;
+            run = 0;
+        }
+        cmd_pool_reset(cmd);
+        cmd->_next = nullptr;
+        if (head) tail->_next = cmd; else head = cmd;
+        tail = cmd;
+        run++;
+    }
+    cmd_pool_return_chain(pool, head, tail, run);
+}
+
+// Internal: allocate a slab of commands onto the free list (caller holds mutex)
+static bool cmd_pool_add_slab(FFCmdPool* pool, uint32_t count) {
+    if (pool->max_size && pool->total_count + count > pool->max_size)
+        count = pool->max_size - pool->total_count;
+    if (count == 0) return false;
+    
+    FFCmdSlab* slab = pool->arena
+        ? static_cast<FFCmdSlab*>(ff_arena_alloc(pool->arena, sizeof(FFCmdSlab)))
+        : static_cast<FFCmdSlab*>(calloc(1, sizeof(FFCmdSlab)));
+    if (!slab) return false;
+    
+    slab->bytes = sizeof(FFCmd) * count;
+    if (pool->arena) {
+        slab->cmds = static_cast<FFCmd*>(ff_arena_alloc(pool->arena, slab->bytes));
+    } else if (pool->numa_node == FF_NUMA_NODE_ANY) {
+        slab->cmds = static_cast<FFCmd*>(calloc(count, sizeof(FFCmd)));
+    } else {
+        slab->cmds = static_cast<FFCmd*>(ff_numa_alloc(slab->bytes, pool->numa_node));
+    }
+    if (!slab->cmds) {
+        if (!pool->arena) free(slab);
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        FFCmd* cmd = &slab->cmds[i];
         cmd->ref = cmd_ref_vtable;
         cmd->_pool = pool;
         cmd->_refcount = 0;
-        
-        // Add to all_cmds list (using _next temporarily, we'll fix this)
-        // Actually, let's just track via free_list for now
         cmd->_next = pool->free_list;
         pool->free_list = cmd;
-        pool->total_count++;
-        pool->free_count++;
     }
     
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->total_count += count;
+    pool->free_count += count;
+    return true;
+}
+
+FFCmdPool* ff_cmd_pool_create(uint32_t initial_size, uint32_t max_size) {
+    return ff_cmd_pool_create_on_node(initial_size, max_size, FF_NUMA_NODE_ANY);
+}
+
+static void cmd_pool_init(FFCmdPool* pool, uint32_t initial_size, uint32_t max_size,
+                          int numa_node, FFArena* arena) {
+    pool->free_list = nullptr;
+    pool->slabs = nullptr;
+    pool->total_count = 0;
+    pool->free_count = 0;
+    pool->max_size = max_size;
+    pool->numa_node = numa_node;
+    pool->arena = arena;
+    pool->destroyed = false;
+    
+    // Pre-allocate initial commands
+    if (initial_size > 0) {
+        cmd_pool_add_slab(pool, initial_size);
+    }
+}
+
+FFCmdPool* ff_cmd_pool_create_on_node(uint32_t initial_size, uint32_t max_size, int numa_node) {
+    FFCmdPool* pool = new FFCmdPool();
+    cmd_pool_init(pool, initial_size, max_size, numa_node, nullptr);
+    return pool;
+}
+
+// Arena pools: memory belongs to the arena, only the mutex needs tearing down
+static void cmd_pool_arena_release(void* opaque) {
+    FFCmdPool* pool = static_cast<FFCmdPool*>(opaque);
+    if (pool->destroyed) return;
+    pool->destroyed = true;
+    pool->~FFCmdPool();
+}
+
+FFCmdPool* ff_cmd_pool_create_in(FFArena* arena, uint32_t initial_size, uint32_t max_size) {
+    if (!arena) return ff_cmd_pool_create(initial_size, max_size);
+    
+    void* mem = ff_arena_alloc(arena, sizeof(FFCmdPool));
+    if (!mem) return nullptr;
+    
+    // Torn down after the arena's FIFOs and stages, which may still hold
+    // its commands, even when they were created first
+    FFCmdPool* pool = new (mem) FFCmdPool();
+    if (ff_arena_defer_final(arena, cmd_pool_arena_release, pool) < 0) {
+        pool->~FFCmdPool();
+        return nullptr;
+    }
+    
+    // Slabs come from the arena, which already carries any node placement
+    cmd_pool_init(pool, initial_size, max_size, FF_NUMA_NODE_ANY, arena);
     return pool;
 }
 
 void ff_cmd_pool_destroy(FFCmdPool* pool) {
     if (!pool) return;
     
-    // Free all commands on the free list
-    FFCmd* cmd = pool->free_list;
-    while (cmd) {
-        FFCmd* next = cmd->_next;
-        free(cmd);
-        cmd = next;
+    // Commands may still sit in other arena objects: the arena tears the
+    // pool down once they are gone
+    if (pool->arena) return;
+    
+    FFCmdSlab* slab = pool->slabs;
+    while (slab) {
+        FFCmdSlab* next = slab->next;
+        if (pool->numa_node == FF_NUMA_NODE_ANY) {
+            free(slab->cmds);
+        } else {
+            ff_numa_free(slab->cmds, slab->bytes);
+        }
+        free(slab);
+        slab = next;
     }
     
     delete pool;
@@ -209,14 +356,11 @@ FFCmd* ff_cmd_pool_acquire(FFCmdPool* pool) {
         cmd = pool->free_list;
         pool->free_list = cmd->_next;
         pool->free_count--;
-    } else if (pool->max_size == 0 || pool->total_count < pool->max_size) {
-        // Allocate new
-        cmd = static_cast<FFCmd*>(calloc(1, sizeof(FFCmd)));
-        if (cmd) {
-            cmd->ref = cmd_ref_vtable;
-            cmd->_pool = pool;
-            pool->total_count++;
-        }
+    } else if (cmd_pool_add_slab(pool, CMD_POOL_GROW_COUNT)) {
+        // Grew by a slab
+        cmd = pool->free_list;
+        pool->free_list = cmd->_next;
+        pool->free_count--;
     }
     
     if (cmd) {
@@ -229,6 +373,9 @@ FFCmd* ff_cmd_pool_acquire(FFCmdPool* pool) {
         cmd->dts = 0;
         cmd->flags = 0;
         cmd->stream_index = 0;
+        cmd->data_size = 0;
+        cmd->payload_release = nullptr;
+        cmd->payload_addref = nullptr;
         cmd->user_data = nullptr;
     }
     
@@ -277,137 +424,495 @@ void ff_cmd_set_data(FFCmd* cmd, void* data, IFFRefCounted* data_ref) {
     // Clear existing data
     ff_cmd_clear_data(cmd);
     
+    // FFmpeg objects are referenced by cloning; see frame_addref
+    if (data && data_ref == &frame_ref_vtable) {
+        data = av_frame_clone(static_cast<AVFrame*>(data));
+    } else if (data && data_ref == &packet_ref_vtable) {
+        data = av_packet_clone(static_cast<AVPacket*>(data));
+    } else if (data && data_ref && data_ref->AddRef) {
+        data_ref->AddRef(data);
+    }
+    
     cmd->data = data;
-    cmd->data_ref = data_ref;
+    cmd->data_ref = data ? data_ref : nullptr;
+}
+
+int ff_cmd_set_payload(FFCmd* cmd, void* ptr, size_t size_hint,
+                       FFPayloadReleaseFunc release_fn, FFPayloadAddRefFunc addref_fn) {
+    if (!cmd || (ptr && !release_fn)) return AVERROR(EINVAL);
     
-    // AddRef if interface provided
-    if (data && data_ref && data_ref->AddRef) {
-        data_ref->AddRef(data);
+    ff_cmd_clear_data(cmd);
+    if (!ptr) return 0;
+    
+    cmd->data = ptr;
+    cmd->data_size = size_hint;
+    cmd->payload_release = release_fn;
+    cmd->payload_addref = addref_fn;
+    return 0;
+}
+
+int ff_cmd_copy_payload(FFCmd* dst, const FFCmd* src) {
+    if (!dst || !src || dst == src) return AVERROR(EINVAL);
+    
+    if (src->payload_release) {
+        if (!src->payload_addref) return AVERROR(ENOSYS);
+        void* ref = src->data ? src->payload_addref(src->data) : nullptr;
+        if (src->data && !ref) return AVERROR(ENOMEM);
+        return ff_cmd_set_payload(dst, ref, src->data_size, src->payload_release, src->payload_addref);
+    }
+    
+    if (src->data && src->data_ref != &frame_ref_vtable && src->data_ref != &packet_ref_vtable)
+        return AVERROR(ENOSYS);
+    ff_cmd_set_data(dst, src->data, src->data_ref);
+    if (src->data && !dst->data) return AVERROR(ENOMEM);
+    dst->data_size = src->data_size;
+    return 0;
+}
+
+int ff_cmd_init_config(FFCmd* cmd, const AVCodecParameters* codecpar, uint32_t stream_index) {
+    if (!cmd || !codecpar) return AVERROR(EINVAL);
+
+    AVCodecParameters* copy = avcodec_parameters_alloc();
+    if (!copy) return AVERROR(ENOMEM);
+    int ret = avcodec_parameters_copy(copy, codecpar);
+    if (ret < 0) {
+        avcodec_parameters_free(&copy);
+        return ret;
     }
+
+    ff_cmd_init(cmd, FF_CMD_CONFIG);
+    ff_cmd_set_data(cmd, copy, ff_codecpar_ref_interface());
+    cmd->stream_index = stream_index;
+    return 0;
+}
+
+void ff_cmd_init_error(FFCmd* cmd, int error, uint32_t stream_index) {
+    if (!cmd) return;
+    ff_cmd_init(cmd, FF_CMD_ERROR);
+    cmd->flags = (uint32_t)-error;
+    cmd->stream_index = stream_index;
 }
 
 void ff_cmd_clear_data(FFCmd* cmd) {
     if (!cmd) return;
     
-    // Release if interface provided
-    if (cmd->data && cmd->data_ref && cmd->data_ref->Release) {
+    // Release through whichever owner is attached
+    if (cmd->data && cmd->payload_release) {
+        cmd->payload_release(cmd->data);
+    } else if (cmd->data && cmd->data_ref && cmd->data_ref->Release) {
         cmd->data_ref->Release(cmd->data);
     }
     
     cmd->data = nullptr;
     cmd->data_ref = nullptr;
+    cmd->data_size = 0;
+    cmd->payload_release = nullptr;
+    cmd->payload_addref = nullptr;
+}
+
+bool ff_cmd_is_keyframe(FFCmd* cmd) {
+    if (!ff_cmd_is_media(cmd)) return false;
+    if (cmd->flags & FF_CMD_FLAG_KEYFRAME) return true;
+    
+    // Only FFmpeg payloads can be inspected; foreign ones rely on the flag
+    if (cmd->data && cmd->data_ref == &packet_ref_vtable)
+        return (static_cast<AVPacket*>(cmd->data)->flags & AV_PKT_FLAG_KEY) != 0;
+    if (cmd->data && cmd->data_ref == &frame_ref_vtable)
+        return (static_cast<AVFrame*>(cmd->data)->flags & AV_FRAME_FLAG_KEY) != 0;
+    return false;
+}
+
+// Timestamp of a media command: its FFmpeg payload's pts, else the command's own
+static int64_t cmd_media_pts(FFCmd* cmd) {
+    int64_t pts = AV_NOPTS_VALUE;
+    if (cmd->data && cmd->data_ref == &packet_ref_vtable)
+        pts = static_cast<AVPacket*>(cmd->data)->pts;
+    else if (cmd->data && cmd->data_ref == &frame_ref_vtable)
+        pts = static_cast<AVFrame*>(cmd->data)->pts;
+    return pts != AV_NOPTS_VALUE ? pts : cmd->pts;
+}
+
+// Stream of a media command: its FFmpeg packet's index, else the command's own
+static int64_t cmd_media_stream(FFCmd* cmd) {
+    if (cmd->data && cmd->data_ref == &packet_ref_vtable)
+        return static_cast<AVPacket*>(cmd->data)->stream_index;
+    return cmd->stream_index;
 }
 
 // -----------------------------------------------------------------------------
 // Command FIFO implementation
 // -----------------------------------------------------------------------------
 
-struct FFCmdFifo {
+struct FFCmdFifo final : public sproqet::sproqet_generic_fifo_head_monitor {
     using FifoType = sproqet::sproqet_generic_waitable_fifo<FFCmd*, sproqet::default_semaphore_impl>;
-    std::unique_ptr<FifoType> fifo;
+    using InlineFifoType = sproqet::sproqet_generic_waitable_fifo<
+        FFCmd*, sproqet::default_semaphore_impl,
+        sproqet::static_circular_fifo<FFCmd*, FF_CMD_FIFO_INLINE_CAPACITY>>;
     
-    FFCmdFifo(uint32_t capacity, sproqet::SP_Circular_Fifo_Mode mode) {
-        fifo = std::make_unique<FifoType>(
-            capacity,
-            nullptr,    // no head monitor
+    // Exactly one of the two is engaged, chosen by capacity at creation
+    std::optional<FifoType> fifo;
+    std::optional<InlineFifoType> inline_fifo;
+    FFArena* arena = nullptr;   // Owning arena, NULL if heap allocated
+    bool destroyed = false;
+    FFCmdFifoHeadFunc head_func = nullptr;
+    void* head_userdata = nullptr;
+    uint32_t max_capacity = 0;  // Resize bound, 0 = ring storage is the bound
+    
+    // Catch-up policy and the timestamps it compares
+    std::atomic<uint32_t> skip_max_count{0};
+    std::atomic<int64_t> skip_max_lag{0};
+    std::atomic<int64_t> newest_write_pts{AV_NOPTS_VALUE};
+    std::atomic<int64_t> last_read_pts{AV_NOPTS_VALUE};
+    std::atomic<uint64_t> skipped{0};
+    
+    // Push-mode delivery (see ff_cmd_fifo_set_consumer)
+    std::atomic<FFCmdFifoConsumeFunc> consume_func{nullptr};
+    void* consume_userdata = nullptr;
+    std::atomic<bool> delivering{false};
+    
+    FFCmdFifo(uint32_t capacity, sproqet::SP_Circular_Fifo_Mode mode,
+              FFCmdFifoHeadFunc func = nullptr, void* userdata = nullptr,
+              uint32_t max_capacity = 0)
+        : head_func(func), head_userdata(userdata), max_capacity(max_capacity) {
+        sproqet::sproqet_generic_fifo_head_monitor* monitor = func ? this : nullptr;
+        uint32_t storage = std::max(capacity, max_capacity);
+        if (capacity > 0 && storage <= FF_CMD_FIFO_INLINE_CAPACITY) {
+            inline_fifo.emplace(capacity, monitor, true, mode, nullptr, 0, true);
+            return;
+        }
+        
+        // Lockless rings cannot be swapped under running threads, so they
+        // start at full size and are shrunk to the requested capacity
+        if (mode == sproqet::Circular_Fifo_Mode_Blocking) storage = capacity;
+        fifo.emplace(
+            storage,
+            monitor,    // head monitor only when someone listens
             true,       // read semaphore
             mode,
             nullptr,    // user data
             0,          // tag
             true        // can unwait
         );
+        if (storage != capacity) fifo->resize(capacity);
+    }
+    
+    // Run op on whichever fifo is engaged; both share one interface
+    template<typename Op>
+    decltype(auto) with_fifo(Op&& op) {
+        return inline_fifo ? op(*inline_fifo) : op(*fifo);
     }
     
     ~FFCmdFifo() {
-        // Drain and release any remaining commands
-        fifo->setFlowEnabled(false);
+        // Release any remaining commands, without notifying anyone
+        head_func = nullptr;
+        close();
+    }
+    
+    // Wake all waiters and release the queued commands in batches
+    int close() {
+        FFCmd* batch[64];
+        size_t pending = 0;
+        int released = with_fifo([&](auto& f) {
+            return f.close([&](FFCmd* c) {
+                batch[pending++] = c;
+                if (pending == sizeof(batch) / sizeof(batch[0])) {
+                    cmd_release_batch(batch, pending);
+                    pending = 0;
+                }
+            });
+        });
+        cmd_release_batch(batch, pending);
+        return released;
+    }
+    
+    int skip_to_keyframe() {
+        int dropped = with_fifo([](auto& f) {
+            // Only a keyframe of the stream at the head can restart it: an
+            // audio packet (always key) must not end a skip through video.
+            // skipTo tests target first, in queue order, so the first media
+            // command seen picks the stream.
+            int64_t stream = -1;
+            return f.skipTo(
+                [&stream](FFCmd* c) {
+                    if (!ff_cmd_is_media(c)) return false;
+                    if (stream < 0) stream = cmd_media_stream(c);
+                    return cmd_media_stream(c) == stream && ff_cmd_is_keyframe(c);
+                },
+                [](FFCmd* c) { return !ff_cmd_is_media(c); },
+                [](FFCmd* c) { FF_CMD_RELEASE(c); });
+        });
+        if (dropped > 0) skipped.fetch_add((uint64_t)dropped, std::memory_order_relaxed);
+        return dropped;
+    }
+    
+    bool behind() {
+        uint32_t max_count = skip_max_count.load(std::memory_order_relaxed);
+        if (max_count && (uint32_t)with_fifo([](auto& f) { return f.storedCount(); }) > max_count)
+            return true;
         
-        FFCmd* cmd = nullptr;
-        while (fifo->tryWaitForReadData() == 0) {
-            fifo->read(cmd);
-            if (cmd) {
-                FF_CMD_RELEASE(cmd);
+        int64_t max_lag = skip_max_lag.load(std::memory_order_relaxed);
+        if (!max_lag) return false;
+        int64_t newest = newest_write_pts.load(std::memory_order_relaxed);
+        int64_t last = last_read_pts.load(std::memory_order_relaxed);
+        return newest != AV_NOPTS_VALUE && last != AV_NOPTS_VALUE && newest - last > max_lag;
+    }
+    
+    // Write in push mode. The thread that wins `delivering` acts as the
+    // consumer until the ring is empty; a command that finds the FIFO idle
+    // goes straight to the stage without touching the ring.
+    int write_pushed(FFCmdFifoConsumeFunc func, FFCmd* cmd) {
+        return with_fifo([&](auto& f) {
+            int ret;
+            bool owner = f.storedCount() == 0 && begin_delivery();
+            if (owner && f.storedCount() == 0) {
+                ret = f.bypass();
+                if (ret == SPR_OK) deliver(func, cmd);
+            } else {
+                ret = f.write(cmd);
+                if (!owner && ret == SPR_OK) owner = begin_delivery();
+            }
+            if (owner) drain_pushed(f, func);
+            return ret;
+        });
+    }
+    
+    bool begin_delivery() {
+        bool expected = false;
+        return delivering.compare_exchange_strong(expected, true, std::memory_order_seq_cst);
+    }
+    
+    // Deliver what other writers queued meanwhile. After letting go, look
+    // again: a writer whose claim failed just before the release relies on
+    // the current owner to pick its command up.
+    template<typename Fifo>
+    void drain_pushed(Fifo& f, FFCmdFifoConsumeFunc func) {
+        do {
+            FFCmd* c = nullptr;
+            while (f.tryWaitForReadData() == 0) {
+                f.read(c);
+                if (c) deliver(func, c);
             }
+            delivering.store(false, std::memory_order_seq_cst);
+        } while (f.storedCount() > 0 && !f.isClosed() && begin_delivery());
+    }
+    
+    void deliver(FFCmdFifoConsumeFunc func, FFCmd* cmd) {
+        if (ff_cmd_is_media(cmd)) {
+            int64_t pts = cmd_media_pts(cmd);
+            if (pts != AV_NOPTS_VALUE) last_read_pts.store(pts, std::memory_order_relaxed);
         }
+        func(this, cmd, consume_userdata);
+    }
+    
+    bool generic_fifo_new_head(void*, void*, uint32_t) override {
+        FFCmdFifoHeadFunc func = head_func;
+        if (func) func(this, head_userdata);
+        return true;
     }
 };
 
-FFCmdFifo* ff_cmd_fifo_create(uint32_t capacity, FFCmdFifoMode mode) {
-    auto spMode = (mode == FF_CMD_FIFO_BLOCKING)
+static sproqet::SP_Circular_Fifo_Mode cmd_fifo_mode(FFCmdFifoMode mode) {
+    return (mode == FF_CMD_FIFO_BLOCKING)
         ? sproqet::Circular_Fifo_Mode_Blocking
         : sproqet::Circular_Fifo_Mode_Single_Producer_Lockless;
-    return new FFCmdFifo(capacity, spMode);
+}
+
+FFCmdFifo* ff_cmd_fifo_create(uint32_t capacity, FFCmdFifoMode mode) {
+    return new FFCmdFifo(capacity, cmd_fifo_mode(mode));
+}
+
+FFCmdFifo* ff_cmd_fifo_create_monitored(uint32_t capacity, FFCmdFifoMode mode,
+                                        FFCmdFifoHeadFunc func, void* userdata) {
+    if (!func) return ff_cmd_fifo_create(capacity, mode);
+    return new FFCmdFifo(capacity, cmd_fifo_mode(mode), func, userdata);
+}
+
+static void cmd_fifo_arena_release(void* opaque) {
+    FFCmdFifo* fifo = static_cast<FFCmdFifo*>(opaque);
+    if (fifo->destroyed) return;
+    fifo->destroyed = true;
+    fifo->~FFCmdFifo();
+}
+
+FFCmdFifo* ff_cmd_fifo_create_in(FFArena* arena, uint32_t capacity, FFCmdFifoMode mode) {
+    if (!arena) return ff_cmd_fifo_create(capacity, mode);
+    
+    void* mem = ff_arena_alloc(arena, sizeof(FFCmdFifo));
+    if (!mem) return nullptr;
+    
+    // Large rings are still allocated by the sproqet fifo; inline ones land in the arena
+    FFCmdFifo* fifo = new (mem) FFCmdFifo(capacity, cmd_fifo_mode(mode));
+    fifo->arena = arena;
+    if (ff_arena_defer(arena, cmd_fifo_arena_release, fifo) < 0) {
+        fifo->~FFCmdFifo();
+        return nullptr;
+    }
+    return fifo;
 }
 
 void ff_cmd_fifo_destroy(FFCmdFifo* fifo) {
+    if (!fifo) return;
+    if (fifo->arena) {
+        cmd_fifo_arena_release(fifo);
+        return;
+    }
     delete fifo;
 }
 
+FFCmdFifo* ff_cmd_fifo_create_resizable(uint32_t capacity, uint32_t max_capacity,
+                                        FFCmdFifoMode mode) {
+    if (!capacity || max_capacity < capacity) return nullptr;
+    return new FFCmdFifo(capacity, cmd_fifo_mode(mode), nullptr, nullptr, max_capacity);
+}
+
+int ff_cmd_fifo_resize(FFCmdFifo* fifo, uint32_t capacity) {
+    if (!fifo || !capacity) return FF_CMD_FIFO_INVALID_PARAMS;
+    if (fifo->max_capacity && capacity > fifo->max_capacity) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([capacity](auto& f) { return f.resize(capacity); });
+}
+
+uint32_t ff_cmd_fifo_capacity(FFCmdFifo* fifo) {
+    return fifo ? (uint32_t)fifo->with_fifo([](auto& f) { return f.capacity(); }) : 0;
+}
+
+int ff_cmd_fifo_set_consumer(FFCmdFifo* fifo, FFCmdFifoConsumeFunc func, void* userdata) {
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    // A writer may be inside the old consumer (or about to call it) while
+    // flow is enabled, and the caller frees its userdata once this returns
+    if (ff_cmd_fifo_get_flow_enabled(fifo) || fifo->delivering.load(std::memory_order_seq_cst))
+        return FF_CMD_FIFO_INVALID_PARAMS;
+    fifo->consume_userdata = userdata;
+    fifo->consume_func.store(func, std::memory_order_release);
+    return FF_CMD_FIFO_OK;
+}
+
+int ff_cmd_fifo_close(FFCmdFifo* fifo) {
+    return fifo ? fifo->close() : 0;
+}
+
+bool ff_cmd_fifo_is_closed(FFCmdFifo* fifo) {
+    return fifo ? fifo->with_fifo([](auto& f) { return f.isClosed(); }) : true;
+}
+
 void ff_cmd_fifo_set_flow_enabled(FFCmdFifo* fifo, bool enabled) {
-    if (fifo && fifo->fifo) {
-        fifo->fifo->setFlowEnabled(enabled);
+    if (fifo) {
+        fifo->with_fifo([enabled](auto& f) { f.setFlowEnabled(enabled); return 0; });
     }
 }
 
 bool ff_cmd_fifo_get_flow_enabled(FFCmdFifo* fifo) {
-    return fifo && fifo->fifo ? fifo->fifo->getFlowEnabled() : false;
+    return fifo ? fifo->with_fifo([](auto& f) { return f.getFlowEnabled(); }) : false;
 }
 
 int ff_cmd_fifo_wait_write(FFCmdFifo* fifo) {
-    if (!fifo || !fifo->fifo) return FF_CMD_FIFO_INVALID_PARAMS;
-    return fifo->fifo->waitForWriteSpace();
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([](auto& f) { return f.waitForWriteSpace(); });
 }
 
 int ff_cmd_fifo_wait_write_timed(FFCmdFifo* fifo, int msecs) {
-    if (!fifo || !fifo->fifo) return FF_CMD_FIFO_INVALID_PARAMS;
-    return fifo->fifo->waitForWriteSpaceTimed(msecs);
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([msecs](auto& f) { return f.waitForWriteSpaceTimed(msecs); });
 }
 
 int ff_cmd_fifo_try_write(FFCmdFifo* fifo) {
-    if (!fifo || !fifo->fifo) return FF_CMD_FIFO_INVALID_PARAMS;
-    return fifo->fifo->tryWaitForWriteData();
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([](auto& f) { return f.tryWaitForWriteData(); });
 }
 
 int ff_cmd_fifo_write(FFCmdFifo* fifo, FFCmd* cmd) {
-    if (!fifo || !fifo->fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    if (ff_cmd_is_media(cmd)) {
+        int64_t pts = cmd_media_pts(cmd);
+        if (pts != AV_NOPTS_VALUE) fifo->newest_write_pts.store(pts, std::memory_order_relaxed);
+    }
     // Transfer ownership - no addref, FIFO now owns the ref
-    return fifo->fifo->write(cmd);
+    FFCmdFifoConsumeFunc consume = fifo->consume_func.load(std::memory_order_acquire);
+    if (consume) return fifo->write_pushed(consume, cmd);
+    return fifo->with_fifo([&cmd](auto& f) { return f.write(cmd); });
 }
 
 int ff_cmd_fifo_wait_read(FFCmdFifo* fifo) {
-    if (!fifo || !fifo->fifo) return FF_CMD_FIFO_INVALID_PARAMS;
-    return fifo->fifo->waitForReadData();
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([](auto& f) { return f.waitForReadData(); });
 }
 
 int ff_cmd_fifo_wait_read_timed(FFCmdFifo* fifo, int msecs) {
-    if (!fifo || !fifo->fifo) return FF_CMD_FIFO_INVALID_PARAMS;
-    return fifo->fifo->waitForReadDataTimed(msecs);
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([msecs](auto& f) { return f.waitForReadDataTimed(msecs); });
 }
 
 int ff_cmd_fifo_try_read(FFCmdFifo* fifo) {
-    if (!fifo || !fifo->fifo) return FF_CMD_FIFO_INVALID_PARAMS;
-    return fifo->fifo->tryWaitForReadData();
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([](auto& f) { return f.tryWaitForReadData(); });
 }
 
 int ff_cmd_fifo_read(FFCmdFifo* fifo, FFCmd** cmd) {
-    if (!fifo || !fifo->fifo || !cmd) return FF_CMD_FIFO_INVALID_PARAMS;
+    if (!fifo || !cmd) return FF_CMD_FIFO_INVALID_PARAMS;
+    
+    if (fifo->behind()) fifo->skip_to_keyframe();
     
     FFCmd* c = nullptr;
-    fifo->fifo->read(c);
+    fifo->with_fifo([&c](auto& f) { return f.read(c); });
+    if (!c && ff_cmd_fifo_is_closed(fifo)) {
+        *cmd = nullptr;
+        return FF_CMD_FIFO_CLOSED;
+    }
+    if (ff_cmd_is_media(c)) {
+        int64_t pts = cmd_media_pts(c);
+        if (pts != AV_NOPTS_VALUE) fifo->last_read_pts.store(pts, std::memory_order_relaxed);
+    }
     *cmd = c;
     // Transfer ownership - no addref, caller now owns the ref
     return FF_CMD_FIFO_OK;
 }
 
 int ff_cmd_fifo_preempt(FFCmdFifo* fifo, FFCmd* cmd) {
-    if (!fifo || !fifo->fifo) return FF_CMD_FIFO_INVALID_PARAMS;
-    return fifo->fifo->preempt(cmd);
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([cmd](auto& f) { return f.preempt(cmd); });
+}
+
+int64_t ff_cmd_fifo_clock_us(void) {
+    return sproqet::default_semaphore_impl::MonotonicNanos() / 1000;
+}
+
+int ff_cmd_fifo_wait_write_us(FFCmdFifo* fifo, int64_t usecs) {
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([usecs](auto& f) { return f.waitForWriteSpaceTimedUs(usecs); });
+}
+
+int ff_cmd_fifo_wait_write_until(FFCmdFifo* fifo, int64_t deadline_us) {
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([deadline_us](auto& f) { return f.waitForWriteSpaceUntil(deadline_us * 1000); });
+}
+
+int ff_cmd_fifo_wait_read_us(FFCmdFifo* fifo, int64_t usecs) {
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([usecs](auto& f) { return f.waitForReadDataTimedUs(usecs); });
+}
+
+int ff_cmd_fifo_wait_read_until(FFCmdFifo* fifo, int64_t deadline_us) {
+    if (!fifo) return FF_CMD_FIFO_INVALID_PARAMS;
+    return fifo->with_fifo([deadline_us](auto& f) { return f.waitForReadDataUntil(deadline_us * 1000); });
+}
+
+int ff_cmd_fifo_skip_to_keyframe(FFCmdFifo* fifo) {
+    return fifo ? fifo->skip_to_keyframe() : 0;
+}
+
+void ff_cmd_fifo_set_skip_policy(FFCmdFifo* fifo, const FFCmdFifoSkipPolicy* policy) {
+    if (!fifo) return;
+    fifo->skip_max_count.store(policy ? policy->max_count : 0, std::memory_order_relaxed);
+    fifo->skip_max_lag.store(policy ? policy->max_lag : 0, std::memory_order_relaxed);
+}
+
+uint64_t ff_cmd_fifo_skipped_count(FFCmdFifo* fifo) {
+    return fifo ? fifo->skipped.load(std::memory_order_relaxed) : 0;
 }
 
 int ff_cmd_fifo_count(FFCmdFifo* fifo) {
-    return fifo && fifo->fifo ? fifo->fifo->storedCount() : 0;
+    return fifo ? fifo->with_fifo([](auto& f) { return f.storedCount(); }) : 0;
 }
 
 bool ff_cmd_fifo_has_been_read(FFCmdFifo* fifo) {
-    return fifo && fifo->fifo ? fifo->fifo->hasBeenRead() : false;
+    return fifo ? fifo->with_fifo([](auto& f) { return f.hasBeenRead(); }) : false;
 }
\ No newline at end of file
@@ -0,0 +1,493 @@
+/**
+ * ff_decode_service.c
+ *
+ * Run-queue scheduling of many decoders on a few threads. Arrival is
+ * signalled by the input FIFO's head monitor; a stream is on at most one
+ * list (run queue or parked) and runs on at most one worker at a time.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_decode_service.h"
+#include "include/ff_decoder_cache.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DECODE_SERVICE_MAX_THREADS  64
+
+// -----------------------------------------------------------------------------
+// Internal structures
+// -----------------------------------------------------------------------------
+
+typedef enum {
+    STREAM_IDLE = 0,        // Nothing to do, waiting for input
+    STREAM_QUEUED,          // On the run queue
+    STREAM_RUNNING,         // A worker is inside its turn
+    STREAM_PARKED,          // Output full, retried periodically
+    STREAM_REMOVED
+} StreamState;
+
+typedef enum {
+    TURN_IDLE,              // Input exhausted
+    TURN_YIELD,             // Quantum used up, more input waiting
+    TURN_BLOCKED            // Output full
+} TurnResult;
+
+struct FFDecodeStream {
+    FFDecodeService *service;
+    FFDecoderContext *decoder;
+    FFCmdFifo *input;
+    FFCmdFifo *output;
+    void *opaque;
+    int stream_index;
+
+    // Worker-owned between turns
+    FFCmd *pending_input;   // Packet the decoder could not take yet
+    FFCmd *pending_output;  // Command waiting for output space
+    FFCmd *drain;           // EOS or CONFIG held back until the decoder is drained
+    AVFrame *frame;
+
+    // Guarded by the service lock
+    StreamState state;
+    bool notified;          // Input arrived while running or parked
+    struct FFDecodeStream *next;            // Run queue / parked list linkage
+    struct FFDecodeStream *all_next;        // Every attached stream
+
+    uint64_t packets;
+    uint64_t frames;
+};
+
+struct FFDecodeService {
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;       // Run queue non-empty, or stop
+    pthread_cond_t idle_cond;       // A turn ended
+    clockid_t clock;                // work_cond's clock, monotonic where supported
+
+    pthread_t threads[DECODE_SERVICE_MAX_THREADS];
+    uint32_t thread_count;
+    uint32_t quantum;
+
+    FFCmdPool *cmd_pool;
+    bool owns_pool;
+    FFDecoderCache *decoder_cache;  // Warm contexts for CONFIG reopens
+
+    FFDecodeStream *run_head, *run_tail;
+    FFDecodeStream *parked;
+    int64_t unpark_at;              // Parked streams rejoin the run queue (ns on clock)
+    FFDecodeStream *streams;
+    uint32_t stream_count;
+    bool stop;
+};
+
+// -----------------------------------------------------------------------------
+// Scheduling (service lock held)
+// -----------------------------------------------------------------------------
+
+static int64_t service_now(FFDecodeService *service) {
+    struct timespec ts;
+    clock_gettime(service->clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void service_enqueue(FFDecodeService *service, FFDecodeStream *st) {
+    st->state = STREAM_QUEUED;
+    st->next = NULL;
+    if (service->run_tail) service->run_tail->next = st;
+    else service->run_head = st;
+    service->run_tail = st;
+    pthread_cond_signal(&service->work_cond);
+}
+
+static FFDecodeStream* service_dequeue(FFDecodeService *service) {
+    FFDecodeStream *st = service->run_head;
+    if (!st) return NULL;
+    service->run_head = st->next;
+    if (!service->run_head) service->run_tail = NULL;
+    st->next = NULL;
+    return st;
+}
+
+static void service_unlink(FFDecodeService *service, FFDecodeStream *st) {
+    FFDecodeStream *prev = NULL;
+    for (FFDecodeStream *it = service->run_head; it; prev = it, it = it->next) {
+        if (it != st) continue;
+        if (prev) prev->next = it->next;
+        else service->run_head = it->next;
+        if (service->run_tail == it) service->run_tail = prev;
+        return;
+    }
+    for (FFDecodeStream **link = &service->parked; *link; link = &(*link)->next) {
+        if (*link == st) {
+            *link = st->next;
+            return;
+        }
+    }
+}
+
+// The first stream to park sets when the list is retried
+static void service_park(FFDecodeService *service, FFDecodeStream *st) {
+    if (!service->parked)
+        service->unpark_at = service_now(service) + FF_DECODE_SERVICE_RETRY_MSECS * 1000000LL;
+    st->state = STREAM_PARKED;
+    st->next = service->parked;
+    service->parked = st;
+}
+
+// Parked streams rejoin the back of the run queue
+static void service_unpark(FFDecodeService *service) {
+    while (service->parked) {
+        FFDecodeStream *st = service->parked;
+        service->parked = st->next;
+        service_enqueue(service, st);
+    }
+}
+
+// Head monitor of every input FIFO; runs on the producer's thread
+static void stream_input_arrived(FFCmdFifo *fifo, void *userdata) {
+    FFDecodeStream *st = userdata;
+    FFDecodeService *service = st->service;
+    (void)fifo;
+
+    pthread_mutex_lock(&service->lock);
+    if (st->state == STREAM_IDLE) service_enqueue(service, st);
+    else if (st->state == STREAM_RUNNING) st->notified = true;
+    pthread_mutex_unlock(&service->lock);
+}
+
+// -----------------------------------------------------------------------------
+// A stream's turn (no lock held)
+// -----------------------------------------------------------------------------
+
+// Hand a command downstream; false when the output has no room
+static bool stream_emit(FFDecodeStream *st, FFCmd *cmd) {
+    int ret = ff_cmd_fifo_try_write(st->output);
+    if (ret == FF_CMD_FIFO_FLOW_DISABLED) {
+        // Nobody is listening any more
+        FF_CMD_RELEASE(cmd);
+        return true;
+    }
+    if (ret != FF_CMD_FIFO_OK) {
+        st->pending_output = cmd;
+        return false;
+    }
+    if (ff_cmd_fifo_write(st->output, cmd) != FF_CMD_FIFO_OK)
+        FF_CMD_RELEASE(cmd);
+    return true;
+}
+
+// Move every decoded frame downstream; false when the output filled up
+static bool stream_drain_frames(FFDecodeStream *st) {
+    for (;;) {
+        int ret = ff_decoder_receive_frame(st->decoder, st->frame);
+        if (ret == AVERROR_EOF && st->drain) {
+            // Drained: the decoder starts over, on new parameters for a
+            // CONFIG, and the held command goes out after the last frame
+            FFCmd *cmd = st->drain;
+            st->drain = NULL;
+            if (cmd->type == FF_CMD_CONFIG && cmd->data_ref == ff_codecpar_ref_interface()) {
+                int ret = ff_decoder_reconfigure(st->decoder, cmd->data,
+                                                 __atomic_load_n(&st->service->decoder_cache, __ATOMIC_ACQUIRE));
+                if (ret < 0) {
+                    // The decoder kept the old parameters, so downstream
+                    // must not switch to the announced ones
+                    ff_cmd_init_error(cmd, ret, (uint32_t)st->stream_index);
+                    cmd->user_data = st->opaque;
+                }
+            }
+            ff_decoder_flush(st->decoder);
+            return stream_emit(st, cmd);
+        }
+        if (ret < 0) return true;
+
+        FFCmd *cmd = ff_cmd_pool_acquire(st->service->cmd_pool);
+        AVFrame *frame = cmd ? av_frame_alloc() : NULL;
+        if (!frame) {
+            // Out of commands or memory: drop this frame, keep decoding
+            FF_CMD_RELEASE(cmd);
+            av_frame_unref(st->frame);
+            continue;
+        }
+        av_frame_move_ref(frame, st->frame);
+
+        // The command owns the frame; its Release frees it
+        ff_cmd_init(cmd, FF_CMD_FRAME);
+        cmd->data = frame;
+        cmd->data_ref = ff_frame_ref_interface();
+        cmd->pts = frame->pts;
+        cmd->dts = frame->pkt_dts;
+        cmd->stream_index = (uint32_t)st->stream_index;
+        cmd->user_data = st->opaque;
+
+        __atomic_fetch_add(&st->frames, 1, __ATOMIC_RELAXED);
+        if (!stream_emit(st, cmd)) return false;
+    }
+}
+
+static TurnResult stream_run(FFDecodeStream *st, uint32_t quantum) {
+    for (;;) {
+        if (st->pending_output) {
+            FFCmd *cmd = st->pending_output;
+            st->pending_output = NULL;
+            if (!stream_emit(st, cmd)) return TURN_BLOCKED;
+        }
+        if (!stream_drain_frames(st)) return TURN_BLOCKED;
+        if (st->drain) continue;    // Still draining
+
+        FFCmd *cmd = st->pending_input;
+        st->pending_input = NULL;
+        if (!cmd) {
+            // The head monitor fires before the read token is posted, so a
+            // stored command without a token is about to become readable
+            if (quantum == 0 || ff_cmd_fifo_try_read(st->input) != FF_CMD_FIFO_OK)
+                return ff_cmd_fifo_count(st->input) ? TURN_YIELD : TURN_IDLE;
+            if (ff_cmd_fifo_read(st->input, &cmd) != FF_CMD_FIFO_OK || !cmd) continue;
+            quantum--;
+        }
+
+        switch (cmd->type) {
+        case FF_CMD_PACKET: {
+            int ret = ff_decoder_send_packet(st->decoder, cmd->data);
+            if (ret == AVERROR(EAGAIN)) {
+                // Frames must come out first
+                st->pending_input = cmd;
+                continue;
+            }
+            __atomic_fetch_add(&st->packets, 1, __ATOMIC_RELAXED);
+            FF_CMD_RELEASE(cmd);
+            break;
+        }
+        case FF_CMD_EOS:
+        case FF_CMD_CONFIG:
+            ff_decoder_send_packet(st->decoder, NULL);
+            st->drain = cmd;
+            break;
+        case FF_CMD_FLUSH:
+            ff_decoder_flush(st->decoder);
+            if (!stream_emit(st, cmd)) return TURN_BLOCKED;
+            break;
+        default:
+            if (!stream_emit(st, cmd)) return TURN_BLOCKED;
+            break;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Workers
+// -----------------------------------------------------------------------------
+
+static void* service_worker(void *arg) {
+    FFDecodeService *service = arg;
+
+    pthread_mutex_lock(&service->lock);
+    while (!service->stop) {
+        // Checked on every pass, not only when a wait times out: with other
+        // streams keeping the run queue busy no wait ever would
+        if (service->parked && service_now(service) >= service->unpark_at)
+            service_unpark(service);
+
+        FFDecodeStream *st = service_dequeue(service);
+        if (!st) {
+            if (!service->parked) {
+                pthread_cond_wait(&service->work_cond, &service->lock);
+                continue;
+            }
+
+            // Only parked streams left: give their consumers a moment
+            struct timespec deadline = {
+                .tv_sec = service->unpark_at / 1000000000LL,
+                .tv_nsec = service->unpark_at % 1000000000LL,
+            };
+            pthread_cond_timedwait(&service->work_cond, &service->lock, &deadline);
+            continue;
+        }
+
+        st->state = STREAM_RUNNING;
+        st->notified = false;
+        pthread_mutex_unlock(&service->lock);
+
+        TurnResult result = stream_run(st, service->quantum);
+
+        pthread_mutex_lock(&service->lock);
+        if (result == TURN_BLOCKED) {
+            service_park(service, st);
+        } else if (result == TURN_YIELD || st->notified) {
+            service_enqueue(service, st);
+        } else {
+            st->state = STREAM_IDLE;
+        }
+        pthread_cond_broadcast(&service->idle_cond);
+    }
+    pthread_mutex_unlock(&service->lock);
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+FFDecodeService* ff_decode_service_create(uint32_t thread_count, uint32_t quantum,
+                                          FFCmdPool* cmd_pool) {
+    FFDecodeService *service = calloc(1, sizeof(FFDecodeService));
+    if (!service) return NULL;
+
+    pthread_mutex_init(&service->lock, NULL);
+
+    // Park retries are timed waits; a monotonic clock keeps them immune to
+    // wall-clock steps. Darwin has no pthread_condattr_setclock
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    service->clock = CLOCK_REALTIME;
+#if !defined(__APPLE__)
+    if (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0)
+        service->clock = CLOCK_MONOTONIC;
+#endif
+    pthread_cond_init(&service->work_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&service->idle_cond, NULL);
+    service->quantum = quantum ? quantum : FF_DECODE_SERVICE_DEFAULT_QUANTUM;
+
+    service->cmd_pool = cmd_pool;
+    if (!service->cmd_pool) {
+        service->cmd_pool = ff_cmd_pool_create(64, 0);
+        service->owns_pool = true;
+        if (!service->cmd_pool) {
+            ff_decode_service_destroy(service);
+            return NULL;
+        }
+    }
+
+    if (thread_count == 0) thread_count = (uint32_t)FFMAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+    thread_count = FFMIN(thread_count, DECODE_SERVICE_MAX_THREADS);
+    for (uint32_t i = 0; i < thread_count; i++) {
+        if (pthread_create(&service->threads[i], NULL, service_worker, service) != 0) {
+            ff_decode_service_destroy(service);
+            return NULL;
+        }
+        service->thread_count++;
+    }
+
+    return service;
+}
+
+void ff_decode_service_destroy(FFDecodeService* service) {
+    if (!service) return;
+
+    pthread_mutex_lock(&service->lock);
+    service->stop = true;
+    pthread_cond_broadcast(&service->work_cond);
+    pthread_mutex_unlock(&service->lock);
+
+    for (uint32_t i = 0; i < service->thread_count; i++)
+        pthread_join(service->threads[i], NULL);
+
+    while (service->streams)
+        ff_decode_service_remove_stream(service, service->streams);
+
+    if (service->owns_pool) ff_cmd_pool_destroy(service->cmd_pool);
+    pthread_cond_destroy(&service->idle_cond);
+    pthread_cond_destroy(&service->work_cond);
+    pthread_mutex_destroy(&service->lock);
+    free(service);
+}
+
+FFDecodeStream* ff_decode_service_add_stream(FFDecodeService* service,
+                                             FFDemuxContext* demux_ctx, int stream_index,
+                                             bool use_hardware, uint32_t input_capacity,
+                                             FFCmdFifo* output, void* opaque) {
+    if (!service || !output || input_capacity == 0) return NULL;
+
+    FFDecodeStream *st = calloc(1, sizeof(FFDecodeStream));
+    if (!st) return NULL;
+    st->service = service;
+    st->output = output;
+    st->opaque = opaque;
+    st->stream_index = stream_index;
+
+    // Hundreds of decoders share a few cores: no per-decoder thread pools
+    FFDecoderSetup setup = { .thread_count = 1 };
+    st->decoder = ff_decoder_create_setup(NULL, demux_ctx, stream_index, use_hardware, NULL, &setup);
+    st->frame = av_frame_alloc();
+    st->input = ff_cmd_fifo_create_monitored(input_capacity, FF_CMD_FIFO_BLOCKING,
+                                             stream_input_arrived, st);
+    if (!st->decoder || !st->frame || !st->input) {
+        ff_cmd_fifo_destroy(st->input);
+        av_frame_free(&st->frame);
+        ff_decoder_destroy(st->decoder);
+        free(st);
+        return NULL;
+    }
+    ff_cmd_fifo_set_flow_enabled(st->input, true);
+
+    pthread_mutex_lock(&service->lock);
+    st->all_next = service->streams;
+    service->streams = st;
+    service->stream_count++;
+    pthread_mutex_unlock(&service->lock);
+    return st;
+}
+
+void ff_decode_service_remove_stream(FFDecodeService* service, FFDecodeStream* stream) {
+    if (!service || !stream) return;
+
+    // No new arrivals, wake producers blocked on a full FIFO and release
+    // what is queued now rather than command by command at destroy
+    ff_cmd_fifo_close(stream->input);
+
+    pthread_mutex_lock(&service->lock);
+    while (stream->state == STREAM_RUNNING)
+        pthread_cond_wait(&service->idle_cond, &service->lock);
+    service_unlink(service, stream);
+    stream->state = STREAM_REMOVED;
+
+    for (FFDecodeStream **link = &service->streams; *link; link = &(*link)->all_next) {
+        if (*link == stream) {
+            *link = stream->all_next;
+            service->stream_count--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&service->lock);
+
+    ff_cmd_fifo_destroy(stream->input);
+    FF_CMD_RELEASE(stream->pending_input);
+    FF_CMD_RELEASE(stream->pending_output);
+    FF_CMD_RELEASE(stream->drain);
+    av_frame_free(&stream->frame);
+    ff_decoder_destroy(stream->decoder);
+    free(stream);
+}
+
+void ff_decode_service_set_decoder_cache(FFDecodeService* service, FFDecoderCache* cache) {
+    if (service) __atomic_store_n(&service->decoder_cache, cache, __ATOMIC_RELEASE);
+}
+
+// -----------------------------------------------------------------------------
+// Info
+// -----------------------------------------------------------------------------
+
+FFCmdFifo* ff_decode_stream_input(FFDecodeStream* stream) {
+    return stream ? stream->input : NULL;
+}
+
+uint32_t ff_decode_service_thread_count(FFDecodeService* service) {
+    return service ? service->thread_count : 0;
+}
+
+uint32_t ff_decode_service_stream_count(FFDecodeService* service) {
+    if (!service) return 0;
+    pthread_mutex_lock(&service->lock);
+    uint32_t count = service->stream_count;
+    pthread_mutex_unlock(&service->lock);
+    return count;
+}
+
+uint64_t ff_decode_stream_packet_count(FFDecodeStream* stream) {
+    return stream ? __atomic_load_n(&stream->packets, __ATOMIC_RELAXED) : 0;
+}
+
+uint64_t ff_decode_stream_frame_count(FFDecodeStream* stream) {
+    return stream ? __atomic_load_n(&stream->frames, __ATOMIC_RELAXED) : 0;
+}
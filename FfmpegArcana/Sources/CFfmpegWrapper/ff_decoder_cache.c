@@ -0,0 +1,309 @@
+/**
+ * ff_decoder_cache.c
+ *
+ * Warm decoder cache: idle decoders are kept on a most-recently-used-first
+ * list, matched by FFDecoderKey and evicted by count and age.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_decoder_cache.h"
+#include <libavutil/time.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+struct FFDecoderCache {
+    pthread_mutex_t mutex;
+    FFDecoderContext *idle;     // Most recently parked first
+    uint32_t idle_count;
+    uint32_t max_idle;
+    int64_t max_idle_us;        // 0 = no age limit
+    uint64_t hits;
+    uint64_t misses;
+};
+
+// -----------------------------------------------------------------------------
+// Idle list
+// -----------------------------------------------------------------------------
+
+// Caller holds cache->mutex. Unlinks aged decoders onto *evicted.
+static uint32_t decoder_cache_collect_aged(FFDecoderCache *cache, int64_t now,
+                                           FFDecoderContext **evicted) {
+    if (!cache->max_idle_us) return 0;
+
+    uint32_t count = 0;
+    FFDecoderContext **link = &cache->idle;
+    while (*link) {
+        FFDecoderContext *dec = *link;
+        if (now - dec->idle_since > cache->max_idle_us) {
+            *link = dec->cache_next;
+            dec->cache_next = *evicted;
+            *evicted = dec;
+            cache->idle_count--;
+            count++;
+        } else {
+            link = &dec->cache_next;
+        }
+    }
+    return count;
+}
+
+// Caller holds cache->mutex. Unlinks the least recently parked decoder.
+static FFDecoderContext *decoder_cache_pop_oldest(FFDecoderCache *cache) {
+    FFDecoderContext **link = &cache->idle;
+    if (!*link) return NULL;
+    while ((*link)->cache_next) link = &(*link)->cache_next;
+
+    FFDecoderContext *dec = *link;
+    *link = NULL;
+    cache->idle_count--;
+    return dec;
+}
+
+// Close decoders outside the lock; avcodec_free_context can be slow
+static void decoder_cache_close_list(FFDecoderContext *list) {
+    while (list) {
+        FFDecoderContext *next = list->cache_next;
+        list->cache_next = NULL;
+        ff_decoder_destroy(list);
+        list = next;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+FFDecoderCache* ff_decoder_cache_create(uint32_t max_idle, double max_idle_seconds) {
+    FFDecoderCache *cache = calloc(1, sizeof(FFDecoderCache));
+    if (!cache) return NULL;
+
+    if (pthread_mutex_init(&cache->mutex, NULL) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    cache->max_idle = max_idle;
+    cache->max_idle_us = max_idle_seconds > 0 ? (int64_t)(max_idle_seconds * 1000000.0) : 0;
+    return cache;
+}
+
+void ff_decoder_cache_destroy(FFDecoderCache *cache) {
+    if (!cache) return;
+    decoder_cache_close_list(cache->idle);
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache);
+}
+
+FFDecoderContext* ff_decoder_cache_acquire(FFDecoderCache *cache, FFDemuxContext *demux_ctx,
+                                           int stream_index, bool use_hardware) {
+    if (!cache) return ff_decoder_create(demux_ctx, stream_index, use_hardware);
+    if (!demux_ctx || !demux_ctx->fmt_ctx) return NULL;
+    if (stream_index < 0 || stream_index >= (int)demux_ctx->fmt_ctx->nb_streams) return NULL;
+
+    AVStream *stream = demux_ctx->fmt_ctx->streams[stream_index];
+    return ff_decoder_cache_acquire_params(cache, stream->codecpar, stream->time_base,
+                                           stream_index, use_hardware);
+}
+
+static FFDecoderContext* decoder_cache_acquire(FFDecoderCache *cache,
+                                               const AVCodecParameters *codecpar,
+                                               AVRational time_base, int stream_index,
+                                               bool use_hardware, int *error) {
+    if (!cache)
+        return ff_decoder_open_params(NULL, codecpar, time_base, stream_index, use_hardware,
+                                      NULL, NULL, error);
+
+    FFDecoderKey key;
+    ff_decoder_key_init(&key, codecpar, use_hardware);
+
+    FFDecoderContext *evicted = NULL;
+    FFDecoderContext *found = NULL;
+
+    pthread_mutex_lock(&cache->mutex);
+    decoder_cache_collect_aged(cache, av_gettime_relative(), &evicted);
+
+    for (FFDecoderContext **link = &cache->idle; *link; link = &(*link)->cache_next) {
+        if (ff_decoder_key_equal(&(*link)->key, &key)) {
+            found = *link;
+            *link = found->cache_next;
+            found->cache_next = NULL;
+            cache->idle_count--;
+            break;
+        }
+    }
+
+    if (found) cache->hits++;
+    else cache->misses++;
+    pthread_mutex_unlock(&cache->mutex);
+
+    decoder_cache_close_list(evicted);
+
+    if (!found)
+        return ff_decoder_open_params(NULL, codecpar, time_base, stream_index, use_hardware,
+                                      NULL, NULL, error);
+
+    // Already flushed when parked; only the stream binding changes
+    found->stream_index = stream_index;
+    found->time_base = time_base;
+    return found;
+}
+
+FFDecoderContext* ff_decoder_cache_acquire_params(FFDecoderCache *cache,
+                                                  const AVCodecParameters *codecpar,
+                                                  AVRational time_base, int stream_index,
+                                                  bool use_hardware) {
+    if (!codecpar) return NULL;
+    return decoder_cache_acquire(cache, codecpar, time_base, stream_index, use_hardware, NULL);
+}
+
+void ff_decoder_cache_release(FFDecoderCache *cache, FFDecoderContext *decoder) {
+    if (!decoder) return;
+    if (!cache || decoder->frame_pool || decoder->arena || !decoder->codec_ctx) {
+        ff_decoder_destroy(decoder);
+        return;
+    }
+
+    avcodec_flush_buffers(decoder->codec_ctx);
+
+    FFDecoderContext *evicted = NULL;
+    int64_t now = av_gettime_relative();
+
+    pthread_mutex_lock(&cache->mutex);
+    decoder_cache_collect_aged(cache, now, &evicted);
+
+    if (cache->max_idle == 0) {
+        decoder->cache_next = evicted;
+        evicted = decoder;
+    } else {
+        if (cache->idle_count >= cache->max_idle) {
+            FFDecoderContext *oldest = decoder_cache_pop_oldest(cache);
+            oldest->cache_next = evicted;
+            evicted = oldest;
+        }
+        decoder->idle_since = now;
+        decoder->cache_next = cache->idle;
+        cache->idle = decoder;
+        cache->idle_count++;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+
+    decoder_cache_close_list(evicted);
+}
+
+uint32_t ff_decoder_cache_trim(FFDecoderCache *cache) {
+    if (!cache) return 0;
+
+    FFDecoderContext *evicted = NULL;
+    pthread_mutex_lock(&cache->mutex);
+    uint32_t count = decoder_cache_collect_aged(cache, av_gettime_relative(), &evicted);
+    pthread_mutex_unlock(&cache->mutex);
+
+    decoder_cache_close_list(evicted);
+    return count;
+}
+
+uint32_t ff_decoder_cache_idle_count(FFDecoderCache *cache) {
+    if (!cache) return 0;
+    pthread_mutex_lock(&cache->mutex);
+    uint32_t count = cache->idle_count;
+    pthread_mutex_unlock(&cache->mutex);
+    return count;
+}
+
+uint64_t ff_decoder_cache_hit_count(FFDecoderCache *cache) {
+    if (!cache) return 0;
+    pthread_mutex_lock(&cache->mutex);
+    uint64_t hits = cache->hits;
+    pthread_mutex_unlock(&cache->mutex);
+    return hits;
+}
+
+uint64_t ff_decoder_cache_miss_count(FFDecoderCache *cache) {
+    if (!cache) return 0;
+    pthread_mutex_lock(&cache->mutex);
+    uint64_t misses = cache->misses;
+    pthread_mutex_unlock(&cache->mutex);
+    return misses;
+}
+
+// -----------------------------------------------------------------------------
+// Reconfiguration
+// -----------------------------------------------------------------------------
+
+// Codecs that carry their geometry in the bitstream (sequence headers, frame
+// headers) and re-initialise themselves when it changes
+static bool codec_follows_inband_changes(enum AVCodecID codec_id) {
+    switch (codec_id) {
+    case AV_CODEC_ID_H264:
+    case AV_CODEC_ID_HEVC:
+    case AV_CODEC_ID_VP8:
+    case AV_CODEC_ID_VP9:
+    case AV_CODEC_ID_AV1:
+    case AV_CODEC_ID_MPEG2VIDEO:
+    case AV_CODEC_ID_MPEG4:
+    case AV_CODEC_ID_MJPEG:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int ff_decoder_reconfigure(FFDecoderContext *decoder, const AVCodecParameters *codecpar,
+                           FFDecoderCache *cache) {
+    if (!decoder || !decoder->codec_ctx || !codecpar) return AVERROR(EINVAL);
+
+    FFDecoderKey key;
+    ff_decoder_key_init(&key, codecpar, decoder->key.use_hardware);
+    if (ff_decoder_key_equal(&key, &decoder->key)) return FF_DECODER_RECONFIG_NONE;
+
+    // Same codec and same out-of-band headers: the decoder picks the new
+    // geometry up from the next keyframe on its own
+    if (key.codec_id == decoder->key.codec_id &&
+        key.extradata_size == decoder->key.extradata_size &&
+        key.extradata_hash == decoder->key.extradata_hash &&
+        codec_follows_inband_changes(key.codec_id)) {
+        avcodec_flush_buffers(decoder->codec_ctx);
+        decoder->key = key;
+        return FF_DECODER_RECONFIG_IN_PLACE;
+    }
+
+    // Pooled get_buffer2 must be installed before avcodec_open2, so pooled
+    // decoders always open fresh; everything else may come out of the cache
+    FFDecoderContext *fresh;
+    int ret = AVERROR(EINVAL);
+    if (decoder->frame_pool) {
+        FFDecoderSetup setup = {
+            .thread_count = decoder->codec_ctx->thread_count,
+            .thread_type = decoder->codec_ctx->thread_type,
+            .flags = decoder->codec_ctx->flags,
+            .flags2 = decoder->codec_ctx->flags2,
+        };
+        fresh = ff_decoder_open_params(NULL, codecpar, decoder->time_base, decoder->stream_index,
+                                       decoder->key.use_hardware, decoder->frame_pool, &setup, &ret);
+    } else {
+        fresh = decoder_cache_acquire(cache, codecpar, decoder->time_base, decoder->stream_index,
+                                      decoder->key.use_hardware, &ret);
+    }
+    if (!fresh) return ret;
+
+    // The handle callers hold stays put; only the codec state moves
+    AVCodecContext *codec_ctx = decoder->codec_ctx;
+    AVBufferRef *hw_device_ctx = decoder->hw_device_ctx;
+    bool is_hardware = decoder->is_hardware;
+    FFDecoderKey old_key = decoder->key;
+
+    decoder->codec_ctx = fresh->codec_ctx;
+    decoder->hw_device_ctx = fresh->hw_device_ctx;
+    decoder->is_hardware = fresh->is_hardware;
+    decoder->key = fresh->key;
+    if (decoder->frame_pool) decoder->codec_ctx->opaque = decoder;
+
+    fresh->codec_ctx = codec_ctx;
+    fresh->hw_device_ctx = hw_device_ctx;
+    fresh->is_hardware = is_hardware;
+    fresh->key = old_key;
+
+    // Park the previous rendition's context for when the stream switches back
+    ff_decoder_cache_release(cache, fresh);
+    return FF_DECODER_RECONFIG_REOPENED;
+}
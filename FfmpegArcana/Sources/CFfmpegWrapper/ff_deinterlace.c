@@ -0,0 +1,577 @@
+/**
+ * ff_deinterlace.c
+ *
+ * Lines of the kept field are copied; the other field's lines are rebuilt:
+ *   BOB    average of the kept lines above and below
+ *   BLEND  every line becomes (above + 2 * line + below) / 4, fields mixed
+ *   YADIF  as libavfilter's vf_yadif: the best of five edge directions
+ *          through the kept lines, clamped to how far the missing pixel
+ *          moved between the previous and next fields
+ * The frame window is prev / cur / next. BOB and BLEND only use cur, so
+ * they emit as soon as a frame is sent; YADIF waits for next. Neighbours
+ * of a different geometry (stream change) or missing at either end of the
+ * stream are replaced by cur. Output is produced on receive, straight
+ * into the caller's frame.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_deinterlace.h"
+#include <libavutil/mem.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define DEINT_NEON 1
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define DEINT_SSE2 1
+#endif
+
+#define SLICES_PER_THREAD   4
+#define MAX_PLANES          3
+
+typedef struct {
+    int count;
+    int width[MAX_PLANES];      // In bytes
+    int height[MAX_PLANES];
+    int step[MAX_PLANES];       // Bytes between horizontally adjacent samples
+} PlaneLayout;
+
+typedef struct {
+    const AVFrame *prev, *cur, *next;
+    AVFrame *dst;
+    PlaneLayout layout;
+    int parity;                 // Kept field: 0 top (even lines), 1 bottom
+    bool tff;
+} DeintJob;
+
+struct FFDeinterlacer {
+    FFDeinterlaceMode mode;
+    bool double_rate;
+    FFFieldOrder order;
+
+    FFSlicePool *pool;
+    int nb_workers;
+
+    AVFrame *prev, *cur, *next;
+    bool eof;
+
+    // Outputs owed for cur
+    int fields_total;
+    int fields_left;
+    bool cur_progressive;
+    bool cur_tff;
+
+    DeintJob job;
+};
+
+static bool plane_layout(int format, int w, int h, PlaneLayout *pl) {
+    int cw = (w + 1) >> 1, ch = (h + 1) >> 1;
+    switch (format) {
+    case AV_PIX_FMT_YUV420P:
+        *pl = (PlaneLayout){ 3, { w, cw, cw }, { h, ch, ch }, { 1, 1, 1 } };
+        return true;
+    case AV_PIX_FMT_YUV422P:
+        *pl = (PlaneLayout){ 3, { w, cw, cw }, { h, h, h }, { 1, 1, 1 } };
+        return true;
+    case AV_PIX_FMT_YUV444P:
+        *pl = (PlaneLayout){ 3, { w, w, w }, { h, h, h }, { 1, 1, 1 } };
+        return true;
+    case AV_PIX_FMT_NV12:
+        *pl = (PlaneLayout){ 2, { w, 2 * cw }, { h, ch }, { 1, 2 } };
+        return true;
+    case AV_PIX_FMT_GRAY8:
+        *pl = (PlaneLayout){ 1, { w }, { h }, { 1 } };
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool ff_deinterlacer_supports_format(int format) {
+    PlaneLayout pl;
+    return plane_layout(format, 2, 2, &pl);
+}
+
+static bool same_geometry(const AVFrame *a, const AVFrame *b) {
+    return a->format == b->format && a->width == b->width && a->height == b->height;
+}
+
+static inline const uint8_t* plane_row(const AVFrame *f, int p, int y) {
+    return f->data[p] + (ptrdiff_t)y * f->linesize[p];
+}
+
+// ----------------------------------------------------------------------------
+// BOB and BLEND
+// ----------------------------------------------------------------------------
+
+static void bob_row(uint8_t *dst, const uint8_t *a, const uint8_t *b, int n) {
+    int x = 0;
+#if defined(DEINT_NEON)
+    for (; x + 16 <= n; x += 16)
+        vst1q_u8(dst + x, vrhaddq_u8(vld1q_u8(a + x), vld1q_u8(b + x)));
+#elif defined(DEINT_SSE2)
+    for (; x + 16 <= n; x += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + x));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + x));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_avg_epu8(va, vb));
+    }
+#endif
+    for (; x < n; x++) dst[x] = (uint8_t)((a[x] + b[x] + 1) >> 1);
+}
+
+static void blend_row(uint8_t *dst, const uint8_t *a, const uint8_t *c, const uint8_t *b, int n) {
+    int x = 0;
+#if defined(DEINT_NEON)
+    for (; x + 16 <= n; x += 16) {
+        uint8x16_t va = vld1q_u8(a + x), vc = vld1q_u8(c + x), vb = vld1q_u8(b + x);
+        uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(va), vget_low_u8(vb)),
+                                  vshll_n_u8(vget_low_u8(vc), 1));
+        uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(va), vget_high_u8(vb)),
+                                  vshll_n_u8(vget_high_u8(vc), 1));
+        vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+    }
+#elif defined(DEINT_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    for (; x + 16 <= n; x += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + x));
+        __m128i vc = _mm_loadu_si128((const __m128i *)(c + x));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + x));
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+        lo = _mm_add_epi16(lo, _mm_slli_epi16(_mm_unpacklo_epi8(vc, zero), 1));
+        hi = _mm_add_epi16(hi, _mm_slli_epi16(_mm_unpackhi_epi8(vc, zero), 1));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < n; x++) dst[x] = (uint8_t)((a[x] + 2 * c[x] + b[x] + 2) >> 2);
+}
+
+// ----------------------------------------------------------------------------
+// YADIF
+// ----------------------------------------------------------------------------
+
+// One missing line. The prev2/next2 lines are the same missing line in the
+// fields before and after this one; the *_m/*_p lines are one line above
+// and below it.
+typedef struct {
+    const uint8_t *cur_m, *cur_p;
+    const uint8_t *prev_m, *prev_p;
+    const uint8_t *next_m, *next_p;
+    const uint8_t *prev2, *next2;
+    const uint8_t *prev2_mm, *prev2_pp;     // Two lines up and down, for the
+    const uint8_t *next2_mm, *next2_pp;     // spatial interlacing check
+    int n;
+    int step;
+    bool spatial_check;
+} YadifRow;
+
+static inline int yadif_clamp_x(const YadifRow *r, int x) {
+    while (x < 0) x += r->step;
+    while (x >= r->n) x -= r->step;
+    return x;
+}
+
+// Edge direction j: difference along the line through (x + j, y - 1) and
+// (x - j, y + 1), summed over three neighbouring columns
+static inline int yadif_dir_score(const YadifRow *r, int x, int j) {
+    int s = r->step, score = 0;
+    for (int k = -1; k <= 1; k++)
+        score += abs(r->cur_m[yadif_clamp_x(r, x + (k + j) * s)] -
+                     r->cur_p[yadif_clamp_x(r, x + (k - j) * s)]);
+    return score;
+}
+
+static inline int yadif_dir_pred(const YadifRow *r, int x, int j) {
+    int s = r->step;
+    return (r->cur_m[yadif_clamp_x(r, x + j * s)] + r->cur_p[yadif_clamp_x(r, x - j * s)]) >> 1;
+}
+
+static uint8_t yadif_pixel(const YadifRow *r, int x) {
+    int c = r->cur_m[x], e = r->cur_p[x];
+    int d = (r->prev2[x] + r->next2[x]) >> 1;
+    int td0 = abs(r->prev2[x] - r->next2[x]);
+    int td1 = (abs(r->prev_m[x] - c) + abs(r->prev_p[x] - e)) >> 1;
+    int td2 = (abs(r->next_m[x] - c) + abs(r->next_p[x] - e)) >> 1;
+    int diff = FFMAX3(td0 >> 1, td1, td2);
+
+    // The shallower angle is only tried when the steeper one already won
+    int score = yadif_dir_score(r, x, 0) - 1;
+    int pred = (c + e) >> 1;
+    int sc = yadif_dir_score(r, x, -1);
+    if (sc < score) {
+        score = sc;
+        pred = yadif_dir_pred(r, x, -1);
+        sc = yadif_dir_score(r, x, -2);
+        if (sc < score) {
+            score = sc;
+            pred = yadif_dir_pred(r, x, -2);
+        }
+    }
+    sc = yadif_dir_score(r, x, 1);
+    if (sc < score) {
+        score = sc;
+        pred = yadif_dir_pred(r, x, 1);
+        sc = yadif_dir_score(r, x, 2);
+        if (sc < score) pred = yadif_dir_pred(r, x, 2);
+    }
+
+    if (r->spatial_check) {
+        int b = (r->prev2_mm[x] + r->next2_mm[x]) >> 1;
+        int f = (r->prev2_pp[x] + r->next2_pp[x]) >> 1;
+        int mx = FFMAX3(d - e, d - c, FFMIN(b - c, f - e));
+        int mn = FFMIN3(d - e, d - c, FFMAX(b - c, f - e));
+        diff = FFMAX3(diff, mn, -mx);
+    }
+    return (uint8_t)av_clip(pred, d - diff, d + diff);
+}
+
+#if defined(DEINT_SSE2)
+static inline __m128i yadif_load(const uint8_t *p) {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+}
+
+static inline __m128i yadif_absdiff(__m128i a, __m128i b) {
+    return _mm_max_epi16(_mm_sub_epi16(a, b), _mm_sub_epi16(b, a));
+}
+
+static inline __m128i yadif_select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i yadif_score_vec(const YadifRow *r, int x, int j) {
+    int s = r->step;
+    __m128i sum = yadif_absdiff(yadif_load(r->cur_m + x + (j - 1) * s), yadif_load(r->cur_p + x + (-j - 1) * s));
+    sum = _mm_add_epi16(sum, yadif_absdiff(yadif_load(r->cur_m + x + j * s), yadif_load(r->cur_p + x - j * s)));
+    return _mm_add_epi16(sum, yadif_absdiff(yadif_load(r->cur_m + x + (j + 1) * s), yadif_load(r->cur_p + x + (1 - j) * s)));
+}
+
+static inline __m128i yadif_pred_vec(const YadifRow *r, int x, int j) {
+    int s = r->step;
+    return _mm_srli_epi16(_mm_add_epi16(yadif_load(r->cur_m + x + j * s), yadif_load(r->cur_p + x - j * s)), 1);
+}
+
+// Eight pixels at x, which must be at least 3 samples from either end
+static inline void yadif_vec(uint8_t *dst, const YadifRow *r, int x) {
+    __m128i c = yadif_load(r->cur_m + x), e = yadif_load(r->cur_p + x);
+    __m128i p2 = yadif_load(r->prev2 + x), n2 = yadif_load(r->next2 + x);
+    __m128i d = _mm_srli_epi16(_mm_add_epi16(p2, n2), 1);
+    __m128i td0 = _mm_srli_epi16(yadif_absdiff(p2, n2), 1);
+    __m128i td1 = _mm_srli_epi16(_mm_add_epi16(yadif_absdiff(yadif_load(r->prev_m + x), c),
+                                               yadif_absdiff(yadif_load(r->prev_p + x), e)), 1);
+    __m128i td2 = _mm_srli_epi16(_mm_add_epi16(yadif_absdiff(yadif_load(r->next_m + x), c),
+                                               yadif_absdiff(yadif_load(r->next_p + x), e)), 1);
+    __m128i diff = _mm_max_epi16(td0, _mm_max_epi16(td1, td2));
+
+    __m128i score = _mm_sub_epi16(yadif_score_vec(r, x, 0), _mm_set1_epi16(1));
+    __m128i pred = _mm_srli_epi16(_mm_add_epi16(c, e), 1);
+    for (int dir = -1; dir <= 1; dir += 2) {
+        __m128i sc = yadif_score_vec(r, x, dir);
+        __m128i won = _mm_cmplt_epi16(sc, score);
+        score = yadif_select(won, sc, score);
+        pred = yadif_select(won, yadif_pred_vec(r, x, dir), pred);
+        sc = yadif_score_vec(r, x, 2 * dir);
+        won = _mm_and_si128(won, _mm_cmplt_epi16(sc, score));
+        score = yadif_select(won, sc, score);
+        pred = yadif_select(won, yadif_pred_vec(r, x, 2 * dir), pred);
+    }
+
+    if (r->spatial_check) {
+        __m128i b = _mm_srli_epi16(_mm_add_epi16(yadif_load(r->prev2_mm + x), yadif_load(r->next2_mm + x)), 1);
+        __m128i f = _mm_srli_epi16(_mm_add_epi16(yadif_load(r->prev2_pp + x), yadif_load(r->next2_pp + x)), 1);
+        __m128i de = _mm_sub_epi16(d, e), dc = _mm_sub_epi16(d, c);
+        __m128i bc = _mm_sub_epi16(b, c), fe = _mm_sub_epi16(f, e);
+        __m128i mx = _mm_max_epi16(_mm_max_epi16(de, dc), _mm_min_epi16(bc, fe));
+        __m128i mn = _mm_min_epi16(_mm_min_epi16(de, dc), _mm_max_epi16(bc, fe));
+        diff = _mm_max_epi16(_mm_max_epi16(diff, mn), _mm_sub_epi16(_mm_setzero_si128(), mx));
+    }
+    pred = _mm_max_epi16(pred, _mm_sub_epi16(d, diff));
+    pred = _mm_min_epi16(pred, _mm_add_epi16(d, diff));
+    _mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(pred, pred));
+}
+#elif defined(DEINT_NEON)
+static inline int16x8_t yadif_load(const uint8_t *p) {
+    return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+}
+
+static inline int16x8_t yadif_score_vec(const YadifRow *r, int x, int j) {
+    int s = r->step;
+    int16x8_t sum = vabdq_s16(yadif_load(r->cur_m + x + (j - 1) * s), yadif_load(r->cur_p + x + (-j - 1) * s));
+    sum = vabaq_s16(sum, yadif_load(r->cur_m + x + j * s), yadif_load(r->cur_p + x - j * s));
+    return vabaq_s16(sum, yadif_load(r->cur_m + x + (j + 1) * s), yadif_load(r->cur_p + x + (1 - j) * s));
+}
+
+static inline int16x8_t yadif_pred_vec(const YadifRow *r, int x, int j) {
+    int s = r->step;
+    return vshrq_n_s16(vaddq_s16(yadif_load(r->cur_m + x + j * s), yadif_load(r->cur_p + x - j * s)), 1);
+}
+
+static inline void yadif_vec(uint8_t *dst, const YadifRow *r, int x) {
+    int16x8_t c = yadif_load(r->cur_m + x), e = yadif_load(r->cur_p + x);
+    int16x8_t p2 = yadif_load(r->prev2 + x), n2 = yadif_load(r->next2 + x);
+    int16x8_t d = vshrq_n_s16(vaddq_s16(p2, n2), 1);
+    int16x8_t td0 = vshrq_n_s16(vabdq_s16(p2, n2), 1);
+    int16x8_t td1 = vshrq_n_s16(vaddq_s16(vabdq_s16(yadif_load(r->prev_m + x), c),
+                                          vabdq_s16(yadif_load(r->prev_p + x), e)), 1);
+    int16x8_t td2 = vshrq_n_s16(vaddq_s16(vabdq_s16(yadif_load(r->next_m + x), c),
+                                          vabdq_s16(yadif_load(r->next_p + x), e)), 1);
+    int16x8_t diff = vmaxq_s16(td0, vmaxq_s16(td1, td2));
+
+    int16x8_t score = vsubq_s16(yadif_score_vec(r, x, 0), vdupq_n_s16(1));
+    int16x8_t pred = vshrq_n_s16(vaddq_s16(c, e), 1);
+    for (int dir = -1; dir <= 1; dir += 2) {
+        int16x8_t sc = yadif_score_vec(r, x, dir);
+        uint16x8_t won = vcltq_s16(sc, score);
+        score = vbslq_s16(won, sc, score);
+        pred = vbslq_s16(won, yadif_pred_vec(r, x, dir), pred);
+        sc = yadif_score_vec(r, x, 2 * dir);
+        won = vandq_u16(won, vcltq_s16(sc, score));
+        score = vbslq_s16(won, sc, score);
+        pred = vbslq_s16(won, yadif_pred_vec(r, x, 2 * dir), pred);
+    }
+
+    if (r->spatial_check) {
+        int16x8_t b = vshrq_n_s16(vaddq_s16(yadif_load(r->prev2_mm + x), yadif_load(r->next2_mm + x)), 1);
+        int16x8_t f = vshrq_n_s16(vaddq_s16(yadif_load(r->prev2_pp + x), yadif_load(r->next2_pp + x)), 1);
+        int16x8_t de = vsubq_s16(d, e), dc = vsubq_s16(d, c);
+        int16x8_t bc = vsubq_s16(b, c), fe = vsubq_s16(f, e);
+        int16x8_t mx = vmaxq_s16(vmaxq_s16(de, dc), vminq_s16(bc, fe));
+        int16x8_t mn = vminq_s16(vminq_s16(de, dc), vmaxq_s16(bc, fe));
+        diff = vmaxq_s16(vmaxq_s16(diff, mn), vnegq_s16(mx));
+    }
+    pred = vminq_s16(vmaxq_s16(pred, vsubq_s16(d, diff)), vaddq_s16(d, diff));
+    vst1_u8(dst, vqmovun_s16(pred));
+}
+#endif
+
+static void yadif_row(uint8_t *dst, const YadifRow *r) {
+    int n = r->n, x = 0;
+    // Direction scores reach 3 samples either side
+    int edge = FFMIN(3 * r->step, n);
+    for (; x < edge; x++) dst[x] = yadif_pixel(r, x);
+#if defined(DEINT_SSE2) || defined(DEINT_NEON)
+    for (; x + 8 + 3 * r->step <= n; x += 8) yadif_vec(dst + x, r, x);
+#endif
+    for (; x < n; x++) dst[x] = yadif_pixel(r, x);
+}
+
+// ----------------------------------------------------------------------------
+// Slices
+// ----------------------------------------------------------------------------
+
+static void deint_line(const FFDeinterlacer *di, const DeintJob *job, int p, int y) {
+    int h = job->layout.height[p], n = job->layout.width[p];
+    uint8_t *dst = job->dst->data[p] + (ptrdiff_t)y * job->dst->linesize[p];
+    const AVFrame *cur = job->cur;
+
+    if (di->mode == FF_DEINTERLACE_BLEND) {
+        int up = y > 0 ? y - 1 : FFMIN(1, h - 1);
+        int down = y + 1 < h ? y + 1 : FFMAX(h - 2, 0);
+        blend_row(dst, plane_row(cur, p, up), plane_row(cur, p, y), plane_row(cur, p, down), n);
+        return;
+    }
+    if (((y ^ job->parity) & 1) == 0 || h < 2) {
+        memcpy(dst, plane_row(cur, p, y), n);
+        return;
+    }
+
+    // Missing line: a kept line is always on at least one side
+    int up = y > 0 ? y - 1 : y + 1;
+    int down = y + 1 < h ? y + 1 : y - 1;
+    if (di->mode == FF_DEINTERLACE_BOB) {
+        bob_row(dst, plane_row(cur, p, up), plane_row(cur, p, down), n);
+        return;
+    }
+
+    // The field being rebuilt sits between the previous field of the other
+    // parity and the next one; which frames hold those depends on whether
+    // this is the frame's first or second field
+    bool from_prev = job->parity ^ job->tff;
+    const AVFrame *prev2 = from_prev ? job->prev : cur;
+    const AVFrame *next2 = from_prev ? cur : job->next;
+    bool check = y >= 2 && y + 2 < h;
+    YadifRow r = {
+        .cur_m = plane_row(cur, p, up), .cur_p = plane_row(cur, p, down),
+        .prev_m = plane_row(job->prev, p, up), .prev_p = plane_row(job->prev, p, down),
+        .next_m = plane_row(job->next, p, up), .next_p = plane_row(job->next, p, down),
+        .prev2 = plane_row(prev2, p, y), .next2 = plane_row(next2, p, y),
+        .prev2_mm = plane_row(prev2, p, check ? y - 2 : y),
+        .prev2_pp = plane_row(prev2, p, check ? y + 2 : y),
+        .next2_mm = plane_row(next2, p, check ? y - 2 : y),
+        .next2_pp = plane_row(next2, p, check ? y + 2 : y),
+        .n = n,
+        .step = job->layout.step[p],
+        .spatial_check = check
+    };
+    yadif_row(dst, &r);
+}
+
+static void deint_slice(void *opaque, int slice, int nb_slices, int worker) {
+    const FFDeinterlacer *di = opaque;
+    const DeintJob *job = &di->job;
+    for (int p = 0; p < job->layout.count; p++) {
+        int h = job->layout.height[p];
+        int y0 = (int)((int64_t)h * slice / nb_slices);
+        int y1 = (int)((int64_t)h * (slice + 1) / nb_slices);
+        for (int y = y0; y < y1; y++) deint_line(di, job, p, y);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Frame window
+// ----------------------------------------------------------------------------
+
+// Half the frame period, from the frame's duration or its neighbours' pts
+static int64_t field_duration(const FFDeinterlacer *di) {
+    const AVFrame *cur = di->cur;
+    if (cur->duration > 0) return cur->duration / 2;
+    if (cur->pts == AV_NOPTS_VALUE) return 0;
+    if (di->next && di->next->pts != AV_NOPTS_VALUE && di->next->pts > cur->pts)
+        return (di->next->pts - cur->pts) / 2;
+    if (di->prev && di->prev->pts != AV_NOPTS_VALUE && di->prev->pts < cur->pts)
+        return (cur->pts - di->prev->pts) / 2;
+    return 0;
+}
+
+static void deint_schedule(FFDeinterlacer *di) {
+    FFFieldOrder order = di->order;
+    if (order == FF_FIELD_ORDER_AUTO) {
+        if (!(di->cur->flags & AV_FRAME_FLAG_INTERLACED))
+            order = FF_FIELD_ORDER_PROGRESSIVE;
+        else if (di->cur->flags & AV_FRAME_FLAG_TOP_FIELD_FIRST)
+            order = FF_FIELD_ORDER_TOP_FIRST;
+        else
+            order = FF_FIELD_ORDER_BOTTOM_FIRST;
+    }
+    di->cur_progressive = order == FF_FIELD_ORDER_PROGRESSIVE;
+    di->cur_tff = order != FF_FIELD_ORDER_BOTTOM_FIRST;
+    // Progressive frames are repeated in double rate to keep the rate constant
+    di->fields_total = di->double_rate && di->mode != FF_DEINTERLACE_BLEND ? 2 : 1;
+    di->fields_left = di->fields_total;
+}
+
+static void deint_clear(FFDeinterlacer *di) {
+    av_frame_free(&di->prev);
+    av_frame_free(&di->cur);
+    av_frame_free(&di->next);
+    di->fields_left = 0;
+    di->eof = false;
+}
+
+// ----------------------------------------------------------------------------
+// API
+// ----------------------------------------------------------------------------
+
+FFDeinterlacer* ff_deinterlacer_create(FFDeinterlaceMode mode, bool double_rate, int threads) {
+    if (mode != FF_DEINTERLACE_BOB && mode != FF_DEINTERLACE_BLEND && mode != FF_DEINTERLACE_YADIF)
+        return NULL;
+
+    FFDeinterlacer *di = av_mallocz(sizeof(FFDeinterlacer));
+    if (!di) return NULL;
+
+    di->mode = mode;
+    di->double_rate = double_rate;
+    di->order = FF_FIELD_ORDER_AUTO;
+
+    di->pool = ff_slice_pool_create(threads);
+    if (!di->pool) {
+        av_free(di);
+        return NULL;
+    }
+    di->nb_workers = ff_slice_pool_threads(di->pool);
+    return di;
+}
+
+void ff_deinterlacer_destroy(FFDeinterlacer* di) {
+    if (!di) return;
+    deint_clear(di);
+    ff_slice_pool_destroy(di->pool);
+    av_free(di);
+}
+
+void ff_deinterlacer_set_field_order(FFDeinterlacer* di, FFFieldOrder order) {
+    if (di) di->order = order;
+}
+
+int ff_deinterlacer_send_frame(FFDeinterlacer* di, const AVFrame* frame) {
+    if (!di) return AVERROR(EINVAL);
+    if (di->fields_left > 0) return AVERROR(EAGAIN);
+    if (di->eof) return AVERROR_EOF;
+
+    AVFrame *ref = NULL;
+    if (frame) {
+        if (!ff_deinterlacer_supports_format(frame->format) ||
+            frame->width <= 0 || frame->height <= 0)
+            return AVERROR(EINVAL);
+        ref = av_frame_clone(frame);
+        if (!ref) return AVERROR(ENOMEM);
+    } else {
+        di->eof = true;
+    }
+
+    av_frame_free(&di->prev);
+    di->prev = di->cur;
+    if (di->mode == FF_DEINTERLACE_YADIF) {
+        di->cur = di->next;
+        di->next = ref;
+    } else {
+        di->cur = ref;
+    }
+    if (di->cur) deint_schedule(di);
+    return 0;
+}
+
+int ff_deinterlacer_receive_frame(FFDeinterlacer* di, AVFrame* frame) {
+    if (!di || !frame) return AVERROR(EINVAL);
+    if (di->fields_left == 0) return di->eof ? AVERROR_EOF : AVERROR(EAGAIN);
+
+    const AVFrame *cur = di->cur;
+    int index = di->fields_total - di->fields_left;
+    di->fields_left--;
+    av_frame_unref(frame);
+
+    int ret;
+    if (di->cur_progressive) {
+        ret = av_frame_ref(frame, cur);
+        if (ret < 0) return ret;
+    } else {
+        frame->format = cur->format;
+        frame->width = cur->width;
+        frame->height = cur->height;
+        ret = av_frame_get_buffer(frame, 0);
+        if (ret < 0) return ret;
+        ret = av_frame_copy_props(frame, cur);
+        if (ret < 0) {
+            av_frame_unref(frame);
+            return ret;
+        }
+
+        DeintJob *job = &di->job;
+        plane_layout(cur->format, cur->width, cur->height, &job->layout);
+        job->cur = cur;
+        job->prev = di->prev && same_geometry(di->prev, cur) ? di->prev : cur;
+        job->next = di->next && same_geometry(di->next, cur) ? di->next : cur;
+        job->dst = frame;
+        job->tff = di->cur_tff;
+        job->parity = di->cur_tff ? index : !index;
+        ff_slice_pool_run(di->pool, deint_slice, di,
+                          FFMIN(cur->height, di->nb_workers * SLICES_PER_THREAD));
+        memset(job, 0, sizeof(*job));
+        frame->flags &= ~(AV_FRAME_FLAG_INTERLACED | AV_FRAME_FLAG_TOP_FIELD_FIRST);
+    }
+
+    if (di->fields_total == 2) {
+        int64_t half = field_duration(di);
+        if (frame->pts != AV_NOPTS_VALUE) frame->pts += index * half;
+        frame->duration = half;
+    }
+    return 0;
+}
+
+void ff_deinterlacer_flush(FFDeinterlacer* di) {
+    if (di) deint_clear(di);
+}
@@ -0,0 +1,220 @@
+/**
+ * ff_demux_cache.c
+ *
+ * Demuxer cache: parked contexts sit on an LRU list (most recent at the
+ * head) and are matched by FFDemuxKey.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_demux_cache.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+struct FFDemuxCache {
+    pthread_mutex_t mutex;
+    FFDemuxContext *head;       // Most recently parked
+    FFDemuxContext *tail;       // Eviction candidate
+    uint32_t open_count;
+    uint32_t max_open;
+    uint64_t hits;
+    uint64_t misses;
+};
+
+// -----------------------------------------------------------------------------
+// File identity
+// -----------------------------------------------------------------------------
+
+// Fills everything but the path; fails for anything that is not a regular file
+static int demux_key_stat(const char *url, FFDemuxKey *key) {
+    const char *path = url;
+    if (!strncmp(path, "file:", 5)) path += 5;
+
+    struct stat st;
+    if (stat(path, &st) != 0) return AVERROR(errno);
+    if (!S_ISREG(st.st_mode)) return AVERROR(EINVAL);
+
+    key->path = NULL;
+    key->dev = (uint64_t)st.st_dev;
+    key->ino = (uint64_t)st.st_ino;
+    key->size = (int64_t)st.st_size;
+#if defined(__APPLE__)
+    key->mtime_ns = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    key->mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return 0;
+}
+
+static bool demux_key_matches(const FFDemuxKey *cached, const FFDemuxKey *key, const char *url) {
+    return cached->path && !strcmp(cached->path, url) &&
+           cached->dev == key->dev && cached->ino == key->ino &&
+           cached->mtime_ns == key->mtime_ns && cached->size == key->size;
+}
+
+// -----------------------------------------------------------------------------
+// LRU list (caller holds cache->mutex)
+// -----------------------------------------------------------------------------
+
+static void demux_cache_unlink(FFDemuxCache *cache, FFDemuxContext *ctx) {
+    if (ctx->cache_prev) ctx->cache_prev->cache_next = ctx->cache_next;
+    else cache->head = ctx->cache_next;
+    if (ctx->cache_next) ctx->cache_next->cache_prev = ctx->cache_prev;
+    else cache->tail = ctx->cache_prev;
+
+    ctx->cache_prev = ctx->cache_next = NULL;
+    cache->open_count--;
+}
+
+static void demux_cache_push_front(FFDemuxCache *cache, FFDemuxContext *ctx) {
+    ctx->cache_prev = NULL;
+    ctx->cache_next = cache->head;
+    if (cache->head) cache->head->cache_prev = ctx;
+    else cache->tail = ctx;
+    cache->head = ctx;
+    cache->open_count++;
+}
+
+// -----------------------------------------------------------------------------
+// Rewind
+// -----------------------------------------------------------------------------
+
+static int demux_rewind(FFDemuxContext *ctx) {
+    AVFormatContext *fmt_ctx = ctx->fmt_ctx;
+    if (!fmt_ctx) return AVERROR(EINVAL);
+
+    int64_t start = fmt_ctx->start_time != AV_NOPTS_VALUE ? fmt_ctx->start_time : 0;
+    int ret = avformat_seek_file(fmt_ctx, -1, INT64_MIN, start, start, 0);
+    if (ret < 0) ret = av_seek_frame(fmt_ctx, -1, start, AVSEEK_FLAG_BACKWARD);
+    if (ret < 0) return ret;
+
+    avformat_flush(fmt_ctx);
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+FFDemuxCache* ff_demux_cache_create(uint32_t max_open) {
+    FFDemuxCache *cache = calloc(1, sizeof(FFDemuxCache));
+    if (!cache) return NULL;
+
+    if (pthread_mutex_init(&cache->mutex, NULL) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    cache->max_open = max_open;
+    return cache;
+}
+
+void ff_demux_cache_destroy(FFDemuxCache *cache) {
+    if (!cache) return;
+
+    FFDemuxContext *ctx = cache->head;
+    while (ctx) {
+        FFDemuxContext *next = ctx->cache_next;
+        ctx->cache_prev = ctx->cache_next = NULL;
+        ff_demux_destroy(ctx);
+        ctx = next;
+    }
+
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache);
+}
+
+int ff_demux_cache_open(FFDemuxCache *cache, const char *url, FFDemuxContext **out) {
+    if (!url || !out) return AVERROR(EINVAL);
+    *out = NULL;
+
+    FFDemuxKey key;
+    bool cacheable = cache && demux_key_stat(url, &key) == 0;
+
+    if (cacheable) {
+        FFDemuxContext *found = NULL;
+
+        pthread_mutex_lock(&cache->mutex);
+        for (FFDemuxContext *ctx = cache->head; ctx; ctx = ctx->cache_next) {
+            if (demux_key_matches(&ctx->key, &key, url)) {
+                found = ctx;
+                demux_cache_unlink(cache, ctx);
+                break;
+            }
+        }
+        if (found) cache->hits++;
+        else cache->misses++;
+        pthread_mutex_unlock(&cache->mutex);
+
+        // Parked contexts were rewound on release
+        if (found) {
+            *out = found;
+            return 0;
+        }
+    }
+
+    FFDemuxContext *ctx = ff_demux_create();
+    if (!ctx) return AVERROR(ENOMEM);
+
+    int ret = ff_demux_open(ctx, url);
+    if (ret < 0) {
+        ff_demux_destroy(ctx);
+        return ret;
+    }
+
+    if (cacheable) {
+        ctx->key = key;
+        ctx->key.path = av_strdup(url);
+    }
+
+    *out = ctx;
+    return 0;
+}
+
+void ff_demux_cache_release(FFDemuxCache *cache, FFDemuxContext *demux_ctx) {
+    if (!demux_ctx) return;
+    if (!cache || cache->max_open == 0 || !demux_ctx->key.path || demux_ctx->arena ||
+        demux_rewind(demux_ctx) < 0) {
+        ff_demux_destroy(demux_ctx);
+        return;
+    }
+
+    FFDemuxContext *evicted = NULL;
+
+    pthread_mutex_lock(&cache->mutex);
+    if (cache->open_count >= cache->max_open) {
+        evicted = cache->tail;
+        demux_cache_unlink(cache, evicted);
+    }
+    demux_cache_push_front(cache, demux_ctx);
+    pthread_mutex_unlock(&cache->mutex);
+
+    // Closing a file can block; do it outside the lock
+    ff_demux_destroy(evicted);
+}
+
+uint32_t ff_demux_cache_open_count(FFDemuxCache *cache) {
+    if (!cache) return 0;
+    pthread_mutex_lock(&cache->mutex);
+    uint32_t count = cache->open_count;
+    pthread_mutex_unlock(&cache->mutex);
+    return count;
+}
+
+uint64_t ff_demux_cache_hit_count(FFDemuxCache *cache) {
+    if (!cache) return 0;
+    pthread_mutex_lock(&cache->mutex);
+    uint64_t hits = cache->hits;
+    pthread_mutex_unlock(&cache->mutex);
+    return hits;
+}
+
+uint64_t ff_demux_cache_miss_count(FFDemuxCache *cache) {
+    if (!cache) return 0;
+    pthread_mutex_lock(&cache->mutex);
+    uint64_t misses = cache->misses;
+    pthread_mutex_unlock(&cache->mutex);
+    return misses;
+}
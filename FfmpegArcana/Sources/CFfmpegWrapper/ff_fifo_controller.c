@@ -0,0 +1,103 @@
+/**
+ * ff_fifo_controller.c
+ *
+ * Additive increase on every jitter event, one step back per quiet window.
+ * Events are counted atomically by whichever thread sees them and consumed
+ * by the updating thread, which is the only one that resizes.
+ */
+
+#include "include/ff_fifo_controller.h"
+#include <stdlib.h>
+
+struct FFFifoController {
+    FFCmdFifo *fifo;
+    uint32_t min_capacity;
+    uint32_t max_capacity;
+    uint32_t window;
+
+    uint32_t events;        // Atomic: overflows and underruns since the last update
+    uint32_t requested;     // Atomic: capacity asked for by set_capacity, 0 = none
+    uint32_t capacity;      // Atomic: read by ff_fifo_controller_capacity
+    uint32_t quiet_reads;
+};
+
+static uint32_t controller_clamp(FFFifoController *ctl, uint32_t capacity) {
+    if (capacity < ctl->min_capacity) return ctl->min_capacity;
+    if (capacity > ctl->max_capacity) return ctl->max_capacity;
+    return capacity;
+}
+
+static void controller_apply(FFFifoController *ctl, uint32_t capacity) {
+    if (capacity == __atomic_load_n(&ctl->capacity, __ATOMIC_RELAXED)) return;
+    if (ff_cmd_fifo_resize(ctl->fifo, capacity) == FF_CMD_FIFO_OK)
+        __atomic_store_n(&ctl->capacity, capacity, __ATOMIC_RELAXED);
+}
+
+FFFifoController* ff_fifo_controller_create(FFCmdFifo* fifo, uint32_t min_capacity,
+                                             uint32_t max_capacity) {
+    if (!fifo || !min_capacity || max_capacity < min_capacity) return NULL;
+
+    FFFifoController *ctl = calloc(1, sizeof(FFFifoController));
+    if (!ctl) return NULL;
+
+    ctl->fifo = fifo;
+    ctl->min_capacity = min_capacity;
+    ctl->max_capacity = max_capacity;
+    ctl->window = FF_FIFO_CONTROLLER_DEFAULT_WINDOW;
+    ctl->capacity = ff_cmd_fifo_capacity(fifo);
+
+    controller_apply(ctl, controller_clamp(ctl, ctl->capacity));
+    return ctl;
+}
+
+void ff_fifo_controller_destroy(FFFifoController* ctl) {
+    free(ctl);
+}
+
+void ff_fifo_controller_set_window(FFFifoController* ctl, uint32_t reads) {
+    if (ctl) ctl->window = reads ? reads : FF_FIFO_CONTROLLER_DEFAULT_WINDOW;
+}
+
+void ff_fifo_controller_overflow(FFFifoController* ctl) {
+    if (ctl) __atomic_fetch_add(&ctl->events, 1, __ATOMIC_RELAXED);
+}
+
+void ff_fifo_controller_underrun(FFFifoController* ctl) {
+    if (ctl) __atomic_fetch_add(&ctl->events, 1, __ATOMIC_RELAXED);
+}
+
+void ff_fifo_controller_set_capacity(FFFifoController* ctl, uint32_t capacity) {
+    if (ctl && capacity)
+        __atomic_store_n(&ctl->requested, controller_clamp(ctl, capacity), __ATOMIC_RELAXED);
+}
+
+uint32_t ff_fifo_controller_update(FFFifoController* ctl) {
+    if (!ctl) return 0;
+
+    uint32_t requested = __atomic_exchange_n(&ctl->requested, 0, __ATOMIC_RELAXED);
+    if (requested) {
+        // A manual depth starts over: events seen before it were measured
+        // against the old one
+        __atomic_store_n(&ctl->events, 0, __ATOMIC_RELAXED);
+        ctl->quiet_reads = 0;
+        controller_apply(ctl, requested);
+        return __atomic_load_n(&ctl->capacity, __ATOMIC_RELAXED);
+    }
+
+    uint32_t capacity = __atomic_load_n(&ctl->capacity, __ATOMIC_RELAXED);
+    uint32_t events = __atomic_exchange_n(&ctl->events, 0, __ATOMIC_RELAXED);
+    if (events) {
+        // One step per update however many events arrived: a single burst
+        // should not jump straight to the maximum
+        ctl->quiet_reads = 0;
+        if (capacity < ctl->max_capacity) controller_apply(ctl, capacity + 1);
+    } else if (++ctl->quiet_reads >= ctl->window) {
+        ctl->quiet_reads = 0;
+        if (capacity > ctl->min_capacity) controller_apply(ctl, capacity - 1);
+    }
+    return __atomic_load_n(&ctl->capacity, __ATOMIC_RELAXED);
+}
+
+uint32_t ff_fifo_controller_capacity(FFFifoController* ctl) {
+    return ctl ? __atomic_load_n(&ctl->capacity, __ATOMIC_RELAXED) : 0;
+}
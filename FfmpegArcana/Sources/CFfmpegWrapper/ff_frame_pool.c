@@ -0,0 +1,361 @@
+/**
+ * ff_frame_pool.c
+ *
+ * Huge-page backed frame buffer pool.
+ */
+
+#include "include/ff_frame_pool.h"
+#include "include/ff_numa.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#if defined(__APPLE__) && defined(__MACH__)
+    #include <mach/vm_statistics.h>
+#endif
+
+#define FRAME_POOL_HUGE_PAGE_SIZE   ((size_t)2 * 1024 * 1024)
+#define FRAME_POOL_SLOT_ALIGN       ((size_t)4096)
+#define FRAME_POOL_LINESIZE_ALIGN   64
+#define FRAME_POOL_PADDING          ((size_t)(AV_INPUT_BUFFER_PADDING_SIZE + 192))
+
+// -----------------------------------------------------------------------------
+// Internal structures
+// -----------------------------------------------------------------------------
+
+typedef struct FramePoolSlab {
+    struct FramePoolSlab *next;
+    uint8_t *base;          // First slot
+    size_t mapped_size;     // Length passed to munmap
+} FramePoolSlab;
+
+struct FFFramePool {
+    pthread_mutex_t mutex;
+    size_t buffer_size;     // Usable bytes per buffer
+    size_t slot_size;       // Distance between buffers in a slab
+    uint32_t flags;
+    int numa_node;
+    uint32_t max_count;
+    uint32_t total_count;
+    uint32_t free_count;
+    uint8_t **free_slots;   // Stack of free buffers
+    uint32_t free_capacity;
+    FramePoolSlab *slabs;
+    FFFramePoolBacking backing;
+    bool destroyed;
+};
+
+// -----------------------------------------------------------------------------
+// Layout
+// -----------------------------------------------------------------------------
+
+static int frame_pool_layout(int pixel_format, int width, int height,
+                             int linesizes[4], size_t sizes[4], size_t *total) {
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pixel_format);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL)))
+        return AVERROR(EINVAL);
+    if (av_image_check_size(width, height, 0, NULL) < 0)
+        return AVERROR(EINVAL);
+
+    int ret = av_image_fill_linesizes(linesizes, pixel_format, FFALIGN(width, FRAME_POOL_LINESIZE_ALIGN));
+    if (ret < 0) return ret;
+
+    ptrdiff_t strides[4];
+    for (int i = 0; i < 4; i++) {
+        linesizes[i] = FFALIGN(linesizes[i], FRAME_POOL_LINESIZE_ALIGN);
+        strides[i] = linesizes[i];
+    }
+
+    ret = av_image_fill_plane_sizes(sizes, pixel_format, height, strides);
+    if (ret < 0) return ret;
+
+    *total = FRAME_POOL_PADDING;
+    for (int i = 0; i < 4; i++) *total += sizes[i];
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Slab mapping
+// -----------------------------------------------------------------------------
+
+static uint8_t *frame_pool_map(size_t size, uint32_t flags,
+                               size_t *mapped_size, FFFramePoolBacking *backing) {
+    const int prot = PROT_READ | PROT_WRITE;
+    uint8_t *p = MAP_FAILED;
+
+    if (flags & FF_FRAME_POOL_HUGE_PAGES) {
+        size_t len = FFALIGN(size, FRAME_POOL_HUGE_PAGE_SIZE);
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+        // Explicit huge pages from the hugetlbfs pool. Not MAP_POPULATE'd:
+        // node placement has to be applied before the first touch.
+        p = mmap(NULL, len, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            *mapped_size = len;
+            *backing = FF_FRAME_POOL_BACKING_HUGETLB;
+            return p;
+        }
+#elif defined(__APPLE__) && defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+        // Superpages are only honoured on Intel Macs; Apple silicon falls through
+        p = mmap(NULL, len, prot, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+        if (p != MAP_FAILED) {
+            *mapped_size = len;
+            *backing = FF_FRAME_POOL_BACKING_HUGETLB;
+            return p;
+        }
+#endif
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        // Transparent huge pages need a 2 MB aligned range, so over-map and trim
+        size_t span = len + FRAME_POOL_HUGE_PAGE_SIZE;
+        uint8_t *raw = mmap(NULL, span, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw != MAP_FAILED) {
+            uintptr_t aligned = FFALIGN((uintptr_t)raw, (uintptr_t)FRAME_POOL_HUGE_PAGE_SIZE);
+            size_t head = aligned - (uintptr_t)raw;
+            size_t tail = span - head - len;
+            if (head) munmap(raw, head);
+            if (tail) munmap((uint8_t *)aligned + len, tail);
+
+            p = (uint8_t *)aligned;
+            *mapped_size = len;
+            *backing = (madvise(p, len, MADV_HUGEPAGE) == 0)
+                ? FF_FRAME_POOL_BACKING_TRANSPARENT
+                : FF_FRAME_POOL_BACKING_NORMAL;
+            return p;
+        }
+#endif
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t len = FFALIGN(size, page);
+    p = mmap(NULL, len, prot, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+
+    *mapped_size = len;
+    *backing = FF_FRAME_POOL_BACKING_NORMAL;
+    return p;
+}
+
+static void frame_pool_prefault(uint8_t *base, size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    for (size_t off = 0; off < size; off += page)
+        ((volatile uint8_t *)base)[off] = 0;
+}
+
+// Caller holds pool->mutex
+static int frame_pool_add_slab(FFFramePool *pool, uint32_t count) {
+    if (pool->max_count && pool->total_count + count > pool->max_count)
+        count = pool->max_count - pool->total_count;
+    if (count == 0) return AVERROR(ENOMEM);
+
+    if (pool->total_count + count > pool->free_capacity) {
+        uint32_t capacity = FFMAX(pool->free_capacity * 2, pool->total_count + count);
+        uint8_t **slots = realloc(pool->free_slots, capacity * sizeof(uint8_t *));
+        if (!slots) return AVERROR(ENOMEM);
+        pool->free_slots = slots;
+        pool->free_capacity = capacity;
+    }
+
+    FramePoolSlab *slab = calloc(1, sizeof(FramePoolSlab));
+    if (!slab) return AVERROR(ENOMEM);
+
+    FFFramePoolBacking backing = FF_FRAME_POOL_BACKING_NORMAL;
+    slab->base = frame_pool_map(pool->slot_size * count, pool->flags, &slab->mapped_size, &backing);
+    if (!slab->base) {
+        free(slab);
+        return AVERROR(ENOMEM);
+    }
+
+    ff_numa_bind_memory(slab->base, slab->mapped_size, pool->numa_node);
+
+    if (pool->flags & FF_FRAME_POOL_PREFAULT)
+        frame_pool_prefault(slab->base, slab->mapped_size);
+
+    // Report the weakest backing any slab got
+    if (pool->total_count == 0 || backing < pool->backing)
+        pool->backing = backing;
+
+    for (uint32_t i = 0; i < count; i++)
+        pool->free_slots[pool->free_count++] = slab->base + (size_t)i * pool->slot_size;
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->total_count += count;
+    return 0;
+}
+
+static void frame_pool_free(FFFramePool *pool) {
+    FramePoolSlab *slab = pool->slabs;
+    while (slab) {
+        FramePoolSlab *next = slab->next;
+        munmap(slab->base, slab->mapped_size);
+        free(slab);
+        slab = next;
+    }
+    free(pool->free_slots);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+// -----------------------------------------------------------------------------
+// Buffer recycling
+// -----------------------------------------------------------------------------
+
+static void frame_pool_release_slot(void *opaque, uint8_t *data) {
+    FFFramePool *pool = opaque;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->free_slots[pool->free_count++] = data;
+    bool last = pool->destroyed && pool->free_count == pool->total_count;
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (last) frame_pool_free(pool);
+}
+
+static uint8_t *frame_pool_take_slot(FFFramePool *pool) {
+    uint8_t *slot = NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->free_count == 0) {
+        // Grow by at least one huge page worth of buffers
+        uint32_t grow = (uint32_t)FFMAX((size_t)1, FRAME_POOL_HUGE_PAGE_SIZE / pool->slot_size);
+        frame_pool_add_slab(pool, grow);
+    }
+    if (pool->free_count > 0)
+        slot = pool->free_slots[--pool->free_count];
+    pthread_mutex_unlock(&pool->mutex);
+
+    return slot;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+FFFramePool* ff_frame_pool_create(int width, int height, int pixel_format,
+                                  uint32_t initial_count, uint32_t max_count,
+                                  uint32_t flags) {
+    return ff_frame_pool_create_on_node(width, height, pixel_format,
+                                        initial_count, max_count, flags, FF_NUMA_NODE_ANY);
+}
+
+FFFramePool* ff_frame_pool_create_on_node(int width, int height, int pixel_format,
+                                          uint32_t initial_count, uint32_t max_count,
+                                          uint32_t flags, int numa_node) {
+    if (width <= 0 || height <= 0) return NULL;
+    if (max_count && initial_count > max_count) initial_count = max_count;
+
+    // Size buffers for the coded geometry decoders ask for (macroblock and
+    // superblock alignment plus the extra rows H.264 reserves)
+    int linesizes[4];
+    size_t sizes[4], total = 0;
+    if (frame_pool_layout(pixel_format, FFALIGN(width, 64), FFALIGN(height, 64) + 2,
+                          linesizes, sizes, &total) < 0)
+        return NULL;
+
+    FFFramePool *pool = calloc(1, sizeof(FFFramePool));
+    if (!pool) return NULL;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pool->buffer_size = total;
+    pool->slot_size = FFALIGN(total, FRAME_POOL_SLOT_ALIGN);
+    pool->flags = flags;
+    pool->numa_node = numa_node;
+    pool->max_count = max_count;
+
+    if (initial_count > 0 && frame_pool_add_slab(pool, initial_count) < 0) {
+        frame_pool_free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void ff_frame_pool_destroy(FFFramePool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->destroyed = true;
+    bool idle = pool->free_count == pool->total_count;
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (idle) frame_pool_free(pool);
+}
+
+int ff_frame_pool_get_buffer(FFFramePool *pool, AVFrame *frame,
+                             int aligned_width, int aligned_height) {
+    if (!pool || !frame || frame->buf[0]) return AVERROR(EINVAL);
+
+    int linesizes[4];
+    size_t sizes[4], total = 0;
+    int ret = frame_pool_layout(frame->format, aligned_width, aligned_height, linesizes, sizes, &total);
+    if (ret < 0) return ret;
+    if (total > pool->buffer_size) return AVERROR(EINVAL);
+
+    uint8_t *slot = frame_pool_take_slot(pool);
+    if (!slot) return AVERROR(ENOMEM);
+
+    frame->buf[0] = av_buffer_create(slot, pool->buffer_size, frame_pool_release_slot, pool, 0);
+    if (!frame->buf[0]) {
+        frame_pool_release_slot(pool, slot);
+        return AVERROR(ENOMEM);
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < 4 && sizes[i]; i++) {
+        frame->data[i] = slot + offset;
+        frame->linesize[i] = linesizes[i];
+        offset += sizes[i];
+    }
+    frame->extended_data = frame->data;
+
+    return 0;
+}
+
+int ff_frame_pool_alloc_buffer(FFFramePool *pool, AVFrame *frame,
+                               int width, int height, int pixel_format) {
+    if (!pool || !frame) return AVERROR(EINVAL);
+    frame->width = width;
+    frame->height = height;
+    frame->format = pixel_format;
+    return ff_frame_pool_get_buffer(pool, frame, width, height);
+}
+
+size_t ff_frame_pool_buffer_size(FFFramePool *pool) {
+    return pool ? pool->buffer_size : 0;
+}
+
+FFFramePoolBacking ff_frame_pool_backing(FFFramePool *pool) {
+    if (!pool) return FF_FRAME_POOL_BACKING_NORMAL;
+    pthread_mutex_lock(&pool->mutex);
+    FFFramePoolBacking backing = pool->backing;
+    pthread_mutex_unlock(&pool->mutex);
+    return backing;
+}
+
+uint32_t ff_frame_pool_total_count(FFFramePool *pool) {
+    if (!pool) return 0;
+    pthread_mutex_lock(&pool->mutex);
+    uint32_t count = pool->total_count;
+    pthread_mutex_unlock(&pool->mutex);
+    return count;
+}
+
+uint32_t ff_frame_pool_free_count(FFFramePool *pool) {
+    if (!pool) return 0;
+    pthread_mutex_lock(&pool->mutex);
+    uint32_t count = pool->free_count;
+    pthread_mutex_unlock(&pool->mutex);
+    return count;
+}
+
+uint32_t ff_frame_pool_in_use_count(FFFramePool *pool) {
+    if (!pool) return 0;
+    pthread_mutex_lock(&pool->mutex);
+    uint32_t count = pool->total_count - pool->free_count;
+    pthread_mutex_unlock(&pool->mutex);
+    return count;
+}
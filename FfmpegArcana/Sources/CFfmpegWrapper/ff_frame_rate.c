@@ -0,0 +1,267 @@
+/**
+ * ff_frame_rate.c
+ *
+ * Slot mapping follows FFmpeg's fps filter with round-to-nearest: a frame
+ * owns the output slots from its own rounded timestamp up to the next
+ * frame's. The last frame is held back because its slot count is not known
+ * until its successor (or EOS) arrives.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_frame_rate.h"
+#include <stdlib.h>
+
+struct FFFrameRateConverter {
+    AVRational in_time_base;
+    AVRational out_time_base;
+    FFCmdPool *cmd_pool;
+    uint32_t max_repeat;
+
+    FFCmd *held;            // Latest frame, waiting for its successor
+    int64_t held_slot;      // Output slot of the held frame
+    FFCmd **queued;         // Control commands that arrived after the held frame
+    int queued_count;
+    int queued_capacity;
+    int64_t next_slot;      // First slot not yet emitted (AV_NOPTS_VALUE = no timeline)
+
+    uint64_t outputs;
+    uint64_t dropped;
+    uint64_t repeated;
+};
+
+// -----------------------------------------------------------------------------
+// Output
+// -----------------------------------------------------------------------------
+
+static int converter_write(FFCmdFifo *output, FFCmd *cmd) {
+    int ret = ff_cmd_fifo_wait_write(output);
+    if (ret == FF_CMD_FIFO_OK) ret = ff_cmd_fifo_write(output, cmd);
+    if (ret != FF_CMD_FIFO_OK) FF_CMD_RELEASE(cmd);
+    return ret;
+}
+
+static void stamp(FFFrameRateConverter *conv, FFCmd *cmd, AVFrame *frame, int64_t slot) {
+    cmd->pts = slot;
+    cmd->dts = slot;
+    frame->pts = slot;
+    frame->pkt_dts = slot;
+    frame->duration = 1;
+    frame->time_base = conv->out_time_base;
+}
+
+// A command carries its own pts, so each repeat needs one; the pixel buffers
+// behind it are shared with the source frame by reference
+static FFCmd* make_repeat(FFFrameRateConverter *conv, FFCmd *src) {
+    FFCmd *cmd = ff_cmd_pool_acquire(conv->cmd_pool);
+    if (!cmd) return NULL;
+
+    AVFrame *frame = av_frame_clone(src->data);
+    if (!frame) {
+        FF_CMD_RELEASE(cmd);
+        return NULL;
+    }
+
+    ff_cmd_init(cmd, FF_CMD_FRAME);
+    cmd->data = frame;
+    cmd->data_ref = ff_frame_ref_interface();
+    cmd->flags = src->flags;
+    cmd->stream_index = src->stream_index;
+    cmd->user_data = src->user_data;
+    return cmd;
+}
+
+// Forward the control commands queued behind the held frame, in order
+static int emit_queued(FFFrameRateConverter *conv, FFCmdFifo *output) {
+    int ret = FF_CMD_FIFO_OK;
+    for (int i = 0; i < conv->queued_count; i++) {
+        if (ret == FF_CMD_FIFO_OK) ret = converter_write(output, conv->queued[i]);
+        else FF_CMD_RELEASE(conv->queued[i]);
+    }
+    conv->queued_count = 0;
+    return ret;
+}
+
+static int queue_behind_held(FFFrameRateConverter *conv, FFCmd *cmd) {
+    if (conv->queued_count == conv->queued_capacity) {
+        int capacity = FFMAX(conv->queued_capacity * 2, 4);
+        FFCmd **queued = realloc(conv->queued, capacity * sizeof(*queued));
+        if (!queued) {
+            FF_CMD_RELEASE(cmd);
+            return FF_CMD_FIFO_INVALID_PARAMS;
+        }
+        conv->queued = queued;
+        conv->queued_capacity = capacity;
+    }
+    conv->queued[conv->queued_count++] = cmd;
+    return FF_CMD_FIFO_OK;
+}
+
+// Emit the held frame into slots [next_slot, end); end <= next_slot drops it
+static int emit_held_frame(FFFrameRateConverter *conv, int64_t end, FFCmdFifo *output) {
+    FFCmd *held = conv->held;
+    conv->held = NULL;
+    if (!held) return FF_CMD_FIFO_OK;
+
+    int64_t count = end - conv->next_slot;
+    if (count <= 0) {
+        conv->dropped++;
+        FF_CMD_RELEASE(held);
+        return FF_CMD_FIFO_OK;
+    }
+
+    // Repeats are cloned from the held frame while it is still ours, and the
+    // held command itself goes out last, in the final slot
+    for (int64_t slot = conv->next_slot; slot < end - 1; slot++) {
+        FFCmd *repeat = make_repeat(conv, held);
+        if (!repeat) continue;      // Out of commands: leave a gap rather than stall
+        stamp(conv, repeat, repeat->data, slot);
+        int ret = converter_write(output, repeat);
+        if (ret != FF_CMD_FIFO_OK) {
+            FF_CMD_RELEASE(held);
+            return ret;
+        }
+        conv->outputs++;
+        conv->repeated++;
+    }
+
+    stamp(conv, held, held->data, end - 1);
+    conv->next_slot = end;
+    int ret = converter_write(output, held);
+    if (ret == FF_CMD_FIFO_OK) conv->outputs++;
+    return ret;
+}
+
+// The held frame and then the commands queued behind it, so none overtakes it
+static int emit_held(FFFrameRateConverter *conv, int64_t end, FFCmdFifo *output) {
+    int ret = emit_held_frame(conv, end, output);
+    int queued = emit_queued(conv, output);
+    return ret != FF_CMD_FIFO_OK ? ret : queued;
+}
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+FFFrameRateConverter* ff_frame_rate_create(AVRational in_time_base, AVRational out_rate,
+                                           FFCmdPool* cmd_pool) {
+    if (!cmd_pool || in_time_base.num <= 0 || in_time_base.den <= 0 ||
+        out_rate.num <= 0 || out_rate.den <= 0)
+        return NULL;
+
+    FFFrameRateConverter *conv = calloc(1, sizeof(FFFrameRateConverter));
+    if (!conv) return NULL;
+
+    conv->in_time_base = in_time_base;
+    conv->out_time_base = av_inv_q(out_rate);
+    conv->cmd_pool = cmd_pool;
+    conv->max_repeat = FF_FRAME_RATE_DEFAULT_MAX_REPEAT;
+    conv->next_slot = AV_NOPTS_VALUE;
+    return conv;
+}
+
+void ff_frame_rate_destroy(FFFrameRateConverter* conv) {
+    if (!conv) return;
+    FF_CMD_RELEASE(conv->held);
+    for (int i = 0; i < conv->queued_count; i++) FF_CMD_RELEASE(conv->queued[i]);
+    free(conv->queued);
+    free(conv);
+}
+
+void ff_frame_rate_set_max_repeat(FFFrameRateConverter* conv, uint32_t max_repeat) {
+    if (conv) conv->max_repeat = max_repeat ? max_repeat : FF_FRAME_RATE_DEFAULT_MAX_REPEAT;
+}
+
+// -----------------------------------------------------------------------------
+// Conversion
+// -----------------------------------------------------------------------------
+
+static int push_frame(FFFrameRateConverter *conv, FFCmd *cmd, FFCmdFifo *output) {
+    AVFrame *frame = cmd->data;
+    int64_t pts = frame->pts != AV_NOPTS_VALUE ? frame->pts : cmd->pts;
+
+    int64_t slot;
+    if (pts == AV_NOPTS_VALUE) {
+        // Untimed: take the slot after the held frame
+        slot = conv->held ? conv->held_slot + 1 : (conv->next_slot != AV_NOPTS_VALUE ? conv->next_slot : 0);
+    } else {
+        slot = av_rescale_q_rnd(pts, conv->in_time_base, conv->out_time_base,
+                                AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+    }
+
+    if (conv->next_slot == AV_NOPTS_VALUE) conv->next_slot = slot;
+
+    int ret = FF_CMD_FIFO_OK;
+    if (conv->held) {
+        int64_t end = slot;
+        if (end - conv->next_slot > (int64_t)conv->max_repeat + 1) {
+            // Gap too long to fill: emit once and restart the timeline here
+            end = conv->next_slot + 1;
+            ret = emit_held(conv, end, output);
+            conv->next_slot = slot;
+        } else {
+            ret = emit_held(conv, end, output);
+        }
+    } else if (slot < conv->next_slot) {
+        // Behind the timeline with nothing held: it would only be dropped later
+        slot = conv->next_slot;
+    }
+
+    conv->held = cmd;
+    conv->held_slot = slot;
+    return ret;
+}
+
+int ff_frame_rate_push(FFFrameRateConverter* conv, FFCmd* cmd, FFCmdFifo* output) {
+    if (!conv || !cmd || !output) {
+        FF_CMD_RELEASE(cmd);
+        return FF_CMD_FIFO_INVALID_PARAMS;
+    }
+
+    if (cmd->type == FF_CMD_FRAME && cmd->data)
+        return push_frame(conv, cmd, output);
+
+    int ret = FF_CMD_FIFO_OK;
+    if (cmd->type == FF_CMD_FLUSH) {
+        if (conv->held) {
+            conv->dropped++;
+            FF_CMD_RELEASE(conv->held);
+            conv->held = NULL;
+        }
+        ret = emit_queued(conv, output);
+        conv->next_slot = AV_NOPTS_VALUE;
+    } else if (cmd->type == FF_CMD_EOS && conv->held) {
+        // Nothing follows to bound it: the held frame gets one slot
+        ret = emit_held(conv, FFMAX(conv->held_slot, conv->next_slot) + 1, output);
+    } else if (conv->held) {
+        // CONFIG, SEEK and user commands wait behind the held frame, which
+        // still needs its successor to know how many slots it covers; a
+        // scaler must not switch before the last frame of the old geometry
+        return queue_behind_held(conv, cmd);
+    }
+
+    if (ret != FF_CMD_FIFO_OK) {
+        FF_CMD_RELEASE(cmd);
+        return ret;
+    }
+    return converter_write(output, cmd);
+}
+
+// -----------------------------------------------------------------------------
+// Info
+// -----------------------------------------------------------------------------
+
+AVRational ff_frame_rate_output_time_base(FFFrameRateConverter* conv) {
+    return conv ? conv->out_time_base : (AVRational){ 0, 1 };
+}
+
+uint64_t ff_frame_rate_output_count(FFFrameRateConverter* conv) {
+    return conv ? conv->outputs : 0;
+}
+
+uint64_t ff_frame_rate_dropped_count(FFFrameRateConverter* conv) {
+    return conv ? conv->dropped : 0;
+}
+
+uint64_t ff_frame_rate_repeated_count(FFFrameRateConverter* conv) {
+    return conv ? conv->repeated : 0;
+}
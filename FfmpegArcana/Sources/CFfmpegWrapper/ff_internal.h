@@ -0,0 +1,123 @@
+/**
+ * ff_internal.h
+ *
+ * Context layouts shared between the wrapper's translation units.
+ * Not part of the public API.
+ */
+
+#ifndef FF_INTERNAL_H
+#define FF_INTERNAL_H
+
+#include "include/ffmpeg_wrapper.h"
+#include "include/ff_frame_pool.h"
+#include "include/ff_arena.h"
+#include "include/ff_async_io.h"
+#include "include/ff_pixconv.h"
+
+// -----------------------------------------------------------------------------
+// Internal structures
+// -----------------------------------------------------------------------------
+
+// Identity of an opened file: path plus what stat() says about it, so a
+// replaced or rewritten file never matches a stale cached context
+typedef struct FFDemuxKey {
+    char *path;             // av_malloc'd, NULL if not cacheable
+    uint64_t dev;
+    uint64_t ino;
+    int64_t mtime_ns;
+    int64_t size;
+} FFDemuxKey;
+
+struct FFDemuxContext {
+    AVFormatContext *fmt_ctx;
+    int video_stream_idx;
+    int audio_stream_idx;
+    FFArena *arena;         // Owning arena, NULL if heap allocated
+    FFAsyncIO *aio;         // Custom I/O behind fmt_ctx->pb, if any
+    FFDemuxKey key;
+    struct FFDemuxContext *cache_prev;      // LRU linkage while parked
+    struct FFDemuxContext *cache_next;
+};
+
+// Identity of an opened decoder: two streams with equal keys can share a
+// flushed codec context
+typedef struct FFDecoderKey {
+    enum AVCodecID codec_id;
+    uint32_t codec_tag;
+    int profile;
+    int width, height, format;
+    int sample_rate, channels;
+    int extradata_size;
+    uint64_t extradata_hash;
+    bool use_hardware;
+} FFDecoderKey;
+
+struct FFDecoderContext {
+    AVCodecContext *codec_ctx;
+    AVBufferRef *hw_device_ctx;
+    bool is_hardware;
+    int stream_index;
+    AVRational time_base;
+    FFFramePool *frame_pool;
+    FFArena *arena;
+    FFDecoderKey key;
+    struct FFDecoderContext *cache_next;    // Idle list linkage
+    int64_t idle_since;                     // av_gettime_relative() when parked
+    struct FFLatencyTracker *latency;       // Send-to-receive timing, NULL when off
+};
+
+struct FFScalerContext {
+    struct SwsContext *sws_ctx;
+    int src_width, src_height, src_format;
+    int dst_width, dst_height, dst_format;
+    struct FFPixConv *pixconv;      // Same-size 10-bit fast path, NULL when swscale does it all
+    int dither;                     // FFDitherMode for the fast path
+    FFArena *arena;
+};
+
+// Decoder knobs the public constructors leave at FFmpeg's defaults
+typedef struct FFDecoderSetup {
+    int thread_count;       // 0 = FFmpeg default
+    int thread_type;        // FF_THREAD_* mask, 0 = FFmpeg default
+    int flags;              // Extra AV_CODEC_FLAG_* bits
+    int flags2;             // Extra AV_CODEC_FLAG2_* bits
+} FFDecoderSetup;
+
+// -----------------------------------------------------------------------------
+// Internal helpers
+// -----------------------------------------------------------------------------
+
+int ff_demux_finish_open(FFDemuxContext *ctx);
+FFDecoderContext* ff_decoder_create_setup(FFArena *arena, FFDemuxContext *demux_ctx,
+                                          int stream_index, bool use_hardware,
+                                          FFFramePool *pool, const FFDecoderSetup *setup);
+// error (optional) receives the AVERROR of the step that failed
+FFDecoderContext* ff_decoder_open_params(FFArena *arena, const AVCodecParameters *codecpar,
+                                         AVRational time_base, int stream_index,
+                                         bool use_hardware, FFFramePool *pool,
+                                         const FFDecoderSetup *setup, int *error);
+void ff_decoder_key_init(FFDecoderKey *key, const AVCodecParameters *codecpar, bool use_hardware);
+bool ff_decoder_key_equal(const FFDecoderKey *a, const FFDecoderKey *b);
+
+// Row kernels from ff_pixconv.c, shared with the filters that end in an
+// 8-bit reduction. pattern holds 16 dither offsets (0..3) added before the
+// two low bits are dropped, indexed by pixel; see ff_pixconv_dither_pattern.
+void ff_pixconv_dither_pattern(FFDitherMode mode, int y, uint16_t *pattern);
+void ff_pixconv_reduce_row(const uint16_t *src, uint8_t *dst, int n, int shift,
+                           const uint16_t *pattern);
+void ff_pixconv_reduce_merge(const uint16_t *u, const uint16_t *v, uint8_t *dst, int pairs, int shift,
+                             const uint16_t *pattern);
+
+// Slice threading for per-frame filters (ff_slice_pool.c). run hands out
+// slices 0..nb_slices-1 to the workers and the calling thread, returning
+// when all are done; worker is 0..threads-1 and identifies per-thread
+// scratch. One run at a time per pool.
+typedef struct FFSlicePool FFSlicePool;
+typedef void (*FFSliceFunc)(void *opaque, int slice, int nb_slices, int worker);
+
+FFSlicePool* ff_slice_pool_create(int threads);     // <= 0: one per online CPU
+void ff_slice_pool_destroy(FFSlicePool *pool);
+int ff_slice_pool_threads(const FFSlicePool *pool);
+void ff_slice_pool_run(FFSlicePool *pool, FFSliceFunc func, void *opaque, int nb_slices);
+
+#endif // FF_INTERNAL_H
@@ -0,0 +1,203 @@
+/**
+ * ff_numa.c
+ *
+ * NUMA placement without a libnuma dependency: topology comes from sysfs and
+ * policies are applied through the raw mbind/set_mempolicy system calls.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE     // CPU_SET, pthread_setaffinity_np
+#endif
+
+#include "include/ff_numa.h"
+#include <libavutil/avutil.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#if defined(__linux__)
+    #include <sched.h>
+    #include <sys/syscall.h>
+    #define NUMA_LINUX 1
+#endif
+
+#define NUMA_MAX_NODES      1024
+#define NUMA_MASK_WORDS     (NUMA_MAX_NODES / (8 * sizeof(unsigned long)))
+
+#ifndef MPOL_PREFERRED
+    #define MPOL_PREFERRED  1
+#endif
+#ifndef MPOL_BIND
+    #define MPOL_BIND       2
+#endif
+
+// -----------------------------------------------------------------------------
+// Topology
+// -----------------------------------------------------------------------------
+
+static pthread_once_t numa_once = PTHREAD_ONCE_INIT;
+static int numa_nodes[NUMA_MAX_NODES];
+static int numa_node_total = 1;
+static atomic_uint numa_spread_cursor;
+
+#if defined(NUMA_LINUX)
+// Parse a sysfs range list such as "0-3,8,10-11", calling fn for each value
+static int numa_parse_list(const char *path, void (*fn)(int value, void *opaque), void *opaque) {
+    FILE *f = fopen(path, "r");
+    if (!f) return AVERROR(errno);
+
+    char line[4096];
+    if (!fgets(line, sizeof(line), f)) {
+        fclose(f);
+        return AVERROR(EIO);
+    }
+    fclose(f);
+
+    char *p = line;
+    while (*p && *p != '\n') {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        if (end == p) break;
+        long hi = lo;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+        }
+        for (long v = lo; v <= hi; v++) fn((int)v, opaque);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return 0;
+}
+
+static void numa_collect_node(int node, void *opaque) {
+    int *count = opaque;
+    if (node >= 0 && node < NUMA_MAX_NODES && *count < NUMA_MAX_NODES)
+        numa_nodes[(*count)++] = node;
+}
+
+static void numa_collect_cpu(int cpu, void *opaque) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, (cpu_set_t *)opaque);
+}
+
+static void numa_node_mask(int node, unsigned long mask[NUMA_MASK_WORDS]) {
+    memset(mask, 0, NUMA_MASK_WORDS * sizeof(unsigned long));
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+}
+#endif
+
+static void numa_discover(void) {
+    numa_nodes[0] = 0;
+    numa_node_total = 1;
+
+#if defined(NUMA_LINUX)
+    int count = 0;
+    if (numa_parse_list("/sys/devices/system/node/online", numa_collect_node, &count) == 0 && count > 0)
+        numa_node_total = count;
+#endif
+}
+
+static bool numa_node_valid(int node) {
+    pthread_once(&numa_once, numa_discover);
+    for (int i = 0; i < numa_node_total; i++)
+        if (numa_nodes[i] == node) return true;
+    return false;
+}
+
+int ff_numa_node_count(void) {
+    pthread_once(&numa_once, numa_discover);
+    return numa_node_total;
+}
+
+int ff_numa_next_node(void) {
+    pthread_once(&numa_once, numa_discover);
+    unsigned slot = atomic_fetch_add_explicit(&numa_spread_cursor, 1, memory_order_relaxed);
+    return numa_nodes[slot % (unsigned)numa_node_total];
+}
+
+int ff_numa_current_node(void) {
+#if defined(NUMA_LINUX) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) return (int)node;
+#endif
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Binding
+// -----------------------------------------------------------------------------
+
+int ff_numa_bind_thread(int node) {
+    if (node == FF_NUMA_NODE_ANY) return 0;
+    if (!numa_node_valid(node)) return AVERROR(EINVAL);
+
+#if defined(NUMA_LINUX)
+    if (numa_node_total == 1) return 0;
+
+    char path[128];
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    int ret = numa_parse_list(path, numa_collect_cpu, &cpus);
+    if (ret < 0) return ret;
+
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (ret) return AVERROR(ret);
+
+    // Preferred rather than strict, so incidental allocations never fail
+    unsigned long mask[NUMA_MASK_WORDS];
+    numa_node_mask(node, mask);
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, NUMA_MAX_NODES + 1) < 0)
+        return AVERROR(errno);
+#endif
+
+    return 0;
+}
+
+int ff_numa_bind_memory(void *ptr, size_t size, int node) {
+    if (node == FF_NUMA_NODE_ANY || !ptr || size == 0) return 0;
+    if (!numa_node_valid(node)) return AVERROR(EINVAL);
+
+#if defined(NUMA_LINUX)
+    if (numa_node_total == 1) return 0;
+
+    unsigned long mask[NUMA_MASK_WORDS];
+    numa_node_mask(node, mask);
+    if (syscall(SYS_mbind, ptr, size, MPOL_BIND, mask, NUMA_MAX_NODES + 1, 0) < 0)
+        return AVERROR(errno);
+#endif
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Allocation
+// -----------------------------------------------------------------------------
+
+static size_t numa_round_size(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return FFALIGN(size, page);
+}
+
+void* ff_numa_alloc(size_t size, int node) {
+    if (size == 0) return NULL;
+
+    size_t len = numa_round_size(size);
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+
+    // Placement only takes effect for pages not yet touched, which fresh
+    // anonymous mappings guarantee
+    ff_numa_bind_memory(p, len, node);
+    return p;
+}
+
+void ff_numa_free(void *ptr, size_t size) {
+    if (!ptr || size == 0) return;
+    munmap(ptr, numa_round_size(size));
+}
@@ -0,0 +1,505 @@
+/**
+ * ff_parallel_decoder.c
+ *
+ * Each packet gets a sequence number and goes to the least loaded instance.
+ * The number rides through the decoder in pkt->opaque / frame->opaque
+ * (AV_CODEC_FLAG_COPY_OPAQUE), so a packet that decodes to nothing (a
+ * discarded or skipped packet) cannot shift later frames onto the wrong
+ * number; it is answered as failed once a later packet's frame, or the
+ * decoder's request for more input, shows it will not produce one. Frames
+ * are parked in a window of slots indexed by sequence number and released
+ * to the caller strictly in order.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_parallel_decoder.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PARALLEL_WINDOW_PER_INSTANCE    4   // Packets in flight per instance
+
+// -----------------------------------------------------------------------------
+// Internal structures
+// -----------------------------------------------------------------------------
+
+typedef enum {
+    PARALLEL_SLOT_FREE = 0,
+    PARALLEL_SLOT_PENDING,          // Queued or decoding
+    PARALLEL_SLOT_DONE              // Decoded (or failed: no frame)
+} ParallelSlotState;
+
+typedef struct {
+    AVFrame *frame;
+    ParallelSlotState state;
+    bool has_frame;
+} ParallelSlot;
+
+typedef struct {
+    struct FFParallelDecoder *owner;
+    FFDecoderContext *decoder;
+    AVFrame *scratch;
+    pthread_t thread;
+    pthread_cond_t cond;            // Work available
+    bool started;
+    bool busy;                      // Working outside the lock
+
+    // Packets waiting for this instance (ring of window entries)
+    AVPacket **packets;
+    int64_t *packet_seqs;
+    uint32_t in_head, in_count;
+
+    // Sequence numbers sent to the decoder, frame not yet out (ring)
+    int64_t *awaiting;
+    uint32_t await_head, await_count;
+
+    bool drain;                     // Drain requested
+    bool drained;
+} ParallelWorker;
+
+struct FFParallelDecoder {
+    pthread_mutex_t lock;
+    pthread_cond_t done_cond;       // A slot completed or a worker went idle
+
+    FFDecoderContext *direct;       // Single instance: no threads, no reordering
+    ParallelWorker workers[FF_PARALLEL_DECODER_MAX_INSTANCES];
+    int count;
+
+    ParallelSlot *slots;
+    uint32_t window;
+    int64_t next_seq;               // Next packet's sequence number
+    int64_t out_seq;                // Next sequence number to hand out
+    uint32_t next_worker;           // Round-robin start for ties
+
+    bool draining;
+    bool stop;
+    uint64_t errors;
+};
+
+// -----------------------------------------------------------------------------
+// Intra-only detection
+// -----------------------------------------------------------------------------
+
+bool ff_stream_is_intra_only(FFDemuxContext *demux_ctx, int stream_index) {
+    if (!demux_ctx || !demux_ctx->fmt_ctx) return false;
+    if (stream_index < 0 || stream_index >= (int)demux_ctx->fmt_ctx->nb_streams) return false;
+
+    AVCodecParameters *par = demux_ctx->fmt_ctx->streams[stream_index]->codecpar;
+    if (par->codec_type != AVMEDIA_TYPE_VIDEO) return false;
+
+    const AVCodecDescriptor *desc = avcodec_descriptor_get(par->codec_id);
+    if (desc && (desc->props & AV_CODEC_PROP_INTRA_ONLY)) return true;
+
+    // The H.264 intra profiles carry a flag bit
+    return par->codec_id == AV_CODEC_ID_H264 && par->profile != AV_PROFILE_UNKNOWN &&
+           (par->profile & AV_PROFILE_H264_INTRA);
+}
+
+// -----------------------------------------------------------------------------
+// Workers
+// -----------------------------------------------------------------------------
+
+// Called with the lock held
+static void parallel_complete(FFParallelDecoder *dec, int64_t seq, AVFrame *frame) {
+    ParallelSlot *slot = &dec->slots[seq % dec->window];
+    if (frame) {
+        av_frame_move_ref(slot->frame, frame);
+        slot->has_frame = true;
+    } else {
+        dec->errors++;
+    }
+    slot->state = PARALLEL_SLOT_DONE;
+    pthread_cond_broadcast(&dec->done_cond);
+}
+
+static int64_t worker_pop_awaiting(ParallelWorker *w) {
+    int64_t seq = w->awaiting[w->await_head];
+    w->await_head = (w->await_head + 1) % w->owner->window;
+    w->await_count--;
+    return seq;
+}
+
+// Answer every outstanding sequence number before seq as frameless;
+// called with the lock held
+static void worker_skip_before(ParallelWorker *w, int64_t seq) {
+    while (w->await_count && w->awaiting[w->await_head] < seq)
+        parallel_complete(w->owner, worker_pop_awaiting(w), NULL);
+}
+
+// Pull every frame the decoder has ready; called without the lock
+static int worker_collect(ParallelWorker *w) {
+    FFParallelDecoder *dec = w->owner;
+
+    for (;;) {
+        int ret = ff_decoder_receive_frame(w->decoder, w->scratch);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return ret;
+
+        pthread_mutex_lock(&dec->lock);
+        if (ret >= 0) {
+            int64_t seq = (int64_t)(intptr_t)w->scratch->opaque;
+            w->scratch->opaque = NULL;
+            worker_skip_before(w, seq);
+            // A frame for a number already answered is dropped
+            if (w->await_count && w->awaiting[w->await_head] == seq)
+                parallel_complete(dec, worker_pop_awaiting(w), w->scratch);
+        } else if (w->await_count) {
+            // A failed receive costs the oldest outstanding packet its frame
+            parallel_complete(dec, worker_pop_awaiting(w), NULL);
+        }
+        pthread_mutex_unlock(&dec->lock);
+        av_frame_unref(w->scratch);
+        if (ret < 0) return ret;
+    }
+}
+
+static void worker_decode(ParallelWorker *w, AVPacket *pkt, int64_t seq) {
+    FFParallelDecoder *dec = w->owner;
+
+    pkt->opaque = (void *)(intptr_t)seq;
+    int ret;
+    while ((ret = ff_decoder_send_packet(w->decoder, pkt)) == AVERROR(EAGAIN))
+        worker_collect(w);
+    av_packet_free(&pkt);
+
+    pthread_mutex_lock(&dec->lock);
+    if (ret < 0) {
+        parallel_complete(dec, seq, NULL);
+    } else {
+        w->awaiting[(w->await_head + w->await_count) % dec->window] = seq;
+        w->await_count++;
+    }
+    pthread_mutex_unlock(&dec->lock);
+
+    // Instances are single-threaded and low-delay, so once the decoder wants
+    // more input every packet it has taken has produced its frame; whatever
+    // is still outstanding decoded to nothing and would otherwise hold the
+    // window until the next frame from this instance
+    if (worker_collect(w) == AVERROR(EAGAIN)) {
+        pthread_mutex_lock(&dec->lock);
+        worker_skip_before(w, seq + 1);
+        pthread_mutex_unlock(&dec->lock);
+    }
+}
+
+static void worker_drain(ParallelWorker *w) {
+    FFParallelDecoder *dec = w->owner;
+
+    ff_decoder_send_packet(w->decoder, NULL);
+    worker_collect(w);
+
+    // Whatever is still outstanding will never produce a frame
+    pthread_mutex_lock(&dec->lock);
+    while (w->await_count)
+        parallel_complete(dec, worker_pop_awaiting(w), NULL);
+    pthread_mutex_unlock(&dec->lock);
+}
+
+static void* worker_main(void *arg) {
+    ParallelWorker *w = arg;
+    FFParallelDecoder *dec = w->owner;
+
+    pthread_mutex_lock(&dec->lock);
+    while (!dec->stop) {
+        if (w->in_count) {
+            AVPacket *pkt = w->packets[w->in_head];
+            int64_t seq = w->packet_seqs[w->in_head];
+            w->in_head = (w->in_head + 1) % dec->window;
+            w->in_count--;
+
+            w->busy = true;
+            pthread_mutex_unlock(&dec->lock);
+            worker_decode(w, pkt, seq);
+            pthread_mutex_lock(&dec->lock);
+            w->busy = false;
+            pthread_cond_broadcast(&dec->done_cond);
+        } else if (w->drain && !w->drained) {
+            w->busy = true;
+            pthread_mutex_unlock(&dec->lock);
+            worker_drain(w);
+            pthread_mutex_lock(&dec->lock);
+            w->busy = false;
+            w->drained = true;
+            pthread_cond_broadcast(&dec->done_cond);
+        } else {
+            pthread_cond_wait(&w->cond, &dec->lock);
+        }
+    }
+    pthread_mutex_unlock(&dec->lock);
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+FFParallelDecoder* ff_parallel_decoder_create(FFDemuxContext *demux_ctx, int stream_index,
+                                              int instance_count, FFFramePool *pool) {
+    if (!demux_ctx || !demux_ctx->fmt_ctx) return NULL;
+
+    FFParallelDecoder *dec = calloc(1, sizeof(FFParallelDecoder));
+    if (!dec) return NULL;
+    pthread_mutex_init(&dec->lock, NULL);
+    pthread_cond_init(&dec->done_cond, NULL);
+
+    if (!ff_stream_is_intra_only(demux_ctx, stream_index)) {
+        instance_count = 1;
+    } else if (instance_count <= 0) {
+        instance_count = (int)FFMAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+    }
+    instance_count = FFMIN(instance_count, FF_PARALLEL_DECODER_MAX_INSTANCES);
+
+    if (instance_count == 1) {
+        dec->direct = ff_decoder_create_pooled(demux_ctx, stream_index, false, pool);
+        if (!dec->direct) {
+            ff_parallel_decoder_destroy(dec);
+            return NULL;
+        }
+        dec->count = 1;
+        return dec;
+    }
+
+    dec->window = (uint32_t)instance_count * PARALLEL_WINDOW_PER_INSTANCE;
+    dec->slots = calloc(dec->window, sizeof(ParallelSlot));
+    if (!dec->slots) {
+        ff_parallel_decoder_destroy(dec);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < dec->window; i++) {
+        dec->slots[i].frame = av_frame_alloc();
+        if (!dec->slots[i].frame) {
+            ff_parallel_decoder_destroy(dec);
+            return NULL;
+        }
+    }
+
+    // The parallelism is across instances; each one decodes on its own thread
+    // and emits a frame as soon as its packet is in. Frames carry their
+    // packet's sequence number back in opaque.
+    FFDecoderSetup setup = {
+        .thread_count = 1,
+        .flags = AV_CODEC_FLAG_LOW_DELAY | AV_CODEC_FLAG_COPY_OPAQUE,
+    };
+
+    for (int i = 0; i < instance_count; i++) {
+        ParallelWorker *w = &dec->workers[i];
+        w->owner = dec;
+        pthread_cond_init(&w->cond, NULL);
+        dec->count++;
+
+        w->decoder = ff_decoder_create_setup(NULL, demux_ctx, stream_index, false, pool, &setup);
+        w->scratch = av_frame_alloc();
+        w->packets = calloc(dec->window, sizeof(AVPacket *));
+        w->packet_seqs = calloc(dec->window, sizeof(int64_t));
+        w->awaiting = calloc(dec->window, sizeof(int64_t));
+        if (!w->decoder || !w->scratch || !w->packets || !w->packet_seqs || !w->awaiting ||
+            pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            ff_parallel_decoder_destroy(dec);
+            return NULL;
+        }
+        w->started = true;
+    }
+
+    return dec;
+}
+
+// Called with the lock held
+static void parallel_drop_queued(FFParallelDecoder *dec) {
+    for (int i = 0; i < dec->count; i++) {
+        ParallelWorker *w = &dec->workers[i];
+        while (w->in_count) {
+            av_packet_free(&w->packets[w->in_head]);
+            w->in_head = (w->in_head + 1) % dec->window;
+            w->in_count--;
+        }
+    }
+}
+
+void ff_parallel_decoder_destroy(FFParallelDecoder *dec) {
+    if (!dec) return;
+
+    pthread_mutex_lock(&dec->lock);
+    dec->stop = true;
+    for (int i = 0; i < dec->count; i++)
+        pthread_cond_signal(&dec->workers[i].cond);
+    pthread_mutex_unlock(&dec->lock);
+
+    for (int i = 0; i < dec->count; i++) {
+        ParallelWorker *w = &dec->workers[i];
+        if (w->started) pthread_join(w->thread, NULL);
+    }
+
+    if (dec->slots) parallel_drop_queued(dec);
+    for (int i = 0; i < dec->count; i++) {
+        ParallelWorker *w = &dec->workers[i];
+        ff_decoder_destroy(w->decoder);
+        av_frame_free(&w->scratch);
+        free(w->packets);
+        free(w->packet_seqs);
+        free(w->awaiting);
+        pthread_cond_destroy(&w->cond);
+    }
+    if (dec->slots) {
+        for (uint32_t i = 0; i < dec->window; i++)
+            av_frame_free(&dec->slots[i].frame);
+        free(dec->slots);
+    }
+    ff_decoder_destroy(dec->direct);
+
+    pthread_cond_destroy(&dec->done_cond);
+    pthread_mutex_destroy(&dec->lock);
+    free(dec);
+}
+
+// -----------------------------------------------------------------------------
+// Decoding
+// -----------------------------------------------------------------------------
+
+int ff_parallel_decoder_send_packet(FFParallelDecoder *dec, AVPacket *pkt) {
+    if (!dec) return AVERROR(EINVAL);
+    if (dec->direct) return ff_decoder_send_packet(dec->direct, pkt);
+
+    pthread_mutex_lock(&dec->lock);
+
+    if (dec->draining) {
+        pthread_mutex_unlock(&dec->lock);
+        return AVERROR_EOF;
+    }
+
+    if (!pkt) {
+        dec->draining = true;
+        for (int i = 0; i < dec->count; i++) {
+            dec->workers[i].drain = true;
+            pthread_cond_signal(&dec->workers[i].cond);
+        }
+        pthread_mutex_unlock(&dec->lock);
+        return 0;
+    }
+
+    if (dec->next_seq - dec->out_seq >= dec->window) {
+        pthread_mutex_unlock(&dec->lock);
+        return AVERROR(EAGAIN);
+    }
+
+    AVPacket *copy = av_packet_clone(pkt);
+    if (!copy) {
+        pthread_mutex_unlock(&dec->lock);
+        return AVERROR(ENOMEM);
+    }
+
+    // Least loaded instance; ties rotate so equal instances take turns
+    ParallelWorker *target = NULL;
+    uint32_t best_load = UINT32_MAX;
+    for (int i = 0; i < dec->count; i++) {
+        ParallelWorker *w = &dec->workers[(dec->next_worker + i) % dec->count];
+        uint32_t load = w->in_count + w->await_count + (w->busy ? 1 : 0);
+        if (load < best_load) {
+            best_load = load;
+            target = w;
+        }
+    }
+    dec->next_worker = (dec->next_worker + 1) % dec->count;
+
+    int64_t seq = dec->next_seq++;
+    dec->slots[seq % dec->window].state = PARALLEL_SLOT_PENDING;
+    uint32_t tail = (target->in_head + target->in_count) % dec->window;
+    target->packets[tail] = copy;
+    target->packet_seqs[tail] = seq;
+    target->in_count++;
+    pthread_cond_signal(&target->cond);
+
+    pthread_mutex_unlock(&dec->lock);
+    return 0;
+}
+
+int ff_parallel_decoder_receive_frame(FFParallelDecoder *dec, AVFrame *frame) {
+    if (!dec || !frame) return AVERROR(EINVAL);
+    if (dec->direct) return ff_decoder_receive_frame(dec->direct, frame);
+
+    pthread_mutex_lock(&dec->lock);
+    for (;;) {
+        if (dec->out_seq == dec->next_seq) {
+            int ret = dec->draining ? AVERROR_EOF : AVERROR(EAGAIN);
+            pthread_mutex_unlock(&dec->lock);
+            return ret;
+        }
+
+        ParallelSlot *slot = &dec->slots[dec->out_seq % dec->window];
+        if (slot->state == PARALLEL_SLOT_DONE) {
+            bool has_frame = slot->has_frame;
+            if (has_frame) av_frame_move_ref(frame, slot->frame);
+            slot->has_frame = false;
+            slot->state = PARALLEL_SLOT_FREE;
+            dec->out_seq++;
+            if (has_frame) {
+                pthread_mutex_unlock(&dec->lock);
+                return 0;
+            }
+            continue;
+        }
+
+        // Only wait when the caller has no more packets to give
+        if (!dec->draining && dec->next_seq - dec->out_seq < dec->window) {
+            pthread_mutex_unlock(&dec->lock);
+            return AVERROR(EAGAIN);
+        }
+        pthread_cond_wait(&dec->done_cond, &dec->lock);
+    }
+}
+
+void ff_parallel_decoder_flush(FFParallelDecoder *dec) {
+    if (!dec) return;
+    if (dec->direct) {
+        ff_decoder_flush(dec->direct);
+        return;
+    }
+
+    pthread_mutex_lock(&dec->lock);
+    parallel_drop_queued(dec);
+
+    // Instances can only be reset while no worker is inside one
+    for (;;) {
+        bool busy = false;
+        for (int i = 0; i < dec->count; i++) busy |= dec->workers[i].busy;
+        if (!busy) break;
+        pthread_cond_wait(&dec->done_cond, &dec->lock);
+    }
+
+    for (int i = 0; i < dec->count; i++) {
+        ParallelWorker *w = &dec->workers[i];
+        ff_decoder_flush(w->decoder);
+        w->await_head = w->await_count = 0;
+        w->in_head = 0;
+        w->drain = w->drained = false;
+    }
+    for (uint32_t i = 0; i < dec->window; i++) {
+        av_frame_unref(dec->slots[i].frame);
+        dec->slots[i].has_frame = false;
+        dec->slots[i].state = PARALLEL_SLOT_FREE;
+    }
+    dec->next_seq = dec->out_seq = 0;
+    dec->draining = false;
+
+    pthread_mutex_unlock(&dec->lock);
+}
+
+// -----------------------------------------------------------------------------
+// Info
+// -----------------------------------------------------------------------------
+
+int ff_parallel_decoder_instance_count(FFParallelDecoder *dec) {
+    return dec ? dec->count : 0;
+}
+
+int ff_parallel_decoder_get_pixel_format(FFParallelDecoder *dec) {
+    if (!dec) return AV_PIX_FMT_NONE;
+    return ff_decoder_get_pixel_format(dec->direct ? dec->direct : dec->workers[0].decoder);
+}
+
+uint64_t ff_parallel_decoder_error_count(FFParallelDecoder *dec) {
+    if (!dec) return 0;
+    pthread_mutex_lock(&dec->lock);
+    uint64_t errors = dec->errors;
+    pthread_mutex_unlock(&dec->lock);
+    return errors;
+}
@@ -0,0 +1,383 @@
+/**
+ * ff_params.c
+ *
+ * Reclamation uses one hazard pointer per reader: a reader publishes the
+ * snapshot it is about to use and then checks it is still current. Every
+ * retired snapshot that is not some reader's hazard is freed at once, so a
+ * reader that stops reading pins only the snapshot it last saw, not every
+ * version published after it.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_params.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARAMS_CACHE_LINE   64
+
+typedef struct {
+    FFParamType type;
+    union {
+        int64_t i;
+        double d;
+        char s[FF_PARAMS_MAX_STRING];
+    } v;
+} ParamValue;
+
+struct FFParamSnapshot {
+    uint64_t version;
+    struct FFParamSnapshot *retired_next;
+    uint32_t count;
+    ParamValue values[];
+};
+
+struct FFParamReader {
+    // Written by its own thread on every version change, read by writers
+    _Alignas(PARAMS_CACHE_LINE) FFParamSnapshot *hazard;
+    FFParamStore *store;
+    struct FFParamReader *next;
+};
+
+struct FFParamWrite {
+    FFParamStore *store;
+    FFParamSnapshot *draft;
+    bool dirty;
+};
+
+struct FFParamStore {
+    FFParamSnapshot *current;           // Atomic; the only thing readers touch
+    pthread_mutex_t write_lock;         // Writers, registration, reclamation
+
+    char keys[FF_PARAMS_MAX_COUNT][FF_PARAMS_MAX_KEY];
+    FFParamReader *readers;
+    FFParamSnapshot *retired;           // At most one per reader after reclaim
+    FFParamWrite write;
+};
+
+// -----------------------------------------------------------------------------
+// Snapshots (write lock held)
+// -----------------------------------------------------------------------------
+
+static FFParamSnapshot* snapshot_alloc(uint32_t count) {
+    return calloc(1, sizeof(FFParamSnapshot) + count * sizeof(ParamValue));
+}
+
+static FFParamSnapshot* snapshot_copy(const FFParamSnapshot *src, uint32_t count) {
+    FFParamSnapshot *snap = snapshot_alloc(count);
+    if (!snap) return NULL;
+    snap->count = count;
+    memcpy(snap->values, src->values, src->count * sizeof(ParamValue));
+    return snap;
+}
+
+static bool snapshot_in_use(FFParamStore *store, const FFParamSnapshot *snap) {
+    for (FFParamReader *r = store->readers; r; r = r->next) {
+        if (__atomic_load_n(&r->hazard, __ATOMIC_SEQ_CST) == snap) return true;
+    }
+    return false;
+}
+
+// Free retired snapshots that no reader is using
+static void store_reclaim(FFParamStore *store) {
+    FFParamSnapshot **link = &store->retired;
+    while (*link) {
+        FFParamSnapshot *snap = *link;
+        if (!snapshot_in_use(store, snap)) {
+            *link = snap->retired_next;
+            free(snap);
+        } else {
+            link = &snap->retired_next;
+        }
+    }
+}
+
+static uint64_t store_publish(FFParamStore *store, FFParamSnapshot *snap) {
+    FFParamSnapshot *old = store->current;
+    snap->version = old->version + 1;
+    __atomic_store_n(&store->current, snap, __ATOMIC_SEQ_CST);
+
+    old->retired_next = store->retired;
+    store->retired = old;
+    store_reclaim(store);
+    return snap->version;
+}
+
+// -----------------------------------------------------------------------------
+// Store
+// -----------------------------------------------------------------------------
+
+FFParamStore* ff_params_create(void) {
+    FFParamStore *store = calloc(1, sizeof(FFParamStore));
+    if (!store) return NULL;
+
+    store->current = snapshot_alloc(0);
+    if (!store->current) {
+        free(store);
+        return NULL;
+    }
+    store->current->version = 1;
+    pthread_mutex_init(&store->write_lock, NULL);
+    return store;
+}
+
+void ff_params_destroy(FFParamStore* store) {
+    if (!store) return;
+
+    while (store->retired) {
+        FFParamSnapshot *snap = store->retired;
+        store->retired = snap->retired_next;
+        free(snap);
+    }
+    free(store->current);
+    pthread_mutex_destroy(&store->write_lock);
+    free(store);
+}
+
+static int store_find(FFParamStore *store, const char *key) {
+    for (uint32_t i = 0; i < store->current->count; i++) {
+        if (strcmp(store->keys[i], key) == 0) return (int)i;
+    }
+    return AVERROR(ENOENT);
+}
+
+static int store_add(FFParamStore *store, const char *key, const ParamValue *value) {
+    if (!store || !key || !key[0] || strlen(key) >= FF_PARAMS_MAX_KEY) return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&store->write_lock);
+    uint32_t count = store->current->count;
+    int ret;
+    if (store_find(store, key) >= 0) {
+        ret = AVERROR(EEXIST);
+    } else if (count >= FF_PARAMS_MAX_COUNT) {
+        ret = AVERROR(ENOSPC);
+    } else {
+        FFParamSnapshot *snap = snapshot_copy(store->current, count + 1);
+        if (!snap) {
+            ret = AVERROR(ENOMEM);
+        } else {
+            snap->values[count] = *value;
+            strcpy(store->keys[count], key);
+            store_publish(store, snap);
+            ret = (int)count;
+        }
+    }
+    pthread_mutex_unlock(&store->write_lock);
+    return ret;
+}
+
+int ff_params_add_int(FFParamStore* store, const char* key, int64_t value) {
+    ParamValue v = { .type = FF_PARAM_INT, .v.i = value };
+    return store_add(store, key, &v);
+}
+
+int ff_params_add_double(FFParamStore* store, const char* key, double value) {
+    ParamValue v = { .type = FF_PARAM_DOUBLE, .v.d = value };
+    return store_add(store, key, &v);
+}
+
+int ff_params_add_string(FFParamStore* store, const char* key, const char* value) {
+    ParamValue v = { .type = FF_PARAM_STRING };
+    if (value) snprintf(v.v.s, sizeof(v.v.s), "%s", value);
+    return store_add(store, key, &v);
+}
+
+int ff_params_find(FFParamStore* store, const char* key) {
+    if (!store || !key) return AVERROR(EINVAL);
+    pthread_mutex_lock(&store->write_lock);
+    int ret = store_find(store, key);
+    pthread_mutex_unlock(&store->write_lock);
+    return ret;
+}
+
+uint64_t ff_params_version(FFParamStore* store) {
+    if (!store) return 0;
+    return __atomic_load_n(&store->current, __ATOMIC_ACQUIRE)->version;
+}
+
+// -----------------------------------------------------------------------------
+// Writing
+// -----------------------------------------------------------------------------
+
+FFParamWrite* ff_params_write_begin(FFParamStore* store) {
+    if (!store) return NULL;
+
+    pthread_mutex_lock(&store->write_lock);
+    FFParamWrite *write = &store->write;
+    write->store = store;
+    write->dirty = false;
+    write->draft = snapshot_copy(store->current, store->current->count);
+    if (!write->draft) {
+        pthread_mutex_unlock(&store->write_lock);
+        return NULL;
+    }
+    return write;
+}
+
+static ParamValue* write_slot(FFParamWrite *write, int index, FFParamType type) {
+    if (!write || index < 0 || (uint32_t)index >= write->draft->count) return NULL;
+    ParamValue *slot = &write->draft->values[index];
+    return slot->type == type ? slot : NULL;
+}
+
+int ff_params_write_int(FFParamWrite* write, int index, int64_t value) {
+    ParamValue *slot = write_slot(write, index, FF_PARAM_INT);
+    if (!slot) return AVERROR(EINVAL);
+    if (slot->v.i != value) {
+        slot->v.i = value;
+        write->dirty = true;
+    }
+    return 0;
+}
+
+int ff_params_write_double(FFParamWrite* write, int index, double value) {
+    ParamValue *slot = write_slot(write, index, FF_PARAM_DOUBLE);
+    if (!slot) return AVERROR(EINVAL);
+    if (slot->v.d != value) {
+        slot->v.d = value;
+        write->dirty = true;
+    }
+    return 0;
+}
+
+int ff_params_write_string(FFParamWrite* write, int index, const char* value) {
+    ParamValue *slot = write_slot(write, index, FF_PARAM_STRING);
+    if (!slot) return AVERROR(EINVAL);
+    char s[FF_PARAMS_MAX_STRING] = { 0 };
+    if (value) snprintf(s, sizeof(s), "%s", value);
+    if (strcmp(slot->v.s, s) != 0) {
+        memcpy(slot->v.s, s, sizeof(s));
+        write->dirty = true;
+    }
+    return 0;
+}
+
+uint64_t ff_params_write_commit(FFParamWrite* write) {
+    if (!write) return 0;
+    FFParamStore *store = write->store;
+
+    uint64_t version;
+    if (write->dirty) {
+        version = store_publish(store, write->draft);
+    } else {
+        free(write->draft);
+        version = store->current->version;
+    }
+    write->draft = NULL;
+    pthread_mutex_unlock(&store->write_lock);
+    return version;
+}
+
+void ff_params_write_abort(FFParamWrite* write) {
+    if (!write) return;
+    free(write->draft);
+    write->draft = NULL;
+    pthread_mutex_unlock(&write->store->write_lock);
+}
+
+int ff_params_set_int(FFParamStore* store, int index, int64_t value) {
+    FFParamWrite *write = ff_params_write_begin(store);
+    if (!write) return AVERROR(ENOMEM);
+    int ret = ff_params_write_int(write, index, value);
+    if (ret < 0) ff_params_write_abort(write);
+    else ff_params_write_commit(write);
+    return ret;
+}
+
+int ff_params_set_double(FFParamStore* store, int index, double value) {
+    FFParamWrite *write = ff_params_write_begin(store);
+    if (!write) return AVERROR(ENOMEM);
+    int ret = ff_params_write_double(write, index, value);
+    if (ret < 0) ff_params_write_abort(write);
+    else ff_params_write_commit(write);
+    return ret;
+}
+
+int ff_params_set_string(FFParamStore* store, int index, const char* value) {
+    FFParamWrite *write = ff_params_write_begin(store);
+    if (!write) return AVERROR(ENOMEM);
+    int ret = ff_params_write_string(write, index, value);
+    if (ret < 0) ff_params_write_abort(write);
+    else ff_params_write_commit(write);
+    return ret;
+}
+
+// -----------------------------------------------------------------------------
+// Reading
+// -----------------------------------------------------------------------------
+
+FFParamReader* ff_params_reader_create(FFParamStore* store) {
+    if (!store) return NULL;
+
+    FFParamReader *reader = NULL;
+    if (posix_memalign((void **)&reader, PARAMS_CACHE_LINE, sizeof(FFParamReader)) != 0)
+        return NULL;
+    memset(reader, 0, sizeof(FFParamReader));
+    reader->store = store;
+
+    // Registered on the current snapshot, which cannot be retired while
+    // the write lock is held
+    pthread_mutex_lock(&store->write_lock);
+    reader->hazard = store->current;
+    reader->next = store->readers;
+    store->readers = reader;
+    pthread_mutex_unlock(&store->write_lock);
+    return reader;
+}
+
+void ff_params_reader_destroy(FFParamReader* reader) {
+    if (!reader) return;
+    FFParamStore *store = reader->store;
+
+    pthread_mutex_lock(&store->write_lock);
+    for (FFParamReader **link = &store->readers; *link; link = &(*link)->next) {
+        if (*link == reader) {
+            *link = reader->next;
+            break;
+        }
+    }
+    store_reclaim(store);
+    pthread_mutex_unlock(&store->write_lock);
+    free(reader);
+}
+
+const FFParamSnapshot* ff_params_read(FFParamReader* reader) {
+    FFParamStore *store = reader->store;
+    FFParamSnapshot *snap = __atomic_load_n(&store->current, __ATOMIC_SEQ_CST);
+    // Announce only on change, so steady-state reads are a single load. A
+    // snapshot still current after the announcement was not retired before
+    // it, so the writer's next reclaim sees the hazard
+    while (snap != reader->hazard) {
+        __atomic_store_n(&reader->hazard, snap, __ATOMIC_SEQ_CST);
+        FFParamSnapshot *now = __atomic_load_n(&store->current, __ATOMIC_SEQ_CST);
+        if (now == snap) break;
+        snap = now;
+    }
+    return snap;
+}
+
+static const ParamValue* snapshot_slot(const FFParamSnapshot *snap, int index, FFParamType type) {
+    if (!snap || index < 0 || (uint32_t)index >= snap->count) return NULL;
+    const ParamValue *slot = &snap->values[index];
+    return slot->type == type ? slot : NULL;
+}
+
+uint64_t ff_params_snapshot_version(const FFParamSnapshot* snap) {
+    return snap ? snap->version : 0;
+}
+
+int64_t ff_params_snapshot_int(const FFParamSnapshot* snap, int index) {
+    const ParamValue *slot = snapshot_slot(snap, index, FF_PARAM_INT);
+    return slot ? slot->v.i : 0;
+}
+
+double ff_params_snapshot_double(const FFParamSnapshot* snap, int index) {
+    const ParamValue *slot = snapshot_slot(snap, index, FF_PARAM_DOUBLE);
+    return slot ? slot->v.d : 0.0;
+}
+
+const char* ff_params_snapshot_string(const FFParamSnapshot* snap, int index) {
+    const ParamValue *slot = snapshot_slot(snap, index, FF_PARAM_STRING);
+    return slot ? slot->v.s : "";
+}
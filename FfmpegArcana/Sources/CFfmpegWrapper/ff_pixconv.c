@@ -0,0 +1,527 @@
+/**
+ * ff_pixconv.c
+ *
+ * Every output row comes from one kernel: reduce (10 -> 8 bits, same
+ * layout), reduce_split (UVUV -> two planes), reduce_merge (two planes ->
+ * UVUV) or yuv_to_bgra. Dither reaches the SIMD kernels as a per-row bias
+ * pattern, so truncation and ordered dither share one code path. Error
+ * diffusion carries error from each pixel to the next and stays scalar.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_pixconv.h"
+#include <libavutil/mem.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define PIXCONV_NEON 1
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define PIXCONV_SSE2 1
+#endif
+
+// Thresholds in sixteenths. A 2-bit residual has four levels, so on planes
+// the matrix collapses to its 2x2 core (>> 2); BGRA keeps all sixteen since
+// its 10-bit values carry fractional bits.
+static const uint8_t bayer4[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+// Per-row dither bias for the kernels
+typedef struct {
+    uint16_t planar[16];    // Added before >> 2, indexed by pixel
+    uint16_t inter[16];     // Same, indexed by sample of a UVUV row
+    int32_t bias[4];        // BGRA: added to Q13 10-bit values before >> 15
+} RowDither;
+
+// YUV -> 10-bit RGB, Q13
+typedef struct {
+    int16_t y_off;
+    int16_t cy, rv, gu, gv, bu;
+} YuvCoeffs;
+
+struct FFPixConv {
+    int width, height;
+    int src_format, dst_format;
+    int shift;              // Bits below the 10-bit sample (6 for P010)
+    bool src_interleaved;   // Chroma as UVUV (P010) rather than two planes
+    FFDitherMode dither;
+
+    int16_t *chroma_u;      // BGRA: one chroma row, centred on 0
+    int16_t *chroma_v;
+    uint16_t *rgb10;        // BGRA error diffusion: one row of 10-bit RGB
+    int32_t *err[3][2];     // Error diffusion: this row and the next, per component
+    int err_len;
+};
+
+static inline uint8_t clamp8(int v) {
+    return v < 0 ? 0 : v > 255 ? 255 : (uint8_t)v;
+}
+
+static inline int clamp10(int v) {
+    return v < 0 ? 0 : v > 1023 ? 1023 : v;
+}
+
+void ff_pixconv_dither_pattern(FFDitherMode mode, int y, uint16_t *pattern) {
+    for (int i = 0; i < 16; i++)
+        pattern[i] = mode == FF_DITHER_ORDERED ? bayer4[y & 3][i & 3] >> 2 : 0;
+}
+
+static void row_dither(FFDitherMode mode, int y, RowDither *d) {
+    const uint8_t *row = bayer4[y & 3];
+    bool ordered = mode == FF_DITHER_ORDERED;
+    ff_pixconv_dither_pattern(mode, y, d->planar);
+    for (int i = 0; i < 16; i++)
+        d->inter[i] = ordered ? row[(i >> 1) & 3] >> 2 : 0;
+    // Truncation rounds to 10 bits first; ordered puts the threshold
+    // mid-step, (2b + 1) / 32 of an 8-bit step
+    for (int i = 0; i < 4; i++)
+        d->bias[i] = ordered ? (2 * row[i] + 1) * 1024 : 1 << 12;
+}
+
+// -----------------------------------------------------------------------------
+// Row kernels
+// -----------------------------------------------------------------------------
+
+void ff_pixconv_reduce_row(const uint16_t *src, uint8_t *dst, int n, int shift,
+                           const uint16_t *pattern) {
+    int i = 0;
+#if defined(PIXCONV_NEON)
+    int16x8_t sh = vdupq_n_s16((int16_t)-shift);
+    uint16x8_t d0 = vld1q_u16(pattern), d1 = vld1q_u16(pattern + 8);
+    for (; i + 16 <= n; i += 16) {
+        uint16x8_t a = vqaddq_u16(vshlq_u16(vld1q_u16(src + i), sh), d0);
+        uint16x8_t b = vqaddq_u16(vshlq_u16(vld1q_u16(src + i + 8), sh), d1);
+        vst1q_u8(dst + i, vcombine_u8(vqshrn_n_u16(a, 2), vqshrn_n_u16(b, 2)));
+    }
+#elif defined(PIXCONV_SSE2)
+    __m128i sh = _mm_cvtsi32_si128(shift);
+    __m128i d0 = _mm_loadu_si128((const __m128i *)pattern);
+    __m128i d1 = _mm_loadu_si128((const __m128i *)(pattern + 8));
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_adds_epu16(_mm_srl_epi16(_mm_loadu_si128((const __m128i *)(src + i)), sh), d0);
+        __m128i b = _mm_adds_epu16(_mm_srl_epi16(_mm_loadu_si128((const __m128i *)(src + i + 8)), sh), d1);
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_packus_epi16(_mm_srli_epi16(a, 2), _mm_srli_epi16(b, 2)));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = clamp8(((src[i] >> shift) + pattern[i & 15]) >> 2);
+}
+
+// UVUV -> U and V planes
+static void reduce_split(const uint16_t *src, uint8_t *u, uint8_t *v, int pairs, int shift,
+                         const RowDither *d) {
+    int k = 0;
+#if defined(PIXCONV_NEON)
+    int16x8_t sh = vdupq_n_s16((int16_t)-shift);
+    uint16x8_t d0 = vld1q_u16(d->planar);
+    for (; k + 8 <= pairs; k += 8) {
+        uint16x8x2_t uv = vld2q_u16(src + 2 * k);
+        vst1_u8(u + k, vqshrn_n_u16(vqaddq_u16(vshlq_u16(uv.val[0], sh), d0), 2));
+        vst1_u8(v + k, vqshrn_n_u16(vqaddq_u16(vshlq_u16(uv.val[1], sh), d0), 2));
+    }
+#elif defined(PIXCONV_SSE2)
+    __m128i sh = _mm_cvtsi32_si128(shift);
+    __m128i d0 = _mm_loadu_si128((const __m128i *)d->inter);
+    __m128i low = _mm_set1_epi32(0xFFFF);
+    for (; k + 8 <= pairs; k += 8) {
+        // Reduce while still interleaved; the results fit in 14 bits, so
+        // the signed 32 -> 16 pack cannot saturate
+        __m128i a = _mm_adds_epu16(_mm_srl_epi16(_mm_loadu_si128((const __m128i *)(src + 2 * k)), sh), d0);
+        __m128i b = _mm_adds_epu16(_mm_srl_epi16(_mm_loadu_si128((const __m128i *)(src + 2 * k + 8)), sh), d0);
+        a = _mm_srli_epi16(a, 2);
+        b = _mm_srli_epi16(b, 2);
+        __m128i us = _mm_packs_epi32(_mm_and_si128(a, low), _mm_and_si128(b, low));
+        __m128i vs = _mm_packs_epi32(_mm_srli_epi32(a, 16), _mm_srli_epi32(b, 16));
+        _mm_storel_epi64((__m128i *)(u + k), _mm_packus_epi16(us, us));
+        _mm_storel_epi64((__m128i *)(v + k), _mm_packus_epi16(vs, vs));
+    }
+#endif
+    for (; k < pairs; k++) {
+        u[k] = clamp8(((src[2 * k] >> shift) + d->planar[k & 15]) >> 2);
+        v[k] = clamp8(((src[2 * k + 1] >> shift) + d->planar[k & 15]) >> 2);
+    }
+}
+
+// U and V planes -> UVUV
+void ff_pixconv_reduce_merge(const uint16_t *u, const uint16_t *v, uint8_t *dst, int pairs, int shift,
+                             const uint16_t *pattern) {
+    int k = 0;
+#if defined(PIXCONV_NEON)
+    int16x8_t sh = vdupq_n_s16((int16_t)-shift);
+    uint16x8_t d0 = vld1q_u16(pattern);
+    for (; k + 8 <= pairs; k += 8) {
+        uint8x8x2_t uv;
+        uv.val[0] = vqshrn_n_u16(vqaddq_u16(vshlq_u16(vld1q_u16(u + k), sh), d0), 2);
+        uv.val[1] = vqshrn_n_u16(vqaddq_u16(vshlq_u16(vld1q_u16(v + k), sh), d0), 2);
+        vst2_u8(dst + 2 * k, uv);
+    }
+#elif defined(PIXCONV_SSE2)
+    __m128i sh = _mm_cvtsi32_si128(shift);
+    __m128i d0 = _mm_loadu_si128((const __m128i *)pattern);
+    __m128i max8 = _mm_set1_epi16(255);
+    for (; k + 8 <= pairs; k += 8) {
+        __m128i a = _mm_adds_epu16(_mm_srl_epi16(_mm_loadu_si128((const __m128i *)(u + k)), sh), d0);
+        __m128i b = _mm_adds_epu16(_mm_srl_epi16(_mm_loadu_si128((const __m128i *)(v + k)), sh), d0);
+        a = _mm_min_epi16(_mm_srli_epi16(a, 2), max8);
+        b = _mm_min_epi16(_mm_srli_epi16(b, 2), max8);
+        _mm_storeu_si128((__m128i *)(dst + 2 * k), _mm_or_si128(a, _mm_slli_epi16(b, 8)));
+    }
+#endif
+    for (; k < pairs; k++) {
+        dst[2 * k] = clamp8(((u[k] >> shift) + pattern[k & 15]) >> 2);
+        dst[2 * k + 1] = clamp8(((v[k] >> shift) + pattern[k & 15]) >> 2);
+    }
+}
+
+#if defined(PIXCONV_NEON)
+static inline uint8x8_t bgra_narrow(int32x4_t lo, int32x4_t hi) {
+    return vqmovn_u16(vcombine_u16(vqshrun_n_s32(lo, 15), vqshrun_n_s32(hi, 15)));
+}
+#elif defined(PIXCONV_SSE2)
+// Y and one chroma per 32-bit lane against (ky, kc), plus bias, >> 15
+static inline __m128i bgra_channel(__m128i yy, __m128i cc, __m128i k, __m128i bias) {
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(yy, cc), k), bias);
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(yy, cc), k), bias);
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 15), _mm_srai_epi32(hi, 15));
+}
+
+static inline __m128i coeff_pair(int16_t a, int16_t b) {
+    return _mm_set_epi16(b, a, b, a, b, a, b, a);
+}
+#endif
+
+// One row of luma plus its (half-width, centred) chroma to BGRA
+static void yuv_to_bgra_row(const uint16_t *y, int shift, const int16_t *cu, const int16_t *cv,
+                            uint8_t *dst, int w, const YuvCoeffs *c, const int32_t *bias) {
+    int x = 0;
+#if defined(PIXCONV_NEON)
+    int16x8_t sh = vdupq_n_s16((int16_t)-shift);
+    uint16x8_t mask = vdupq_n_u16(0x3FF);
+    int16x8_t yoff = vdupq_n_s16(c->y_off);
+    int32x4_t b4 = vld1q_s32(bias);
+    for (; x + 8 <= w; x += 8) {
+        int16x8_t yy = vsubq_s16(vreinterpretq_s16_u16(vandq_u16(vshlq_u16(vld1q_u16(y + x), sh), mask)), yoff);
+        int16x4_t u4 = vld1_s16(cu + x / 2), v4 = vld1_s16(cv + x / 2);
+        int16x4x2_t u2 = vzip_s16(u4, u4), v2 = vzip_s16(v4, v4);
+        int32x4_t ylo = vmlal_n_s16(b4, vget_low_s16(yy), c->cy);
+        int32x4_t yhi = vmlal_n_s16(b4, vget_high_s16(yy), c->cy);
+
+        uint8x8x4_t px;
+        px.val[0] = bgra_narrow(vmlal_n_s16(ylo, u2.val[0], c->bu), vmlal_n_s16(yhi, u2.val[1], c->bu));
+        px.val[1] = bgra_narrow(vmlsl_n_s16(vmlsl_n_s16(ylo, u2.val[0], c->gu), v2.val[0], c->gv),
+                                vmlsl_n_s16(vmlsl_n_s16(yhi, u2.val[1], c->gu), v2.val[1], c->gv));
+        px.val[2] = bgra_narrow(vmlal_n_s16(ylo, v2.val[0], c->rv), vmlal_n_s16(yhi, v2.val[1], c->rv));
+        px.val[3] = vdup_n_u8(255);
+        vst4_u8(dst + 4 * x, px);
+    }
+#elif defined(PIXCONV_SSE2)
+    __m128i sh = _mm_cvtsi32_si128(shift);
+    __m128i mask = _mm_set1_epi16(0x3FF);
+    __m128i yoff = _mm_set1_epi16(c->y_off);
+    __m128i b4 = _mm_loadu_si128((const __m128i *)bias);
+    __m128i k_b = coeff_pair(c->cy, c->bu);
+    __m128i k_r = coeff_pair(c->cy, c->rv);
+    __m128i k_g = coeff_pair(c->cy, (int16_t)-c->gu);
+    __m128i k_gv = coeff_pair((int16_t)-c->gv, 0);
+    __m128i zero = _mm_setzero_si128();
+    __m128i alpha = _mm_set1_epi8((char)0xFF);
+    for (; x + 8 <= w; x += 8) {
+        __m128i yy = _mm_sub_epi16(_mm_and_si128(_mm_srl_epi16(_mm_loadu_si128((const __m128i *)(y + x)), sh), mask), yoff);
+        __m128i uu = _mm_loadl_epi64((const __m128i *)(cu + x / 2));
+        __m128i vv = _mm_loadl_epi64((const __m128i *)(cv + x / 2));
+        uu = _mm_unpacklo_epi16(uu, uu);
+        vv = _mm_unpacklo_epi16(vv, vv);
+
+        __m128i b = bgra_channel(yy, uu, k_b, b4);
+        __m128i r = bgra_channel(yy, vv, k_r, b4);
+        // Green has three terms: the V product is added as a second madd
+        __m128i glo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(yy, uu), k_g),
+                                    _mm_madd_epi16(_mm_unpacklo_epi16(vv, zero), k_gv));
+        __m128i ghi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(yy, uu), k_g),
+                                    _mm_madd_epi16(_mm_unpackhi_epi16(vv, zero), k_gv));
+        __m128i g = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(glo, b4), 15),
+                                    _mm_srai_epi32(_mm_add_epi32(ghi, b4), 15));
+
+        __m128i bg = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), _mm_packus_epi16(g, g));
+        __m128i ra = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), alpha);
+        _mm_storeu_si128((__m128i *)(dst + 4 * x), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i *)(dst + 4 * x + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+#endif
+    for (; x < w; x++) {
+        int yv = (int)((y[x] >> shift) & 0x3FF) - c->y_off;
+        int u = cu[x >> 1], v = cv[x >> 1];
+        int base = c->cy * yv + bias[x & 3];
+        dst[4 * x + 0] = clamp8((base + c->bu * u) >> 15);
+        dst[4 * x + 1] = clamp8((base - c->gu * u - c->gv * v) >> 15);
+        dst[4 * x + 2] = clamp8((base + c->rv * v) >> 15);
+        dst[4 * x + 3] = 255;
+    }
+}
+
+// Floyd-Steinberg along one row of one component, in sixteenths of a
+// 10-bit step. cur carries error into this row and next collects it for
+// the one below; both are indexed by pixel + 1 and hold weighted sums.
+static void diffuse_row(const uint16_t *src, int sstep, int shift, uint8_t *dst, int dstep, int n,
+                        int32_t *cur, int32_t *next) {
+    int32_t right = 0;
+    for (int i = 0; i < n; i++) {
+        int want = (int)((src[i * sstep] >> shift) & 0x3FF) * 16 + ((cur[i + 1] + right) >> 4);
+        int q = clamp8((want + 32) >> 6);
+        int e = want - q * 64;
+        dst[i * dstep] = (uint8_t)q;
+        right = e * 7;
+        next[i] += e * 3;
+        next[i + 1] += e * 5;
+        next[i + 2] += e;
+    }
+}
+
+static void diffuse_reset(FFPixConv *conv) {
+    for (int c = 0; c < 3; c++)
+        for (int r = 0; r < 2; r++)
+            memset(conv->err[c][r], 0, conv->err_len * sizeof(int32_t));
+}
+
+static void diffuse_advance(FFPixConv *conv, int c) {
+    int32_t *done = conv->err[c][0];
+    conv->err[c][0] = conv->err[c][1];
+    conv->err[c][1] = done;
+    memset(done, 0, conv->err_len * sizeof(int32_t));
+}
+
+static void diffuse(FFPixConv *conv, int c, const uint16_t *src, int sstep, int shift,
+                    uint8_t *dst, int dstep, int n) {
+    diffuse_row(src, sstep, shift, dst, dstep, n, conv->err[c][0], conv->err[c][1]);
+    diffuse_advance(conv, c);
+}
+
+// -----------------------------------------------------------------------------
+// Frame conversion
+// -----------------------------------------------------------------------------
+
+static inline const uint16_t *row16(const AVFrame *f, int plane, int y) {
+    return (const uint16_t *)(f->data[plane] + (ptrdiff_t)y * f->linesize[plane]);
+}
+
+static inline uint8_t *row8(AVFrame *f, int plane, int y) {
+    return f->data[plane] + (ptrdiff_t)y * f->linesize[plane];
+}
+
+static void convert_planes(FFPixConv *conv, const AVFrame *src, AVFrame *dst) {
+    int w = conv->width, h = conv->height;
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    int shift = conv->shift;
+    bool diffusing = conv->dither == FF_DITHER_ERROR_DIFFUSION;
+    bool nv12 = conv->dst_format == AV_PIX_FMT_NV12;
+    RowDither d;
+
+    if (diffusing) diffuse_reset(conv);
+    for (int y = 0; y < h; y++) {
+        if (diffusing) {
+            diffuse(conv, 0, row16(src, 0, y), 1, shift, row8(dst, 0, y), 1, w);
+        } else {
+            row_dither(conv->dither, y, &d);
+            ff_pixconv_reduce_row(row16(src, 0, y), row8(dst, 0, y), w, shift, d.planar);
+        }
+    }
+
+    for (int y = 0; y < ch; y++) {
+        row_dither(conv->dither, y, &d);
+        if (conv->src_interleaved) {
+            const uint16_t *uv = row16(src, 1, y);
+            if (nv12 && diffusing) {
+                diffuse(conv, 1, uv, 2, shift, row8(dst, 1, y), 2, cw);
+                diffuse(conv, 2, uv + 1, 2, shift, row8(dst, 1, y) + 1, 2, cw);
+            } else if (nv12) {
+                ff_pixconv_reduce_row(uv, row8(dst, 1, y), 2 * cw, shift, d.inter);
+            } else if (diffusing) {
+                diffuse(conv, 1, uv, 2, shift, row8(dst, 1, y), 1, cw);
+                diffuse(conv, 2, uv + 1, 2, shift, row8(dst, 2, y), 1, cw);
+            } else {
+                reduce_split(uv, row8(dst, 1, y), row8(dst, 2, y), cw, shift, &d);
+            }
+        } else {
+            const uint16_t *u = row16(src, 1, y), *v = row16(src, 2, y);
+            if (nv12 && diffusing) {
+                diffuse(conv, 1, u, 1, shift, row8(dst, 1, y), 2, cw);
+                diffuse(conv, 2, v, 1, shift, row8(dst, 1, y) + 1, 2, cw);
+            } else if (nv12) {
+                ff_pixconv_reduce_merge(u, v, row8(dst, 1, y), cw, shift, d.planar);
+            } else if (diffusing) {
+                diffuse(conv, 1, u, 1, shift, row8(dst, 1, y), 1, cw);
+                diffuse(conv, 2, v, 1, shift, row8(dst, 2, y), 1, cw);
+            } else {
+                ff_pixconv_reduce_row(u, row8(dst, 1, y), cw, shift, d.planar);
+                ff_pixconv_reduce_row(v, row8(dst, 2, y), cw, shift, d.planar);
+            }
+        }
+    }
+}
+
+static void yuv_coeffs(const AVFrame *src, YuvCoeffs *c) {
+    double kr = 0.2126, kb = 0.0722;
+    switch (src->colorspace) {
+    case AVCOL_SPC_BT470BG:
+    case AVCOL_SPC_SMPTE170M:
+        kr = 0.299; kb = 0.114;
+        break;
+    case AVCOL_SPC_BT2020_NCL:
+    case AVCOL_SPC_BT2020_CL:
+        kr = 0.2627; kb = 0.0593;
+        break;
+    default:
+        break;
+    }
+    double kg = 1.0 - kr - kb;
+
+    // Limited range: Y 64..940 and chroma 64..960 stretched to 0..1023
+    bool full = src->color_range == AVCOL_RANGE_JPEG;
+    double ys = full ? 1.0 : 1023.0 / 876.0;
+    double cs = full ? 1.0 : 1023.0 / 896.0;
+    c->y_off = full ? 0 : 64;
+    c->cy = (int16_t)lrint(ys * 8192);
+    c->rv = (int16_t)lrint(cs * 2 * (1 - kr) * 8192);
+    c->bu = (int16_t)lrint(cs * 2 * (1 - kb) * 8192);
+    c->gu = (int16_t)lrint(cs * 2 * (1 - kb) * kb / kg * 8192);
+    c->gv = (int16_t)lrint(cs * 2 * (1 - kr) * kr / kg * 8192);
+}
+
+static void load_chroma(FFPixConv *conv, const AVFrame *src, int y) {
+    int cw = (conv->width + 1) / 2;
+    int shift = conv->shift;
+    if (conv->src_interleaved) {
+        const uint16_t *uv = row16(src, 1, y);
+        for (int k = 0; k < cw; k++) {
+            conv->chroma_u[k] = (int16_t)(((uv[2 * k] >> shift) & 0x3FF) - 512);
+            conv->chroma_v[k] = (int16_t)(((uv[2 * k + 1] >> shift) & 0x3FF) - 512);
+        }
+    } else {
+        const uint16_t *u = row16(src, 1, y), *v = row16(src, 2, y);
+        for (int k = 0; k < cw; k++) {
+            conv->chroma_u[k] = (int16_t)(((u[k] >> shift) & 0x3FF) - 512);
+            conv->chroma_v[k] = (int16_t)(((v[k] >> shift) & 0x3FF) - 512);
+        }
+    }
+}
+
+static void bgra_diffuse_row(FFPixConv *conv, const uint16_t *y, uint8_t *dst, const YuvCoeffs *c) {
+    int w = conv->width;
+    uint16_t *rgb = conv->rgb10;
+    for (int x = 0; x < w; x++) {
+        int yv = (int)((y[x] >> conv->shift) & 0x3FF) - c->y_off;
+        int u = conv->chroma_u[x >> 1], v = conv->chroma_v[x >> 1];
+        int base = c->cy * yv + (1 << 12);
+        rgb[3 * x + 0] = (uint16_t)clamp10((base + c->rv * v) >> 13);
+        rgb[3 * x + 1] = (uint16_t)clamp10((base - c->gu * u - c->gv * v) >> 13);
+        rgb[3 * x + 2] = (uint16_t)clamp10((base + c->bu * u) >> 13);
+        dst[4 * x + 3] = 255;
+    }
+    // R, G, B land at bytes 2, 1, 0
+    for (int ch = 0; ch < 3; ch++)
+        diffuse(conv, ch, rgb + ch, 3, 0, dst + 2 - ch, 4, w);
+}
+
+static void convert_bgra(FFPixConv *conv, const AVFrame *src, AVFrame *dst) {
+    YuvCoeffs c;
+    yuv_coeffs(src, &c);
+    bool diffusing = conv->dither == FF_DITHER_ERROR_DIFFUSION;
+    RowDither d;
+
+    if (diffusing) diffuse_reset(conv);
+    for (int y = 0; y < conv->height; y++) {
+        if (!(y & 1)) load_chroma(conv, src, y >> 1);
+        if (diffusing) {
+            bgra_diffuse_row(conv, row16(src, 0, y), row8(dst, 0, y), &c);
+            continue;
+        }
+        row_dither(conv->dither, y, &d);
+        yuv_to_bgra_row(row16(src, 0, y), conv->shift, conv->chroma_u, conv->chroma_v,
+                        row8(dst, 0, y), conv->width, &c, d.bias);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+bool ff_pixconv_supported(int src_format, int dst_format) {
+    bool src_ok = src_format == AV_PIX_FMT_P010LE || src_format == AV_PIX_FMT_YUV420P10LE;
+    bool dst_ok = dst_format == AV_PIX_FMT_NV12 || dst_format == AV_PIX_FMT_YUV420P ||
+                  dst_format == AV_PIX_FMT_BGRA;
+    return src_ok && dst_ok;
+}
+
+FFPixConv* ff_pixconv_create(int width, int height, int src_format, int dst_format) {
+    if (width <= 0 || height <= 0 || !ff_pixconv_supported(src_format, dst_format)) return NULL;
+
+    FFPixConv *conv = av_mallocz(sizeof(FFPixConv));
+    if (!conv) return NULL;
+
+    conv->width = width;
+    conv->height = height;
+    conv->src_format = src_format;
+    conv->dst_format = dst_format;
+    conv->src_interleaved = src_format == AV_PIX_FMT_P010LE;
+    conv->shift = conv->src_interleaved ? 6 : 0;
+    conv->dither = FF_DITHER_NONE;
+
+    // Chroma rows are read 4 at a time by the BGRA kernels; pad to match
+    int cw = (width + 1) / 2 + 4;
+    conv->err_len = width + 2;
+    bool bgra = dst_format == AV_PIX_FMT_BGRA;
+    bool failed = false;
+    if (bgra) {
+        conv->chroma_u = av_malloc(cw * sizeof(int16_t));
+        conv->chroma_v = av_malloc(cw * sizeof(int16_t));
+        conv->rgb10 = av_malloc((size_t)width * 3 * sizeof(uint16_t));
+        failed = !conv->chroma_u || !conv->chroma_v || !conv->rgb10;
+    }
+    for (int c = 0; c < 3 && !failed; c++) {
+        for (int r = 0; r < 2 && !failed; r++) {
+            conv->err[c][r] = av_mallocz(conv->err_len * sizeof(int32_t));
+            failed = !conv->err[c][r];
+        }
+    }
+    if (failed) {
+        ff_pixconv_destroy(conv);
+        return NULL;
+    }
+    return conv;
+}
+
+void ff_pixconv_destroy(FFPixConv* conv) {
+    if (!conv) return;
+    av_free(conv->chroma_u);
+    av_free(conv->chroma_v);
+    av_free(conv->rgb10);
+    for (int c = 0; c < 3; c++)
+        for (int r = 0; r < 2; r++)
+            av_free(conv->err[c][r]);
+    av_free(conv);
+}
+
+void ff_pixconv_set_dither(FFPixConv* conv, FFDitherMode mode) {
+    if (conv) conv->dither = mode;
+}
+
+int ff_pixconv_convert(FFPixConv* conv, const AVFrame* src, AVFrame* dst) {
+    if (!conv || !src || !dst) return AVERROR(EINVAL);
+    if (src->format != conv->src_format || dst->format != conv->dst_format ||
+        src->width != conv->width || src->height != conv->height ||
+        dst->width != conv->width || dst->height != conv->height)
+        return AVERROR(EINVAL);
+
+    if (conv->dst_format == AV_PIX_FMT_BGRA)
+        convert_bgra(conv, src, dst);
+    else
+        convert_planes(conv, src, dst);
+    return 0;
+}
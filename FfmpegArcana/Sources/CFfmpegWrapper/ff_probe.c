@@ -0,0 +1,183 @@
+/**
+ * ff_probe.c
+ *
+ * Batch media-info probing. Workers pull the next path index from a shared
+ * counter, so slow files (network mounts, huge headers) never hold up a
+ * statically assigned share of the batch.
+ */
+
+#include "include/ff_probe.h"
+#include <libavutil/dict.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// Single file
+// -----------------------------------------------------------------------------
+
+static void probe_copy_name(char *dst, const char *src) {
+    snprintf(dst, FF_PROBE_NAME_SIZE, "%s", src ? src : "");
+}
+
+// Does the container header leave anything a catalogue needs unknown?
+static bool probe_needs_analysis(AVFormatContext *fmt_ctx) {
+    if (fmt_ctx->nb_streams == 0 || fmt_ctx->duration == AV_NOPTS_VALUE) return true;
+
+    for (unsigned i = 0; i < fmt_ctx->nb_streams; i++) {
+        AVStream *stream = fmt_ctx->streams[i];
+        AVCodecParameters *par = stream->codecpar;
+        if (par->codec_id == AV_CODEC_ID_NONE) return true;
+
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+            if (par->width <= 0 || par->height <= 0 || par->format < 0) return true;
+            if (!stream->avg_frame_rate.num && !stream->r_frame_rate.num) return true;
+        } else if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+            if (par->sample_rate <= 0 || par->ch_layout.nb_channels <= 0) return true;
+        }
+    }
+    return false;
+}
+
+static void probe_fill_stream(AVStream *stream, FFProbeStream *out) {
+    AVCodecParameters *par = stream->codecpar;
+
+    out->index = stream->index;
+    out->media_type = par->codec_type;
+    out->codec_id = par->codec_id;
+    probe_copy_name(out->codec_name, avcodec_get_name(par->codec_id));
+    out->bit_rate = par->bit_rate;
+    if (stream->duration != AV_NOPTS_VALUE && stream->time_base.den)
+        out->duration = stream->duration * av_q2d(stream->time_base);
+
+    if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+        AVRational fps = stream->avg_frame_rate;
+        if (fps.num == 0 || fps.den == 0) fps = stream->r_frame_rate;
+
+        out->width = par->width;
+        out->height = par->height;
+        out->pixel_format = par->format;
+        out->fps_num = fps.num;
+        out->fps_den = fps.den;
+    } else if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+        out->sample_rate = par->sample_rate;
+        out->channels = par->ch_layout.nb_channels;
+    }
+}
+
+void ff_probe_options_default(FFProbeOptions *options) {
+    if (!options) return;
+    memset(options, 0, sizeof(*options));
+    options->probe_size = FF_PROBE_DEFAULT_PROBE_SIZE;
+    options->analyze_duration = FF_PROBE_DEFAULT_ANALYZE_DURATION;
+}
+
+int ff_probe_file(const char *path, const FFProbeOptions *options, FFProbeResult *result) {
+    if (!result) return AVERROR(EINVAL);
+    memset(result, 0, sizeof(*result));
+    result->video_stream_index = -1;
+    result->audio_stream_index = -1;
+    if (!path) return result->status = AVERROR(EINVAL);
+
+    FFProbeOptions defaults;
+    ff_probe_options_default(&defaults);
+    if (!options) options = &defaults;
+
+    // Fast-open budget: the container header plus a short look at the packets
+    AVDictionary *format_opts = NULL;
+    av_dict_set_int(&format_opts, "probesize",
+                    options->probe_size > 0 ? options->probe_size : defaults.probe_size, 0);
+    av_dict_set_int(&format_opts, "analyzeduration",
+                    options->analyze_duration > 0 ? options->analyze_duration : defaults.analyze_duration, 0);
+
+    AVFormatContext *fmt_ctx = NULL;
+    int ret = avformat_open_input(&fmt_ctx, path, NULL, &format_opts);
+    av_dict_free(&format_opts);
+    if (ret < 0) return result->status = ret;
+
+    if ((options->flags & FF_PROBE_FULL) || probe_needs_analysis(fmt_ctx)) {
+        ret = avformat_find_stream_info(fmt_ctx, NULL);
+        if (ret < 0) {
+            avformat_close_input(&fmt_ctx);
+            return result->status = ret;
+        }
+    }
+
+    probe_copy_name(result->format_name, fmt_ctx->iformat ? fmt_ctx->iformat->name : NULL);
+    if (fmt_ctx->duration != AV_NOPTS_VALUE)
+        result->duration = (double)fmt_ctx->duration / AV_TIME_BASE;
+    result->bit_rate = fmt_ctx->bit_rate;
+    result->stream_count = (int)fmt_ctx->nb_streams;
+    result->video_stream_index = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    result->audio_stream_index = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
+    if (result->video_stream_index < 0) result->video_stream_index = -1;
+    if (result->audio_stream_index < 0) result->audio_stream_index = -1;
+
+    unsigned count = FFMIN(fmt_ctx->nb_streams, (unsigned)FF_PROBE_MAX_STREAMS);
+    for (unsigned i = 0; i < count; i++)
+        probe_fill_stream(fmt_ctx->streams[i], &result->streams[i]);
+
+    avformat_close_input(&fmt_ctx);
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Batch
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    const char *const *paths;
+    int count;
+    const FFProbeOptions *options;
+    FFProbeResult *results;
+    int next;                       // Next index to claim (atomic)
+    int succeeded;                  // Atomic
+} ProbeBatch;
+
+static void* probe_worker(void *arg) {
+    ProbeBatch *batch = arg;
+    int succeeded = 0;
+
+    for (;;) {
+        int i = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED);
+        if (i >= batch->count) break;
+        if (ff_probe_file(batch->paths[i], batch->options, &batch->results[i]) == 0)
+            succeeded++;
+    }
+
+    __atomic_fetch_add(&batch->succeeded, succeeded, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+int ff_probe_batch(const char *const *paths, int n, const FFProbeOptions *options,
+                   FFProbeResult *results) {
+    if (n < 0 || (n > 0 && (!paths || !results))) return AVERROR(EINVAL);
+    if (n == 0) return 0;
+
+    ProbeBatch batch = {
+        .paths = paths,
+        .count = n,
+        .options = options,
+        .results = results,
+    };
+
+    // Probing mostly waits on I/O, so oversubscribe the CPUs a little
+    long thread_count = options ? (long)options->thread_count : 0;
+    if (thread_count <= 0) thread_count = FFMAX(sysconf(_SC_NPROCESSORS_ONLN), 1) * 2;
+    thread_count = FFMIN(FFMIN(thread_count, FF_PROBE_MAX_THREADS), n);
+
+    // The calling thread is one of the workers
+    pthread_t threads[FF_PROBE_MAX_THREADS - 1];
+    int started = 0;
+    for (long i = 1; i < thread_count; i++) {
+        if (pthread_create(&threads[started], NULL, probe_worker, &batch) != 0) break;
+        started++;
+    }
+
+    probe_worker(&batch);
+    for (int i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    return batch.succeeded;
+}
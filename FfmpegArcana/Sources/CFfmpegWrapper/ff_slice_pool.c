@@ -0,0 +1,140 @@
+/**
+ * ff_slice_pool.c
+ *
+ * Workers sleep on a generation counter. A run publishes the job, bumps
+ * the generation and then claims slices alongside the workers, one at a
+ * time under the lock; slices are a few rows of a frame, so the lock is
+ * taken far less often than the work it guards.
+ */
+
+#include "ff_internal.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    struct FFSlicePool *pool;
+    pthread_t thread;
+    int index;
+    bool started;
+} SliceWorker;
+
+struct FFSlicePool {
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;       // New job or shutdown
+    pthread_cond_t done_cond;       // Last slice of the job finished
+    SliceWorker *workers;           // threads - 1 of them; the caller is worker 0
+    int threads;
+
+    FFSliceFunc func;
+    void *opaque;
+    int nb_slices;
+    int next_slice;                 // Next unclaimed slice
+    int pending;                    // Slices not yet finished
+    uint64_t generation;
+    bool shutdown;
+};
+
+// Called and returns with the lock held
+static void slice_pool_work(FFSlicePool *pool, int worker) {
+    while (pool->next_slice < pool->nb_slices) {
+        int slice = pool->next_slice++;
+        FFSliceFunc func = pool->func;
+        void *opaque = pool->opaque;
+        int nb_slices = pool->nb_slices;
+
+        pthread_mutex_unlock(&pool->lock);
+        func(opaque, slice, nb_slices, worker);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0) pthread_cond_signal(&pool->done_cond);
+    }
+}
+
+static void *slice_worker_main(void *arg) {
+    SliceWorker *worker = arg;
+    FFSlicePool *pool = worker->pool;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen)
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        slice_pool_work(pool, worker->index);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+FFSlicePool* ff_slice_pool_create(int threads) {
+    if (threads <= 0) threads = (int)FFMAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+
+    FFSlicePool *pool = calloc(1, sizeof(FFSlicePool));
+    if (!pool) return NULL;
+    pool->threads = threads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    if (threads > 1) {
+        pool->workers = calloc(threads - 1, sizeof(SliceWorker));
+        if (!pool->workers) { ff_slice_pool_destroy(pool); return NULL; }
+        for (int i = 0; i < threads - 1; i++) {
+            SliceWorker *w = &pool->workers[i];
+            w->pool = pool;
+            w->index = i + 1;
+            if (pthread_create(&w->thread, NULL, slice_worker_main, w) != 0) {
+                ff_slice_pool_destroy(pool);
+                return NULL;
+            }
+            w->started = true;
+        }
+    }
+    return pool;
+}
+
+void ff_slice_pool_destroy(FFSlicePool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; pool->workers && i < pool->threads - 1; i++)
+        if (pool->workers[i].started) pthread_join(pool->workers[i].thread, NULL);
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+int ff_slice_pool_threads(const FFSlicePool *pool) {
+    return pool ? pool->threads : 1;
+}
+
+void ff_slice_pool_run(FFSlicePool *pool, FFSliceFunc func, void *opaque, int nb_slices) {
+    if (!func || nb_slices <= 0) return;
+    if (!pool || pool->threads <= 1 || nb_slices == 1) {
+        for (int s = 0; s < nb_slices; s++) func(opaque, s, nb_slices, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->opaque = opaque;
+    pool->nb_slices = nb_slices;
+    pool->next_slice = 0;
+    pool->pending = nb_slices;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+
+    slice_pool_work(pool, 0);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,583 @@
+/**
+ * ff_tonemap.c
+ *
+ * Each slice walks row pairs (one chroma row) through four steps:
+ *   1. Y'CbCr BT.2020 -> R'G'B' 10-bit codes (integer matrix, SIMD)
+ *   2. Codes -> linear light through a LUT, scaled by a tone gain looked up
+ *      from max(R',G',B'); the transfer is monotonic, so the code maximum
+ *      picks the same channel as the linear one and hue is preserved
+ *   3. BT.2020 -> BT.709 primaries and clamp (float matrix, SIMD), then
+ *      the BT.709 OETF through a LUT back to 10-bit codes
+ *   4. BGRA packing, or BT.709 Y'CbCr with chroma averaged over the 2x2
+ *      block, reduced to 8 bits with the ff_pixconv dither
+ * LUTs depend only on transfer, peak and curve, and are rebuilt when one
+ * of those changes.
+ */
+
+#include "ff_internal.h"
+#include "include/ff_tonemap.h"
+#include <libavutil/mem.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define TONEMAP_NEON 1
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define TONEMAP_SSE2 1
+#endif
+
+#define SDR_WHITE_NITS      100.0   // Linear 1.0; SDR output white
+#define DEFAULT_PEAK_NITS   1000.0f
+#define OETF_LUT_SIZE       4096    // Linear 0..1 in steps under 0.2 of an 8-bit code
+#define SLICES_PER_THREAD   4
+
+// SMPTE ST 2084
+#define PQ_M1   0.1593017578125
+#define PQ_M2   78.84375
+#define PQ_C1   0.8359375
+#define PQ_C2   18.8515625
+#define PQ_C3   18.6875
+
+// ARIB STD-B67
+#define HLG_A   0.17883277
+#define HLG_B   0.28466892
+#define HLG_C   0.55991073
+
+// Linear BT.2020 RGB -> linear BT.709 RGB
+static const float gamut_2020_to_709[3][3] = {
+    {  1.660491f, -0.587641f, -0.072850f },
+    { -0.124550f,  1.132900f, -0.008349f },
+    { -0.018151f, -0.100579f,  1.118730f }
+};
+
+// out_k = clamp(0..1023, (m[k][0] a + m[k][1] b + m[k][2] c + off[k]) >> 13)
+typedef struct {
+    int16_t m[3][3];
+    int32_t off[3];
+} IntMatrix;
+
+// Per-worker rows; see tonemap_pair
+typedef struct {
+    int16_t *yy, *uu, *vv;          // Centred luma and per-pixel chroma
+    uint16_t *r[2], *g[2], *b[2];   // R'G'B' codes, 2020 then 709
+    float *fr, *fg, *fb;            // Tone-mapped linear light
+    int16_t *ar, *ag, *ab;          // 2x2 chroma block averages
+    uint16_t *y10, *cb, *cr;        // BT.709 Y'CbCr before reduction
+} TonemapScratch;
+
+struct FFToneMap {
+    int width, height;
+    int src_format, dst_format;
+    int shift;                      // Bits below the 10-bit sample (6 for P010)
+    bool src_interleaved;           // Chroma as UVUV (P010) rather than two planes
+    FFToneCurve curve;
+    FFDitherMode dither;
+    float peak_nits;                // 0 = DEFAULT_PEAK_NITS
+
+    // LUTs and what they were built for
+    bool lut_valid;
+    int lut_trc;
+    float lut_peak;
+    FFToneCurve lut_curve;
+    float lin[1024];                // R'G'B' code -> linear, 1.0 = SDR white
+    float gain[1024];               // Tone curve gain by max(R',G',B') code
+    uint16_t oetf[OETF_LUT_SIZE];   // Linear 0..1 -> BT.709 10-bit code
+
+    IntMatrix to_rgb;               // From the source's range, per frame
+    int y_off;                      // Luma black level of that range
+    IntMatrix to_yuv;               // BT.709 limited range, fixed
+
+    FFSlicePool *pool;
+    TonemapScratch *scratch;        // One per pool thread
+    void *scratch_mem;
+    int nb_workers;
+
+    const AVFrame *src;             // During ff_tonemap_process
+    AVFrame *dst;
+};
+
+static inline uint8_t clamp8(int v) {
+    return v < 0 ? 0 : v > 255 ? 255 : (uint8_t)v;
+}
+
+static inline int16_t q13(double v) {
+    return (int16_t)lrint(v * 8192);
+}
+
+// -----------------------------------------------------------------------------
+// Transfer functions and curves (LUT construction only)
+// -----------------------------------------------------------------------------
+
+static double pq_eotf(double e) {
+    double p = pow(FFMAX(e, 0.0), 1.0 / PQ_M2);
+    return 10000.0 * pow(FFMAX(p - PQ_C1, 0.0) / (PQ_C2 - PQ_C3 * p), 1.0 / PQ_M1);
+}
+
+static double pq_inverse_eotf(double nits) {
+    double y = pow(FFMAX(nits, 0.0) / 10000.0, PQ_M1);
+    return pow((PQ_C1 + PQ_C2 * y) / (1.0 + PQ_C3 * y), PQ_M2);
+}
+
+static double hlg_inverse_oetf(double e) {
+    return e <= 0.5 ? e * e / 3.0 : (exp((e - HLG_C) / HLG_A) + HLG_B) / 12.0;
+}
+
+static double bt709_oetf(double l) {
+    return l < 0.018 ? 4.5 * l : 1.099 * pow(l, 0.45) - 0.099;
+}
+
+static double hable(double x) {
+    const double a = 0.15, b = 0.50, c = 0.10, d = 0.20, e = 0.02, f = 0.30;
+    return (x * (a * x + c * b) + d * e) / (x * (a * x + b) + d * f) - e / f;
+}
+
+// BT.2390 EETF: a Hermite knee in PQ space, normalised to the source peak
+static double bt2390(double x, double peak) {
+    double src = pq_inverse_eotf(peak * SDR_WHITE_NITS);
+    double max_lum = pq_inverse_eotf(SDR_WHITE_NITS) / src;
+    double ks = FFMAX(1.5 * max_lum - 0.5, 0.0);
+    double e1 = FFMIN(pq_inverse_eotf(x * SDR_WHITE_NITS) / src, 1.0);
+    double e2 = e1;
+    if (e1 > ks) {
+        double t = (e1 - ks) / (1.0 - ks), t2 = t * t, t3 = t2 * t;
+        e2 = (2 * t3 - 3 * t2 + 1) * ks + (t3 - 2 * t2 + t) * (1 - ks) + (-2 * t3 + 3 * t2) * max_lum;
+    }
+    return pq_eotf(e2 * src) / SDR_WHITE_NITS;
+}
+
+// x and peak in units of SDR white
+static double tone_curve(FFToneCurve curve, double x, double peak) {
+    if (peak <= 1.0) return x;
+    switch (curve) {
+    case FF_TONE_CURVE_REINHARD: return x * (1.0 + x / (peak * peak)) / (1.0 + x);
+    case FF_TONE_CURVE_BT2390:   return bt2390(x, peak);
+    default:                     return hable(x) / hable(peak);
+    }
+}
+
+static void tonemap_build_luts(FFToneMap *tm, int trc) {
+    double peak_nits = tm->peak_nits > 0 ? tm->peak_nits : DEFAULT_PEAK_NITS;
+    double peak = peak_nits / SDR_WHITE_NITS;
+    // HLG system gamma for the display peak (BT.2100), applied per
+    // component rather than on luminance to keep this a 1D lookup
+    double hlg_gamma = 1.2 + 0.42 * log10(peak_nits / 1000.0);
+
+    for (int c = 0; c < 1024; c++) {
+        double e = c / 1023.0;
+        double l = trc == AVCOL_TRC_ARIB_STD_B67
+            ? peak * pow(hlg_inverse_oetf(e), hlg_gamma)
+            : pq_eotf(e) / SDR_WHITE_NITS;
+        tm->lin[c] = (float)l;
+        tm->gain[c] = l > 0 ? (float)(tone_curve(tm->curve, l, peak) / l) : 1.0f;
+    }
+    for (int i = 0; i < OETF_LUT_SIZE; i++)
+        tm->oetf[i] = (uint16_t)lrint(bt709_oetf(i / (double)(OETF_LUT_SIZE - 1)) * 1023.0);
+
+    tm->lut_valid = true;
+    tm->lut_trc = trc;
+    tm->lut_peak = tm->peak_nits;
+    tm->lut_curve = tm->curve;
+}
+
+static void rgb_matrix_from_frame(FFToneMap *tm, const AVFrame *src) {
+    const double kr = 0.2627, kb = 0.0593, kg = 1.0 - kr - kb;
+    bool full = src->color_range == AVCOL_RANGE_JPEG;
+    IntMatrix *m = &tm->to_rgb;
+    tm->y_off = full ? 0 : 64;
+    double ys = full ? 1.0 : 1023.0 / 876.0;
+    double cs = full ? 1.0 : 1023.0 / 896.0;
+    int16_t cy = q13(ys);
+    *m = (IntMatrix){
+        .m = {
+            { cy, 0, q13(cs * 2 * (1 - kr)) },
+            { cy, q13(-cs * 2 * (1 - kb) * kb / kg), q13(-cs * 2 * (1 - kr) * kr / kg) },
+            { cy, q13(cs * 2 * (1 - kb)), 0 }
+        },
+        .off = { 1 << 12, 1 << 12, 1 << 12 }
+    };
+}
+
+static void yuv_matrix_709(IntMatrix *m) {
+    const double kr = 0.2126, kb = 0.0722, kg = 1.0 - kr - kb;
+    const double ys = 876.0 / 1023.0, cs = 896.0 / 1023.0;
+    const double cb = 2 * (1 - kb), cr = 2 * (1 - kr);
+    *m = (IntMatrix){
+        .m = {
+            { q13(ys * kr), q13(ys * kg), q13(ys * kb) },
+            { q13(-cs * kr / cb), q13(-cs * kg / cb), q13(cs * 0.5) },
+            { q13(cs * 0.5), q13(-cs * kg / cr), q13(-cs * kb / cr) }
+        },
+        .off = { (64 << 13) + (1 << 12), (512 << 13) + (1 << 12), (512 << 13) + (1 << 12) }
+    };
+}
+
+// -----------------------------------------------------------------------------
+// Row kernels
+// -----------------------------------------------------------------------------
+
+#if defined(TONEMAP_SSE2)
+static inline __m128i coeff_pair(int16_t a, int16_t b) {
+    return _mm_set_epi16(b, a, b, a, b, a, b, a);
+}
+#endif
+
+// Outputs left NULL are skipped. Coefficients are copied to locals first:
+// the uint16_t stores may alias the int16_t matrix, which would otherwise be
+// reloaded on every iteration.
+static void matrix_row(const int16_t *a, const int16_t *b, const int16_t *c, int n,
+                       const IntMatrix *m, uint16_t *const out[3]) {
+    int i = 0;
+#if defined(TONEMAP_NEON)
+    int16_t k0[3], k1[3], k2[3];
+    int32x4_t off[3];
+    for (int k = 0; k < 3; k++) {
+        k0[k] = m->m[k][0]; k1[k] = m->m[k][1]; k2[k] = m->m[k][2];
+        off[k] = vdupq_n_s32(m->off[k]);
+    }
+    uint16x8_t max10 = vdupq_n_u16(1023);
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t va = vld1q_s16(a + i), vb = vld1q_s16(b + i), vc = vld1q_s16(c + i);
+        for (int k = 0; k < 3; k++) {
+            if (!out[k]) continue;
+            int32x4_t lo = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(off[k], vget_low_s16(va), k0[k]),
+                                                   vget_low_s16(vb), k1[k]),
+                                       vget_low_s16(vc), k2[k]);
+            int32x4_t hi = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(off[k], vget_high_s16(va), k0[k]),
+                                                   vget_high_s16(vb), k1[k]),
+                                       vget_high_s16(vc), k2[k]);
+            vst1q_u16(out[k] + i, vminq_u16(vcombine_u16(vqshrun_n_s32(lo, 13), vqshrun_n_s32(hi, 13)), max10));
+        }
+    }
+#elif defined(TONEMAP_SSE2)
+    __m128i k01[3], k2[3], off[3];
+    for (int k = 0; k < 3; k++) {
+        k01[k] = coeff_pair(m->m[k][0], m->m[k][1]);
+        k2[k] = coeff_pair(m->m[k][2], 0);
+        off[k] = _mm_set1_epi32(m->off[k]);
+    }
+    __m128i zero = _mm_setzero_si128();
+    __m128i max10 = _mm_set1_epi16(1023);
+    for (; i + 8 <= n; i += 8) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i vc = _mm_loadu_si128((const __m128i *)(c + i));
+        __m128i ab_lo = _mm_unpacklo_epi16(va, vb), ab_hi = _mm_unpackhi_epi16(va, vb);
+        __m128i c_lo = _mm_unpacklo_epi16(vc, zero), c_hi = _mm_unpackhi_epi16(vc, zero);
+        for (int k = 0; k < 3; k++) {
+            if (!out[k]) continue;
+            __m128i lo = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(ab_lo, k01[k]), _mm_madd_epi16(c_lo, k2[k])), off[k]);
+            __m128i hi = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(ab_hi, k01[k]), _mm_madd_epi16(c_hi, k2[k])), off[k]);
+            __m128i v = _mm_packs_epi32(_mm_srai_epi32(lo, 13), _mm_srai_epi32(hi, 13));
+            _mm_storeu_si128((__m128i *)(out[k] + i), _mm_min_epi16(_mm_max_epi16(v, zero), max10));
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            if (!out[k]) continue;
+            int v = (m->m[k][0] * a[i] + m->m[k][1] * b[i] + m->m[k][2] * c[i] + m->off[k]) >> 13;
+            out[k][i] = (uint16_t)(v < 0 ? 0 : v > 1023 ? 1023 : v);
+        }
+    }
+}
+
+// Linear BT.2020 (already tone mapped) -> BT.709 codes for one output channel
+static inline uint16_t gamut_oetf(const FFToneMap *tm, int k, float r, float g, float b) {
+    const float *row = gamut_2020_to_709[k];
+    float v = row[0] * r + row[1] * g + row[2] * b;
+    v = v < 0.0f ? 0.0f : v > 1.0f ? 1.0f : v;
+    return tm->oetf[(int)(v * (OETF_LUT_SIZE - 1) + 0.5f)];
+}
+
+// R'G'B' 2020 codes in, R'G'B' 709 codes out, in place
+static void tone_row(const FFToneMap *tm, TonemapScratch *sc, uint16_t *r, uint16_t *g, uint16_t *b, int n) {
+    float *fr = sc->fr, *fg = sc->fg, *fb = sc->fb;
+    for (int i = 0; i < n; i++) {
+        float k = tm->gain[FFMAX3(r[i], g[i], b[i])];
+        fr[i] = tm->lin[r[i]] * k;
+        fg[i] = tm->lin[g[i]] * k;
+        fb[i] = tm->lin[b[i]] * k;
+    }
+
+    uint16_t *out[3] = { r, g, b };
+    int i = 0;
+#if defined(TONEMAP_NEON)
+    float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f);
+    float32x4_t half = vdupq_n_f32(0.5f);
+    float32x4_t scale = vdupq_n_f32(OETF_LUT_SIZE - 1);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t vr = vld1q_f32(fr + i), vg = vld1q_f32(fg + i), vb = vld1q_f32(fb + i);
+        for (int k = 0; k < 3; k++) {
+            const float *row = gamut_2020_to_709[k];
+            float32x4_t v = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vr, row[0]), vg, row[1]), vb, row[2]);
+            v = vminq_f32(vmaxq_f32(v, zero), one);
+            int32_t idx[4];
+            vst1q_s32(idx, vcvtq_s32_f32(vmlaq_f32(half, v, scale)));
+            for (int j = 0; j < 4; j++) out[k][i + j] = tm->oetf[idx[j]];
+        }
+    }
+#elif defined(TONEMAP_SSE2)
+    __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 scale = _mm_set1_ps(OETF_LUT_SIZE - 1);
+    for (; i + 4 <= n; i += 4) {
+        __m128 vr = _mm_loadu_ps(fr + i), vg = _mm_loadu_ps(fg + i), vb = _mm_loadu_ps(fb + i);
+        for (int k = 0; k < 3; k++) {
+            const float *row = gamut_2020_to_709[k];
+            __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vr, _mm_set1_ps(row[0])),
+                                             _mm_mul_ps(vg, _mm_set1_ps(row[1]))),
+                                  _mm_mul_ps(vb, _mm_set1_ps(row[2])));
+            v = _mm_min_ps(_mm_max_ps(v, zero), one);
+            int32_t idx[4];
+            _mm_storeu_si128((__m128i *)idx, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half)));
+            for (int j = 0; j < 4; j++) out[k][i + j] = tm->oetf[idx[j]];
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        float vr = fr[i], vg = fg[i], vb = fb[i];
+        for (int k = 0; k < 3; k++) out[k][i] = gamut_oetf(tm, k, vr, vg, vb);
+    }
+}
+
+static void pack_bgra_row(const uint16_t *r, const uint16_t *g, const uint16_t *b, uint8_t *dst, int n,
+                          const uint16_t *pattern) {
+    int x = 0;
+#if defined(TONEMAP_NEON)
+    uint16x8_t d0 = vld1q_u16(pattern);
+    for (; x + 8 <= n; x += 8) {
+        uint8x8x4_t px;
+        px.val[0] = vqshrn_n_u16(vqaddq_u16(vld1q_u16(b + x), d0), 2);
+        px.val[1] = vqshrn_n_u16(vqaddq_u16(vld1q_u16(g + x), d0), 2);
+        px.val[2] = vqshrn_n_u16(vqaddq_u16(vld1q_u16(r + x), d0), 2);
+        px.val[3] = vdup_n_u8(255);
+        vst4_u8(dst + 4 * x, px);
+    }
+#elif defined(TONEMAP_SSE2)
+    __m128i d0 = _mm_loadu_si128((const __m128i *)pattern);
+    __m128i alpha = _mm_set1_epi8((char)0xFF);
+    for (; x + 8 <= n; x += 8) {
+        __m128i vb = _mm_srli_epi16(_mm_adds_epu16(_mm_loadu_si128((const __m128i *)(b + x)), d0), 2);
+        __m128i vg = _mm_srli_epi16(_mm_adds_epu16(_mm_loadu_si128((const __m128i *)(g + x)), d0), 2);
+        __m128i vr = _mm_srli_epi16(_mm_adds_epu16(_mm_loadu_si128((const __m128i *)(r + x)), d0), 2);
+        __m128i bg = _mm_unpacklo_epi8(_mm_packus_epi16(vb, vb), _mm_packus_epi16(vg, vg));
+        __m128i ra = _mm_unpacklo_epi8(_mm_packus_epi16(vr, vr), alpha);
+        _mm_storeu_si128((__m128i *)(dst + 4 * x), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i *)(dst + 4 * x + 16), _mm_unpackhi_epi16(bg, ra));
+    }
+#endif
+    for (; x < n; x++) {
+        dst[4 * x + 0] = clamp8((b[x] + pattern[x & 15]) >> 2);
+        dst[4 * x + 1] = clamp8((g[x] + pattern[x & 15]) >> 2);
+        dst[4 * x + 2] = clamp8((r[x] + pattern[x & 15]) >> 2);
+        dst[4 * x + 3] = 255;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Slices
+// -----------------------------------------------------------------------------
+
+static inline const uint16_t *row16(const AVFrame *f, int plane, int y) {
+    return (const uint16_t *)(f->data[plane] + (ptrdiff_t)y * f->linesize[plane]);
+}
+
+static inline uint8_t *row8(AVFrame *f, int plane, int y) {
+    return f->data[plane] + (ptrdiff_t)y * f->linesize[plane];
+}
+
+static void load_chroma(const FFToneMap *tm, TonemapScratch *sc, int cy) {
+    const AVFrame *src = tm->src;
+    int shift = tm->shift;
+    for (int x = 0; x < tm->width; x++) {
+        int k = x >> 1;
+        uint16_t u = tm->src_interleaved ? row16(src, 1, cy)[2 * k] : row16(src, 1, cy)[k];
+        uint16_t v = tm->src_interleaved ? row16(src, 1, cy)[2 * k + 1] : row16(src, 2, cy)[k];
+        sc->uu[x] = (int16_t)(((u >> shift) & 0x3FF) - 512);
+        sc->vv[x] = (int16_t)(((v >> shift) & 0x3FF) - 512);
+    }
+}
+
+// Luma rows 2cy and 2cy + 1, chroma row cy
+static void tonemap_pair(FFToneMap *tm, TonemapScratch *sc, int cy) {
+    const AVFrame *src = tm->src;
+    AVFrame *dst = tm->dst;
+    int w = tm->width, cw = (w + 1) / 2;
+    int rows = FFMIN(2, tm->height - 2 * cy);
+    bool bgra = tm->dst_format == AV_PIX_FMT_BGRA;
+    uint16_t pattern[16];
+
+    load_chroma(tm, sc, cy);
+    for (int k = 0; k < rows; k++) {
+        int y = 2 * cy + k;
+        const uint16_t *luma = row16(src, 0, y);
+        for (int x = 0; x < w; x++)
+            sc->yy[x] = (int16_t)(((luma[x] >> tm->shift) & 0x3FF) - tm->y_off);
+
+        uint16_t *rgb[3] = { sc->r[k], sc->g[k], sc->b[k] };
+        matrix_row(sc->yy, sc->uu, sc->vv, w, &tm->to_rgb, rgb);
+        tone_row(tm, sc, rgb[0], rgb[1], rgb[2], w);
+
+        ff_pixconv_dither_pattern(tm->dither, y, pattern);
+        if (bgra) {
+            pack_bgra_row(rgb[0], rgb[1], rgb[2], row8(dst, 0, y), w, pattern);
+        } else {
+            uint16_t *luma_out[3] = { sc->y10, NULL, NULL };
+            matrix_row((const int16_t *)rgb[0], (const int16_t *)rgb[1], (const int16_t *)rgb[2],
+                       w, &tm->to_yuv, luma_out);
+            ff_pixconv_reduce_row(sc->y10, row8(dst, 0, y), w, 0, pattern);
+        }
+    }
+    if (bgra) return;
+
+    // Chroma from the 2x2 average in the gamma domain, as swscale does
+    int last = rows - 1;
+    for (int k = 0; k < cw; k++) {
+        int x0 = 2 * k, x1 = FFMIN(2 * k + 1, w - 1);
+        sc->ar[k] = (int16_t)((sc->r[0][x0] + sc->r[0][x1] + sc->r[last][x0] + sc->r[last][x1] + 2) >> 2);
+        sc->ag[k] = (int16_t)((sc->g[0][x0] + sc->g[0][x1] + sc->g[last][x0] + sc->g[last][x1] + 2) >> 2);
+        sc->ab[k] = (int16_t)((sc->b[0][x0] + sc->b[0][x1] + sc->b[last][x0] + sc->b[last][x1] + 2) >> 2);
+    }
+    uint16_t *chroma_out[3] = { NULL, sc->cb, sc->cr };
+    matrix_row(sc->ar, sc->ag, sc->ab, cw, &tm->to_yuv, chroma_out);
+
+    ff_pixconv_dither_pattern(tm->dither, cy, pattern);
+    if (tm->dst_format == AV_PIX_FMT_NV12) {
+        ff_pixconv_reduce_merge(sc->cb, sc->cr, row8(dst, 1, cy), cw, 0, pattern);
+    } else {
+        ff_pixconv_reduce_row(sc->cb, row8(dst, 1, cy), cw, 0, pattern);
+        ff_pixconv_reduce_row(sc->cr, row8(dst, 2, cy), cw, 0, pattern);
+    }
+}
+
+static void tonemap_slice(void *opaque, int slice, int nb_slices, int worker) {
+    FFToneMap *tm = opaque;
+    int ch = (tm->height + 1) / 2;
+    int first = (int)((int64_t)ch * slice / nb_slices);
+    int end = (int)((int64_t)ch * (slice + 1) / nb_slices);
+    for (int cy = first; cy < end; cy++)
+        tonemap_pair(tm, &tm->scratch[worker], cy);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+bool ff_tonemap_is_hdr(const AVFrame* frame) {
+    return frame && (frame->color_trc == AVCOL_TRC_SMPTE2084 ||
+                     frame->color_trc == AVCOL_TRC_ARIB_STD_B67);
+}
+
+// Lay one worker's rows out from base, 64-byte aligned; with base NULL
+// only the size is computed, so sizing and carving walk the same list
+static size_t tonemap_carve(TonemapScratch *sc, uint8_t *base, size_t w, size_t cw) {
+    size_t off = 0;
+    #define CARVE(field, count) \
+        do { \
+            if (base) (field) = (void *)(base + off); \
+            off += FFALIGN((count) * sizeof(*(field)), 64); \
+        } while (0)
+    CARVE(sc->yy, w); CARVE(sc->uu, w); CARVE(sc->vv, w);
+    for (int k = 0; k < 2; k++) { CARVE(sc->r[k], w); CARVE(sc->g[k], w); CARVE(sc->b[k], w); }
+    CARVE(sc->fr, w); CARVE(sc->fg, w); CARVE(sc->fb, w);
+    CARVE(sc->y10, w);
+    CARVE(sc->ar, cw); CARVE(sc->ag, cw); CARVE(sc->ab, cw);
+    CARVE(sc->cb, cw); CARVE(sc->cr, cw);
+    #undef CARVE
+    return off;
+}
+
+// Carve one allocation into every worker's rows
+static bool tonemap_alloc_scratch(FFToneMap *tm) {
+    size_t w = (size_t)tm->width, cw = (w + 1) / 2;
+    TonemapScratch sizing;
+    size_t per_worker = tonemap_carve(&sizing, NULL, w, cw);
+
+    tm->scratch = av_calloc(tm->nb_workers, sizeof(TonemapScratch));
+    tm->scratch_mem = av_malloc(per_worker * tm->nb_workers);
+    if (!tm->scratch || !tm->scratch_mem) return false;
+
+    for (int i = 0; i < tm->nb_workers; i++)
+        tonemap_carve(&tm->scratch[i], (uint8_t *)tm->scratch_mem + per_worker * i, w, cw);
+    return true;
+}
+
+FFToneMap* ff_tonemap_create(int width, int height, int src_format, int dst_format,
+                             FFToneCurve curve, int threads) {
+    if (width <= 0 || height <= 0) return NULL;
+    if (src_format != AV_PIX_FMT_P010LE && src_format != AV_PIX_FMT_YUV420P10LE) return NULL;
+    if (dst_format != AV_PIX_FMT_NV12 && dst_format != AV_PIX_FMT_YUV420P &&
+        dst_format != AV_PIX_FMT_BGRA) return NULL;
+
+    FFToneMap *tm = av_mallocz(sizeof(FFToneMap));
+    if (!tm) return NULL;
+
+    tm->width = width;
+    tm->height = height;
+    tm->src_format = src_format;
+    tm->dst_format = dst_format;
+    tm->src_interleaved = src_format == AV_PIX_FMT_P010LE;
+    tm->shift = tm->src_interleaved ? 6 : 0;
+    tm->curve = curve;
+    tm->dither = FF_DITHER_NONE;
+    yuv_matrix_709(&tm->to_yuv);
+
+    tm->pool = ff_slice_pool_create(threads);
+    tm->nb_workers = ff_slice_pool_threads(tm->pool);
+    if (!tm->pool || !tonemap_alloc_scratch(tm)) {
+        ff_tonemap_destroy(tm);
+        return NULL;
+    }
+    return tm;
+}
+
+void ff_tonemap_destroy(FFToneMap* tm) {
+    if (!tm) return;
+    ff_slice_pool_destroy(tm->pool);
+    av_free(tm->scratch_mem);
+    av_free(tm->scratch);
+    av_free(tm);
+}
+
+void ff_tonemap_set_curve(FFToneMap* tm, FFToneCurve curve) {
+    if (tm) tm->curve = curve;
+}
+
+void ff_tonemap_set_dither(FFToneMap* tm, FFDitherMode mode) {
+    if (tm) tm->dither = mode == FF_DITHER_NONE ? FF_DITHER_NONE : FF_DITHER_ORDERED;
+}
+
+void ff_tonemap_set_peak(FFToneMap* tm, float peak_nits) {
+    if (tm) tm->peak_nits = FFMAX(peak_nits, 0.0f);
+}
+
+int ff_tonemap_process(FFToneMap* tm, const AVFrame* src, AVFrame* dst) {
+    if (!tm || !src || !dst) return AVERROR(EINVAL);
+    if (src->format != tm->src_format || dst->format != tm->dst_format ||
+        src->width != tm->width || src->height != tm->height ||
+        dst->width != tm->width || dst->height != tm->height)
+        return AVERROR(EINVAL);
+    if (!ff_tonemap_is_hdr(src)) return AVERROR(EINVAL);
+
+    if (!tm->lut_valid || tm->lut_trc != (int)src->color_trc ||
+        tm->lut_peak != tm->peak_nits || tm->lut_curve != tm->curve)
+        tonemap_build_luts(tm, src->color_trc);
+    rgb_matrix_from_frame(tm, src);
+
+    tm->src = src;
+    tm->dst = dst;
+    int ch = (tm->height + 1) / 2;
+    ff_slice_pool_run(tm->pool, tonemap_slice, tm,
+                      FFMIN(ch, tm->nb_workers * SLICES_PER_THREAD));
+    tm->src = NULL;
+    tm->dst = NULL;
+
+    bool bgra = tm->dst_format == AV_PIX_FMT_BGRA;
+    dst->color_primaries = AVCOL_PRI_BT709;
+    dst->color_trc = AVCOL_TRC_BT709;
+    dst->colorspace = bgra ? AVCOL_SPC_RGB : AVCOL_SPC_BT709;
+    dst->color_range = bgra ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+    return 0;
+}
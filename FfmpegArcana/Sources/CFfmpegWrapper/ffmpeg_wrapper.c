@@ -2,13 +2,16 @@
  * ffmpeg_wrapper.c
  */
 
-#include "include/ffmpeg_wrapper.h"
+#include "ff_internal.h"
+#include "include/ff_pixconv.h"
 #include <libavutil/hwcontext.h>
 #include <libavutil/hwcontext_videotoolbox.h>
+#include <libavutil/time.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <unistd.h>
 
 // -----------------------------------------------------------------------------
 // Constants
@@ -23,6 +26,7 @@ const int FF_PIX_FMT_BGRA = AV_PIX_FMT_BGRA;
 const int FF_PIX_FMT_RGBA = AV_PIX_FMT_RGBA;
 const int FF_PIX_FMT_RGB24 = AV_PIX_FMT_RGB24;
 const int FF_PIX_FMT_P010LE = AV_PIX_FMT_P010LE;
+const int FF_PIX_FMT_YUV420P10LE = AV_PIX_FMT_YUV420P10LE;
 const int FF_PIX_FMT_VIDEOTOOLBOX = AV_PIX_FMT_VIDEOTOOLBOX;
 
 const int FF_LOG_QUIET   = AV_LOG_QUIET;
@@ -35,28 +39,24 @@ const int FF_LOG_VERBOSE = AV_LOG_VERBOSE;
 const int FF_LOG_DEBUG   = AV_LOG_DEBUG;
 
 // -----------------------------------------------------------------------------
-// Internal structures
+// Context allocation
 // -----------------------------------------------------------------------------
 
-struct FFDemuxContext {
-    AVFormatContext *fmt_ctx;
-    int video_stream_idx;
-    int audio_stream_idx;
-};
-
-struct FFDecoderContext {
-    AVCodecContext *codec_ctx;
-    AVBufferRef *hw_device_ctx;
-    bool is_hardware;
-    int stream_index;
-    AVRational time_base;
-};
-
-struct FFScalerContext {
-    struct SwsContext *sws_ctx;
-    int src_width, src_height, src_format;
-    int dst_width, dst_height, dst_format;
-};
+// Contexts come from the arena when one is given, otherwise from the heap.
+// Arena contexts register their release function with the arena so that
+// ff_arena_destroy tears down anything the caller did not destroy itself;
+// release functions must therefore be safe to call twice.
+static void *context_alloc(FFArena *arena, size_t size, FFArenaCleanupFunc release) {
+    if (!arena) return calloc(1, size);
+
+    void *ctx = ff_arena_alloc(arena, size);
+    if (ctx && ff_arena_defer(arena, release, ctx) < 0) return NULL;
+    return ctx;
+}
+
+static void context_free(FFArena *arena, void *ctx) {
+    if (!arena) free(ctx);
+}
 
 // -----------------------------------------------------------------------------
 // Error handling
@@ -113,9 +113,22 @@ const char* ff_get_avutil_version(void) {
 // Demuxer
 // -----------------------------------------------------------------------------
 
+static void demux_release(void *opaque) {
+    FFDemuxContext *ctx = opaque;
+    if (ctx->fmt_ctx) avformat_close_input(&ctx->fmt_ctx);
+    if (ctx->aio) ff_async_io_close(ctx->aio);
+    ctx->aio = NULL;
+    av_freep(&ctx->key.path);
+}
+
 FFDemuxContext* ff_demux_create(void) {
-    FFDemuxContext *ctx = calloc(1, sizeof(FFDemuxContext));
+    return ff_demux_create_in(NULL);
+}
+
+FFDemuxContext* ff_demux_create_in(FFArena *arena) {
+    FFDemuxContext *ctx = context_alloc(arena, sizeof(FFDemuxContext), demux_release);
     if (!ctx) return NULL;
+    ctx->arena = arena;
     ctx->video_stream_idx = -1;
     ctx->audio_stream_idx = -1;
     return ctx;
@@ -127,7 +140,12 @@ int ff_demux_open(FFDemuxContext *ctx, const char *url) {
     int ret = avformat_open_input(&ctx->fmt_ctx, url, NULL, NULL);
     if (ret < 0) return ret;
 
-    ret = avformat_find_stream_info(ctx->fmt_ctx, NULL);
+    return ff_demux_finish_open(ctx);
+}
+
+// Stream discovery shared by every way of opening the input
+int ff_demux_finish_open(FFDemuxContext *ctx) {
+    int ret = avformat_find_stream_info(ctx->fmt_ctx, NULL);
     if (ret < 0) {
         avformat_close_input(&ctx->fmt_ctx);
         return ret;
@@ -174,6 +192,12 @@ int ff_demux_get_video_info(FFDemuxContext *ctx,
     return 0;
 }
 
+const AVCodecParameters* ff_demux_get_codec_parameters(FFDemuxContext *ctx, int stream_index) {
+    if (!ctx || !ctx->fmt_ctx) return NULL;
+    if (stream_index < 0 || stream_index >= (int)ctx->fmt_ctx->nb_streams) return NULL;
+    return ctx->fmt_ctx->streams[stream_index]->codecpar;
+}
+
 double ff_demux_get_duration(FFDemuxContext *ctx) {
     if (!ctx || !ctx->fmt_ctx) return 0.0;
     if (ctx->fmt_ctx->duration != AV_NOPTS_VALUE)
@@ -194,8 +218,69 @@ int ff_demux_seek(FFDemuxContext *ctx, double timestamp_seconds) {
 
 void ff_demux_destroy(FFDemuxContext *ctx) {
     if (!ctx) return;
-    if (ctx->fmt_ctx) avformat_close_input(&ctx->fmt_ctx);
-    free(ctx);
+    demux_release(ctx);
+    context_free(ctx->arena, ctx);
+}
+
+// -----------------------------------------------------------------------------
+// Decoder latency tracking
+// -----------------------------------------------------------------------------
+
+#define LATENCY_SLOTS   32      // Packets in flight inside a decoder
+
+typedef struct FFLatencyTracker {
+    struct {
+        int64_t ts;             // Packet pts (dts without one), AV_NOPTS_VALUE = free
+        int64_t sent_us;
+    } slots[LATENCY_SLOTS];
+    uint32_t next;
+    FFDecodeLatencyStats stats;
+    int64_t total_us;
+} FFLatencyTracker;
+
+static int64_t packet_key(const AVPacket *pkt) {
+    return pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+}
+
+static int64_t frame_key(const AVFrame *frame) {
+    return frame->pts != AV_NOPTS_VALUE ? frame->pts : frame->pkt_dts;
+}
+
+static void latency_sent(FFLatencyTracker *lt, const AVPacket *pkt) {
+    int64_t key = packet_key(pkt);
+    if (key == AV_NOPTS_VALUE) return;
+    // Oldest slot is overwritten: its frame was dropped or never matched
+    lt->slots[lt->next].ts = key;
+    lt->slots[lt->next].sent_us = av_gettime_relative();
+    lt->next = (lt->next + 1) % LATENCY_SLOTS;
+}
+
+// Packets in flight are gone after a flush; their timestamps can recur after a seek
+static void latency_forget_in_flight(FFLatencyTracker *lt) {
+    for (uint32_t i = 0; i < LATENCY_SLOTS; i++)
+        lt->slots[i].ts = AV_NOPTS_VALUE;
+    lt->next = 0;
+}
+
+static void latency_received(FFLatencyTracker *lt, const AVFrame *frame) {
+    int64_t key = frame_key(frame);
+    if (key == AV_NOPTS_VALUE) return;
+
+    for (uint32_t i = 0; i < LATENCY_SLOTS; i++) {
+        if (lt->slots[i].ts != key) continue;
+
+        int64_t latency = av_gettime_relative() - lt->slots[i].sent_us;
+        lt->slots[i].ts = AV_NOPTS_VALUE;
+
+        FFDecodeLatencyStats *st = &lt->stats;
+        if (st->frames == 0 || latency < st->min_us) st->min_us = latency;
+        if (latency > st->max_us) st->max_us = latency;
+        st->last_us = latency;
+        st->frames++;
+        lt->total_us += latency;
+        st->mean_us = lt->total_us / (int64_t)st->frames;
+        return;
+    }
 }
 
 // -----------------------------------------------------------------------------
@@ -211,30 +296,135 @@ static enum AVPixelFormat get_hw_format(AVCodecContext *ctx,
     return pix_fmts[0];
 }
 
+static int get_pooled_buffer(AVCodecContext *avctx, AVFrame *frame, int flags) {
+    FFDecoderContext *ctx = avctx->opaque;
+
+    if (ctx && ctx->frame_pool && avctx->codec_type == AVMEDIA_TYPE_VIDEO &&
+        (avctx->codec->capabilities & AV_CODEC_CAP_DR1) &&
+        !ff_pixel_format_is_hardware(frame->format)) {
+        int width = frame->width, height = frame->height;
+        int linesize_align[AV_NUM_DATA_POINTERS];
+        avcodec_align_dimensions2(avctx, &width, &height, linesize_align);
+
+        if (ff_frame_pool_get_buffer(ctx->frame_pool, frame, width, height) == 0)
+            return 0;
+    }
+
+    return avcodec_default_get_buffer2(avctx, frame, flags);
+}
+
+void ff_decoder_key_init(FFDecoderKey *key, const AVCodecParameters *codecpar, bool use_hardware) {
+    memset(key, 0, sizeof(*key));
+    key->codec_id = codecpar->codec_id;
+    key->codec_tag = codecpar->codec_tag;
+    key->profile = codecpar->profile;
+    key->width = codecpar->width;
+    key->height = codecpar->height;
+    key->format = codecpar->format;
+    key->sample_rate = codecpar->sample_rate;
+    key->channels = codecpar->ch_layout.nb_channels;
+    key->use_hardware = use_hardware;
+
+    // FNV-1a over the extradata (SPS/PPS, VPS, codec private data)
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < codecpar->extradata_size; i++) {
+        hash ^= codecpar->extradata[i];
+        hash *= 0x100000001b3ULL;
+    }
+    key->extradata_size = codecpar->extradata_size;
+    key->extradata_hash = hash;
+}
+
+bool ff_decoder_key_equal(const FFDecoderKey *a, const FFDecoderKey *b) {
+    return a->codec_id == b->codec_id &&
+           a->codec_tag == b->codec_tag && a->profile == b->profile &&
+           a->width == b->width && a->height == b->height && a->format == b->format &&
+           a->sample_rate == b->sample_rate && a->channels == b->channels &&
+           a->extradata_size == b->extradata_size && a->extradata_hash == b->extradata_hash &&
+           a->use_hardware == b->use_hardware;
+}
+
+static void decoder_release(void *opaque) {
+    FFDecoderContext *ctx = opaque;
+    av_freep(&ctx->latency);
+    if (ctx->codec_ctx) avcodec_free_context(&ctx->codec_ctx);
+    if (ctx->hw_device_ctx) av_buffer_unref(&ctx->hw_device_ctx);
+}
+
 FFDecoderContext* ff_decoder_create(FFDemuxContext *demux_ctx, int stream_index, bool use_hardware) {
+    return ff_decoder_create_pooled_in(NULL, demux_ctx, stream_index, use_hardware, NULL);
+}
+
+FFDecoderContext* ff_decoder_create_in(FFArena *arena, FFDemuxContext *demux_ctx,
+                                       int stream_index, bool use_hardware) {
+    return ff_decoder_create_pooled_in(arena, demux_ctx, stream_index, use_hardware, NULL);
+}
+
+FFDecoderContext* ff_decoder_create_pooled(FFDemuxContext *demux_ctx, int stream_index,
+                                           bool use_hardware, FFFramePool *pool) {
+    return ff_decoder_create_pooled_in(NULL, demux_ctx, stream_index, use_hardware, pool);
+}
+
+FFDecoderContext* ff_decoder_create_pooled_in(FFArena *arena, FFDemuxContext *demux_ctx,
+                                              int stream_index, bool use_hardware,
+                                              FFFramePool *pool) {
+    return ff_decoder_create_setup(arena, demux_ctx, stream_index, use_hardware, pool, NULL);
+}
+
+FFDecoderContext* ff_decoder_create_setup(FFArena *arena, FFDemuxContext *demux_ctx,
+                                          int stream_index, bool use_hardware,
+                                          FFFramePool *pool, const FFDecoderSetup *setup) {
     if (!demux_ctx || !demux_ctx->fmt_ctx) return NULL;
     if (stream_index < 0 || stream_index >= (int)demux_ctx->fmt_ctx->nb_streams) return NULL;
 
-    FFDecoderContext *ctx = calloc(1, sizeof(FFDecoderContext));
-    if (!ctx) return NULL;
-
     AVStream *stream = demux_ctx->fmt_ctx->streams[stream_index];
-    AVCodecParameters *codecpar = stream->codecpar;
+    return ff_decoder_open_params(arena, stream->codecpar, stream->time_base, stream_index,
+                                  use_hardware, pool, setup, NULL);
+}
 
+FFDecoderContext* ff_decoder_open_params(FFArena *arena, const AVCodecParameters *codecpar,
+                                         AVRational time_base, int stream_index,
+                                         bool use_hardware, FFFramePool *pool,
+                                         const FFDecoderSetup *setup, int *error) {
+    int dummy;
+    if (!error) error = &dummy;
+
+    *error = AVERROR(EINVAL);
+    if (!codecpar) return NULL;
+
+    *error = AVERROR_DECODER_NOT_FOUND;
     const AVCodec *codec = avcodec_find_decoder(codecpar->codec_id);
-    if (!codec) { free(ctx); return NULL; }
+    if (!codec) return NULL;
+
+    *error = AVERROR(ENOMEM);
+    FFDecoderContext *ctx = context_alloc(arena, sizeof(FFDecoderContext), decoder_release);
+    if (!ctx) return NULL;
+    ctx->arena = arena;
 
     ctx->codec_ctx = avcodec_alloc_context3(codec);
-    if (!ctx->codec_ctx) { free(ctx); return NULL; }
+    if (!ctx->codec_ctx) { ff_decoder_destroy(ctx); return NULL; }
 
-    if (avcodec_parameters_to_context(ctx->codec_ctx, codecpar) < 0) {
-        avcodec_free_context(&ctx->codec_ctx);
-        free(ctx);
+    if ((*error = avcodec_parameters_to_context(ctx->codec_ctx, codecpar)) < 0) {
+        ff_decoder_destroy(ctx);
         return NULL;
     }
 
     ctx->stream_index = stream_index;
-    ctx->time_base = stream->time_base;
+    ctx->time_base = time_base;
+    ff_decoder_key_init(&ctx->key, codecpar, use_hardware);
+
+    if (setup) {
+        if (setup->thread_count > 0) ctx->codec_ctx->thread_count = setup->thread_count;
+        if (setup->thread_type) ctx->codec_ctx->thread_type = setup->thread_type;
+        ctx->codec_ctx->flags |= setup->flags;
+        ctx->codec_ctx->flags2 |= setup->flags2;
+    }
+
+    if (pool) {
+        ctx->frame_pool = pool;
+        ctx->codec_ctx->opaque = ctx;
+        ctx->codec_ctx->get_buffer2 = get_pooled_buffer;
+    }
 
     if (use_hardware && codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
         if (av_hwdevice_ctx_create(&ctx->hw_device_ctx, AV_HWDEVICE_TYPE_VIDEOTOOLBOX, NULL, NULL, 0) == 0) {
@@ -244,28 +434,77 @@ FFDecoderContext* ff_decoder_create(FFDemuxContext *demux_ctx, int stream_index,
         }
     }
 
-    if (avcodec_open2(ctx->codec_ctx, codec, NULL) < 0) {
-        if (ctx->hw_device_ctx) av_buffer_unref(&ctx->hw_device_ctx);
-        avcodec_free_context(&ctx->codec_ctx);
-        free(ctx);
+    if ((*error = avcodec_open2(ctx->codec_ctx, codec, NULL)) < 0) {
+        ff_decoder_destroy(ctx);
         return NULL;
     }
 
     return ctx;
 }
 
+FFDecoderContext* ff_decoder_create_profile(FFDemuxContext *demux_ctx, int stream_index,
+                                            bool use_hardware, FFDecoderProfile profile) {
+    if (profile != FF_DECODER_PROFILE_LOW_LATENCY)
+        return ff_decoder_create(demux_ctx, stream_index, use_hardware);
+    if (!demux_ctx || !demux_ctx->fmt_ctx) return NULL;
+    if (stream_index < 0 || stream_index >= (int)demux_ctx->fmt_ctx->nb_streams) return NULL;
+
+    const AVCodecParameters *codecpar = demux_ctx->fmt_ctx->streams[stream_index]->codecpar;
+
+    // Frame threading buffers a frame per thread; slices split one frame.
+    // The count is explicit: libavcodec's default is a single thread.
+    FFDecoderSetup setup = {
+        .thread_count = (int)FFMAX(sysconf(_SC_NPROCESSORS_ONLN), 1),
+        .thread_type = FF_THREAD_SLICE,
+        .flags2 = AV_CODEC_FLAG2_FAST,
+    };
+    // Forcing LOW_DELAY on a stream with B-frames would emit them out of order
+    if (codecpar->video_delay == 0) setup.flags |= AV_CODEC_FLAG_LOW_DELAY;
+
+    FFDecoderContext *ctx = ff_decoder_create_setup(NULL, demux_ctx, stream_index, use_hardware,
+                                                    NULL, &setup);
+    if (ctx) ff_decoder_set_latency_tracking(ctx, true);
+    return ctx;
+}
+
+int ff_decoder_set_latency_tracking(FFDecoderContext *ctx, bool enabled) {
+    if (!ctx) return AVERROR(EINVAL);
+    av_freep(&ctx->latency);
+    if (!enabled) return 0;
+
+    ctx->latency = av_mallocz(sizeof(FFLatencyTracker));
+    if (!ctx->latency) return AVERROR(ENOMEM);
+    latency_forget_in_flight(ctx->latency);
+    return 0;
+}
+
+int ff_decoder_get_latency_stats(FFDecoderContext *ctx, FFDecodeLatencyStats *stats) {
+    if (!ctx || !stats) return AVERROR(EINVAL);
+    if (!ctx->latency) return AVERROR(ENOENT);
+    *stats = ctx->latency->stats;
+    stats->in_flight = 0;
+    for (uint32_t i = 0; i < LATENCY_SLOTS; i++)
+        if (ctx->latency->slots[i].ts != AV_NOPTS_VALUE) stats->in_flight++;
+    return 0;
+}
+
 int ff_decoder_send_packet(FFDecoderContext *ctx, AVPacket *pkt) {
     if (!ctx || !ctx->codec_ctx) return AVERROR(EINVAL);
-    return avcodec_send_packet(ctx->codec_ctx, pkt);
+    int ret = avcodec_send_packet(ctx->codec_ctx, pkt);
+    if (ret == 0 && pkt && ctx->latency) latency_sent(ctx->latency, pkt);
+    return ret;
 }
 
 int ff_decoder_receive_frame(FFDecoderContext *ctx, AVFrame *frame) {
     if (!ctx || !ctx->codec_ctx || !frame) return AVERROR(EINVAL);
-    return avcodec_receive_frame(ctx->codec_ctx, frame);
+    int ret = avcodec_receive_frame(ctx->codec_ctx, frame);
+    if (ret == 0 && ctx->latency) latency_received(ctx->latency, frame);
+    return ret;
 }
 
 void ff_decoder_flush(FFDecoderContext *ctx) {
     if (ctx && ctx->codec_ctx) avcodec_flush_buffers(ctx->codec_ctx);
+    if (ctx && ctx->latency) latency_forget_in_flight(ctx->latency);
 }
 
 bool ff_decoder_is_hardware(FFDecoderContext *ctx) {
@@ -279,20 +518,50 @@ int ff_decoder_get_pixel_format(FFDecoderContext *ctx) {
 
 void ff_decoder_destroy(FFDecoderContext *ctx) {
     if (!ctx) return;
-    if (ctx->codec_ctx) avcodec_free_context(&ctx->codec_ctx);
-    if (ctx->hw_device_ctx) av_buffer_unref(&ctx->hw_device_ctx);
-    free(ctx);
+    decoder_release(ctx);
+    context_free(ctx->arena, ctx);
 }
 
 // -----------------------------------------------------------------------------
 // Scaler
 // -----------------------------------------------------------------------------
 
+static void scaler_release(void *opaque) {
+    FFScalerContext *ctx = opaque;
+    if (ctx->sws_ctx) sws_freeContext(ctx->sws_ctx);
+    ctx->sws_ctx = NULL;
+    ff_pixconv_destroy(ctx->pixconv);
+    ctx->pixconv = NULL;
+}
+
+// Same-size 10-bit to 8-bit conversions skip swscale. The sws context is
+// kept regardless, as the fallback when a frame does not match.
+static void scaler_update_fast_path(FFScalerContext *ctx) {
+    ff_pixconv_destroy(ctx->pixconv);
+    ctx->pixconv = NULL;
+    if (ctx->src_width != ctx->dst_width || ctx->src_height != ctx->dst_height ||
+        !ff_pixconv_supported(ctx->src_format, ctx->dst_format))
+        return;
+
+    ctx->pixconv = ff_pixconv_create(ctx->src_width, ctx->src_height,
+                                     ctx->src_format, ctx->dst_format);
+    if (ctx->pixconv) ff_pixconv_set_dither(ctx->pixconv, ctx->dither);
+}
+
 FFScalerContext* ff_scaler_create(int src_width, int src_height, int src_format,
                                   int dst_width, int dst_height, int dst_format) {
-    FFScalerContext *ctx = calloc(1, sizeof(FFScalerContext));
+    return ff_scaler_create_in(NULL, src_width, src_height, src_format,
+                               dst_width, dst_height, dst_format);
+}
+
+FFScalerContext* ff_scaler_create_in(FFArena *arena,
+                                     int src_width, int src_height, int src_format,
+                                     int dst_width, int dst_height, int dst_format) {
+    FFScalerContext *ctx = context_alloc(arena, sizeof(FFScalerContext), scaler_release);
     if (!ctx) return NULL;
 
+    ctx->arena = arena;
+
     ctx->src_width = src_width;
     ctx->src_height = src_height;
     ctx->src_format = src_format;
@@ -303,14 +572,40 @@ FFScalerContext* ff_scaler_create(int src_width, int src_height, int src_format,
     ctx->sws_ctx = sws_getContext(src_width, src_height, src_format,
                                   dst_width, dst_height, dst_format,
                                   SWS_BILINEAR, NULL, NULL, NULL);
-    if (!ctx->sws_ctx) { free(ctx); return NULL; }
+    if (!ctx->sws_ctx) { ff_scaler_destroy(ctx); return NULL; }
 
+    scaler_update_fast_path(ctx);
     return ctx;
 }
 
+int ff_scaler_reconfigure(FFScalerContext *ctx, int src_width, int src_height, int src_format) {
+    if (!ctx) return AVERROR(EINVAL);
+    if (ctx->sws_ctx && ctx->src_width == src_width && ctx->src_height == src_height &&
+        ctx->src_format == src_format)
+        return 0;
+
+    // Reuses the allocation and only rebuilds what the new geometry needs
+    struct SwsContext *sws = sws_getCachedContext(ctx->sws_ctx,
+                                                  src_width, src_height, src_format,
+                                                  ctx->dst_width, ctx->dst_height, ctx->dst_format,
+                                                  SWS_BILINEAR, NULL, NULL, NULL);
+    if (!sws) return AVERROR(EINVAL);
+
+    ctx->sws_ctx = sws;
+    ctx->src_width = src_width;
+    ctx->src_height = src_height;
+    ctx->src_format = src_format;
+    scaler_update_fast_path(ctx);
+    return 1;
+}
+
 int ff_scaler_scale(FFScalerContext *ctx, AVFrame *src_frame, AVFrame *dst_frame) {
     if (!ctx || !ctx->sws_ctx || !src_frame || !dst_frame) return AVERROR(EINVAL);
 
+    // The converter rejects frames that differ from its geometry before
+    // writing anything, so those fall through to swscale
+    if (ctx->pixconv && ff_pixconv_convert(ctx->pixconv, src_frame, dst_frame) == 0) return 0;
+
     int ret = sws_scale(ctx->sws_ctx,
                         (const uint8_t * const *)src_frame->data, src_frame->linesize,
                         0, ctx->src_height,
@@ -318,10 +613,20 @@ int ff_scaler_scale(FFScalerContext *ctx, AVFrame *src_frame, AVFrame *dst_frame
     return (ret > 0) ? 0 : AVERROR_EXTERNAL;
 }
 
+void ff_scaler_set_dither(FFScalerContext *ctx, int mode) {
+    if (!ctx) return;
+    ctx->dither = mode;
+    ff_pixconv_set_dither(ctx->pixconv, (FFDitherMode)mode);
+}
+
+bool ff_scaler_has_fast_path(FFScalerContext *ctx) {
+    return ctx && ctx->pixconv;
+}
+
 void ff_scaler_destroy(FFScalerContext *ctx) {
     if (!ctx) return;
-    if (ctx->sws_ctx) sws_freeContext(ctx->sws_ctx);
-    free(ctx);
+    scaler_release(ctx);
+    context_free(ctx->arena, ctx);
 }
 
 // -----------------------------------------------------------------------------
@@ -1,9 +1,9 @@
 #ifndef SPROQET_BOUND_FIFO_IMPL_H
 #define SPROQET_BOUND_FIFO_IMPL_H
 
-#include <memory>
 #include <atomic>
 #include <mutex>
+#include <optional>
 
 #include "default_semaphore_impl.hpp"
 #include "circular_fifo.hpp"
@@ -18,7 +18,10 @@ public:
     virtual bool generic_fifo_new_head(void * fifo, void * userdata, uint32_t tag) = 0;
 };
 
-template<typename Element, typename SemaphoreType>
+// RingType is circular_fifo<Element> (runtime capacity) or
+// static_circular_fifo<Element, N> (inline storage). The ring and the
+// semaphores are members, not separate allocations.
+template<typename Element, typename SemaphoreType, typename RingType = circular_fifo<Element>>
 class sproqet_generic_waitable_fifo : public isproqet_fifo_head_monitor
 {
 public:
@@ -28,27 +31,33 @@ public:
                             SP_Circular_Fifo_Mode mode = Circular_Fifo_Mode_Single_Producer_Lockless,
                             void * userData = 0,
                             uint32_t tag = 0,
-                            bool canUnwait = true) {
+                            bool canUnwait = true)
+        : _elements(maxPackets, mode),
+          // immediately make available maxPackets for write space
+          _writeSem(maxPackets) {
         _tag = tag;
         _userData = userData;
 
-        // immediately make available maxPackets for write space
-        _writeSem = std::make_unique<SemaphoreType>(maxPackets);
-
         // start read sem with 0 resources
-        _readSem = readSemaphore ? std::make_unique<SemaphoreType>(0) : NULL;
+        if(readSemaphore)
+        {
+            _readSem.emplace(0);
+        }
 
-        _maxPackets = maxPackets;
+        _maxPackets.store((int)maxPackets, std::memory_order_relaxed);
+        _writeDebt.store(0, std::memory_order_relaxed);
 
         // flow is not enabled by default
         _flowEnabled.store(0, std::memory_order_relaxed);
+        _closed.store(0, std::memory_order_relaxed);
+        _readWaiters.store(0, std::memory_order_relaxed);
+        _writeWaiters.store(0, std::memory_order_relaxed);
 
         _canUnwait = canUnwait;
 
-        _elements = std::make_unique<circular_fifo<Element>>(_maxPackets, mode);
         if(headMonitor)
         {
-            _elements->setHeadMonitor(this);
+            _elements.setHeadMonitor(this);
         }
         _headMonitor = headMonitor;
 
@@ -69,6 +78,10 @@ public:
     }
 
     int write(Element& element) {
+        if(isClosed())
+        {
+            return SPR_FIFOCLOSED;
+        }
         int enabledFlow = _flowEnabled.load(std::memory_order_relaxed);
         if(!enabledFlow)
         {
@@ -78,6 +91,10 @@ public:
     }
 
     int preempt(Element element) {
+        if(isClosed())
+        {
+            return SPR_FIFOCLOSED;
+        }
         int enabledFlow = _flowEnabled.load(std::memory_order_relaxed);
         if(!enabledFlow)
         {
@@ -85,7 +102,7 @@ public:
         }
 
         int retv = SPR_OK;
-        if(_elements->preempt(element))
+        if(_elements.preempt(element))
         {
             _signalRead();
         }
@@ -100,12 +117,16 @@ public:
     int waitForReadData() {
         if(_readSem)
         {
-            return _readSem->Wait();
+            return _waitUnlessClosed(_readWaiters, [this]() { return _readSem->Wait(); });
         }
         return SPR_FLOWDISABLED;
     }
 
     int tryWaitForReadData() {
+        if(isClosed())
+        {
+            return SPR_FIFOCLOSED;
+        }
         if(!_readSem)
         {
             return 0;
@@ -114,13 +135,17 @@ public:
     }
 
     int tryWaitForWriteData() {
+        if(isClosed())
+        {
+            return SPR_FIFOCLOSED;
+        }
         int enabledFlow = _flowEnabled.load(std::memory_order_relaxed);
         if(!enabledFlow)
         {
             return SPR_FLOWDISABLED;
         }
 
-        int retv = _writeSem->TryWait();
+        int retv = _writeSem.TryWait();
         int flow = _flowEnabled.load(std::memory_order_relaxed);
         if(!flow)
         {
@@ -131,16 +156,24 @@ public:
     }
 
     int waitForWriteSpace() {
+        if(isClosed())
+        {
+            return SPR_FIFOCLOSED;
+        }
         int enabledFlow = _flowEnabled.load(std::memory_order_relaxed);
         if(!enabledFlow)
         {
             return SPR_FLOWDISABLED;
         }
 
-        _writeSem->Wait();
+        int retv = _waitUnlessClosed(_writeWaiters, [this]() { return _writeSem.Wait(); });
+        if(retv == SPR_FIFOCLOSED)
+        {
+            return retv;
+        }
 
         enabledFlow = _flowEnabled.load(std::memory_order_relaxed);
-        int retv = (enabledFlow == 1) ? SPR_OK : SPR_FLOWDISABLED;
+        retv = (enabledFlow == 1) ? SPR_OK : SPR_FLOWDISABLED;
 
         return retv;
     }
@@ -153,12 +186,12 @@ public:
 
         if(msecs < 1)
         {
-            waitForReadData();
-            return 0;
+            int retv = waitForReadData();
+            return retv == SPR_FIFOCLOSED ? retv : 0;
         }
         else
         {
-            return _readSem->WaitTimed(msecs);
+            return waitForReadDataUntil(SemaphoreType::MonotonicNanos() + (int64_t)msecs * 1000000);
         }
     }
 
@@ -169,24 +202,62 @@ public:
         }
         else
         {
-            int enabledFlow = _flowEnabled.load(std::memory_order_relaxed);
-            if(!enabledFlow)
-            {
-                return SPR_FLOWDISABLED;
-            }
+            return waitForWriteSpaceUntil(SemaphoreType::MonotonicNanos() + (int64_t)msecs * 1000000);
+        }
+    }
 
-            int retv = _writeSem->WaitTimed(msecs);
-            int flow = _flowEnabled.load(std::memory_order_relaxed);
-            if(!flow)
-            {
-                return SPR_FLOWDISABLED;
-            }
+    // Microsecond timeouts; 0 or less only tries
+    int waitForReadDataTimedUs(int64_t usecs) {
+        return waitForReadDataUntil(SemaphoreType::MonotonicNanos() + usecs * 1000);
+    }
+
+    int waitForWriteSpaceTimedUs(int64_t usecs) {
+        return waitForWriteSpaceUntil(SemaphoreType::MonotonicNanos() + usecs * 1000);
+    }
+
+    // Absolute deadlines on SemaphoreType::MonotonicNanos(). A pacing loop
+    // that advances its deadline by one frame period each time never
+    // accumulates the wake-up latency of earlier waits.
+    int waitForReadDataUntil(int64_t deadlineNs) {
+        if(!_readSem)
+        {
+            return 0;
+        }
 
+        int retv = _waitUnlessClosed(_readWaiters, [this, deadlineNs]() { return _readSem->WaitUntil(deadlineNs); });
+        return _timedResult(retv);
+    }
+
+    int waitForWriteSpaceUntil(int64_t deadlineNs) {
+        if(isClosed())
+        {
+            return SPR_FIFOCLOSED;
+        }
+        int enabledFlow = _flowEnabled.load(std::memory_order_relaxed);
+        if(!enabledFlow)
+        {
+            return SPR_FLOWDISABLED;
+        }
+
+        int retv = _waitUnlessClosed(_writeWaiters, [this, deadlineNs]() { return _writeSem.WaitUntil(deadlineNs); });
+        if(retv == SPR_FIFOCLOSED)
+        {
             return retv;
         }
+        int flow = _flowEnabled.load(std::memory_order_relaxed);
+        if(!flow)
+        {
+            return SPR_FLOWDISABLED;
+        }
+
+        return _timedResult(retv);
     }
 
     void setFlowEnabled(bool enabled) {
+        if(enabled && isClosed())
+        {
+            return;
+        }
         int flow = _flowEnabled.load(std::memory_order_relaxed);
         if((flow == 0 && !enabled) || (flow == 1 && enabled))
         {
@@ -201,12 +272,11 @@ public:
         {
             _flowEnabled.store(0, std::memory_order_relaxed);
 
-            int pcount = _elements->storedCount();
-            int cap = _elements->capacity();
-            if(pcount == cap - 1)
+            int pcount = _elements.storedCount();
+            if(pcount >= _maxPackets.load(std::memory_order_relaxed))
             {
-                _writeSem->Post();
-                _writeSem->Reset();
+                _writeSem.Post();
+                _writeSem.Reset();
             }
 
             if(pcount == 0 && _readSem)
@@ -221,17 +291,125 @@ public:
         return _flowEnabled.load(std::memory_order_relaxed) > 0;
     }
 
+    // Close for good. Flow is disabled, every thread blocked in a wait is
+    // woken, and later waits, writes and preempts return SPR_FIFOCLOSED
+    // without blocking. Queued elements are handed to drain in order,
+    // whatever read signals are outstanding. Lockless mode: the ring is
+    // popped here, so the consumer must be blocked, stopped or the caller.
+    template<typename Drain>
+    int close(Drain drain) {
+        _closed.store(1, std::memory_order_seq_cst);
+        _flowEnabled.store(0, std::memory_order_relaxed);
+
+        int drained = 0;
+        Element element;
+        while(_elements.pop(element, NULL))
+        {
+            drain(element);
+            drained++;
+        }
+
+        // A waiter either registered before the flag was set and gets a
+        // post, or registers after it and sees the flag
+        _wakeWaiters(_writeSem, _writeWaiters);
+        if(_readSem)
+        {
+            _wakeWaiters(*_readSem, _readWaiters);
+        }
+        return drained;
+    }
+
+    // Pass an element around the ring to a consumer the caller runs itself:
+    // the same checks as write, and the write space taken for it is
+    // returned at once since it never occupies a slot.
+    int bypass() {
+        if(isClosed())
+        {
+            return SPR_FIFOCLOSED;
+        }
+        if(!_flowEnabled.load(std::memory_order_relaxed))
+        {
+            return SPR_FLOWDISABLED;
+        }
+        _signalWrite();
+        return SPR_OK;
+    }
+
+    bool isClosed() {
+        return _closed.load(std::memory_order_acquire) != 0;
+    }
+
     void fifo_new_head(void * userdata) {
-        if(_headMonitor)
+        if(_headMonitor && !isClosed())
         {
             _headMonitor->generic_fifo_new_head(this, _userData, _tag);
         }
     }
 
-    int storedCount() { return _elements->storedCount(); }
+    int storedCount() { return _elements.storedCount(); }
 
     void setWaterMarkHandler(int high, WaterMarkHandler highHandler, int low, WaterMarkHandler lowHandler, void * data) {
-        _elements->setWaterMarkHandler(high, highHandler, low, lowHandler, data);
+        _elements.setWaterMarkHandler(high, highHandler, low, lowHandler, data);
+    }
+
+    // Change the capacity while producers and consumers run. Write space is
+    // granted or withdrawn through the write semaphore; space that queued
+    // elements still occupy is withdrawn as they are read. The ring's storage
+    // is resized to cover everything that may already hold write space.
+    int resize(unsigned int maxPackets) {
+        if(maxPackets < 1)
+        {
+            return SPR_INVALID_PARAMETERS;
+        }
+
+        std::lock_guard<std::mutex> lock(_fifoMutex);
+        int target = (int)maxPackets;
+        int current = _maxPackets.load(std::memory_order_relaxed);
+        if(target > current)
+        {
+            if(!_elements.reserve(target + _writeDebt.load(std::memory_order_acquire)))
+            {
+                return SPR_INVALID_PARAMETERS;
+            }
+
+            int grow = target - current;
+            int paid = _payDebt(grow);
+            _maxPackets.store(target, std::memory_order_relaxed);
+            for(int i = paid; i < grow; i++)
+            {
+                _writeSem.Post();
+            }
+        }
+        else if(target < current)
+        {
+            int shrink = current - target;
+            int taken = 0;
+            while(taken < shrink && _writeSem.TryWait() == 0)
+            {
+                taken++;
+            }
+            _writeDebt.fetch_add(shrink - taken, std::memory_order_acq_rel);
+            _maxPackets.store(target, std::memory_order_relaxed);
+
+            // give storage back where the ring can
+            _elements.reserve(target + _writeDebt.load(std::memory_order_acquire));
+        }
+        return SPR_OK;
+    }
+
+    int capacity() { return _maxPackets.load(std::memory_order_relaxed); }
+
+    // Drop queued elements ahead of the first target (see circular_fifo::skipTo),
+    // taking their read signals back and returning their write space.
+    template<typename Target, typename Keep, typename Drop>
+    int skipTo(Target target, Keep keep, Drop drop) {
+        int dropped = _elements.skipTo(target, keep, drop,
+                                       [this](int n) { return _reserveRead(n); });
+        for(int i = 0; i < dropped; i++)
+        {
+            _signalWrite();
+        }
+        return dropped;
     }
 
     bool hasBeenRead() {
@@ -241,14 +419,14 @@ public:
 private:
     Element _popPacket() {
         Element retv = Element{};
-        _elements->pop(retv, NULL);
+        _elements.pop(retv, NULL);
         _signalWrite();
         return retv;
     }
 
     int _pushPacket(Element packet) {
         int retv = SPR_OK;
-        if(_elements->push(packet))
+        if(_elements.push(packet))
         {
             _signalRead();
         }
@@ -259,6 +437,51 @@ private:
         return retv;
     }
 
+    template<typename Wait>
+    int _waitUnlessClosed(std::atomic<int>& waiters, Wait wait) {
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        int retv = _closed.load(std::memory_order_seq_cst) ? SPR_FIFOCLOSED : wait();
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return isClosed() ? SPR_FIFOCLOSED : retv;
+    }
+
+    // Semaphores report timeouts in platform terms (errno, kern_return_t, ...)
+    int _timedResult(int retv) {
+        return (retv == SPR_OK || retv == SPR_FIFOCLOSED) ? retv : SPR_TIMEOUT;
+    }
+
+    void _wakeWaiters(SemaphoreType& sem, std::atomic<int>& waiters) {
+        int count = waiters.load(std::memory_order_seq_cst);
+        for(int i = 0; i < count; i++)
+        {
+            sem.Post();
+        }
+    }
+
+    // Take n posted read signals, or none if a reader already holds one of them
+    bool _reserveRead(int n) {
+        if(!_readSem)
+        {
+            return true;
+        }
+
+        int taken = 0;
+        while(taken < n && _readSem->TryWait() == 0)
+        {
+            taken++;
+        }
+        if(taken == n)
+        {
+            return true;
+        }
+
+        while(taken-- > 0)
+        {
+            _readSem->Post();
+        }
+        return false;
+    }
+
     void _signalRead() {
         if(_readSem)
         {
@@ -267,15 +490,36 @@ private:
     }
 
     void _signalWrite() {
-        _writeSem->Post();
+        // space freed while a shrink is outstanding is withdrawn, not posted
+        if(_payDebt(1) == 0)
+        {
+            _writeSem.Post();
+        }
+    }
+
+    int _payDebt(int n) {
+        int debt = _writeDebt.load(std::memory_order_relaxed);
+        while(debt > 0)
+        {
+            int paid = debt < n ? debt : n;
+            if(_writeDebt.compare_exchange_weak(debt, debt - paid, std::memory_order_acq_rel))
+            {
+                return paid;
+            }
+        }
+        return 0;
     }
 
-    std::mutex _fifoMutex;
-    std::unique_ptr<circular_fifo<Element>> _elements;
-    std::unique_ptr<SemaphoreType> _readSem;
-    std::unique_ptr<SemaphoreType> _writeSem;
-    int _maxPackets;
+    std::mutex _fifoMutex;                  // Serializes resizes
+    RingType _elements;
+    SemaphoreType _writeSem;
+    std::optional<SemaphoreType> _readSem;
+    std::atomic<int> _maxPackets;
+    std::atomic<int> _writeDebt;            // Write space still to withdraw after a shrink
     std::atomic<int> _flowEnabled;
+    std::atomic<int> _closed;
+    std::atomic<int> _readWaiters;          // Threads inside a read wait, woken by close
+    std::atomic<int> _writeWaiters;         // Threads inside a write wait, woken by close
     sproqet_generic_fifo_head_monitor * _headMonitor;
     bool _canUnwait;
     void * _userData;
@@ -217,6 +217,108 @@ public:
         }
     }
 
+    // Remove the elements queued ahead of the first one matching target,
+    // except those keep() accepts; they stay, in order, just ahead of it.
+    // reserve(n) is asked before anything is removed and may refuse; drop()
+    // then receives each removed element. Nothing changes if no element
+    // matches. In lockless mode only the consumer thread may call this.
+    template<typename Target, typename Keep, typename Drop, typename Reserve>
+    int skipTo(Target target, Keep keep, Drop drop, Reserve reserve) {
+        const bool blocking = _mode == Circular_Fifo_Mode_Blocking;
+        if(blocking) {
+            _blockingMutex.lock();
+        }
+
+        const int head = blocking ? _nahead : _head.load(std::memory_order_relaxed);
+        const int tail = blocking ? _natail : _tail.load(std::memory_order_acquire);
+        int found = -1;
+        int drops = 0;
+        for(int i = head; i != tail; i = increment(i)) {
+            if(target(_array[i])) {
+                found = i;
+                break;
+            }
+            if(!keep(_array[i])) {
+                drops++;
+            }
+        }
+
+        if(found < 0 || drops == 0 || !reserve(drops)) {
+            if(blocking) {
+                _blockingMutex.unlock();
+            }
+            return 0;
+        }
+
+        // compact backwards so kept elements end up adjacent to the target
+        int write = found;
+        for(int read = found; read != head; ) {
+            read = decrement(read);
+            Element e = ::std::move(_array[read]);
+            _array[read].~Element();
+            if(keep(e)) {
+                write = decrement(write);
+                ::new ((void *)&_array[write]) Element(::std::move(e));
+            } else {
+                drop(e);
+            }
+        }
+
+        int f;
+        if(blocking) {
+            _nahead = write;
+            f = _count.fetch_sub(drops, std::memory_order_relaxed);
+            _blockingMutex.unlock();
+        } else {
+            _head.store(write, std::memory_order_release);
+            f = _count.fetch_sub(drops, std::memory_order_acq_rel);
+        }
+
+        if(_lowWaterMarkHandler && f >= _lowWaterMark && f - drops < _lowWaterMark) {
+            _lowWaterMarkHandler(_waterMarkOpaque);
+        }
+        return drops;
+    }
+
+    // Usable slots of the current storage
+    int storageSize() {
+        return _capacity - 1;
+    }
+
+    // Hand the queued elements over to new storage with fifoSize usable
+    // slots. Blocking mode only, where every access holds the mutex; a
+    // lockless ring keeps its storage and only accepts sizes that fit it.
+    bool reserve(int fifoSize) {
+        if(_mode != Circular_Fifo_Mode_Blocking) {
+            return fifoSize >= 1 && fifoSize <= _capacity - 1;
+        }
+
+        std::lock_guard<std::mutex> lock(_blockingMutex);
+        if(fifoSize < 1 || fifoSize < _count.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if(fifoSize + 1 == _capacity) {
+            return true;
+        }
+
+        Element * array = (Element *)malloc((fifoSize + 1) * sizeof(Element));
+        if(!array) {
+            return false;
+        }
+
+        int n = 0;
+        for(int i = _nahead; i != _natail; i = increment(i)) {
+            ::new ((void *)&array[n++]) Element(::std::move(_array[i]));
+            _array[i].~Element();
+        }
+        free(_array);
+        _array = array;
+        _capacity = fifoSize + 1;
+        _nahead = 0;
+        _natail = n;
+        return true;
+    }
+
     int capacity() {
         return _capacity;
     }
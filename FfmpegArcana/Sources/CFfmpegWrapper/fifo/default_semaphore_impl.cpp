@@ -3,6 +3,7 @@
 
 #if defined(WIN32) || defined(_WIN32)
     #include <windows.h>
+    #include <chrono>
     #define SEM_WINDOWS 1
 #elif defined (__APPLE__) && defined (__MACH__)
     #include <mach/mach.h>
@@ -11,6 +12,7 @@
 //    #include <device/device_port.h>
     #include <pthread.h>
     #include <mach/clock.h>
+    #include <time.h>
     #define SEM_DARWIN 1
 #elif defined(__unix__)
     #include <time.h>
@@ -20,6 +22,7 @@
     #define SEM_POSIX 1
 #else
     #include <semaphore>
+    #include <chrono>
     #define SEM_CPP_20 1
 #endif
 
@@ -100,34 +103,101 @@ int default_semaphore_impl::Wait()
 }
 
 int default_semaphore_impl::WaitTimed(int msecs)
+{
+    return WaitUntil(MonotonicNanos() + (int64_t)msecs * 1000000);
+}
+
+int default_semaphore_impl::WaitTimedUs(int64_t usecs)
+{
+    return WaitUntil(MonotonicNanos() + usecs * 1000);
+}
+
+int default_semaphore_impl::WaitUntil(int64_t deadlineNs)
 {
     int retv = 0;
 
 #if defined(SEM_WINDOWS)
-    retv = WaitForSingleObject((HANDLE)_semaphore_opaque, msecs);
+    // whole msecs only; round up so the wait never ends early
+    int64_t remaining = deadlineNs - MonotonicNanos();
+    DWORD msecs = remaining > 0 ? (DWORD)((remaining + 999999) / 1000000) : 0;
+    retv = (int)WaitForSingleObject((HANDLE)_semaphore_opaque, msecs);
 #elif defined(SEM_DARWIN)
-    mach_timespec_t ts;
-    ts.tv_sec = msecs / 1000;
-    ts.tv_nsec = (msecs % 1000) * 1000000;
-    retv = (int)semaphore_timedwait(*(semaphore_t*)_semaphore_opaque, ts);
+    // mach semaphores take a relative timeout; recompute it after interrupts
+    for(;;)
+    {
+        int64_t remaining = deadlineNs - MonotonicNanos();
+        if(remaining < 0)
+        {
+            remaining = 0;
+        }
+        mach_timespec_t ts;
+        ts.tv_sec = (unsigned int)(remaining / 1000000000);
+        ts.tv_nsec = (clock_res_t)(remaining % 1000000000);
+        kern_return_t kr = semaphore_timedwait(*(semaphore_t*)_semaphore_opaque, ts);
+        if(kr != KERN_ABORTED)
+        {
+            retv = (int)kr;
+            break;
+        }
+    }
 #elif defined(SEM_POSIX)
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
     struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    ts.tv_sec += msecs / 1000;
-    ts.tv_nsec += (msecs % 1000) * 1000000;
-    retv = (int)sem_timedwait((sem_t *)_semaphore_opaque, &ts);
+    ts.tv_sec = (time_t)(deadlineNs / 1000000000);
+    ts.tv_nsec = (long)(deadlineNs % 1000000000);
+    while((retv = sem_clockwait((sem_t *)_semaphore_opaque, CLOCK_MONOTONIC, &ts)) != 0 && errno == EINTR) {}
     if(retv)
     {
         retv = errno;
     }
+#else
+    // sem_timedwait only knows CLOCK_REALTIME: aim it at the remaining
+    // monotonic time and check the monotonic deadline again on each wake
+    for(;;)
+    {
+        int64_t remaining = deadlineNs - MonotonicNanos();
+        if(remaining <= 0)
+        {
+            retv = TryWait() ? ETIMEDOUT : 0;
+            break;
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        int64_t nsec = ts.tv_nsec + remaining % 1000000000;
+        ts.tv_sec += (time_t)(remaining / 1000000000 + nsec / 1000000000);
+        ts.tv_nsec = (long)(nsec % 1000000000);
+        if(sem_timedwait((sem_t *)_semaphore_opaque, &ts) == 0)
+        {
+            retv = 0;
+            break;
+        }
+        if(errno != EINTR && errno != ETIMEDOUT)
+        {
+            retv = errno;
+            break;
+        }
+    }
+#endif
 #elif defined(SEM_CPP_20)
     std::binary_semaphore * m = (std::binary_semaphore*)_semaphore_opaque;
-    auto duration = std::chrono::milliseconds(msecs);
-    retv = m->try_acquire_for(duration) ? 0 : 1;
+    std::chrono::steady_clock::time_point deadline{std::chrono::nanoseconds(deadlineNs)};
+    retv = m->try_acquire_until(deadline) ? 0 : 1;
 #endif
     return retv;
 }
 
+int64_t default_semaphore_impl::MonotonicNanos()
+{
+#if defined(SEM_DARWIN) || defined(SEM_POSIX)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
 int default_semaphore_impl::TryWait()
 {
     int retv = 0;
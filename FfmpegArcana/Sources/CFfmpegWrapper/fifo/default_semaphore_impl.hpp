@@ -1,6 +1,8 @@
 #ifndef DEFAULT_SEMAPHORE_IMPL_H
 #define DEFAULT_SEMAPHORE_IMPL_H
 
+#include <stdint.h>
+
 namespace sproqet
 {
     class default_semaphore_impl
@@ -21,6 +23,16 @@ namespace sproqet
         // wait for n msecs, return 0 if success, non-zero for timeout/error
         int WaitTimed(int msecs);
 
+        // wait for n usecs, return 0 if success, non-zero for timeout/error
+        int WaitTimedUs(int64_t usecs);
+
+        // wait until an absolute MonotonicNanos() deadline; a deadline that
+        // has passed only tries. return 0 if success, non-zero for timeout/error
+        int WaitUntil(int64_t deadlineNs);
+
+        // monotonic clock in nsecs, unaffected by wall clock steps
+        static int64_t MonotonicNanos();
+
         // Try to wait on a semaphore.  If semaphore count is non-zero, semaphore count is decreased,
         // and returns 0.  If semaphore count is zero, returns 1
         int TryWait();
@@ -1,10 +1,12 @@
 #ifndef SPROQET_DEFINES_H_
 #define SPROQET_DEFINES_H_
 
+#define SPR_TIMEOUT                 -1  // a timed wait expired
 #define SPR_OK                      0   // Success
 #define SPR_INVALID_PARAMETERS      1   // Invalid required parameters
 #define SPR_FLOWDISABLED            13  // a fifo has flow disabled
 #define SPR_NETWORKERROR            23  // generic network error
 #define SPR_FIFOFULL                29  // attempted to write to a full fifo
+#define SPR_FIFOCLOSED              30  // the fifo has been closed for good
 
 #endif /* SPROQET_DEFINES_H_ */
@@ -0,0 +1,356 @@
+#ifndef SPROQET_STATIC_CIRCULAR_FIFO_H
+#define SPROQET_STATIC_CIRCULAR_FIFO_H
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstring>
+#include <type_traits>
+
+#include "circular_fifo.hpp"
+
+namespace sproqet {
+
+// Fixed-capacity counterpart of circular_fifo: same interface and semantics,
+// but the ring lives inside the object and its size is a compile time power
+// of two, so wrapping is a mask instead of a modulo. Head and tail are free
+// running counters; the stored count is their difference, so no slot is
+// wasted to tell full from empty.
+//
+// Trivially copyable elements (FFCmd* and other pointers) are moved with a
+// plain copy and never constructed or destroyed in place.
+template<typename Element, int N>
+class static_circular_fifo
+{
+    static_assert(N > 0, "static_circular_fifo needs at least one slot");
+
+    static constexpr unsigned int round_pow2(unsigned int v) {
+        unsigned int p = 1;
+        while(p < v) p <<= 1;
+        return p;
+    }
+
+    static constexpr bool _trivial = std::is_trivially_copyable<Element>::value;
+
+public:
+    static constexpr unsigned int slots = round_pow2((unsigned int)N);
+    static constexpr unsigned int mask = slots - 1;
+
+    // fifoSize is clamped to N; it lets the same ring back a fifo that was
+    // asked for fewer elements than the type was instantiated for.
+    explicit static_circular_fifo(int fifoSize = N,
+                                  SP_Circular_Fifo_Mode mode = Circular_Fifo_Mode_Single_Producer_Lockless) {
+        _mode = mode;
+        _tail.store(0, std::memory_order_relaxed);
+        _head.store(0, std::memory_order_relaxed);
+        _count.store(0);
+        _nahead = _natail = 0;
+        _limit.store((fifoSize > 0 && fifoSize < N) ? (unsigned int)fifoSize : (unsigned int)N,
+                     std::memory_order_relaxed);
+        _headMonitor = NULL;
+        _waterMarkOpaque = NULL;
+        _lowWaterMarkHandler = NULL;
+        _highWaterMarkHandler = NULL;
+        _highWaterMark = -1;
+        _lowWaterMark = -1;
+    }
+
+    ~static_circular_fifo() {
+        Element e;
+        // disable the head monitor and purge any remaining Elements
+        _headMonitor = NULL;
+        while(pop(e, NULL)) {}
+    }
+
+    static_circular_fifo(const static_circular_fifo&) = delete;
+    static_circular_fifo& operator=(const static_circular_fifo&) = delete;
+
+    void setHeadMonitor(isproqet_fifo_head_monitor * monitor) {
+        _headMonitor = monitor;
+    }
+
+    SP_Circular_Fifo_Mode getMode() {
+        return _mode;
+    }
+
+    // add element to back of fifo
+    bool push(const Element& item) {
+        bool newHead = false;
+        if(_mode == Circular_Fifo_Mode_Single_Producer_Lockless) {
+            const unsigned int tail = _tail.load(std::memory_order_relaxed);
+            const unsigned int head = _head.load(std::memory_order_acquire);
+
+            if(tail - head < _limit.load(std::memory_order_relaxed)) {
+                _store(tail, item);
+
+                _tail.store(tail + 1, std::memory_order_release);
+
+                // increase the _count.  If the original value was 0, this is a new head
+                int f = _count.fetch_add(1, std::memory_order_acq_rel);
+                if(f == 0) {
+                    newHead = true;
+                }
+
+                if(_highWaterMarkHandler && f == _highWaterMark + 1) {
+                    _highWaterMarkHandler(_waterMarkOpaque);
+                }
+
+                if(_headMonitor && newHead) {
+                    _headMonitor->fifo_new_head(NULL);
+                }
+                return true;
+            }
+
+            // full queue
+            return false;
+        } else {
+            _blockingMutex.lock();
+            if(_natail == _nahead) {
+                newHead = true;
+            }
+
+            if(_natail - _nahead < _limit.load(std::memory_order_relaxed)) {
+                _store(_natail, item);
+
+                _natail++;
+                int f = _count.fetch_add(1, std::memory_order_relaxed);
+                _blockingMutex.unlock();
+
+                if(_highWaterMarkHandler && f == _highWaterMark + 1) {
+                    _highWaterMarkHandler(_waterMarkOpaque);
+                }
+
+                if(_headMonitor && newHead) {
+                    _headMonitor->fifo_new_head(NULL);
+                }
+                return true;
+            }
+
+            // full queue
+            _blockingMutex.unlock();
+            return false;
+        }
+    }
+
+    // add element to front of fifo, preempting existing elements
+    bool preempt(const Element& item) {
+        if(_mode == Circular_Fifo_Mode_Single_Producer_Lockless) {
+            const unsigned int head = _head.load(std::memory_order_relaxed);
+            if(_tail.load(std::memory_order_acquire) - head < _limit.load(std::memory_order_relaxed)) {
+                _store(head - 1, item);
+
+                _head.store(head - 1, std::memory_order_release);
+                _count.fetch_add(1, std::memory_order_relaxed);
+                if(_headMonitor) {
+                    _headMonitor->fifo_new_head(NULL);
+                }
+                return true;
+            }
+
+            // full queue
+            return false;
+        } else {
+            _blockingMutex.lock();
+            if(_natail - _nahead < _limit.load(std::memory_order_relaxed)) {
+                _nahead--;
+                _store(_nahead, item);
+
+                _count.fetch_add(1, std::memory_order_relaxed);
+                _blockingMutex.unlock();
+                if(_headMonitor) {
+                    _headMonitor->fifo_new_head(NULL);
+                }
+                return true;
+            }
+
+            // full queue
+            _blockingMutex.unlock();
+            return false;
+        }
+    }
+
+    bool pop(Element& item, void * userdata) {
+        if(_mode == Circular_Fifo_Mode_Single_Producer_Lockless) {
+            const unsigned int head = _head.load(std::memory_order_relaxed);
+            if(head == _tail.load(std::memory_order_acquire)) {
+                // empty queue
+                return false;
+            }
+
+            _load(head, item);
+
+            _head.store(head + 1, std::memory_order_release);
+            int f = _count.fetch_sub(1, std::memory_order_acq_rel);
+
+            if(_lowWaterMarkHandler && f == _lowWaterMark - 1) {
+                _lowWaterMarkHandler(_waterMarkOpaque);
+            }
+
+            if((f != 1) && _headMonitor) {
+                _headMonitor->fifo_new_head(userdata);
+            }
+            return true;
+        } else {
+            _blockingMutex.lock();
+            if(_nahead == _natail) {
+                // empty queue
+                _blockingMutex.unlock();
+                return false;
+            }
+
+            _load(_nahead, item);
+
+            _nahead++;
+            int newHead = _count.fetch_sub(1, std::memory_order_relaxed) - 1;
+            _blockingMutex.unlock();
+
+            if(_lowWaterMarkHandler && newHead == _lowWaterMark - 1) {
+                _lowWaterMarkHandler(_waterMarkOpaque);
+            }
+
+            if(newHead && _headMonitor) {
+                _headMonitor->fifo_new_head(userdata);
+            }
+            return true;
+        }
+    }
+
+    // Same contract as circular_fifo::skipTo
+    template<typename Target, typename Keep, typename Drop, typename Reserve>
+    int skipTo(Target target, Keep keep, Drop drop, Reserve reserve) {
+        const bool blocking = _mode == Circular_Fifo_Mode_Blocking;
+        if(blocking) {
+            _blockingMutex.lock();
+        }
+
+        const unsigned int head = blocking ? _nahead : _head.load(std::memory_order_relaxed);
+        const unsigned int tail = blocking ? _natail : _tail.load(std::memory_order_acquire);
+        unsigned int found = tail;
+        int drops = 0;
+        for(unsigned int i = head; i != tail; i++) {
+            if(target(_at(i))) {
+                found = i;
+                break;
+            }
+            if(!keep(_at(i))) {
+                drops++;
+            }
+        }
+
+        if(found == tail || drops == 0 || !reserve(drops)) {
+            if(blocking) {
+                _blockingMutex.unlock();
+            }
+            return 0;
+        }
+
+        // compact backwards so kept elements end up adjacent to the target
+        unsigned int write = found;
+        for(unsigned int read = found; read != head; ) {
+            read--;
+            Element e;
+            _load(read, e);
+            if(keep(e)) {
+                _store(--write, e);
+            } else {
+                drop(e);
+            }
+        }
+
+        int f;
+        if(blocking) {
+            _nahead = write;
+            f = _count.fetch_sub(drops, std::memory_order_relaxed);
+            _blockingMutex.unlock();
+        } else {
+            _head.store(write, std::memory_order_release);
+            f = _count.fetch_sub(drops, std::memory_order_acq_rel);
+        }
+
+        if(_lowWaterMarkHandler && f >= _lowWaterMark && f - drops < _lowWaterMark) {
+            _lowWaterMarkHandler(_waterMarkOpaque);
+        }
+        return drops;
+    }
+
+    // Reported like circular_fifo (usable size + 1), so callers that compare
+    // the stored count against capacity() - 1 work with either ring.
+    int capacity() {
+        return (int)_limit.load(std::memory_order_relaxed) + 1;
+    }
+
+    int storageSize() {
+        return N;
+    }
+
+    // The storage is fixed; only the usable part of it changes. Shrinking
+    // below the stored count just keeps pushes failing until reads catch up.
+    bool reserve(int fifoSize) {
+        if(fifoSize < 1 || fifoSize > N) {
+            return false;
+        }
+        _limit.store((unsigned int)fifoSize, std::memory_order_relaxed);
+        return true;
+    }
+
+    int storedCount() { return _count.load(std::memory_order_relaxed); }
+
+    void setWaterMarkHandler(int high, WaterMarkHandler highHandler, int low, WaterMarkHandler lowHandler, void * data) {
+        _lowWaterMarkHandler = lowHandler;
+        _highWaterMarkHandler = highHandler;
+        _waterMarkOpaque = data;
+        _highWaterMark = high;
+        _lowWaterMark = low;
+    }
+
+private:
+    void * _slot(unsigned int idx) {
+        return &_storage[(idx & mask) * sizeof(Element)];
+    }
+
+    Element& _at(unsigned int idx) {
+        return *std::launder(reinterpret_cast<Element *>(_slot(idx)));
+    }
+
+    void _store(unsigned int idx, const Element& item) {
+        if constexpr (_trivial) {
+            std::memcpy(_slot(idx), &item, sizeof(Element));
+        } else {
+            ::new (_slot(idx)) Element(item);
+        }
+    }
+
+    void _load(unsigned int idx, Element& item) {
+        if constexpr (_trivial) {
+            std::memcpy(&item, _slot(idx), sizeof(Element));
+        } else {
+            Element& e = _at(idx);
+            item = ::std::move(e);
+            e.~Element();
+        }
+    }
+
+    std::atomic<unsigned int>     _tail;
+    std::atomic<unsigned int>     _head;
+    std::atomic<int>              _count;
+
+    unsigned int                  _natail;
+    unsigned int                  _nahead;
+    std::atomic<unsigned int>     _limit;     // Usable slots, <= N
+
+    SP_Circular_Fifo_Mode         _mode;
+    std::mutex                    _blockingMutex;
+    isproqet_fifo_head_monitor *  _headMonitor;
+
+    WaterMarkHandler              _lowWaterMarkHandler;
+    WaterMarkHandler              _highWaterMarkHandler;
+    int                           _highWaterMark;
+    int                           _lowWaterMark;
+    void *                        _waterMarkOpaque;
+
+    alignas(Element) unsigned char _storage[slots * sizeof(Element)];
+};
+
+} // end namespace sproqet
+
+#endif // SPROQET_STATIC_CIRCULAR_FIFO_H
@@ -0,0 +1,113 @@
+/**
+ * ff_analyzer.h
+ *
+ * Bitstream-level stream analysis without decoding.
+ * Walks demuxed packets and collects per-stream structure: GOP lengths and
+ * keyframe intervals, bit rate over time, frame-type distribution (from the
+ * codec parsers, which only read headers) and timestamp anomalies. Runs at
+ * demux speed.
+ */
+
+#ifndef FF_ANALYZER_H
+#define FF_ANALYZER_H
+
+#include "ffmpeg_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFStreamAnalyzer FFStreamAnalyzer;
+
+// Creation flags
+#define FF_ANALYZER_NO_PARSE        (1u << 0)   // Skip parsers: no frame types, pure packet walk
+
+#define FF_ANALYZER_DEFAULT_WINDOW  1.0         // Bit rate window in seconds
+
+typedef struct {
+    int stream_index;
+    int media_type;                 // AVMediaType
+    int codec_id;                   // AVCodecID
+
+    int64_t packets;
+    int64_t bytes;
+    double duration;                // Seconds between first and last timestamp
+    double avg_bit_rate;            // Bits per second over duration
+    double peak_bit_rate;           // Highest single window
+
+    // Frame types (video, when a parser is available)
+    int64_t i_frames;
+    int64_t p_frames;
+    int64_t b_frames;
+    int64_t other_frames;           // S, SI, SP, BI
+    int64_t unknown_frames;         // No parser or no type reported
+    int max_b_run;                  // Longest run of consecutive B frames
+
+    // GOP structure (a GOP runs from one keyframe to the next)
+    int64_t keyframes;
+    int64_t gop_count;              // Includes the trailing, unterminated GOP
+    int min_gop_length;             // Packets
+    int max_gop_length;
+    double avg_gop_length;
+    double min_keyframe_interval;   // Seconds
+    double max_keyframe_interval;
+    double avg_keyframe_interval;
+
+    // Timestamp anomalies
+    int64_t missing_pts;
+    int64_t missing_dts;
+    int64_t dts_not_increasing;     // dts equal to or behind the previous packet
+    int64_t pts_before_dts;
+    int64_t timestamp_gaps;         // dts jumps of more than twice the packet duration
+    int64_t corrupt_packets;        // Flagged AV_PKT_FLAG_CORRUPT by the demuxer
+} FFStreamStats;
+
+/**
+ * Create an analyzer for all streams of an opened demuxer.
+ * @param window_seconds Bit rate sampling window (<= 0 = FF_ANALYZER_DEFAULT_WINDOW)
+ * @param flags FF_ANALYZER_* flags
+ * @return Analyzer handle or NULL on failure
+ */
+FFStreamAnalyzer* ff_analyzer_create(FFDemuxContext *demux_ctx, double window_seconds,
+                                     uint32_t flags);
+
+void ff_analyzer_destroy(FFStreamAnalyzer *analyzer);
+
+/**
+ * Account for one packet (for callers that read packets themselves).
+ * Packets of streams the analyzer does not know are ignored.
+ */
+int ff_analyzer_add_packet(FFStreamAnalyzer *analyzer, const AVPacket *pkt);
+
+/**
+ * Read the demuxer to the end, analysing every packet.
+ * @return 0 at end of file or a negative AVERROR
+ */
+int ff_analyzer_run(FFStreamAnalyzer *analyzer, FFDemuxContext *demux_ctx);
+
+int ff_analyzer_stream_count(FFStreamAnalyzer *analyzer);
+
+/**
+ * Statistics for one stream, as of the packets seen so far.
+ */
+int ff_analyzer_get_stats(FFStreamAnalyzer *analyzer, int stream_index, FFStreamStats *stats);
+
+/**
+ * Bit rate per window, in bits per second, starting at the stream's first timestamp.
+ * @return Total number of windows (may exceed max_count), or negative AVERROR
+ */
+int ff_analyzer_get_bitrate(FFStreamAnalyzer *analyzer, int stream_index,
+                            double *bit_rates, int max_count);
+
+/**
+ * GOP lengths in packets, in stream order, including the trailing GOP.
+ * @return Total number of GOPs (may exceed max_count), or negative AVERROR
+ */
+int ff_analyzer_get_gop_lengths(FFStreamAnalyzer *analyzer, int stream_index,
+                                int *lengths, int max_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_ANALYZER_H
@@ -0,0 +1,78 @@
+/**
+ * ff_arena.h
+ *
+ * Bump allocator for per-pipeline objects. Context structs and side tables
+ * created in an arena are carved out of a few large blocks and are all
+ * released together by ff_arena_destroy, instead of going through the heap
+ * one small allocation at a time.
+ */
+
+#ifndef FF_ARENA_H
+#define FF_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFArena FFArena;
+
+typedef void (*FFArenaCleanupFunc)(void* opaque);
+
+#define FF_ARENA_DEFAULT_BLOCK_SIZE  (64 * 1024)
+
+/**
+ * Create an arena.
+ * @param block_size Bytes reserved per block (0 = FF_ARENA_DEFAULT_BLOCK_SIZE)
+ * @return Arena handle or NULL on failure
+ */
+FFArena* ff_arena_create(size_t block_size);
+
+/**
+ * Create an arena whose blocks are placed on a NUMA node.
+ * @param numa_node Node index, or FF_NUMA_NODE_ANY (-1)
+ */
+FFArena* ff_arena_create_on_node(size_t block_size, int numa_node);
+
+/**
+ * Run all registered cleanups (most recent first), then release every block.
+ * Objects created in the arena must not be used afterwards.
+ */
+void ff_arena_destroy(FFArena* arena);
+
+/**
+ * Allocate zeroed memory aligned for any type. Thread safe.
+ * Memory is only reclaimed when the arena is destroyed.
+ * @return Pointer or NULL on failure
+ */
+void* ff_arena_alloc(FFArena* arena, size_t size);
+
+/**
+ * Register a function to run when the arena is destroyed.
+ * Cleanups run in reverse registration order, so objects are torn down
+ * before anything they were created from.
+ * @return 0 on success or a negative AVERROR code
+ */
+int ff_arena_defer(FFArena* arena, FFArenaCleanupFunc fn, void* opaque);
+
+/**
+ * Register a cleanup that runs after every ff_arena_defer cleanup,
+ * whatever the creation order. For objects the others hand things back
+ * to, such as command pools that queued commands return to.
+ * @return 0 on success or a negative AVERROR code
+ */
+int ff_arena_defer_final(FFArena* arena, FFArenaCleanupFunc fn, void* opaque);
+
+/**
+ * Arena statistics.
+ */
+size_t ff_arena_bytes_used(FFArena* arena);
+size_t ff_arena_bytes_reserved(FFArena* arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_ARENA_H
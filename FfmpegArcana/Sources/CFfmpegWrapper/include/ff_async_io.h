@@ -0,0 +1,94 @@
+/**
+ * ff_async_io.h
+ *
+ * Asynchronous file I/O behind a custom AVIOContext.
+ * Reads keep a window of large blocks in flight ahead of the demuxer;
+ * writes are gathered into blocks and submitted in batches. On Linux the
+ * requests go through io_uring with registered buffers; elsewhere, or when
+ * io_uring is unavailable, the same block machinery runs on pread/pwrite.
+ *
+ * FF_ASYNC_IO_DIRECT turns a reader into a one-pass ingest stream: aligned
+ * O_DIRECT block reads (F_NOCACHE on Apple platforms), double-buffered by
+ * default, so multi-GB sources do not evict the page cache other readers
+ * depend on. When the filesystem cannot meet the alignment rules the handle
+ * quietly stays buffered and drops consumed blocks from the cache instead.
+ */
+
+#ifndef FF_ASYNC_IO_H
+#define FF_ASYNC_IO_H
+
+#include "ffmpeg_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFAsyncIO FFAsyncIO;
+
+// Open flags
+#define FF_ASYNC_IO_SYNC            (1u << 0)   // Never use io_uring (pread/pwrite backend)
+#define FF_ASYNC_IO_DIRECT          (1u << 1)   // Bypass the page cache (reads only)
+
+#define FF_ASYNC_IO_DEFAULT_BLOCK_SIZE  (1024 * 1024)
+#define FF_ASYNC_IO_DEFAULT_DEPTH       8
+
+// What actually services the requests
+typedef enum {
+    FF_ASYNC_IO_BACKEND_PREAD = 0,          // Synchronous pread/pwrite
+    FF_ASYNC_IO_BACKEND_URING,              // io_uring, unregistered buffers
+    FF_ASYNC_IO_BACKEND_URING_FIXED         // io_uring, registered buffers
+} FFAsyncIOBackend;
+
+/**
+ * Open a file for reading.
+ * @param block_size Bytes per request (0 = FF_ASYNC_IO_DEFAULT_BLOCK_SIZE)
+ * @param queue_depth Requests kept in flight (0 = FF_ASYNC_IO_DEFAULT_DEPTH,
+ *                    or 2 with FF_ASYNC_IO_DIRECT)
+ * @param flags FF_ASYNC_IO_* flags
+ * @return Handle or NULL on failure
+ */
+FFAsyncIO* ff_async_io_open_read(const char *path, uint32_t block_size,
+                                 uint32_t queue_depth, uint32_t flags);
+
+/**
+ * Create or truncate a file for writing.
+ */
+FFAsyncIO* ff_async_io_open_write(const char *path, uint32_t block_size,
+                                  uint32_t queue_depth, uint32_t flags);
+
+/**
+ * Flush pending writes, wait for everything in flight and close the file.
+ * The AVIOContext is freed as well; detach it from any format context first.
+ * @return 0 on success or the first write error
+ */
+int ff_async_io_close(FFAsyncIO *aio);
+
+/**
+ * The AVIOContext to hand to libavformat (owned by the FFAsyncIO).
+ */
+AVIOContext* ff_async_io_avio(FFAsyncIO *aio);
+
+FFAsyncIOBackend ff_async_io_backend(FFAsyncIO *aio);
+
+/**
+ * Whether block reads currently bypass the page cache. False when
+ * FF_ASYNC_IO_DIRECT was not requested or could not be honoured.
+ */
+bool ff_async_io_is_direct(FFAsyncIO *aio);
+
+// -----------------------------------------------------------------------------
+// Demuxer integration
+// -----------------------------------------------------------------------------
+
+/**
+ * ff_demux_open variant that reads the file through an FFAsyncIO.
+ * The demuxer owns the FFAsyncIO and closes it with the format context.
+ */
+int ff_demux_open_async(FFDemuxContext *ctx, const char *path, uint32_t block_size,
+                        uint32_t queue_depth, uint32_t flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_ASYNC_IO_H
@@ -10,11 +10,16 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+#include "ff_arena.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct AVCodecParameters;
+
 // -----------------------------------------------------------------------------
 // Ref counting interface - COM style
 // -----------------------------------------------------------------------------
@@ -48,10 +53,14 @@ typedef enum {
     FF_CMD_FLUSH,           // Flush buffers, no data
     FF_CMD_EOS,             // End of stream, no data
     FF_CMD_SEEK,            // Seek request, data is FFSeekParams*
-    FF_CMD_CONFIG,          // Configuration change, data is user-defined
+    FF_CMD_CONFIG,          // Configuration change, data is AVCodecParameters* (or user-defined)
+    FF_CMD_ERROR,           // Stage failure, no data (see ff_cmd_init_error)
     FF_CMD_USER = 0x1000    // User-defined types start here
 } FFCmdType;
 
+// Command flags
+#define FF_CMD_FLAG_KEYFRAME        (1u << 0)   // Media command is a decodable entry point
+
 // -----------------------------------------------------------------------------
 // Seek parameters (example of a command payload)
 // -----------------------------------------------------------------------------
@@ -68,6 +77,14 @@ typedef struct {
 typedef struct FFCmd FFCmd;
 typedef struct FFCmdPool FFCmdPool;
 
+/**
+ * Foreign payload callbacks (see ff_cmd_set_payload). Release drops one
+ * reference; AddRef takes another and returns the pointer that now carries
+ * it (the same pointer for retain-style objects, a new one for clones).
+ */
+typedef void (*FFPayloadReleaseFunc)(void* ptr);
+typedef void* (*FFPayloadAddRefFunc)(void* ptr);
+
 struct FFCmd {
     // Ref counting interface - must be first
     IFFRefCounted ref;
@@ -80,6 +97,11 @@ struct FFCmd {
     int64_t dts;                // Decode timestamp (or AV_NOPTS_VALUE)
     uint32_t flags;             // Command-specific flags
     uint32_t stream_index;      // Stream index (for packets/frames)
+    size_t data_size;           // Payload size hint in bytes, 0 = unknown
+    
+    // Foreign payload callbacks, set by ff_cmd_set_payload (else NULL)
+    FFPayloadReleaseFunc payload_release;
+    FFPayloadAddRefFunc payload_addref;
     
     // User context
     void* user_data;
@@ -102,6 +124,20 @@ struct FFCmd {
  */
 FFCmdPool* ff_cmd_pool_create(uint32_t initial_size, uint32_t max_size);
 
+/**
+ * Create a command pool whose commands live in memory on a NUMA node.
+ * @param numa_node Node index, or FF_NUMA_NODE_ANY (-1) for no preference
+ */
+FFCmdPool* ff_cmd_pool_create_on_node(uint32_t initial_size, uint32_t max_size, int numa_node);
+
+/**
+ * Create a command pool inside an arena. The pool and its commands are
+ * released with the arena, after every other object in it, so FIFOs
+ * created earlier can still drain into it; ff_cmd_pool_destroy on an
+ * arena pool does nothing.
+ */
+FFCmdPool* ff_cmd_pool_create_in(FFArena* arena, uint32_t initial_size, uint32_t max_size);
+
 /**
  * Destroy a command pool.
  * WARNING: All commands must be released before destroying the pool.
@@ -134,10 +170,53 @@ void ff_cmd_init(FFCmd* cmd, FFCmdType type);
 
 /**
  * Set command data with optional ref counting interface.
- * If data_ref is provided, AddRef is called on the data.
+ * If data_ref is provided, AddRef is called on the data. AVFrame and
+ * AVPacket cannot be refcounted through the same pointer, so with their
+ * interfaces the command takes a new reference (av_frame_clone /
+ * av_packet_clone) and the caller keeps, and frees, its own.
  */
 void ff_cmd_set_data(FFCmd* cmd, void* data, IFFRefCounted* data_ref);
 
+/**
+ * Attach a foreign payload (CVPixelBuffer, shared-memory frame, ...) by
+ * reference, without copying. The command takes over one reference to ptr:
+ * release_fn runs exactly once when the data is cleared, whether the command
+ * is consumed, re-initialized, or drained from a FIFO during teardown.
+ * addref_fn is optional and lets ff_cmd_copy_payload share the payload.
+ * @param size_hint Payload size in bytes for accounting, 0 if unknown
+ * @return 0 on success or AVERROR(EINVAL) (release_fn is required)
+ */
+int ff_cmd_set_payload(FFCmd* cmd, void* ptr, size_t size_hint,
+                       FFPayloadReleaseFunc release_fn, FFPayloadAddRefFunc addref_fn);
+
+/**
+ * Give dst its own reference to src's payload (AVFrame, AVPacket or a
+ * foreign payload with an AddRef), replacing dst's data.
+ * @return 0 on success, AVERROR(ENOSYS) if the payload cannot be shared
+ */
+int ff_cmd_copy_payload(FFCmd* dst, const FFCmd* src);
+
+/**
+ * Initialize an FF_CMD_CONFIG command announcing new codec parameters for a
+ * stream. The command owns a copy of codecpar, freed with the command.
+ * @return 0 on success or a negative AVERROR
+ */
+int ff_cmd_init_config(FFCmd* cmd, const struct AVCodecParameters* codecpar, uint32_t stream_index);
+
+/**
+ * Initialize an FF_CMD_ERROR command telling downstream that a stage failed
+ * for a stream. flags carries the AVERROR, negated; read it back with
+ * ff_cmd_error_code.
+ */
+void ff_cmd_init_error(FFCmd* cmd, int error, uint32_t stream_index);
+
+/**
+ * AVERROR carried by an FF_CMD_ERROR command, 0 for any other command.
+ */
+static inline int ff_cmd_error_code(FFCmd* cmd) {
+    return cmd && cmd->type == FF_CMD_ERROR ? -(int)cmd->flags : 0;
+}
+
 /**
  * Clear command data.
  * If data has a ref counting interface, Release is called.
@@ -158,6 +237,12 @@ static inline bool ff_cmd_is_media(FFCmd* cmd) {
     return cmd && (cmd->type == FF_CMD_FRAME || cmd->type == FF_CMD_PACKET);
 }
 
+/**
+ * Check if a media command is a keyframe: FF_CMD_FLAG_KEYFRAME is set, or
+ * its packet/frame carries the FFmpeg key flag.
+ */
+bool ff_cmd_is_keyframe(FFCmd* cmd);
+
 // -----------------------------------------------------------------------------
 // AVFrame/AVPacket ref counting adapters
 // -----------------------------------------------------------------------------
@@ -174,6 +259,11 @@ IFFRefCounted* ff_frame_ref_interface(void);
  */
 IFFRefCounted* ff_packet_ref_interface(void);
 
+/**
+ * Release-only interface for AVCodecParameters (single owner).
+ */
+IFFRefCounted* ff_codecpar_ref_interface(void);
+
 // -----------------------------------------------------------------------------
 // Command FIFO
 // -----------------------------------------------------------------------------
@@ -189,15 +279,98 @@ typedef enum {
 #define FF_CMD_FIFO_INVALID_PARAMS  1
 #define FF_CMD_FIFO_FLOW_DISABLED   13
 #define FF_CMD_FIFO_FULL            29
+#define FF_CMD_FIFO_CLOSED          30
 #define FF_CMD_FIFO_TIMEOUT         -1
 
+#define FF_CMD_FIFO_INLINE_CAPACITY 8   // Rings up to this size live inside the FIFO
+
 /**
- * Create a command FIFO.
+ * Create a command FIFO. Up to FF_CMD_FIFO_INLINE_CAPACITY commands the
+ * ring is stored inline with a power-of-two mask, so small control FIFOs
+ * need no separate ring allocation.
  */
 FFCmdFifo* ff_cmd_fifo_create(uint32_t capacity, FFCmdFifoMode mode);
 void ff_cmd_fifo_destroy(FFCmdFifo* fifo);
 
+/**
+ * Create a command FIFO inside an arena. Remaining commands are drained
+ * when the arena is destroyed; ff_cmd_fifo_destroy is optional.
+ */
+FFCmdFifo* ff_cmd_fifo_create_in(FFArena* arena, uint32_t capacity, FFCmdFifoMode mode);
+
+/**
+ * Head monitor callback. Runs on the thread that wrote or read, whenever a
+ * command becomes the head of the FIFO: a write into an empty FIFO, or a
+ * read that leaves commands behind. Keep it short and never touch the
+ * FIFO itself from inside it.
+ */
+typedef void (*FFCmdFifoHeadFunc)(FFCmdFifo* fifo, void* userdata);
+
+/**
+ * Create a command FIFO that reports new heads, so consumers can be
+ * scheduled on arrival instead of parking a thread in wait_read.
+ */
+FFCmdFifo* ff_cmd_fifo_create_monitored(uint32_t capacity, FFCmdFifoMode mode,
+                                        FFCmdFifoHeadFunc func, void* userdata);
+
+/**
+ * Push-mode consumer. Owns cmd and must release it. Calls are serialized
+ * and arrive in FIFO order, on whichever writer thread is delivering.
+ */
+typedef void (*FFCmdFifoConsumeFunc)(FFCmdFifo* fifo, FFCmd* cmd, void* userdata);
+
+/**
+ * Hand writes straight to a consumer stage instead of a reader thread. A
+ * write that finds the FIFO empty with no delivery in progress calls func
+ * on the writer's thread, skipping the ring and the read semaphore; writes
+ * that arrive during a delivery are queued and then drained, in order, by
+ * the thread already delivering. Meant for short CPU-light stages; to run
+ * a stage on a worker instead, use ff_cmd_fifo_create_monitored and
+ * schedule it from the head callback. Set or clear only with flow
+ * disabled and no thread writing or reading, so no delivery can still be
+ * using the previous func and userdata; NULL returns the FIFO to pull
+ * mode. func must never block waiting on this FIFO.
+ * @return FF_CMD_FIFO_OK, or FF_CMD_FIFO_INVALID_PARAMS while flow is
+ *         enabled or a delivery is still running
+ */
+int ff_cmd_fifo_set_consumer(FFCmdFifo* fifo, FFCmdFifoConsumeFunc func, void* userdata);
+
+/**
+ * Create a command FIFO whose capacity will be changed at runtime with
+ * ff_cmd_fifo_resize, up to max_capacity. Lockless FIFOs reserve ring
+ * storage for max_capacity up front; blocking FIFOs grow it on demand.
+ */
+FFCmdFifo* ff_cmd_fifo_create_resizable(uint32_t capacity, uint32_t max_capacity,
+                                        FFCmdFifoMode mode);
+
+/**
+ * Change the capacity while producers and consumers run. Growing wakes
+ * blocked writers; shrinking below the queued count keeps the commands and
+ * withholds write space until reads bring the count under the new
+ * capacity. Any FIFO can be resized within its ring storage (its creation
+ * capacity, or FF_CMD_FIFO_INLINE_CAPACITY for small ones); blocking FIFOs
+ * move to a larger ring when needed.
+ * @return FF_CMD_FIFO_OK or FF_CMD_FIFO_INVALID_PARAMS
+ */
+int ff_cmd_fifo_resize(FFCmdFifo* fifo, uint32_t capacity);
+
+/**
+ * Current capacity.
+ */
+uint32_t ff_cmd_fifo_capacity(FFCmdFifo* fifo);
+
 // Flow control
+/**
+ * Close the FIFO for good. Every thread blocked in a wait wakes, and later
+ * waits, writes and preempts return FF_CMD_FIFO_CLOSED without blocking.
+ * Queued commands are released at once, a pool lock per batch rather than
+ * per command. Lockless FIFOs: call from the consumer, or while it is
+ * blocked in a wait or stopped. Safe to call more than once.
+ * @return Number of queued commands released
+ */
+int ff_cmd_fifo_close(FFCmdFifo* fifo);
+bool ff_cmd_fifo_is_closed(FFCmdFifo* fifo);
+
 void ff_cmd_fifo_set_flow_enabled(FFCmdFifo* fifo, bool enabled);
 bool ff_cmd_fifo_get_flow_enabled(FFCmdFifo* fifo);
 
@@ -216,6 +389,55 @@ int ff_cmd_fifo_read(FFCmdFifo* fifo, FFCmd** cmd);
 // Preempt - push to front
 int ff_cmd_fifo_preempt(FFCmdFifo* fifo, FFCmd* cmd);
 
+/**
+ * Monotonic clock for FIFO deadlines, in microseconds. Wall clock steps
+ * (NTP, manual changes) never move it.
+ */
+int64_t ff_cmd_fifo_clock_us(void);
+
+/**
+ * Timed waits on the monotonic clock. The _us variants wait up to usecs
+ * (0 only tries); the _until variants take an absolute ff_cmd_fifo_clock_us
+ * deadline, so a pacing loop that advances it by one frame period does not
+ * drift by the wake-up latency of each wait.
+ * @return FF_CMD_FIFO_OK, FF_CMD_FIFO_TIMEOUT, or the FIFO's flow/closed code
+ */
+int ff_cmd_fifo_wait_write_us(FFCmdFifo* fifo, int64_t usecs);
+int ff_cmd_fifo_wait_write_until(FFCmdFifo* fifo, int64_t deadline_us);
+int ff_cmd_fifo_wait_read_us(FFCmdFifo* fifo, int64_t usecs);
+int ff_cmd_fifo_wait_read_until(FFCmdFifo* fifo, int64_t deadline_us);
+
+/**
+ * Live catch-up: release every queued media command ahead of the first
+ * queued keyframe of the head media command's stream (the packet's
+ * stream_index, else the command's), in one step; media of other streams
+ * in between is released too. Sentinels and control commands ahead of it
+ * are kept in order. Does nothing when no keyframe is queued (or when a
+ * blocked reader has already claimed one of the commands to drop). In
+ * lockless mode call it from the consumer thread only.
+ * @return Number of commands released
+ */
+int ff_cmd_fifo_skip_to_keyframe(FFCmdFifo* fifo);
+
+/**
+ * Automatic catch-up: ff_cmd_fifo_read skips to the next keyframe before
+ * reading when either threshold is exceeded. 0 disables a threshold.
+ */
+typedef struct {
+    uint32_t max_count;     // Queued commands
+    int64_t max_lag;        // Newest written pts - last read pts, in the stream's time base
+} FFCmdFifoSkipPolicy;
+
+/**
+ * Set or clear (NULL) the catch-up policy. Any thread.
+ */
+void ff_cmd_fifo_set_skip_policy(FFCmdFifo* fifo, const FFCmdFifoSkipPolicy* policy);
+
+/**
+ * Commands released by catch-up, manual or automatic.
+ */
+uint64_t ff_cmd_fifo_skipped_count(FFCmdFifo* fifo);
+
 // Status
 int ff_cmd_fifo_count(FFCmdFifo* fifo);
 bool ff_cmd_fifo_has_been_read(FFCmdFifo* fifo);
@@ -0,0 +1,98 @@
+/**
+ * ff_decode_service.h
+ *
+ * Multiplexed decoding for many low-rate streams.
+ * Instead of a decoder thread per stream, every stream's decoder runs on a
+ * small fixed set of worker threads. A stream is scheduled when commands
+ * arrive in its input FIFO, gets a bounded turn (a few input commands), and
+ * goes to the back of the run queue if it still has work, so a busy camera
+ * cannot starve quiet ones. Decoders are single-threaded and keep their
+ * state between turns.
+ *
+ * Input commands:  FF_CMD_PACKET (data AVPacket*), FF_CMD_FLUSH, FF_CMD_EOS,
+ *                  FF_CMD_CONFIG (from ff_cmd_init_config).
+ * Output commands: FF_CMD_FRAME (data AVFrame*, owned by the command) plus
+ *                  every non-packet input command, in order. EOS and CONFIG
+ *                  follow the last frame drained before them, so downstream
+ *                  scalers and pools can switch before the first new frame.
+ *                  A CONFIG the decoder cannot switch to is replaced by
+ *                  FF_CMD_ERROR with the AVERROR (ff_cmd_error_code).
+ *                  user_data carries the stream's opaque.
+ */
+
+#ifndef FF_DECODE_SERVICE_H
+#define FF_DECODE_SERVICE_H
+
+#include "ffmpeg_wrapper.h"
+#include "ff_cmd.h"
+#include "ff_decoder_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFDecodeService FFDecodeService;
+typedef struct FFDecodeStream FFDecodeStream;
+
+#define FF_DECODE_SERVICE_DEFAULT_QUANTUM   4       // Input commands per turn
+#define FF_DECODE_SERVICE_RETRY_MSECS       2       // Retry period for streams with a full output
+
+/**
+ * Create a decode service.
+ * @param thread_count Worker threads (0 = one per CPU)
+ * @param quantum Input commands a stream may consume per turn (0 = default)
+ * @param cmd_pool Pool for output frame commands (NULL = the service creates one)
+ * @return Service handle or NULL on failure
+ */
+FFDecodeService* ff_decode_service_create(uint32_t thread_count, uint32_t quantum,
+                                          FFCmdPool* cmd_pool);
+
+/**
+ * Stop the workers and remove every remaining stream.
+ */
+void ff_decode_service_destroy(FFDecodeService* service);
+
+/**
+ * Add a stream. The service opens a single-threaded decoder for it and an
+ * input FIFO (blocking mode, flow enabled) that producers write packets to.
+ * Frames go to output, which must outlive the stream. When output is full
+ * the stream parks and is retried every FF_DECODE_SERVICE_RETRY_MSECS.
+ * @param opaque Copied into the user_data of every output command
+ * @return Stream handle or NULL on failure
+ */
+FFDecodeStream* ff_decode_service_add_stream(FFDecodeService* service,
+                                             FFDemuxContext* demux_ctx, int stream_index,
+                                             bool use_hardware, uint32_t input_capacity,
+                                             FFCmdFifo* output, void* opaque);
+
+/**
+ * Remove a stream: waits out a running turn, then releases its decoder,
+ * its input FIFO and anything still queued in it.
+ */
+void ff_decode_service_remove_stream(FFDecodeService* service, FFDecodeStream* stream);
+
+/**
+ * Decoder cache used when a CONFIG needs a different codec context; old
+ * contexts are parked there for streams that switch back (adaptive HLS).
+ * NULL (the default) opens and closes contexts directly.
+ */
+void ff_decode_service_set_decoder_cache(FFDecodeService* service, FFDecoderCache* cache);
+
+/**
+ * FIFO that producers write this stream's commands to.
+ */
+FFCmdFifo* ff_decode_stream_input(FFDecodeStream* stream);
+
+/**
+ * Statistics.
+ */
+uint32_t ff_decode_service_thread_count(FFDecodeService* service);
+uint32_t ff_decode_service_stream_count(FFDecodeService* service);
+uint64_t ff_decode_stream_packet_count(FFDecodeStream* stream);
+uint64_t ff_decode_stream_frame_count(FFDecodeStream* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_DECODE_SERVICE_H
@@ -0,0 +1,97 @@
+/**
+ * ff_decoder_cache.h
+ *
+ * Warm decoder cache. Opening a decoder (codec lookup, context allocation,
+ * parameter copy, avcodec_open2) dominates short decode jobs such as
+ * thumbnailing. Released decoders are flushed and parked here, and handed
+ * back out for the next stream with the same codec and parameters, or for
+ * a running decoder whose stream switches parameters mid-way.
+ */
+
+#ifndef FF_DECODER_CACHE_H
+#define FF_DECODER_CACHE_H
+
+#include "ffmpeg_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFDecoderCache FFDecoderCache;
+
+/**
+ * Create a decoder cache.
+ * @param max_idle Maximum number of parked decoders (oldest evicted first)
+ * @param max_idle_seconds Parked decoders older than this are closed (<= 0 = no age limit)
+ * @return Cache handle or NULL on failure
+ */
+FFDecoderCache* ff_decoder_cache_create(uint32_t max_idle, double max_idle_seconds);
+
+/**
+ * Destroy a cache and close all parked decoders.
+ * Decoders currently handed out stay valid; release them with ff_decoder_destroy.
+ */
+void ff_decoder_cache_destroy(FFDecoderCache *cache);
+
+/**
+ * Get a decoder for a stream: a parked decoder whose codec id and tag,
+ * profile, dimensions, format and extradata match, or a newly opened one.
+ * @return Decoder or NULL on failure
+ */
+FFDecoderContext* ff_decoder_cache_acquire(FFDecoderCache *cache, FFDemuxContext *demux_ctx,
+                                           int stream_index, bool use_hardware);
+
+/**
+ * Get a decoder for explicit codec parameters (e.g. a new rendition that
+ * arrived in an FF_CMD_CONFIG command).
+ */
+FFDecoderContext* ff_decoder_cache_acquire_params(FFDecoderCache *cache,
+                                                  const AVCodecParameters *codecpar,
+                                                  AVRational time_base, int stream_index,
+                                                  bool use_hardware);
+
+/**
+ * Return a decoder. It is flushed and parked for reuse; decoders that use a
+ * frame pool or live in an arena are destroyed instead.
+ */
+void ff_decoder_cache_release(FFDecoderCache *cache, FFDecoderContext *decoder);
+
+/**
+ * Close parked decoders that exceeded the age limit.
+ * @return Number of decoders closed
+ */
+uint32_t ff_decoder_cache_trim(FFDecoderCache *cache);
+
+/**
+ * Cache statistics.
+ */
+uint32_t ff_decoder_cache_idle_count(FFDecoderCache *cache);
+uint64_t ff_decoder_cache_hit_count(FFDecoderCache *cache);
+uint64_t ff_decoder_cache_miss_count(FFDecoderCache *cache);
+
+// -----------------------------------------------------------------------------
+// Reconfiguration
+// -----------------------------------------------------------------------------
+
+#define FF_DECODER_RECONFIG_NONE        0   // Parameters unchanged
+#define FF_DECODER_RECONFIG_IN_PLACE    1   // Same codec context, flushed
+#define FF_DECODER_RECONFIG_REOPENED    2   // Codec context swapped for a matching one
+
+/**
+ * Switch a decoder to new codec parameters mid-stream (resolution, pixel
+ * format or extradata change) while keeping the decoder handle valid.
+ * Codecs that follow in-band header changes are flushed and keep their
+ * context; otherwise the codec context is replaced by a warm one from the
+ * cache (or a newly opened one) and the old context is parked there.
+ * Drain the decoder first; buffered frames are discarded.
+ * @param cache Decoder cache, or NULL to open and close contexts directly
+ * @return FF_DECODER_RECONFIG_* or a negative AVERROR (decoder unchanged)
+ */
+int ff_decoder_reconfigure(FFDecoderContext *decoder, const AVCodecParameters *codecpar,
+                           FFDecoderCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_DECODER_CACHE_H
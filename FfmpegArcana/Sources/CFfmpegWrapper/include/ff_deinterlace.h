@@ -0,0 +1,78 @@
+/**
+ * ff_deinterlace.h
+ *
+ * Native deinterlacing of 8-bit YUV (YUV420P, YUV422P, YUV444P, NV12,
+ * GRAY8) without a filter graph. Rows are rebuilt by NEON or SSE2 kernels
+ * and frames are split into slices across a thread pool. Output is one
+ * frame per input frame, or one per field (double rate) with the second
+ * field timed half a frame later.
+ *
+ * Usage mirrors the decoder: send a frame, then receive until EAGAIN;
+ * send NULL at the end of the stream and receive until EOF. YADIF holds
+ * one frame back, as it needs the next frame to rebuild the current one.
+ */
+
+#ifndef FF_DEINTERLACE_H
+#define FF_DEINTERLACE_H
+
+#include "ffmpeg_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFDeinterlacer FFDeinterlacer;
+
+typedef enum {
+    FF_DEINTERLACE_BOB = 0,     // Missing lines averaged from the lines either side
+    FF_DEINTERLACE_BLEND = 1,   // Both fields low-passed together; always single rate
+    FF_DEINTERLACE_YADIF = 2    // Edge-directed spatial guess bounded by temporal neighbours
+} FFDeinterlaceMode;
+
+// Mirrors MediaFormat.FieldMode, plus AUTO
+typedef enum {
+    FF_FIELD_ORDER_AUTO = 0,        // AV_FRAME_FLAG_INTERLACED / _TOP_FIELD_FIRST per frame
+    FF_FIELD_ORDER_PROGRESSIVE = 1, // Pass frames through
+    FF_FIELD_ORDER_TOP_FIRST = 2,
+    FF_FIELD_ORDER_BOTTOM_FIRST = 3
+} FFFieldOrder;
+
+bool ff_deinterlacer_supports_format(int format);
+
+/**
+ * @param double_rate One output per field instead of per frame
+ * @param threads Slice threads including the caller, <= 0 for one per CPU
+ */
+FFDeinterlacer* ff_deinterlacer_create(FFDeinterlaceMode mode, bool double_rate, int threads);
+void ff_deinterlacer_destroy(FFDeinterlacer* di);
+
+/**
+ * Override the frame flags, e.g. with the container's field order when
+ * the decoder does not flag interlaced frames.
+ */
+void ff_deinterlacer_set_field_order(FFDeinterlacer* di, FFFieldOrder order);
+
+/**
+ * Queue a frame (referenced, not copied), or NULL to drain.
+ * @return 0, AVERROR(EAGAIN) if output is waiting to be received,
+ *         AVERROR_EOF after draining, or negative AVERROR
+ */
+int ff_deinterlacer_send_frame(FFDeinterlacer* di, const AVFrame* frame);
+
+/**
+ * Produce the next output into frame, which is unreferenced first.
+ * @return 0, AVERROR(EAGAIN) when more input is needed, AVERROR_EOF when
+ *         drained, or negative AVERROR
+ */
+int ff_deinterlacer_receive_frame(FFDeinterlacer* di, AVFrame* frame);
+
+/**
+ * Drop queued frames and history, e.g. after a seek.
+ */
+void ff_deinterlacer_flush(FFDeinterlacer* di);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_DEINTERLACE_H
@@ -0,0 +1,60 @@
+/**
+ * ff_demux_cache.h
+ *
+ * Open-file cache for demuxers. Opening a container probes it and builds
+ * its index; for workloads that keep returning to the same few hundred
+ * files, released demuxers are rewound and parked instead of closed.
+ * Files are identified by path plus device, inode, mtime and size.
+ */
+
+#ifndef FF_DEMUX_CACHE_H
+#define FF_DEMUX_CACHE_H
+
+#include "ffmpeg_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFDemuxCache FFDemuxCache;
+
+/**
+ * Create a demuxer cache.
+ * @param max_open Maximum number of parked demuxers, and so of file
+ *                 descriptors held by the cache (least recently used evicted)
+ * @return Cache handle or NULL on failure
+ */
+FFDemuxCache* ff_demux_cache_create(uint32_t max_open);
+
+/**
+ * Destroy a cache and close all parked demuxers.
+ * Demuxers currently handed out stay valid; release them with ff_demux_destroy.
+ */
+void ff_demux_cache_destroy(FFDemuxCache *cache);
+
+/**
+ * Get an opened demuxer for a URL, positioned at the start of the file.
+ * Local files are served from the cache when an unchanged copy is parked;
+ * anything else is opened normally.
+ * @return 0 on success or a negative AVERROR code
+ */
+int ff_demux_cache_open(FFDemuxCache *cache, const char *url, FFDemuxContext **out);
+
+/**
+ * Return a demuxer. Cacheable demuxers are rewound and parked;
+ * others are destroyed.
+ */
+void ff_demux_cache_release(FFDemuxCache *cache, FFDemuxContext *demux_ctx);
+
+/**
+ * Cache statistics.
+ */
+uint32_t ff_demux_cache_open_count(FFDemuxCache *cache);
+uint64_t ff_demux_cache_hit_count(FFDemuxCache *cache);
+uint64_t ff_demux_cache_miss_count(FFDemuxCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_DEMUX_CACHE_H
@@ -0,0 +1,75 @@
+/**
+ * ff_fifo_controller.h
+ *
+ * Adaptive buffering depth for a resizable command FIFO.
+ * Jitter shows up as a producer finding the FIFO full (a burst the consumer
+ * could not absorb) or a consumer finding it empty when it had a deadline.
+ * Each such event deepens the FIFO by one command; a run of reads without
+ * one gives a command back, so the queue settles at the shallowest depth
+ * that rides out the jitter actually seen, keeping latency low.
+ */
+
+#ifndef FF_FIFO_CONTROLLER_H
+#define FF_FIFO_CONTROLLER_H
+
+#include "ff_cmd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFFifoController FFFifoController;
+
+#define FF_FIFO_CONTROLLER_DEFAULT_WINDOW   120     // Quiet reads before shrinking
+
+/**
+ * Create a controller for a FIFO (see ff_cmd_fifo_create_resizable). The
+ * FIFO is clamped into [min_capacity, max_capacity] straight away.
+ * @return Controller or NULL on invalid bounds
+ */
+FFFifoController* ff_fifo_controller_create(FFCmdFifo* fifo, uint32_t min_capacity,
+                                             uint32_t max_capacity);
+void ff_fifo_controller_destroy(FFFifoController* ctl);
+
+/**
+ * Quiet reads required before giving one command of depth back.
+ * 0 = FF_FIFO_CONTROLLER_DEFAULT_WINDOW.
+ */
+void ff_fifo_controller_set_window(FFFifoController* ctl, uint32_t reads);
+
+/**
+ * Producer side: a write found no space. Any thread.
+ */
+void ff_fifo_controller_overflow(FFFifoController* ctl);
+
+/**
+ * Consumer side: a read missed its deadline because nothing was queued.
+ * Any thread.
+ */
+void ff_fifo_controller_underrun(FFFifoController* ctl);
+
+/**
+ * Manual depth, clamped to the controller's bounds. Any thread; it takes
+ * effect on the next update, so the FIFO is only ever resized by the
+ * updating thread and the controller's capacity stays in step with it.
+ * Resize a controlled FIFO this way, not with ff_cmd_fifo_resize.
+ */
+void ff_fifo_controller_set_capacity(FFFifoController* ctl, uint32_t capacity);
+
+/**
+ * Consumer side, once per read: applies pending events and resizes the
+ * FIFO. Call from one thread.
+ * @return Capacity after the update
+ */
+uint32_t ff_fifo_controller_update(FFFifoController* ctl);
+
+/**
+ * Capacity the controller last set.
+ */
+uint32_t ff_fifo_controller_capacity(FFFifoController* ctl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_FIFO_CONTROLLER_H
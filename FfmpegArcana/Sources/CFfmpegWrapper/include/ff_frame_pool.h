@@ -0,0 +1,110 @@
+/**
+ * ff_frame_pool.h
+ *
+ * Recycling frame buffer pool backed by large pages.
+ * Buffers are carved out of pre-faulted slabs so that stream start does not
+ * page-fault its way through every new 4K/8K frame, and so that scaling and
+ * encoding walk memory through 2 MB TLB entries instead of 4 KB ones.
+ */
+
+#ifndef FF_FRAME_POOL_H
+#define FF_FRAME_POOL_H
+
+#include "ffmpeg_wrapper.h"
+#include "ff_numa.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFFramePool FFFramePool;
+
+// Creation flags
+#define FF_FRAME_POOL_HUGE_PAGES    (1u << 0)   // Back slabs with 2 MB pages when available
+#define FF_FRAME_POOL_PREFAULT      (1u << 1)   // Touch every page when a slab is mapped
+#define FF_FRAME_POOL_DEFAULT       (FF_FRAME_POOL_HUGE_PAGES | FF_FRAME_POOL_PREFAULT)
+
+// What a pool's slabs actually ended up on
+typedef enum {
+    FF_FRAME_POOL_BACKING_NORMAL = 0,       // Ordinary pages
+    FF_FRAME_POOL_BACKING_TRANSPARENT,      // Transparent huge pages (madvise)
+    FF_FRAME_POOL_BACKING_HUGETLB           // Explicit huge pages (hugetlbfs / superpages)
+} FFFramePoolBacking;
+
+/**
+ * Create a frame pool.
+ * Every buffer is large enough for one width x height frame of pixel_format,
+ * including the stride and edge padding decoders expect.
+ * @param initial_count Number of buffers mapped (and pre-faulted) up front
+ * @param max_count Maximum number of buffers (0 = unlimited growth)
+ * @param flags FF_FRAME_POOL_* flags
+ * @return Pool handle or NULL on failure
+ */
+FFFramePool* ff_frame_pool_create(int width, int height, int pixel_format,
+                                  uint32_t initial_count, uint32_t max_count,
+                                  uint32_t flags);
+
+/**
+ * Create a frame pool whose slabs are placed on a NUMA node.
+ * @param numa_node Node index, or FF_NUMA_NODE_ANY
+ */
+FFFramePool* ff_frame_pool_create_on_node(int width, int height, int pixel_format,
+                                          uint32_t initial_count, uint32_t max_count,
+                                          uint32_t flags, int numa_node);
+
+/**
+ * Destroy a frame pool.
+ * Frames still holding pool buffers stay valid; the slabs are unmapped when
+ * the last of them is released.
+ */
+void ff_frame_pool_destroy(FFFramePool *pool);
+
+/**
+ * Pooled replacement for ff_frame_alloc_buffer.
+ * @return 0 on success, AVERROR(EINVAL) if the image does not fit a pool
+ *         buffer, AVERROR(ENOMEM) if the pool is exhausted
+ */
+int ff_frame_pool_alloc_buffer(FFFramePool *pool, AVFrame *frame,
+                               int width, int height, int pixel_format);
+
+/**
+ * Attach a pool buffer to a frame whose width, height and format are already set.
+ * The planes are laid out for aligned_width x aligned_height so that callers
+ * with stricter geometry (decoders) can reserve their edge area.
+ */
+int ff_frame_pool_get_buffer(FFFramePool *pool, AVFrame *frame,
+                             int aligned_width, int aligned_height);
+
+/**
+ * Pool statistics.
+ */
+size_t ff_frame_pool_buffer_size(FFFramePool *pool);
+FFFramePoolBacking ff_frame_pool_backing(FFFramePool *pool);
+uint32_t ff_frame_pool_total_count(FFFramePool *pool);
+uint32_t ff_frame_pool_free_count(FFFramePool *pool);
+uint32_t ff_frame_pool_in_use_count(FFFramePool *pool);
+
+// -----------------------------------------------------------------------------
+// Decoder integration
+// -----------------------------------------------------------------------------
+
+/**
+ * Create a decoder whose software output frames come from a frame pool.
+ * Frames that do not fit a pool buffer, and hardware frames, fall back to
+ * FFmpeg's own allocator. The pool must outlive the decoder.
+ */
+FFDecoderContext* ff_decoder_create_pooled(FFDemuxContext *demux_ctx, int stream_index,
+                                           bool use_hardware, FFFramePool *pool);
+
+/**
+ * Pooled decoder whose context lives in an arena (arena may be NULL).
+ */
+FFDecoderContext* ff_decoder_create_pooled_in(FFArena *arena, FFDemuxContext *demux_ctx,
+                                              int stream_index, bool use_hardware,
+                                              FFFramePool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_FRAME_POOL_H
@@ -0,0 +1,77 @@
+/**
+ * ff_frame_rate.h
+ *
+ * Constant-frame-rate normalizer for FF_CMD_FRAME streams.
+ * Frames with arbitrary timestamps (VFR phone recordings, mixed-rate
+ * sources) are mapped onto the slots of a fixed output rate: a frame that
+ * lands on no slot of its own is dropped, a frame that must cover several
+ * slots is repeated. Repeats share the source frame's buffers by reference;
+ * pixel data is never copied. Output pts count slots in the output time
+ * base (1 / rate).
+ */
+
+#ifndef FF_FRAME_RATE_H
+#define FF_FRAME_RATE_H
+
+#include "ffmpeg_wrapper.h"
+#include "ff_cmd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFFrameRateConverter FFFrameRateConverter;
+
+#define FF_FRAME_RATE_DEFAULT_MAX_REPEAT    60  // Longer gaps are treated as discontinuities
+
+/**
+ * Create a converter.
+ * @param in_time_base Time base of the incoming frame commands' pts
+ * @param out_rate Output frame rate (e.g. 30000/1001)
+ * @param cmd_pool Pool for the commands that carry repeated frames
+ * @return Converter or NULL on failure
+ */
+FFFrameRateConverter* ff_frame_rate_create(AVRational in_time_base, AVRational out_rate,
+                                           FFCmdPool* cmd_pool);
+
+/**
+ * Destroy a converter, releasing the frame it is holding.
+ */
+void ff_frame_rate_destroy(FFFrameRateConverter* conv);
+
+/**
+ * Repeats allowed for one frame before a gap counts as a discontinuity: the
+ * frame is emitted once and the output timeline jumps to the next frame.
+ * 0 = FF_FRAME_RATE_DEFAULT_MAX_REPEAT.
+ */
+void ff_frame_rate_set_max_repeat(FFFrameRateConverter* conv, uint32_t max_repeat);
+
+/**
+ * Feed one command; ownership transfers to the converter. Each frame is
+ * held until the next one shows how many slots it covers, then written to
+ * output (blocking for space). EOS emits the held frame once and is
+ * forwarded; FLUSH discards it and restarts the timeline; other commands
+ * (CONFIG, SEEK, user commands) are queued behind the held frame and go
+ * out right after it and its repeats, so they never overtake a frame and
+ * the output stays at a constant rate.
+ * @return 0 on success or a FF_CMD_FIFO_* error from the output
+ */
+int ff_frame_rate_push(FFFrameRateConverter* conv, FFCmd* cmd, FFCmdFifo* output);
+
+/**
+ * Output time base (1 / out_rate).
+ */
+AVRational ff_frame_rate_output_time_base(FFFrameRateConverter* conv);
+
+/**
+ * Statistics.
+ */
+uint64_t ff_frame_rate_output_count(FFFrameRateConverter* conv);
+uint64_t ff_frame_rate_dropped_count(FFFrameRateConverter* conv);
+uint64_t ff_frame_rate_repeated_count(FFFrameRateConverter* conv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_FRAME_RATE_H
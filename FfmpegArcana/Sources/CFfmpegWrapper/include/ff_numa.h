@@ -0,0 +1,61 @@
+/**
+ * ff_numa.h
+ *
+ * NUMA node discovery, thread pinning and node-local allocation.
+ * On hosts without NUMA (including all Apple platforms) there is exactly one
+ * node, binding to it is a no-op and allocations come from ordinary pages.
+ */
+
+#ifndef FF_NUMA_H
+#define FF_NUMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FF_NUMA_NODE_ANY    (-1)    // No placement preference
+
+/**
+ * Number of online memory nodes (at least 1).
+ */
+int ff_numa_node_count(void);
+
+/**
+ * Spreading policy: returns online nodes round-robin, so that successive
+ * pipeline instances land on successive sockets.
+ */
+int ff_numa_next_node(void);
+
+/**
+ * Node the calling thread is currently running on (0 if unknown).
+ */
+int ff_numa_current_node(void);
+
+/**
+ * Pin the calling thread to the CPUs of a node and prefer that node for the
+ * thread's future allocations. FF_NUMA_NODE_ANY leaves the thread untouched.
+ * @return 0 on success or a negative AVERROR code
+ */
+int ff_numa_bind_thread(int node);
+
+/**
+ * Bind an existing, not yet touched, page-aligned range to a node.
+ * @return 0 on success or a negative AVERROR code
+ */
+int ff_numa_bind_memory(void *ptr, size_t size, int node);
+
+/**
+ * Allocate zeroed, page-aligned memory placed on a node.
+ * Release with ff_numa_free using the same size.
+ */
+void* ff_numa_alloc(size_t size, int node);
+void ff_numa_free(void *ptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_NUMA_H
@@ -0,0 +1,71 @@
+/**
+ * ff_parallel_decoder.h
+ *
+ * Frame-parallel decoding for intra-only streams.
+ * Every packet of an intra-only stream (MJPEG, ProRes, DNxHD, JPEG 2000,
+ * all-intra H.264) decodes on its own, so packets are spread over several
+ * single-threaded decoder instances on worker threads and the frames are
+ * handed back in packet order. Streams that are not intra-only get one
+ * instance and behave like an ordinary FFDecoderContext.
+ */
+
+#ifndef FF_PARALLEL_DECODER_H
+#define FF_PARALLEL_DECODER_H
+
+#include "ffmpeg_wrapper.h"
+#include "ff_frame_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFParallelDecoder FFParallelDecoder;
+
+#define FF_PARALLEL_DECODER_MAX_INSTANCES   64
+
+/**
+ * Whether every packet of a stream can be decoded independently.
+ */
+bool ff_stream_is_intra_only(FFDemuxContext *demux_ctx, int stream_index);
+
+/**
+ * Create a parallel decoder (software decoding only).
+ * @param instance_count Decoder instances for intra-only streams (0 = one per CPU)
+ * @param pool Optional frame pool shared by all instances (must outlive the decoder)
+ * @return Decoder handle or NULL on failure
+ */
+FFParallelDecoder* ff_parallel_decoder_create(FFDemuxContext *demux_ctx, int stream_index,
+                                              int instance_count, FFFramePool *pool);
+
+void ff_parallel_decoder_destroy(FFParallelDecoder *dec);
+
+/**
+ * Same contract as ff_decoder_send_packet: AVERROR(EAGAIN) when enough
+ * packets are in flight that frames must be received first, NULL to drain.
+ */
+int ff_parallel_decoder_send_packet(FFParallelDecoder *dec, AVPacket *pkt);
+
+/**
+ * Same contract as ff_decoder_receive_frame. Frames come out in packet
+ * order; packets that failed to decode or produced no frame are skipped.
+ */
+int ff_parallel_decoder_receive_frame(FFParallelDecoder *dec, AVFrame *frame);
+
+/**
+ * Drop everything in flight and reset all instances (e.g. after a seek).
+ */
+void ff_parallel_decoder_flush(FFParallelDecoder *dec);
+
+int ff_parallel_decoder_instance_count(FFParallelDecoder *dec);
+int ff_parallel_decoder_get_pixel_format(FFParallelDecoder *dec);
+
+/**
+ * Packets whose decoding failed or produced no frame, and were skipped.
+ */
+uint64_t ff_parallel_decoder_error_count(FFParallelDecoder *dec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_PARALLEL_DECODER_H
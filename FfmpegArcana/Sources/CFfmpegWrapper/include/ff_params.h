@@ -0,0 +1,138 @@
+/**
+ * ff_params.h
+ *
+ * Native parameter store with read-copy-update snapshots.
+ * Media threads read the current configuration (scaler size, quality, drop
+ * policy, ...) with one atomic load per frame and never take a lock. A
+ * writer copies the current snapshot, changes it and publishes the copy with
+ * a single pointer swap; old snapshots are freed as soon as no reader is
+ * using them. Writers serialize among themselves only.
+ *
+ * Parameters are addressed by the index returned when they are added, so
+ * the hot path does no string lookups.
+ */
+
+#ifndef FF_PARAMS_H
+#define FF_PARAMS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFParamStore FFParamStore;
+typedef struct FFParamReader FFParamReader;
+typedef struct FFParamSnapshot FFParamSnapshot;
+typedef struct FFParamWrite FFParamWrite;
+
+#define FF_PARAMS_MAX_COUNT         64
+#define FF_PARAMS_MAX_KEY           32      // Including the terminator
+#define FF_PARAMS_MAX_STRING        64      // Including the terminator
+
+typedef enum {
+    FF_PARAM_INT = 0,
+    FF_PARAM_DOUBLE,
+    FF_PARAM_STRING
+} FFParamType;
+
+// -----------------------------------------------------------------------------
+// Store
+// -----------------------------------------------------------------------------
+
+FFParamStore* ff_params_create(void);
+
+/**
+ * Destroy a store. All readers must have been destroyed.
+ */
+void ff_params_destroy(FFParamStore* store);
+
+/**
+ * Add a parameter and publish a snapshot that contains it.
+ * @return Parameter index, or a negative AVERROR (EEXIST, ENOSPC, EINVAL)
+ */
+int ff_params_add_int(FFParamStore* store, const char* key, int64_t value);
+int ff_params_add_double(FFParamStore* store, const char* key, double value);
+int ff_params_add_string(FFParamStore* store, const char* key, const char* value);
+
+/**
+ * Index of a parameter, or a negative AVERROR(ENOENT).
+ */
+int ff_params_find(FFParamStore* store, const char* key);
+
+/**
+ * Version of the most recently published snapshot.
+ */
+uint64_t ff_params_version(FFParamStore* store);
+
+// -----------------------------------------------------------------------------
+// Writing
+// -----------------------------------------------------------------------------
+
+/**
+ * Start a write: waits for other writers (never for readers) and takes a
+ * private copy of the current snapshot. Changes become visible together on
+ * commit, so related values (width and height) never tear.
+ */
+FFParamWrite* ff_params_write_begin(FFParamStore* store);
+
+/**
+ * Change a value in the copy. Fails with AVERROR(EINVAL) on a bad index or
+ * a type mismatch.
+ */
+int ff_params_write_int(FFParamWrite* write, int index, int64_t value);
+int ff_params_write_double(FFParamWrite* write, int index, double value);
+int ff_params_write_string(FFParamWrite* write, int index, const char* value);
+
+/**
+ * Publish the copy (a no-op when nothing changed), free snapshots no reader
+ * can still see, and end the write.
+ * @return Version now current
+ */
+uint64_t ff_params_write_commit(FFParamWrite* write);
+
+/**
+ * Drop the copy and end the write.
+ */
+void ff_params_write_abort(FFParamWrite* write);
+
+/**
+ * Single-value writes (begin + write + commit).
+ */
+int ff_params_set_int(FFParamStore* store, int index, int64_t value);
+int ff_params_set_double(FFParamStore* store, int index, double value);
+int ff_params_set_string(FFParamStore* store, int index, const char* value);
+
+// -----------------------------------------------------------------------------
+// Reading
+// -----------------------------------------------------------------------------
+
+/**
+ * Register a reader, one per thread that reads. Writers free every retired
+ * snapshot except the one each reader last read, so a reader that stops
+ * reading holds on to a single snapshot, however many versions follow.
+ */
+FFParamReader* ff_params_reader_create(FFParamStore* store);
+void ff_params_reader_destroy(FFParamReader* reader);
+
+/**
+ * Current snapshot. Stays valid until the same reader's next
+ * ff_params_read or its destruction. Lock-free and wait-free.
+ */
+const FFParamSnapshot* ff_params_read(FFParamReader* reader);
+
+/**
+ * Snapshot accessors. Out-of-range indices and type mismatches read as 0,
+ * 0.0 and "".
+ */
+uint64_t ff_params_snapshot_version(const FFParamSnapshot* snap);
+int64_t ff_params_snapshot_int(const FFParamSnapshot* snap, int index);
+double ff_params_snapshot_double(const FFParamSnapshot* snap, int index);
+const char* ff_params_snapshot_string(const FFParamSnapshot* snap, int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_PARAMS_H
@@ -0,0 +1,55 @@
+/**
+ * ff_pixconv.h
+ *
+ * Same-size fast paths from 10-bit 4:2:0 (P010LE, YUV420P10LE) to 8-bit
+ * NV12, YUV420P or BGRA. Rows are converted with NEON or SSE2 kernels
+ * where the target has them, so 10-bit previews skip the generic swscale
+ * pipeline. Dropping two bits bands smooth gradients; ordered or
+ * error-diffusion dither trades the banding for fine noise.
+ */
+
+#ifndef FF_PIXCONV_H
+#define FF_PIXCONV_H
+
+#include "ffmpeg_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFPixConv FFPixConv;
+
+typedef enum {
+    FF_DITHER_NONE = 0,             // Truncate the two low bits
+    FF_DITHER_ORDERED = 1,          // 4x4 Bayer threshold, SIMD
+    FF_DITHER_ERROR_DIFFUSION = 2   // Floyd-Steinberg, scalar (serial along each row)
+} FFDitherMode;
+
+/**
+ * Whether a conversion has a fast path.
+ */
+bool ff_pixconv_supported(int src_format, int dst_format);
+
+/**
+ * Create a converter for one geometry. Scratch rows are allocated here,
+ * so converting allocates nothing.
+ * @return Converter or NULL if the formats are unsupported
+ */
+FFPixConv* ff_pixconv_create(int width, int height, int src_format, int dst_format);
+void ff_pixconv_destroy(FFPixConv* conv);
+
+void ff_pixconv_set_dither(FFPixConv* conv, FFDitherMode mode);
+
+/**
+ * Convert src into dst, both allocated at the converter's geometry. BGRA
+ * output follows the source's colorspace (BT.601, BT.709 or BT.2020;
+ * unspecified is BT.709) and range; chroma is repeated, not interpolated.
+ * @return 0 or negative AVERROR
+ */
+int ff_pixconv_convert(FFPixConv* conv, const AVFrame* src, AVFrame* dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_PIXCONV_H
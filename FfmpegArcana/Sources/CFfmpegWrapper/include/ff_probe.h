@@ -0,0 +1,94 @@
+/**
+ * ff_probe.h
+ *
+ * Batch media-info probing.
+ * Opens many files concurrently on a bounded set of worker threads with
+ * short probe budgets, and fills one compact result per file. Stream
+ * analysis (avformat_find_stream_info) only runs when the container header
+ * leaves something essential unknown.
+ */
+
+#ifndef FF_PROBE_H
+#define FF_PROBE_H
+
+#include "ffmpeg_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FF_PROBE_MAX_STREAMS        16      // Streams reported per file
+#define FF_PROBE_NAME_SIZE          32
+
+#define FF_PROBE_DEFAULT_PROBE_SIZE         (512 * 1024)
+#define FF_PROBE_DEFAULT_ANALYZE_DURATION   500000      // Microseconds
+#define FF_PROBE_MAX_THREADS                32      // Includes the calling thread
+
+// Option flags
+#define FF_PROBE_FULL               (1u << 0)   // Always run stream analysis
+
+typedef struct {
+    uint32_t thread_count;          // Worker threads (0 = 2 per CPU), at most FF_PROBE_MAX_THREADS
+    int64_t probe_size;             // Bytes read to identify streams (0 = default)
+    int64_t analyze_duration;       // Microseconds analysed, when needed (0 = default)
+    uint32_t flags;                 // FF_PROBE_* flags
+} FFProbeOptions;
+
+typedef struct {
+    int index;                      // Stream index in the container
+    int media_type;                 // AVMediaType
+    int codec_id;                   // AVCodecID
+    char codec_name[FF_PROBE_NAME_SIZE];
+    int64_t bit_rate;               // 0 if unknown
+    double duration;                // Seconds, 0 if unknown
+
+    // Video
+    int width;
+    int height;
+    int pixel_format;
+    int fps_num;
+    int fps_den;
+
+    // Audio
+    int sample_rate;
+    int channels;
+} FFProbeStream;
+
+typedef struct {
+    int status;                     // 0 or negative AVERROR
+    char format_name[FF_PROBE_NAME_SIZE];
+    double duration;                // Seconds, 0 if unknown
+    int64_t bit_rate;               // Container bit rate, 0 if unknown
+    int stream_count;               // Streams in the file (may exceed FF_PROBE_MAX_STREAMS)
+    int video_stream_index;         // Best video stream, -1 if none
+    int audio_stream_index;         // Best audio stream, -1 if none
+    FFProbeStream streams[FF_PROBE_MAX_STREAMS];
+} FFProbeResult;
+
+/**
+ * Fill options with the fast-open defaults.
+ */
+void ff_probe_options_default(FFProbeOptions *options);
+
+/**
+ * Probe a single file on the calling thread.
+ * @param options NULL for defaults
+ * @return 0 on success or negative AVERROR (also stored in result->status)
+ */
+int ff_probe_file(const char *path, const FFProbeOptions *options, FFProbeResult *result);
+
+/**
+ * Probe n files concurrently. results[i] receives the outcome for paths[i];
+ * a failed file only sets its own status.
+ * @param options NULL for defaults
+ * @return Number of files probed successfully, or negative AVERROR if the
+ *         batch could not run at all
+ */
+int ff_probe_batch(const char *const *paths, int n, const FFProbeOptions *options,
+                   FFProbeResult *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_PROBE_H
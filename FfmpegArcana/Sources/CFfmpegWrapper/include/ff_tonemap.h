@@ -0,0 +1,72 @@
+/**
+ * ff_tonemap.h
+ *
+ * HDR to SDR tone mapping on the CPU. PQ (HDR10) or HLG sources in
+ * P010LE or YUV420P10LE come out as BT.709 NV12, YUV420P or BGRA in one
+ * pass: the 10-bit to 8-bit reduction and its dither are fused into the
+ * last stage, so no 10-bit intermediate frame is written. Transfer curves
+ * and the tone curve are lookup tables, the colour matrices run in NEON or
+ * SSE2, and frames are split into slices across a thread pool.
+ */
+
+#ifndef FF_TONEMAP_H
+#define FF_TONEMAP_H
+
+#include "ffmpeg_wrapper.h"
+#include "ff_pixconv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FFToneMap FFToneMap;
+
+typedef enum {
+    FF_TONE_CURVE_HABLE = 0,        // Filmic, soft shoulder and toe
+    FF_TONE_CURVE_REINHARD = 1,     // Extended Reinhard, source peak maps to white
+    FF_TONE_CURVE_BT2390 = 2        // ITU-R BT.2390 EETF, linear below the knee
+} FFToneCurve;
+
+/**
+ * Whether a frame's transfer is PQ or HLG.
+ */
+bool ff_tonemap_is_hdr(const AVFrame* frame);
+
+/**
+ * Create a tone mapper for one geometry.
+ * @param src_format P010LE or YUV420P10LE
+ * @param dst_format NV12, YUV420P or BGRA
+ * @param threads Slice threads including the caller, <= 0 for one per CPU
+ * @return Tone mapper or NULL
+ */
+FFToneMap* ff_tonemap_create(int width, int height, int src_format, int dst_format,
+                             FFToneCurve curve, int threads);
+void ff_tonemap_destroy(FFToneMap* tm);
+
+void ff_tonemap_set_curve(FFToneMap* tm, FFToneCurve curve);
+
+/**
+ * Ordered dither or none. Error diffusion is serial down the frame and
+ * would tie the slices together, so it is treated as ordered here.
+ */
+void ff_tonemap_set_dither(FFToneMap* tm, FFDitherMode mode);
+
+/**
+ * Source peak luminance in cd/m2, from MaxCLL or the mastering display
+ * when known. 0 selects 1000, the usual HDR10 grade and the HLG nominal
+ * display. For HLG this is the display the system gamma is derived for.
+ */
+void ff_tonemap_set_peak(FFToneMap* tm, float peak_nits);
+
+/**
+ * Tone map src into dst, both allocated at the mapper's geometry, and tag
+ * dst as BT.709. src must carry a PQ or HLG transfer with BT.2020 colour.
+ * @return 0 or negative AVERROR
+ */
+int ff_tonemap_process(FFToneMap* tm, const AVFrame* src, AVFrame* dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FF_TONEMAP_H
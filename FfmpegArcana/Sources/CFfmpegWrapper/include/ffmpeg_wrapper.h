@@ -20,6 +20,8 @@
 #include <libswscale/swscale.h>
 #include <libswresample/swresample.h>
 
+#include "ff_arena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,6 +42,7 @@ extern const int FF_ERROR_EOF;
 typedef struct FFDemuxContext FFDemuxContext;
 
 FFDemuxContext* ff_demux_create(void);
+FFDemuxContext* ff_demux_create_in(FFArena *arena);
 int ff_demux_open(FFDemuxContext *ctx, const char *url);
 int ff_demux_get_stream_count(FFDemuxContext *ctx);
 int ff_demux_get_video_stream_index(FFDemuxContext *ctx);
@@ -47,6 +50,7 @@ int ff_demux_get_audio_stream_index(FFDemuxContext *ctx);
 int ff_demux_get_video_info(FFDemuxContext *ctx,
                             int *width, int *height, int *pixel_format,
                             int *fps_num, int *fps_den);
+const AVCodecParameters* ff_demux_get_codec_parameters(FFDemuxContext *ctx, int stream_index);
 double ff_demux_get_duration(FFDemuxContext *ctx);
 int ff_demux_read_packet(FFDemuxContext *ctx, AVPacket *pkt);
 int ff_demux_seek(FFDemuxContext *ctx, double timestamp_seconds);
@@ -59,6 +63,44 @@ void ff_demux_destroy(FFDemuxContext *ctx);
 typedef struct FFDecoderContext FFDecoderContext;
 
 FFDecoderContext* ff_decoder_create(FFDemuxContext *demux_ctx, int stream_index, bool use_hardware);
+FFDecoderContext* ff_decoder_create_in(FFArena *arena, FFDemuxContext *demux_ctx,
+                                       int stream_index, bool use_hardware);
+// Decoder tuning profiles
+typedef enum {
+    FF_DECODER_PROFILE_DEFAULT = 0,     // FFmpeg defaults, throughput first
+    FF_DECODER_PROFILE_LOW_LATENCY      // Slice threads, LOW_DELAY, FLAG2_FAST
+} FFDecoderProfile;
+
+// FIFO depth for every stage of a low-latency chain
+#define FF_LOW_LATENCY_FIFO_CAPACITY    2
+
+/**
+ * Create a decoder tuned by a profile. FF_DECODER_PROFILE_LOW_LATENCY uses
+ * slice threads instead of frame threads (which hold one frame per thread),
+ * sets AV_CODEC_FLAG2_FAST, sets AV_CODEC_FLAG_LOW_DELAY when the stream has
+ * no reordered (B-)frames, and turns on latency tracking.
+ */
+FFDecoderContext* ff_decoder_create_profile(FFDemuxContext *demux_ctx, int stream_index,
+                                            bool use_hardware, FFDecoderProfile profile);
+
+// Packet-in to frame-out time, in microseconds
+typedef struct {
+    uint64_t frames;        // Frames measured
+    int64_t last_us;
+    int64_t min_us;
+    int64_t max_us;
+    int64_t mean_us;
+    uint32_t in_flight;     // Packets sent whose frame has not come out yet
+} FFDecodeLatencyStats;
+
+/**
+ * Measure the time from ff_decoder_send_packet to the matching frame leaving
+ * ff_decoder_receive_frame (matched by pts, or dts without one).
+ * Enabling resets the statistics.
+ */
+int ff_decoder_set_latency_tracking(FFDecoderContext *ctx, bool enabled);
+int ff_decoder_get_latency_stats(FFDecoderContext *ctx, FFDecodeLatencyStats *stats);
+
 int ff_decoder_send_packet(FFDecoderContext *ctx, AVPacket *pkt);
 int ff_decoder_receive_frame(FFDecoderContext *ctx, AVFrame *frame);
 void ff_decoder_flush(FFDecoderContext *ctx);
@@ -74,7 +116,16 @@ typedef struct FFScalerContext FFScalerContext;
 
 FFScalerContext* ff_scaler_create(int src_width, int src_height, int src_format,
                                   int dst_width, int dst_height, int dst_format);
+FFScalerContext* ff_scaler_create_in(FFArena *arena,
+                                     int src_width, int src_height, int src_format,
+                                     int dst_width, int dst_height, int dst_format);
+// Follow a source geometry change; returns 1 if rebuilt, 0 if unchanged
+int ff_scaler_reconfigure(FFScalerContext *ctx, int src_width, int src_height, int src_format);
 int ff_scaler_scale(FFScalerContext *ctx, AVFrame *src_frame, AVFrame *dst_frame);
+// Dither for same-size 10-bit to 8-bit conversions (FFDitherMode, ff_pixconv.h)
+void ff_scaler_set_dither(FFScalerContext *ctx, int mode);
+// Whether scaling bypasses swscale for the SIMD kernels in ff_pixconv
+bool ff_scaler_has_fast_path(FFScalerContext *ctx);
 void ff_scaler_destroy(FFScalerContext *ctx);
 
 // -----------------------------------------------------------------------------
@@ -113,6 +164,7 @@ extern const int FF_PIX_FMT_BGRA;
 extern const int FF_PIX_FMT_RGBA;
 extern const int FF_PIX_FMT_RGB24;
 extern const int FF_PIX_FMT_P010LE;
+extern const int FF_PIX_FMT_YUV420P10LE;
 extern const int FF_PIX_FMT_VIDEOTOOLBOX;
 
 // -----------------------------------------------------------------------------
@@ -0,0 +1,33 @@
+/**
+ * Arena.swift
+ *
+ * Swift wrapper for the per-pipeline arena allocator.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Arena
+
+/// Block allocator for the wrapper's context structs. Objects created with an
+/// arena keep it alive; its memory is released in one go once the arena and
+/// every object created in it have been released.
+public final class Arena: @unchecked Sendable {
+    internal let ptr: OpaquePointer
+
+    /// - Parameters:
+    ///   - blockSize: Bytes reserved per block (0 = default)
+    ///   - numaNode: Node the blocks are placed on (`Numa.anyNode` = no preference)
+    public init(blockSize: Int = 0, numaNode: Int = Numa.anyNode) throws {
+        guard let ptr = ff_arena_create_on_node(blockSize, Int32(numaNode)) else {
+            throw FFmpegError.invalidContext
+        }
+        self.ptr = ptr
+    }
+
+    deinit { ff_arena_destroy(ptr) }
+
+    /// Arena statistics
+    public var bytesUsed: Int { ff_arena_bytes_used(ptr) }
+    public var bytesReserved: Int { ff_arena_bytes_reserved(ptr) }
+}
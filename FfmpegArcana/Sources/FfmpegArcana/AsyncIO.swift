@@ -0,0 +1,43 @@
+/**
+ * AsyncIO.swift
+ *
+ * Swift options for asynchronous (io_uring) file input.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Read Ahead
+
+/// How a demuxer reads its file through FFAsyncIO: `queueDepth` blocks of
+/// `blockSize` bytes are kept in flight ahead of the read position.
+public struct ReadAhead: Sendable {
+    public var blockSize: Int
+    public var queueDepth: Int
+    /// Service requests with pread instead of io_uring
+    public var synchronous: Bool
+    /// Bypass the page cache (O_DIRECT), falling back to buffered reads
+    public var direct: Bool
+
+    public init(blockSize: Int = Int(FF_ASYNC_IO_DEFAULT_BLOCK_SIZE),
+                queueDepth: Int = Int(FF_ASYNC_IO_DEFAULT_DEPTH),
+                synchronous: Bool = false,
+                direct: Bool = false) {
+        self.blockSize = blockSize
+        self.queueDepth = queueDepth
+        self.synchronous = synchronous
+        self.direct = direct
+    }
+
+    public static let `default` = ReadAhead()
+
+    /// One-pass bulk ingest: double-buffered direct reads
+    public static let ingest = ReadAhead(queueDepth: 2, direct: true)
+
+    internal var flags: UInt32 {
+        var flags: UInt32 = 0
+        if synchronous { flags |= UInt32(FF_ASYNC_IO_SYNC) }
+        if direct { flags |= UInt32(FF_ASYNC_IO_DIRECT) }
+        return flags
+    }
+}
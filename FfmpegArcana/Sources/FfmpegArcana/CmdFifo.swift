@@ -18,6 +18,7 @@ public enum CmdType: UInt32 {
     case eos = 4
     case seek = 5
     case config = 6
+    case error = 7
     case user = 0x1000
     
     init(_ ffType: FFCmdType) {
@@ -33,6 +34,7 @@ public enum CmdType: UInt32 {
 
 public enum CmdFifoError: Error, LocalizedError {
     case flowDisabled
+    case closed
     case fifoFull
     case timeout
     case invalidParameters
@@ -45,6 +47,7 @@ public enum CmdFifoError: Error, LocalizedError {
         case FF_CMD_FIFO_INVALID_PARAMS: self = .invalidParameters
         case FF_CMD_FIFO_FLOW_DISABLED: self = .flowDisabled
         case FF_CMD_FIFO_FULL: self = .fifoFull
+        case FF_CMD_FIFO_CLOSED: self = .closed
         case FF_CMD_FIFO_TIMEOUT: self = .timeout
         default: self = .unknown(code: code)
         }
@@ -53,6 +56,7 @@ public enum CmdFifoError: Error, LocalizedError {
     public var errorDescription: String? {
         switch self {
         case .flowDisabled: return "FIFO flow is disabled"
+        case .closed: return "FIFO is closed"
         case .fifoFull: return "FIFO is full"
         case .timeout: return "Operation timed out"
         case .invalidParameters: return "Invalid parameters"
@@ -68,18 +72,34 @@ public enum CmdFifoError: Error, LocalizedError {
 public final class CmdPool {
     private let pool: OpaquePointer
     
+    /// Node whose memory backs the commands
+    public let numaNode: Int
+    private let arena: Arena?
+    
     /// Create a command pool.
     /// - Parameters:
     ///   - initialSize: Number of commands to pre-allocate
     ///   - maxSize: Maximum pool size (0 = unlimited growth)
-    public init(initialSize: Int = 32, maxSize: Int = 0) {
-        pool = ff_cmd_pool_create(UInt32(initialSize), UInt32(maxSize))
+    ///   - numaNode: Node whose memory backs the commands (`Numa.anyNode` = no preference)
+    public init(initialSize: Int = 32, maxSize: Int = 0, numaNode: Int = Numa.anyNode) {
+        self.numaNode = numaNode
+        self.arena = nil
+        pool = ff_cmd_pool_create_on_node(UInt32(initialSize), UInt32(maxSize), Int32(numaNode))
+    }
+    
+    /// Create a command pool whose commands live in an arena.
+    public init(arena: Arena, initialSize: Int = 32, maxSize: Int = 0) {
+        self.numaNode = Numa.anyNode
+        self.arena = arena
+        pool = ff_cmd_pool_create_in(arena.ptr, UInt32(initialSize), UInt32(maxSize))
     }
     
     deinit {
         ff_cmd_pool_destroy(pool)
     }
     
+    internal var ptr: OpaquePointer { pool }
+    
     /// Acquire a command from the pool. Refcount starts at 1.
     /// - Returns: A command, or nil if pool is exhausted
     public func acquire() -> Cmd? {
@@ -161,6 +181,16 @@ public final class Cmd {
         ff_cmd_is_media(ptr)
     }
     
+    /// Media command that decoding can start from
+    public var isKeyframe: Bool {
+        ff_cmd_is_keyframe(ptr)
+    }
+    
+    /// AVERROR carried by an error command, 0 otherwise
+    public var errorCode: Int32 {
+        ff_cmd_error_code(ptr)
+    }
+    
     // MARK: Data Access
     
     /// Get data as AVFrame pointer (only valid if type == .frame)
@@ -178,7 +208,8 @@ public final class Cmd {
     // MARK: Initialization Helpers
     
     /// Initialize as a frame command.
-    /// - Parameter frame: The AVFrame pointer. You must manage the frame's lifecycle.
+    /// - Parameter frame: The AVFrame pointer. The command takes its own
+    ///   reference; you still free yours.
     public func initFrame(_ frame: UnsafeMutablePointer<AVFrame>?) {
         ff_cmd_init(ptr, FF_CMD_FRAME)
         if let frame = frame {
@@ -187,7 +218,8 @@ public final class Cmd {
     }
     
     /// Initialize as a packet command.
-    /// - Parameter packet: The AVPacket pointer. You must manage the packet's lifecycle.
+    /// - Parameter packet: The AVPacket pointer. The command takes its own
+    ///   reference; you still free yours.
     public func initPacket(_ packet: UnsafeMutablePointer<AVPacket>?) {
         ff_cmd_init(ptr, FF_CMD_PACKET)
         if let packet = packet {
@@ -205,6 +237,14 @@ public final class Cmd {
         ff_cmd_init(ptr, FF_CMD_FLUSH)
     }
     
+    /// Initialize as config command announcing the stream's current codec
+    /// parameters (the command owns a copy).
+    public func initConfig(demuxer: Demuxer, streamIndex: Int) throws {
+        let params = ff_demux_get_codec_parameters(demuxer.internalContext, Int32(streamIndex))
+        let result = ff_cmd_init_config(ptr, params, UInt32(streamIndex))
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+    
     /// Initialize as seek command.
     public func initSeek(position: Double, flags: UInt32 = 0) {
         ff_cmd_init(ptr, FF_CMD_SEEK)
@@ -217,6 +257,48 @@ public final class Cmd {
     public func clearData() {
         ff_cmd_clear_data(ptr)
     }
+    
+    // MARK: Object Payloads
+    
+    /// Attach a Swift or CF object (CMSampleBuffer, CVPixelBuffer, ...) as
+    /// the payload. The command keeps it alive until its data is cleared,
+    /// including when a FIFO drops the command on teardown.
+    public func setPayload(_ object: AnyObject, sizeHint: Int = 0) {
+        let opaque = Unmanaged.passRetained(object).toOpaque()
+        ff_cmd_set_payload(ptr, opaque, sizeHint, objectPayloadRelease, objectPayloadAddRef)
+    }
+    
+    /// Object attached with `setPayload(_:sizeHint:)`, still owned by the command.
+    public var payloadObject: AnyObject? {
+        guard let data = ptr.pointee.data, let release = ptr.pointee.payload_release,
+              unsafeBitCast(release, to: UnsafeRawPointer.self)
+                == unsafeBitCast(objectPayloadRelease, to: UnsafeRawPointer.self) else { return nil }
+        return Unmanaged<AnyObject>.fromOpaque(data).takeUnretainedValue()
+    }
+    
+    /// Payload size hint in bytes, 0 if unknown
+    public var dataSize: Int { ptr.pointee.data_size }
+}
+
+private final class CmdConsumerBox {
+    let body: (Cmd) -> Void
+    init(_ body: @escaping (Cmd) -> Void) { self.body = body }
+}
+
+private let cmdConsumerTrampoline: FFCmdFifoConsumeFunc = { _, cmd, userdata in
+    guard let cmd, let userdata else { return }
+    Unmanaged<CmdConsumerBox>.fromOpaque(userdata).takeUnretainedValue().body(Cmd(cmd))
+}
+
+private let objectPayloadRelease: FFPayloadReleaseFunc = { opaque in
+    guard let opaque else { return }
+    Unmanaged<AnyObject>.fromOpaque(opaque).release()
+}
+
+private let objectPayloadAddRef: FFPayloadAddRefFunc = { opaque in
+    guard let opaque else { return nil }
+    _ = Unmanaged<AnyObject>.fromOpaque(opaque).retain()
+    return opaque
 }
 
 // MARK: - Command FIFO
@@ -225,6 +307,9 @@ public final class Cmd {
 /// Commands flow through with explicit ownership transfer - no hidden ref counting.
 public final class CmdFifo {
     private let fifo: OpaquePointer
+    private let arena: Arena?
+    private let owner: AnyObject?
+    private var consumer: CmdConsumerBox?
     
     public enum Mode {
         case lockless   // Single producer/consumer, fastest
@@ -238,14 +323,32 @@ public final class CmdFifo {
         }
     }
     
-    public init(capacity: Int, mode: Mode = .lockless) {
-        fifo = ff_cmd_fifo_create(UInt32(capacity), mode.ffMode)
+    public init(capacity: Int, mode: Mode = .lockless, arena: Arena? = nil) {
+        self.arena = arena
+        self.owner = nil
+        fifo = ff_cmd_fifo_create_in(arena?.ptr, UInt32(capacity), mode.ffMode)
+    }
+    
+    /// A FIFO whose capacity can change at runtime, up to `maxCapacity`.
+    public init(capacity: Int, maxCapacity: Int, mode: Mode = .lockless) {
+        self.arena = nil
+        self.owner = nil
+        fifo = ff_cmd_fifo_create_resizable(UInt32(capacity), UInt32(max(capacity, maxCapacity)), mode.ffMode)
+    }
+    
+    /// Wrap a FIFO that belongs to another object, which is kept alive.
+    internal init(borrowing fifo: OpaquePointer, owner: AnyObject) {
+        self.fifo = fifo
+        self.arena = nil
+        self.owner = owner
     }
     
     deinit {
-        ff_cmd_fifo_destroy(fifo)
+        if owner == nil { ff_cmd_fifo_destroy(fifo) }
     }
     
+    internal var ptr: OpaquePointer { fifo }
+    
     // MARK: Flow Control
     
     public var flowEnabled: Bool {
@@ -253,6 +356,16 @@ public final class CmdFifo {
         set { ff_cmd_fifo_set_flow_enabled(fifo, newValue) }
     }
     
+    /// Close for good: wakes every blocked reader and writer, makes later
+    /// waits throw `.closed` at once and releases the queued commands.
+    /// - Returns: Number of commands released
+    @discardableResult
+    public func close() -> Int {
+        Int(ff_cmd_fifo_close(fifo))
+    }
+    
+    public var isClosed: Bool { ff_cmd_fifo_is_closed(fifo) }
+    
     // MARK: Write Operations
     
     /// Block until write space available.
@@ -271,6 +384,22 @@ public final class CmdFifo {
         }
     }
     
+    /// Wait for write space for up to `timeout`, measured on the monotonic clock.
+    public func waitForWriteSpace(timeout: Duration) throws {
+        let result = ff_cmd_fifo_wait_write_us(fifo, Self.microseconds(timeout))
+        if result != FF_CMD_FIFO_OK {
+            throw CmdFifoError(code: result)
+        }
+    }
+    
+    /// Wait for write space until an absolute `CmdFifo.clockMicros` deadline.
+    public func waitForWriteSpace(until deadlineMicros: Int64) throws {
+        let result = ff_cmd_fifo_wait_write_until(fifo, deadlineMicros)
+        if result != FF_CMD_FIFO_OK {
+            throw CmdFifoError(code: result)
+        }
+    }
+    
     /// Try to acquire write space without blocking.
     public func tryWaitForWriteSpace() -> Bool {
         ff_cmd_fifo_try_write(fifo) == FF_CMD_FIFO_OK
@@ -303,6 +432,23 @@ public final class CmdFifo {
         }
     }
     
+    /// Wait for read data for up to `timeout`, measured on the monotonic clock.
+    public func waitForReadData(timeout: Duration) throws {
+        let result = ff_cmd_fifo_wait_read_us(fifo, Self.microseconds(timeout))
+        if result != FF_CMD_FIFO_OK {
+            throw CmdFifoError(code: result)
+        }
+    }
+    
+    /// Wait for read data until an absolute `CmdFifo.clockMicros` deadline.
+    /// Advancing the deadline by a fixed period keeps a pacing loop from drifting.
+    public func waitForReadData(until deadlineMicros: Int64) throws {
+        let result = ff_cmd_fifo_wait_read_until(fifo, deadlineMicros)
+        if result != FF_CMD_FIFO_OK {
+            throw CmdFifoError(code: result)
+        }
+    }
+    
     /// Try to check for read data without blocking.
     public func tryWaitForReadData() -> Bool {
         ff_cmd_fifo_try_read(fifo) == FF_CMD_FIFO_OK
@@ -330,6 +476,73 @@ public final class CmdFifo {
         }
     }
     
+    // MARK: Push Delivery
+    
+    /// Deliver writes straight to `body` on the writing thread instead of
+    /// queueing them for a reader; an idle FIFO costs no thread hop. The
+    /// consumer owns each command and must release it. Set with flow
+    /// disabled and no thread writing or reading: the previous consumer is
+    /// released here, so no delivery may still be inside it.
+    /// - Throws: `CmdFifoError.invalidParameters` while flow is enabled
+    public func setConsumer(_ body: @escaping (Cmd) -> Void) throws {
+        let box = CmdConsumerBox(body)
+        let result = ff_cmd_fifo_set_consumer(fifo, cmdConsumerTrampoline, Unmanaged.passUnretained(box).toOpaque())
+        if result != FF_CMD_FIFO_OK { throw CmdFifoError(code: result) }
+        consumer = box
+    }
+    
+    /// Return to pull mode; later writes are queued for a reader again.
+    /// Same rules as `setConsumer`.
+    public func clearConsumer() throws {
+        let result = ff_cmd_fifo_set_consumer(fifo, nil, nil)
+        if result != FF_CMD_FIFO_OK { throw CmdFifoError(code: result) }
+        consumer = nil
+    }
+    
+    // MARK: Clock
+    
+    /// Monotonic clock used for FIFO deadlines, in microseconds.
+    public static var clockMicros: Int64 { ff_cmd_fifo_clock_us() }
+    
+    private static func microseconds(_ duration: Duration) -> Int64 {
+        let (seconds, attoseconds) = duration.components
+        return seconds * 1_000_000 + attoseconds / 1_000_000_000_000
+    }
+    
+    // MARK: Capacity
+    
+    public var capacity: Int { Int(ff_cmd_fifo_capacity(fifo)) }
+    
+    /// Change the capacity while producers and consumers run.
+    public func resize(to capacity: Int) throws {
+        let result = ff_cmd_fifo_resize(fifo, UInt32(capacity))
+        if result != FF_CMD_FIFO_OK { throw CmdFifoError(code: result) }
+    }
+    
+    // MARK: Live Catch-up
+    
+    /// Release every queued media command ahead of the first queued
+    /// keyframe, keeping control commands. Lockless FIFOs: consumer only.
+    /// - Returns: Number of commands released
+    @discardableResult
+    public func skipToKeyframe() -> Int {
+        Int(ff_cmd_fifo_skip_to_keyframe(fifo))
+    }
+    
+    /// Skip to the next keyframe automatically on read when more than
+    /// `maxCount` commands are queued or the writer is more than `maxLag`
+    /// pts ahead of the reader. 0 disables a threshold.
+    public func setSkipPolicy(maxCount: Int = 0, maxLag: Int64 = 0) {
+        var policy = FFCmdFifoSkipPolicy(max_count: UInt32(maxCount), max_lag: maxLag)
+        ff_cmd_fifo_set_skip_policy(fifo, &policy)
+    }
+    
+    public func clearSkipPolicy() {
+        ff_cmd_fifo_set_skip_policy(fifo, nil)
+    }
+    
+    public var skippedCount: UInt64 { ff_cmd_fifo_skipped_count(fifo) }
+    
     // MARK: Status
     
     public var count: Int { Int(ff_cmd_fifo_count(fifo)) }
@@ -347,7 +560,7 @@ public final class CmdFifo {
      
      // Send a frame
      guard let cmd = pool.acquire() else { throw CmdFifoError.poolExhausted }
-     cmd.initFrame(myAVFrame)
+     cmd.initFrame(myAVFrame)   // Takes its own reference; myAVFrame is still yours to free
      cmd.pts = framePts
      
      try fifo.waitForWriteSpace()
@@ -0,0 +1,118 @@
+/**
+ * DecodeService.swift
+ *
+ * Swift wrapper for decoding many low-rate streams on a shared thread pool.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Decode Service
+
+/// Runs the decoders of many streams on a few worker threads. Write packet
+/// commands to a stream's `input`; frame commands appear on the output FIFO
+/// given when the stream was added.
+public final class DecodeService: @unchecked Sendable {
+    fileprivate let ctx: OpaquePointer
+    private let cmdPool: CmdPool?
+
+    /// - Parameters:
+    ///   - threadCount: Worker threads (0 = one per CPU)
+    ///   - quantum: Input commands a stream may consume per turn (0 = default)
+    ///   - cmdPool: Pool for output frame commands (nil = the service's own)
+    public init(threadCount: Int = 0, quantum: Int = 0, cmdPool: CmdPool? = nil) throws {
+        guard let ctx = ff_decode_service_create(UInt32(threadCount), UInt32(quantum), cmdPool?.ptr) else {
+            throw FFmpegError.invalidContext
+        }
+        self.ctx = ctx
+        self.cmdPool = cmdPool
+    }
+
+    deinit { ff_decode_service_destroy(ctx) }
+
+    /// Warm contexts for streams whose CONFIG commands need a different codec context.
+    public var decoderCache: DecoderCache? {
+        didSet { ff_decode_service_set_decoder_cache(ctx, decoderCache?.ptr) }
+    }
+
+    public var threadCount: Int { Int(ff_decode_service_thread_count(ctx)) }
+    public var streamCount: Int { Int(ff_decode_service_stream_count(ctx)) }
+
+    /// The output FIFO must stay alive until the stream is removed. The
+    /// stream is removed when the returned object is released, or earlier
+    /// through `remove`.
+    public func addStream(demuxer: Demuxer, streamIndex: Int, useHardware: Bool = false,
+                          inputCapacity: Int = 16, output: CmdFifo) throws -> DecodeStream {
+        guard let stream = ff_decode_service_add_stream(ctx, demuxer.internalContext, Int32(streamIndex),
+                                                        useHardware, UInt32(inputCapacity),
+                                                        output.ptr, nil) else {
+            throw FFmpegError.decoderCreationFailed
+        }
+        return DecodeStream(stream, service: self, output: output)
+    }
+
+    public func remove(_ stream: DecodeStream) {
+        stream.remove()
+    }
+}
+
+// MARK: - Decode Stream
+
+public final class DecodeStream: @unchecked Sendable {
+    private let lock = NSLock()
+    private var stream: OpaquePointer?      // nil once removed
+    private let service: DecodeService
+    private let output: CmdFifo
+    private var inputFifo: CmdFifo?
+    private var finalPacketCount: UInt64 = 0
+    private var finalFrameCount: UInt64 = 0
+
+    fileprivate init(_ stream: OpaquePointer, service: DecodeService, output: CmdFifo) {
+        self.stream = stream
+        self.service = service
+        self.output = output
+        self.inputFifo = CmdFifo(borrowing: ff_decode_stream_input(stream)!, owner: service)
+    }
+
+    deinit { remove() }
+
+    /// FIFO to write this stream's packet, flush and EOS commands to; nil
+    /// once the stream is removed. The FIFO is freed with the stream, so do
+    /// not keep it beyond `remove`.
+    public var input: CmdFifo? {
+        lock.lock()
+        defer { lock.unlock() }
+        return inputFifo
+    }
+
+    public var isRemoved: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return stream == nil
+    }
+
+    /// Detach from the service and free the decoder and input FIFO. Safe to
+    /// call more than once; counters keep their last values.
+    public func remove() {
+        lock.lock()
+        defer { lock.unlock() }
+        guard let stream else { return }
+        finalPacketCount = ff_decode_stream_packet_count(stream)
+        finalFrameCount = ff_decode_stream_frame_count(stream)
+        inputFifo = nil
+        self.stream = nil
+        ff_decode_service_remove_stream(service.ctx, stream)
+    }
+
+    public var packetCount: UInt64 {
+        lock.lock()
+        defer { lock.unlock() }
+        return stream.map { ff_decode_stream_packet_count($0) } ?? finalPacketCount
+    }
+
+    public var frameCount: UInt64 {
+        lock.lock()
+        defer { lock.unlock() }
+        return stream.map { ff_decode_stream_frame_count($0) } ?? finalFrameCount
+    }
+}
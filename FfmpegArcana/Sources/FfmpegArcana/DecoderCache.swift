@@ -0,0 +1,37 @@
+/**
+ * DecoderCache.swift
+ *
+ * Swift wrapper for the warm decoder cache.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Decoder Cache
+
+/// Keeps flushed decoders open so that the next stream with the same codec
+/// parameters skips codec lookup and avcodec_open2.
+public final class DecoderCache: @unchecked Sendable {
+    internal let ptr: OpaquePointer
+
+    /// - Parameters:
+    ///   - maxIdle: Maximum number of parked decoders
+    ///   - maxIdleSeconds: Parked decoders older than this are closed (0 = no age limit)
+    public init(maxIdle: Int = 8, maxIdleSeconds: Double = 30) throws {
+        guard let ptr = ff_decoder_cache_create(UInt32(maxIdle), maxIdleSeconds) else {
+            throw FFmpegError.invalidContext
+        }
+        self.ptr = ptr
+    }
+
+    deinit { ff_decoder_cache_destroy(ptr) }
+
+    /// Close parked decoders that exceeded the age limit.
+    @discardableResult
+    public func trim() -> Int { Int(ff_decoder_cache_trim(ptr)) }
+
+    /// Cache statistics
+    public var idleCount: Int { Int(ff_decoder_cache_idle_count(ptr)) }
+    public var hitCount: Int { Int(ff_decoder_cache_hit_count(ptr)) }
+    public var missCount: Int { Int(ff_decoder_cache_miss_count(ptr)) }
+}
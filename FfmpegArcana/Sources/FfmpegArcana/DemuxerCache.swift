@@ -0,0 +1,31 @@
+/**
+ * DemuxerCache.swift
+ *
+ * Swift wrapper for the demuxer open-file cache.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Demuxer Cache
+
+/// Keeps released demuxers open and rewound, so reopening an unchanged local
+/// file skips probing and index building.
+public final class DemuxerCache: @unchecked Sendable {
+    internal let ptr: OpaquePointer
+
+    /// - Parameter maxOpen: Maximum number of parked demuxers (open files)
+    public init(maxOpen: Int = 64) throws {
+        guard let ptr = ff_demux_cache_create(UInt32(maxOpen)) else {
+            throw FFmpegError.invalidContext
+        }
+        self.ptr = ptr
+    }
+
+    deinit { ff_demux_cache_destroy(ptr) }
+
+    /// Cache statistics
+    public var openCount: Int { Int(ff_demux_cache_open_count(ptr)) }
+    public var hitCount: Int { Int(ff_demux_cache_hit_count(ptr)) }
+    public var missCount: Int { Int(ff_demux_cache_miss_count(ptr)) }
+}
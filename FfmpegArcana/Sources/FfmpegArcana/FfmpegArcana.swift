@@ -41,6 +41,9 @@ public enum FFmpegError: Error, LocalizedError {
 // MARK: - FFmpeg Utilities
 
 public enum FFmpeg {
+    /// AV_NOPTS_VALUE, which Swift cannot import (it is a cast macro)
+    public static let noPTS = Int64.min
+
     public static func errorString(_ code: Int32) -> String {
         var buffer = [CChar](repeating: 0, count: 256)
         ff_get_error_string(code, &buffer, buffer.count)
@@ -65,7 +68,7 @@ public enum FFmpeg {
 
 public enum PixelFormat: Int32, CustomStringConvertible, Sendable {
     case yuv420p = 0, nv12 = 23, bgra = 26, rgba = 28
-    case rgb24 = 2, p010le = 161, videoToolbox = 181, unknown = -1
+    case rgb24 = 2, p010le = 161, yuv420p10le = 62, videoToolbox = 181, unknown = -1
 
     public init(avFormat: Int32) {
         self = PixelFormat(rawValue: avFormat) ?? .unknown
@@ -100,10 +103,15 @@ public struct VideoInfo: Sendable {
 
 public final class Demuxer: @unchecked Sendable {
     private let ctx: OpaquePointer
+    fileprivate let arena: Arena?
+    private let cache: DemuxerCache?
 
-    public init(url: String) throws {
-        guard let ctx = ff_demux_create() else { throw FFmpegError.invalidContext }
+    /// - Parameter arena: Arena for this demuxer and the decoders created from it
+    public init(url: String, arena: Arena? = nil) throws {
+        guard let ctx = ff_demux_create_in(arena?.ptr) else { throw FFmpegError.invalidContext }
         self.ctx = ctx
+        self.arena = arena
+        self.cache = nil
 
         let result = ff_demux_open(ctx, url)
         if result < 0 {
@@ -112,7 +120,41 @@ public final class Demuxer: @unchecked Sendable {
         }
     }
 
-    deinit { ff_demux_destroy(ctx) }
+    /// Open a local file through asynchronous read-ahead (io_uring where available).
+    public init(path: String, readAhead: ReadAhead) throws {
+        guard let ctx = ff_demux_create() else { throw FFmpegError.invalidContext }
+        self.ctx = ctx
+        self.arena = nil
+        self.cache = nil
+
+        let result = ff_demux_open_async(ctx, path, UInt32(readAhead.blockSize),
+                                         UInt32(readAhead.queueDepth), readAhead.flags)
+        if result < 0 {
+            ff_demux_destroy(ctx)
+            throw FFmpegError.openFailed(path: path, code: result)
+        }
+    }
+
+    /// Open through a cache: an unchanged, previously released file comes back
+    /// already probed and rewound, and returns to the cache on deinit.
+    public init(url: String, cache: DemuxerCache) throws {
+        var opened: OpaquePointer?
+        let result = ff_demux_cache_open(cache.ptr, url, &opened)
+        guard result >= 0, let ctx = opened else {
+            throw FFmpegError.openFailed(path: url, code: result)
+        }
+        self.ctx = ctx
+        self.arena = nil
+        self.cache = cache
+    }
+
+    deinit {
+        if let cache {
+            ff_demux_cache_release(cache.ptr, ctx)
+        } else {
+            ff_demux_destroy(ctx)
+        }
+    }
 
     public var streamCount: Int { Int(ff_demux_get_stream_count(ctx)) }
     public var videoStreamIndex: Int { Int(ff_demux_get_video_stream_index(ctx)) }
@@ -153,37 +195,98 @@ public final class Demuxer: @unchecked Sendable {
         if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
     }
 
-    public func createDecoder(streamIndex: Int, useHardware: Bool = true) throws -> Decoder {
-        try Decoder(demuxer: self, streamIndex: streamIndex, useHardware: useHardware)
+    /// - Parameter cache: Reuse a warm decoder and return it there on release.
+    ///   Ignored for pooled decoders, which are never cached.
+    public func createDecoder(streamIndex: Int, useHardware: Bool = true, framePool: FramePool? = nil,
+                              cache: DecoderCache? = nil) throws -> Decoder {
+        try Decoder(demuxer: self, streamIndex: streamIndex, useHardware: useHardware,
+                    framePool: framePool, cache: cache)
     }
 
-    public func createVideoDecoder(useHardware: Bool = true) throws -> Decoder {
+    public func createVideoDecoder(useHardware: Bool = true, framePool: FramePool? = nil,
+                                   cache: DecoderCache? = nil) throws -> Decoder {
         guard videoStreamIndex >= 0 else { throw FFmpegError.noVideoStream }
-        return try createDecoder(streamIndex: videoStreamIndex, useHardware: useHardware)
+        return try createDecoder(streamIndex: videoStreamIndex, useHardware: useHardware,
+                                 framePool: framePool, cache: cache)
+    }
+
+    /// Decoder tuned for latency over throughput (interactive camera and
+    /// remote-desktop feeds); reports its per-frame latency in `latencyStats`.
+    public func createLowLatencyDecoder(streamIndex: Int, useHardware: Bool = true) throws -> Decoder {
+        try Decoder(demuxer: self, streamIndex: streamIndex, useHardware: useHardware,
+                    profile: FF_DECODER_PROFILE_LOW_LATENCY)
     }
 
-    fileprivate var internalContext: OpaquePointer { ctx }
+    internal var internalContext: OpaquePointer { ctx }
 }
 
 // MARK: - Decoder
 
 public final class Decoder: @unchecked Sendable {
     private let ctx: OpaquePointer
+    private let framePool: FramePool?
+    private let arena: Arena?
+    private let cache: DecoderCache?
     public let streamIndex: Int
 
-    fileprivate init(demuxer: Demuxer, streamIndex: Int, useHardware: Bool) throws {
-        guard let ctx = ff_decoder_create(demuxer.internalContext, Int32(streamIndex), useHardware) else {
+    fileprivate init(demuxer: Demuxer, streamIndex: Int, useHardware: Bool, framePool: FramePool? = nil,
+                     cache: DecoderCache? = nil) throws {
+        // Pooled and arena decoders are never parked in a cache
+        let warmCache = (framePool == nil && demuxer.arena == nil) ? cache : nil
+        let created: OpaquePointer?
+        if let warmCache {
+            created = ff_decoder_cache_acquire(warmCache.ptr, demuxer.internalContext,
+                                               Int32(streamIndex), useHardware)
+        } else {
+            created = ff_decoder_create_pooled_in(demuxer.arena?.ptr, demuxer.internalContext,
+                                                  Int32(streamIndex), useHardware, framePool?.ptr)
+        }
+        guard let ctx = created else { throw FFmpegError.decoderCreationFailed }
+        self.ctx = ctx
+        self.framePool = framePool
+        self.arena = demuxer.arena
+        self.cache = warmCache
+        self.streamIndex = streamIndex
+    }
+
+    fileprivate init(demuxer: Demuxer, streamIndex: Int, useHardware: Bool, profile: FFDecoderProfile) throws {
+        guard let ctx = ff_decoder_create_profile(demuxer.internalContext, Int32(streamIndex),
+                                                  useHardware, profile) else {
             throw FFmpegError.decoderCreationFailed
         }
         self.ctx = ctx
+        self.framePool = nil
+        self.arena = nil
+        self.cache = nil
         self.streamIndex = streamIndex
     }
 
-    deinit { ff_decoder_destroy(ctx) }
+    deinit {
+        if let cache {
+            ff_decoder_cache_release(cache.ptr, ctx)
+        } else {
+            ff_decoder_destroy(ctx)
+        }
+    }
 
     public var isHardwareAccelerated: Bool { ff_decoder_is_hardware(ctx) }
     public var pixelFormat: PixelFormat { PixelFormat(avFormat: ff_decoder_get_pixel_format(ctx)) }
 
+    /// FIFO depth for every stage of a chain fed by a low-latency decoder
+    public static let lowLatencyFifoCapacity = Int(FF_LOW_LATENCY_FIFO_CAPACITY)
+
+    /// Packet-in to frame-out latency, or nil when tracking is off.
+    public var latencyStats: DecodeLatencyStats? {
+        var stats = FFDecodeLatencyStats()
+        guard ff_decoder_get_latency_stats(ctx, &stats) == 0 else { return nil }
+        return DecodeLatencyStats(stats)
+    }
+
+    /// Turn latency measurement on (resetting it) or off.
+    public func setLatencyTracking(_ enabled: Bool) {
+        ff_decoder_set_latency_tracking(ctx, enabled)
+    }
+
     public func send(_ packet: Packet?) throws {
         let result = ff_decoder_send_packet(ctx, packet?.ptr)
         if result < 0 && result != FF_ERROR_EAGAIN {
@@ -200,6 +303,50 @@ public final class Decoder: @unchecked Sendable {
     }
 
     public func flush() { ff_decoder_flush(ctx) }
+
+    public enum Reconfiguration {
+        case unchanged      // Parameters already matched
+        case inPlace        // Same codec context, flushed
+        case reopened       // Switched to a matching (possibly warm) codec context
+    }
+
+    /// Switch to the stream's current codec parameters after a mid-stream
+    /// change. Drain first; buffered frames are discarded. The old context is
+    /// parked in `cache` (or the decoder's own cache) for a later switch back.
+    @discardableResult
+    public func reconfigure(demuxer: Demuxer, streamIndex: Int,
+                            cache: DecoderCache? = nil) throws -> Reconfiguration {
+        guard let params = ff_demux_get_codec_parameters(demuxer.internalContext, Int32(streamIndex)) else {
+            throw FFmpegError.invalidContext
+        }
+        let result = ff_decoder_reconfigure(ctx, params, (cache ?? self.cache)?.ptr)
+        switch result {
+        case FF_DECODER_RECONFIG_NONE: return .unchanged
+        case FF_DECODER_RECONFIG_IN_PLACE: return .inPlace
+        case FF_DECODER_RECONFIG_REOPENED: return .reopened
+        default: throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result))
+        }
+    }
+}
+
+// MARK: - Decode Latency
+
+public struct DecodeLatencyStats: Sendable {
+    public let frames: UInt64
+    public let last: Double     // Seconds
+    public let min: Double
+    public let max: Double
+    public let mean: Double
+    public let inFlight: Int    // Packets sent whose frame has not come out yet
+
+    init(_ stats: FFDecodeLatencyStats) {
+        frames = stats.frames
+        last = Double(stats.last_us) / 1_000_000
+        min = Double(stats.min_us) / 1_000_000
+        max = Double(stats.max_us) / 1_000_000
+        mean = Double(stats.mean_us) / 1_000_000
+        inFlight = Int(stats.in_flight)
+    }
 }
 
 // MARK: - Frame
@@ -246,6 +393,8 @@ public final class Frame: @unchecked Sendable {
     public var height: Int { Int(ptr.pointee.height) }
     public var pixelFormat: PixelFormat { PixelFormat(avFormat: ptr.pointee.format) }
     public var isHardware: Bool { ff_frame_is_hardware(ptr) }
+    /// PQ or HLG transfer; such frames want a ToneMapper before SDR output.
+    public var isHDR: Bool { ff_tonemap_is_hdr(ptr) }
 
     public func data(plane: Int) -> UnsafeMutablePointer<UInt8>? {
         ff_frame_get_data(ptr, Int32(plane))
@@ -300,22 +449,180 @@ public final class Packet: @unchecked Sendable {
 
 // MARK: - Scaler
 
+/// How 10-bit sources are reduced to 8 bits on the scaler's fast path.
+public enum DitherMode: Int32, Sendable {
+    case none = 0           // Truncate
+    case ordered = 1        // Bayer threshold, vectorised
+    case errorDiffusion = 2 // Floyd-Steinberg, scalar
+
+    var ffMode: FFDitherMode {
+        switch self {
+        case .none: return FF_DITHER_NONE
+        case .ordered: return FF_DITHER_ORDERED
+        case .errorDiffusion: return FF_DITHER_ERROR_DIFFUSION
+        }
+    }
+}
+
 public final class Scaler: @unchecked Sendable {
     private let ctx: OpaquePointer
+    private let arena: Arena?
+
+    /// Applies when a same-size P010 or YUV420P10 source goes to NV12,
+    /// YUV420P or BGRA; other conversions are left to swscale.
+    public var dither: DitherMode = .none {
+        didSet { ff_scaler_set_dither(ctx, dither.rawValue) }
+    }
+
+    /// Whether scaling runs on the SIMD conversion kernels instead of swscale.
+    public var usesFastPath: Bool { ff_scaler_has_fast_path(ctx) }
 
     public init(srcWidth: Int, srcHeight: Int, srcFormat: PixelFormat,
-                dstWidth: Int, dstHeight: Int, dstFormat: PixelFormat) throws {
-        guard let ctx = ff_scaler_create(
+                dstWidth: Int, dstHeight: Int, dstFormat: PixelFormat,
+                arena: Arena? = nil) throws {
+        guard let ctx = ff_scaler_create_in(
+            arena?.ptr,
             Int32(srcWidth), Int32(srcHeight), srcFormat.rawValue,
             Int32(dstWidth), Int32(dstHeight), dstFormat.rawValue
         ) else { throw FFmpegError.scalerCreationFailed }
         self.ctx = ctx
+        self.arena = arena
     }
 
     deinit { ff_scaler_destroy(ctx) }
 
+    /// Follow a change of source geometry, reusing the scaling context where
+    /// possible. Returns true if the scaler was rebuilt.
+    @discardableResult
+    public func reconfigure(srcWidth: Int, srcHeight: Int, srcFormat: PixelFormat) throws -> Bool {
+        let result = ff_scaler_reconfigure(ctx, Int32(srcWidth), Int32(srcHeight), srcFormat.rawValue)
+        if result < 0 { throw FFmpegError.scalerCreationFailed }
+        return result > 0
+    }
+
     public func scale(from source: Frame, to destination: Frame) throws {
         let result = ff_scaler_scale(ctx, source.ptr, destination.ptr)
         if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
     }
-}
\ No newline at end of file
+}
+
+// MARK: - Tone Mapper
+
+/// HDR (PQ or HLG, BT.2020) to SDR BT.709 on the CPU, sliced across threads,
+/// with the reduction to 8 bits done in the same pass.
+public final class ToneMapper: @unchecked Sendable {
+    private let ctx: OpaquePointer
+
+    public enum Curve: Sendable {
+        case hable      // Filmic
+        case reinhard   // Extended; source peak maps to white
+        case bt2390     // ITU-R BT.2390 EETF
+
+        var ffCurve: FFToneCurve {
+            switch self {
+            case .hable: return FF_TONE_CURVE_HABLE
+            case .reinhard: return FF_TONE_CURVE_REINHARD
+            case .bt2390: return FF_TONE_CURVE_BT2390
+            }
+        }
+    }
+
+    /// - Parameters:
+    ///   - srcFormat: .p010le or .yuv420p10le
+    ///   - dstFormat: .nv12, .yuv420p or .bgra
+    ///   - threads: Slice threads including the caller, 0 for one per CPU
+    public init(width: Int, height: Int, srcFormat: PixelFormat, dstFormat: PixelFormat,
+                curve: Curve = .bt2390, threads: Int = 0) throws {
+        guard let ctx = ff_tonemap_create(Int32(width), Int32(height), srcFormat.rawValue,
+                                          dstFormat.rawValue, curve.ffCurve, Int32(threads))
+        else { throw FFmpegError.invalidContext }
+        self.ctx = ctx
+        self.curve = curve
+    }
+
+    deinit { ff_tonemap_destroy(ctx) }
+
+    public var curve: Curve {
+        didSet { ff_tonemap_set_curve(ctx, curve.ffCurve) }
+    }
+
+    /// .errorDiffusion is treated as .ordered; slices are dithered independently.
+    public var dither: DitherMode = .none {
+        didSet { ff_tonemap_set_dither(ctx, dither.ffMode) }
+    }
+
+    /// Source peak in cd/m2 (MaxCLL or mastering display), 0 for 1000.
+    public var peakNits: Float = 0 {
+        didSet { ff_tonemap_set_peak(ctx, peakNits) }
+    }
+
+    public func process(from source: Frame, to destination: Frame) throws {
+        let result = ff_tonemap_process(ctx, source.ptr, destination.ptr)
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+}
+
+// MARK: - Deinterlacer
+
+/// Native 8-bit deinterlacer (YUV420P, YUV422P, YUV444P, NV12), sliced
+/// across threads. Send frames and receive until `.needsMoreInput`, as with
+/// `Decoder`; send nil at the end and receive until `.endOfFile`.
+public final class Deinterlacer: @unchecked Sendable {
+    private let ctx: OpaquePointer
+
+    public enum Mode: Sendable {
+        case bob        // Average of the lines either side
+        case blend      // Fields low-passed together; always one output per frame
+        case yadif      // Edge-directed, motion adaptive; one frame of delay
+
+        var ffMode: FFDeinterlaceMode {
+            switch self {
+            case .bob: return FF_DEINTERLACE_BOB
+            case .blend: return FF_DEINTERLACE_BLEND
+            case .yadif: return FF_DEINTERLACE_YADIF
+            }
+        }
+    }
+
+    /// - Parameters:
+    ///   - doubleRate: One output per field, the second half a frame later
+    ///   - threads: Slice threads including the caller, 0 for one per CPU
+    public init(mode: Mode = .yadif, doubleRate: Bool = false, threads: Int = 0) throws {
+        guard let ctx = ff_deinterlacer_create(mode.ffMode, doubleRate, Int32(threads))
+        else { throw FFmpegError.invalidContext }
+        self.ctx = ctx
+    }
+
+    deinit { ff_deinterlacer_destroy(ctx) }
+
+    /// Field order to apply, e.g. the stream's `MediaFormat.fieldMode`.
+    /// nil follows each frame's interlaced and top-field-first flags.
+    public var fieldMode: MediaFormat.FieldMode? {
+        didSet {
+            let order: FFFieldOrder
+            switch fieldMode {
+            case nil: order = FF_FIELD_ORDER_AUTO
+            case .progressive: order = FF_FIELD_ORDER_PROGRESSIVE
+            case .interlacedTopFirst: order = FF_FIELD_ORDER_TOP_FIRST
+            case .interlacedBottomFirst: order = FF_FIELD_ORDER_BOTTOM_FIRST
+            }
+            ff_deinterlacer_set_field_order(ctx, order)
+        }
+    }
+
+    /// Throws if output from the previous frame has not all been received.
+    public func send(_ frame: Frame?) throws {
+        let result = ff_deinterlacer_send_frame(ctx, frame?.ptr)
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+
+    public func receive(into frame: Frame) throws {
+        let result = ff_deinterlacer_receive_frame(ctx, frame.ptr)
+
+        if result == FF_ERROR_EAGAIN { throw FFmpegError.needsMoreInput }
+        if result == FF_ERROR_EOF { throw FFmpegError.endOfFile }
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+
+    public func flush() { ff_deinterlacer_flush(ctx) }
+}
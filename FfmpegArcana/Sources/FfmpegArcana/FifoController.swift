@@ -0,0 +1,50 @@
+/**
+ * FifoController.swift
+ *
+ * Swift wrapper for adaptive command FIFO depth.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - FIFO Controller
+
+/// Deepens a resizable FIFO when its producer overflows or its consumer
+/// underruns, and gives depth back after a run of quiet reads.
+public final class FifoController: @unchecked Sendable {
+    private let ctx: OpaquePointer
+    private let fifo: CmdFifo
+
+    public init(fifo: CmdFifo, minCapacity: Int, maxCapacity: Int) throws {
+        guard let ctx = ff_fifo_controller_create(fifo.ptr, UInt32(minCapacity), UInt32(maxCapacity)) else {
+            throw FFmpegError.invalidContext
+        }
+        self.ctx = ctx
+        self.fifo = fifo
+    }
+
+    deinit { ff_fifo_controller_destroy(ctx) }
+
+    /// Quiet reads required before shrinking by one command.
+    public func setWindow(_ reads: Int) {
+        ff_fifo_controller_set_window(ctx, UInt32(reads))
+    }
+
+    /// Producer found the FIFO full.
+    public func overflow() { ff_fifo_controller_overflow(ctx) }
+
+    /// Consumer found the FIFO empty at a deadline.
+    public func underrun() { ff_fifo_controller_underrun(ctx) }
+
+    /// Manual depth, clamped to the bounds and applied on the next update.
+    /// Use this rather than `CmdFifo.resize` on a controlled FIFO.
+    public func setCapacity(_ capacity: Int) {
+        ff_fifo_controller_set_capacity(ctx, UInt32(max(capacity, 0)))
+    }
+
+    /// Once per read, from the consumer thread.
+    @discardableResult
+    public func update() -> Int { Int(ff_fifo_controller_update(ctx)) }
+
+    public var capacity: Int { Int(ff_fifo_controller_capacity(ctx)) }
+}
@@ -0,0 +1,79 @@
+/**
+ * FramePool.swift
+ *
+ * Swift wrapper for the huge-page backed frame buffer pool.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Frame Pool
+
+/// Recycling pool of frame buffers carved from pre-faulted large-page slabs.
+/// Frames allocated from a pool stay valid after the pool itself is released.
+public final class FramePool: @unchecked Sendable {
+    internal let ptr: OpaquePointer
+
+    public struct Options: OptionSet, Sendable {
+        public let rawValue: UInt32
+        public init(rawValue: UInt32) { self.rawValue = rawValue }
+
+        public static let hugePages = Options(rawValue: FF_FRAME_POOL_HUGE_PAGES)
+        public static let prefault = Options(rawValue: FF_FRAME_POOL_PREFAULT)
+        public static let standard: Options = [.hugePages, .prefault]
+    }
+
+    public enum Backing: Sendable {
+        case normal                 // Ordinary pages
+        case transparentHugePages   // madvise'd transparent huge pages
+        case hugePages              // Explicit 2 MB pages
+    }
+
+    /// Create a frame pool.
+    /// - Parameters:
+    ///   - initialCount: Number of buffers mapped and pre-faulted up front
+    ///   - maxCount: Maximum number of buffers (0 = unlimited growth)
+    ///   - numaNode: Node the slabs are placed on (`Numa.anyNode` = no preference)
+    public init(width: Int, height: Int, pixelFormat: PixelFormat,
+                initialCount: Int = 4, maxCount: Int = 0, options: Options = .standard,
+                numaNode: Int = Numa.anyNode) throws {
+        guard let ptr = ff_frame_pool_create_on_node(
+            Int32(width), Int32(height), pixelFormat.rawValue,
+            UInt32(initialCount), UInt32(maxCount), options.rawValue, Int32(numaNode)
+        ) else { throw FFmpegError.frameAllocationFailed }
+        self.ptr = ptr
+    }
+
+    deinit { ff_frame_pool_destroy(ptr) }
+
+    public var bufferSize: Int { Int(ff_frame_pool_buffer_size(ptr)) }
+
+    public var backing: Backing {
+        switch ff_frame_pool_backing(ptr) {
+        case FF_FRAME_POOL_BACKING_HUGETLB: return .hugePages
+        case FF_FRAME_POOL_BACKING_TRANSPARENT: return .transparentHugePages
+        default: return .normal
+        }
+    }
+
+    /// Pool statistics
+    public var totalCount: Int { Int(ff_frame_pool_total_count(ptr)) }
+    public var freeCount: Int { Int(ff_frame_pool_free_count(ptr)) }
+    public var inUseCount: Int { Int(ff_frame_pool_in_use_count(ptr)) }
+}
+
+// MARK: - Pooled Frames
+
+extension Frame {
+    /// Allocate a frame whose buffer comes from a frame pool.
+    public convenience init(pool: FramePool, width: Int, height: Int, pixelFormat: PixelFormat) throws {
+        guard let ptr = ff_frame_alloc() else { throw FFmpegError.frameAllocationFailed }
+
+        let result = ff_frame_pool_alloc_buffer(pool.ptr, ptr, Int32(width), Int32(height), pixelFormat.rawValue)
+        if result < 0 {
+            ff_frame_free(ptr)
+            throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result))
+        }
+        self.init(taking: ptr)
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * FrameRateConverter.swift
+ *
+ * Swift wrapper for constant-frame-rate normalization of frame commands.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Frame Rate Converter
+
+/// Turns frame commands with arbitrary timestamps into a constant-rate
+/// stream by dropping and repeating frames. Repeats share the source
+/// frame's buffers; output pts count frames at the output rate.
+public final class FrameRateConverter: @unchecked Sendable {
+    private let ctx: OpaquePointer
+    private let cmdPool: CmdPool
+
+    /// - Parameters:
+    ///   - inputTimeBase: Time base of the incoming commands' pts (num, den)
+    ///   - outputRate: Output frames per second as a fraction (num, den)
+    public init(inputTimeBase: (num: Int, den: Int), outputRate: (num: Int, den: Int),
+                cmdPool: CmdPool) throws {
+        guard let ctx = ff_frame_rate_create(AVRational(num: Int32(inputTimeBase.num), den: Int32(inputTimeBase.den)),
+                                             AVRational(num: Int32(outputRate.num), den: Int32(outputRate.den)),
+                                             cmdPool.ptr) else {
+            throw FFmpegError.invalidContext
+        }
+        self.ctx = ctx
+        self.cmdPool = cmdPool
+    }
+
+    deinit { ff_frame_rate_destroy(ctx) }
+
+    /// Repeats allowed for one frame before a gap counts as a discontinuity.
+    public func setMaxRepeat(_ count: Int) {
+        ff_frame_rate_set_max_repeat(ctx, UInt32(count))
+    }
+
+    /// Feed a command; ownership transfers to the converter. Output is
+    /// written to `output`, blocking while it is full.
+    public func push(_ cmd: Cmd, to output: CmdFifo) throws {
+        let result = ff_frame_rate_push(ctx, cmd.ptr, output.ptr)
+        if result != FF_CMD_FIFO_OK { throw CmdFifoError(code: result) }
+    }
+
+    public var outputTimeBase: (num: Int, den: Int) {
+        let tb = ff_frame_rate_output_time_base(ctx)
+        return (Int(tb.num), Int(tb.den))
+    }
+
+    public var outputCount: UInt64 { ff_frame_rate_output_count(ctx) }
+    public var droppedCount: UInt64 { ff_frame_rate_dropped_count(ctx) }
+    public var repeatedCount: UInt64 { ff_frame_rate_repeated_count(ctx) }
+}
@@ -0,0 +1,142 @@
+/**
+ * MediaProbe.swift
+ *
+ * Swift wrapper for batch media-info probing.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Probe Results
+
+public struct StreamInfo: Sendable {
+    public let index: Int
+    public let mediaType: Int32
+    public let codecName: String
+    public let bitRate: Int64
+    public let duration: Double
+
+    public let width: Int
+    public let height: Int
+    public let pixelFormat: PixelFormat
+    public let frameRateNumerator: Int
+    public let frameRateDenominator: Int
+
+    public let sampleRate: Int
+    public let channels: Int
+
+    public var isVideo: Bool { mediaType == AVMEDIA_TYPE_VIDEO.rawValue }
+    public var isAudio: Bool { mediaType == AVMEDIA_TYPE_AUDIO.rawValue }
+
+    public var frameRate: Double {
+        guard frameRateDenominator > 0 else { return 0 }
+        return Double(frameRateNumerator) / Double(frameRateDenominator)
+    }
+}
+
+public struct MediaInfo: Sendable {
+    public let formatName: String
+    public let duration: Double
+    public let bitRate: Int64
+    public let streamCount: Int
+    public let videoStreamIndex: Int
+    public let audioStreamIndex: Int
+    /// At most FF_PROBE_MAX_STREAMS entries
+    public let streams: [StreamInfo]
+}
+
+// MARK: - Media Probe
+
+public enum MediaProbe {
+    public struct Options: Sendable {
+        /// Worker threads (0 = two per CPU)
+        public var threadCount: Int = 0
+        /// Bytes read to identify streams
+        public var probeSize: Int64 = Int64(FF_PROBE_DEFAULT_PROBE_SIZE)
+        /// Microseconds analysed when the header is incomplete
+        public var analyzeDuration: Int64 = Int64(FF_PROBE_DEFAULT_ANALYZE_DURATION)
+        /// Always analyse packets, even when the header looks complete
+        public var full: Bool = false
+
+        public init() {}
+    }
+
+    /// Probe files concurrently; results are in the order of `paths`.
+    public static func probe(_ paths: [String], options: Options = Options())
+        -> [Result<MediaInfo, FFmpegError>] {
+        guard !paths.isEmpty else { return [] }
+
+        var cOptions = FFProbeOptions()
+        cOptions.thread_count = UInt32(options.threadCount)
+        cOptions.probe_size = options.probeSize
+        cOptions.analyze_duration = options.analyzeDuration
+        cOptions.flags = options.full ? UInt32(FF_PROBE_FULL) : 0
+
+        let cPaths = paths.map { UnsafePointer(strdup($0)) }
+        defer { cPaths.forEach { free(UnsafeMutablePointer(mutating: $0)) } }
+
+        var results = [FFProbeResult](repeating: FFProbeResult(), count: paths.count)
+        _ = cPaths.withUnsafeBufferPointer { pathBuffer in
+            results.withUnsafeMutableBufferPointer { resultBuffer in
+                ff_probe_batch(pathBuffer.baseAddress, Int32(paths.count), &cOptions,
+                               resultBuffer.baseAddress)
+            }
+        }
+
+        return zip(paths, results).map { path, result in
+            guard result.status >= 0 else {
+                return .failure(.openFailed(path: path, code: result.status))
+            }
+            return .success(MediaInfo(result))
+        }
+    }
+
+    public static func probe(_ path: String, options: Options = Options()) throws -> MediaInfo {
+        try probe([path], options: options)[0].get()
+    }
+}
+
+// MARK: - Conversion
+
+private func probeName<T>(_ tuple: T) -> String {
+    withUnsafeBytes(of: tuple) { raw in
+        String(cString: raw.bindMemory(to: CChar.self).baseAddress!)
+    }
+}
+
+private extension MediaInfo {
+    init(_ result: FFProbeResult) {
+        let count = min(Int(result.stream_count), Int(FF_PROBE_MAX_STREAMS))
+        let streams = withUnsafeBytes(of: result.streams) { raw in
+            Array(raw.bindMemory(to: FFProbeStream.self).prefix(count))
+        }
+
+        self.init(
+            formatName: probeName(result.format_name),
+            duration: result.duration,
+            bitRate: result.bit_rate,
+            streamCount: Int(result.stream_count),
+            videoStreamIndex: Int(result.video_stream_index),
+            audioStreamIndex: Int(result.audio_stream_index),
+            streams: streams.map(StreamInfo.init)
+        )
+    }
+}
+
+private extension StreamInfo {
+    init(_ stream: FFProbeStream) {
+        self.init(
+            index: Int(stream.index),
+            mediaType: stream.media_type,
+            codecName: probeName(stream.codec_name),
+            bitRate: stream.bit_rate,
+            duration: stream.duration,
+            width: Int(stream.width), height: Int(stream.height),
+            pixelFormat: PixelFormat(avFormat: stream.pixel_format),
+            frameRateNumerator: Int(stream.fps_num),
+            frameRateDenominator: Int(stream.fps_den),
+            sampleRate: Int(stream.sample_rate),
+            channels: Int(stream.channels)
+        )
+    }
+}
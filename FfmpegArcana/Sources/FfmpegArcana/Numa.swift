@@ -0,0 +1,33 @@
+/**
+ * Numa.swift
+ *
+ * Swift wrapper for NUMA node discovery and placement.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - NUMA
+
+/// NUMA topology and placement helpers. On single-node hosts (including all
+/// Apple platforms) every call succeeds without changing anything.
+public enum Numa {
+    /// No placement preference
+    public static let anyNode = Int(FF_NUMA_NODE_ANY)
+
+    /// Number of online memory nodes (at least 1)
+    public static var nodeCount: Int { Int(ff_numa_node_count()) }
+
+    /// Node the calling thread is running on
+    public static var currentNode: Int { Int(ff_numa_current_node()) }
+
+    /// Next node in round-robin order, used to spread pipelines across sockets
+    public static func nextNode() -> Int { Int(ff_numa_next_node()) }
+
+    /// Pin the calling thread to a node's CPUs and prefer its memory.
+    /// - Returns: false if the node is unknown or the binding was refused
+    @discardableResult
+    public static func bindCurrentThread(to node: Int) -> Bool {
+        ff_numa_bind_thread(Int32(node)) == 0
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * ParallelDecoder.swift
+ *
+ * Swift wrapper for frame-parallel decoding of intra-only streams.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Parallel Decoder
+
+/// Spreads the packets of an intra-only stream over several decoder
+/// instances and returns the frames in packet order. Other streams get a
+/// single ordinary decoder.
+public final class ParallelDecoder: @unchecked Sendable {
+    private let ctx: OpaquePointer
+    private let framePool: FramePool?
+    public let streamIndex: Int
+
+    /// - Parameter instanceCount: Decoder instances (0 = one per CPU)
+    public init(demuxer: Demuxer, streamIndex: Int, instanceCount: Int = 0,
+                framePool: FramePool? = nil) throws {
+        guard let ctx = ff_parallel_decoder_create(demuxer.internalContext, Int32(streamIndex),
+                                                   Int32(instanceCount), framePool?.ptr) else {
+            throw FFmpegError.decoderCreationFailed
+        }
+        self.ctx = ctx
+        self.framePool = framePool
+        self.streamIndex = streamIndex
+    }
+
+    deinit { ff_parallel_decoder_destroy(ctx) }
+
+    public static func isIntraOnly(demuxer: Demuxer, streamIndex: Int) -> Bool {
+        ff_stream_is_intra_only(demuxer.internalContext, Int32(streamIndex))
+    }
+
+    public var instanceCount: Int { Int(ff_parallel_decoder_instance_count(ctx)) }
+    public var pixelFormat: PixelFormat { PixelFormat(avFormat: ff_parallel_decoder_get_pixel_format(ctx)) }
+    public var errorCount: UInt64 { ff_parallel_decoder_error_count(ctx) }
+
+    /// Throws `needsMoreInput` when frames must be received before more packets fit.
+    public func send(_ packet: Packet?) throws {
+        let result = ff_parallel_decoder_send_packet(ctx, packet?.ptr)
+        if result == FF_ERROR_EAGAIN { throw FFmpegError.needsMoreInput }
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+
+    public func receive(into frame: Frame) throws {
+        let result = ff_parallel_decoder_receive_frame(ctx, frame.ptr)
+
+        if result == FF_ERROR_EAGAIN { throw FFmpegError.needsMoreInput }
+        if result == FF_ERROR_EOF { throw FFmpegError.endOfFile }
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+
+    public func flush() { ff_parallel_decoder_flush(ctx) }
+}
@@ -0,0 +1,158 @@
+/**
+ * ParameterStore.swift
+ *
+ * Swift wrapper for native parameter snapshots read lock-free by media threads.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Parameter Store
+
+/// Versioned native configuration. Writers publish whole snapshots; media
+/// threads read them through a `ParameterReader` without taking a lock.
+public final class ParameterStore: @unchecked Sendable {
+    let ptr: OpaquePointer
+
+    public init() throws {
+        guard let ptr = ff_params_create() else { throw FFmpegError.invalidContext }
+        self.ptr = ptr
+    }
+
+    deinit { ff_params_destroy(ptr) }
+
+    /// Add a parameter; the returned index addresses it from then on.
+    @discardableResult
+    public func add(_ key: String, int value: Int64) throws -> Int32 {
+        try check(ff_params_add_int(ptr, key, value))
+    }
+
+    @discardableResult
+    public func add(_ key: String, double value: Double) throws -> Int32 {
+        try check(ff_params_add_double(ptr, key, value))
+    }
+
+    @discardableResult
+    public func add(_ key: String, string value: String) throws -> Int32 {
+        try check(ff_params_add_string(ptr, key, value))
+    }
+
+    public func index(of key: String) -> Int32? {
+        let index = ff_params_find(ptr, key)
+        return index >= 0 ? index : nil
+    }
+
+    /// Version of the most recently published snapshot.
+    public var version: UInt64 { ff_params_version(ptr) }
+
+    public func set(_ index: Int32, int value: Int64) throws {
+        try check(ff_params_set_int(ptr, index, value))
+    }
+
+    public func set(_ index: Int32, double value: Double) throws {
+        try check(ff_params_set_double(ptr, index, value))
+    }
+
+    public func set(_ index: Int32, string value: String) throws {
+        try check(ff_params_set_string(ptr, index, value))
+    }
+
+    /// Change several values and publish them as one snapshot. Nothing is
+    /// published if `body` throws.
+    @discardableResult
+    public func write(_ body: (ParameterWrite) throws -> Void) throws -> UInt64 {
+        guard let write = ff_params_write_begin(ptr) else { throw FFmpegError.invalidContext }
+        do {
+            try body(ParameterWrite(ptr: write))
+        } catch {
+            ff_params_write_abort(write)
+            throw error
+        }
+        return ff_params_write_commit(write)
+    }
+
+    /// A reader for one media thread.
+    public func makeReader() throws -> ParameterReader {
+        try ParameterReader(store: self)
+    }
+
+    @discardableResult
+    private func check(_ result: Int32) throws -> Int32 {
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+        return result
+    }
+}
+
+// MARK: - Write
+
+/// Pending changes inside `ParameterStore.write`.
+public struct ParameterWrite {
+    fileprivate let ptr: OpaquePointer
+
+    public func set(_ index: Int32, int value: Int64) throws {
+        try check(ff_params_write_int(ptr, index, value))
+    }
+
+    public func set(_ index: Int32, double value: Double) throws {
+        try check(ff_params_write_double(ptr, index, value))
+    }
+
+    public func set(_ index: Int32, string value: String) throws {
+        try check(ff_params_write_string(ptr, index, value))
+    }
+
+    private func check(_ result: Int32) throws {
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+}
+
+// MARK: - Reader
+
+/// Per-thread view of a store. Not shareable between threads.
+public final class ParameterReader {
+    private let ptr: OpaquePointer
+    private let store: ParameterStore
+    /// Bumped by every `read()`; a snapshot is valid while it still matches
+    fileprivate private(set) var epoch: UInt64 = 0
+
+    fileprivate init(store: ParameterStore) throws {
+        guard let ptr = ff_params_reader_create(store.ptr) else { throw FFmpegError.invalidContext }
+        self.ptr = ptr
+        self.store = store
+    }
+
+    deinit { ff_params_reader_destroy(ptr) }
+
+    /// Current snapshot; valid until this reader's next `read()`.
+    public func read() -> ParameterSnapshot {
+        epoch &+= 1
+        return ParameterSnapshot(ptr: ff_params_read(ptr), reader: self, epoch: epoch)
+    }
+}
+
+/// Immutable view of one published version. The store frees it once its
+/// reader reads again, so it keeps the reader alive and traps if used after.
+public final class ParameterSnapshot {
+    private let ptr: OpaquePointer?
+    private let reader: ParameterReader
+    private let epoch: UInt64
+
+    fileprivate init(ptr: OpaquePointer?, reader: ParameterReader, epoch: UInt64) {
+        self.ptr = ptr
+        self.reader = reader
+        self.epoch = epoch
+    }
+
+    /// False once the reader has read again.
+    public var isValid: Bool { reader.epoch == epoch }
+
+    private var checked: OpaquePointer? {
+        precondition(isValid, "ParameterSnapshot used after its reader read again")
+        return ptr
+    }
+
+    public var version: UInt64 { ff_params_snapshot_version(checked) }
+    public func int(_ index: Int32) -> Int64 { ff_params_snapshot_int(checked, index) }
+    public func double(_ index: Int32) -> Double { ff_params_snapshot_double(checked, index) }
+    public func string(_ index: Int32) -> String { String(cString: ff_params_snapshot_string(checked, index)) }
+}
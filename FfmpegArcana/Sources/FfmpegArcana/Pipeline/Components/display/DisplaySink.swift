@@ -14,16 +14,27 @@ public struct DisplaySinkConfiguration: Sendable {
     public var enableAudioMonitoring: Bool = true
     public var routeAudioToHDMI: Bool = true
     public var fifoCapacity: Int = 3
+    /// Upper bound for runtime resizing of the queues
+    public var maxFifoCapacity: Int = 8
+    /// Let jitter deepen the video queue and quiet periods shrink it
+    public var adaptiveBuffering: Bool = false
     
     public var matchFrameRate: Bool = true
     public var bypassColorSpaceConversion: Bool = true
     
     public init() {}
+    
+    /// Shallow queues for interactive feeds: a frame waits behind at most one other
+    public static var lowLatency: DisplaySinkConfiguration {
+        var config = DisplaySinkConfiguration()
+        config.fifoCapacity = Decoder.lowLatencyFifoCapacity
+        return config
+    }
 }
 
 // MARK: - Display Sink
 
-public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
+public final class DisplaySink: NSObject, SinkComponent, NumaPlaceable, @unchecked Sendable {
     
     // MARK: - PipelineComponent conformance
     
@@ -54,14 +65,18 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
     
     // MARK: - Command Infrastructure
     
-    private let cmdPool: CmdPool
+    private var cmdPool: CmdPool
     private let videoFifo: CmdFifo
     private let audioFifo: CmdFifo
+    private let videoFifoController: FifoController?
     
     private var videoConsumerThread: Thread?
     private var audioConsumerThread: Thread?
     private var shouldRun = false
     
+    /// Node for the consumer threads and command pool, set by the owning pipeline
+    public var numaNode: Int = Numa.anyNode
+    
     // MARK: - Rendering
     
     private let renderer: DisplayRenderer
@@ -100,8 +115,15 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
         self.renderer = renderer ?? Self.createPlatformRenderer()
         
         self.cmdPool = CmdPool(initialSize: 8, maxSize: 16)
-        self.videoFifo = CmdFifo(capacity: configuration.fifoCapacity, mode: .blocking)
-        self.audioFifo = CmdFifo(capacity: configuration.fifoCapacity, mode: .blocking)
+        let videoFifo = CmdFifo(capacity: configuration.fifoCapacity,
+                                maxCapacity: configuration.maxFifoCapacity, mode: .blocking)
+        self.videoFifo = videoFifo
+        self.audioFifo = CmdFifo(capacity: configuration.fifoCapacity,
+                                 maxCapacity: configuration.maxFifoCapacity, mode: .blocking)
+        self.videoFifoController = configuration.adaptiveBuffering
+            ? try? FifoController(fifo: videoFifo, minCapacity: 1,
+                                  maxCapacity: max(configuration.fifoCapacity, configuration.maxFifoCapacity))
+            : nil
         
         self.videoInput = VideoInputPort(id: "video")
         self.audioInput = AudioInputPort(id: "audio")
@@ -137,6 +159,8 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
         _parameters.add(.bool("externalEnabled", display: "External Display", default: config.enableExternalDisplay))
         _parameters.add(.bool("audioMonitoring", display: "Audio Monitor", default: config.enableAudioMonitoring))
         _parameters.add(.bool("hdmiAudio", display: "HDMI Audio", default: config.routeAudioToHDMI))
+        _parameters.add(.int("fifoCapacity", display: "Buffer Depth", default: config.fifoCapacity,
+                             range: 1...max(config.fifoCapacity, config.maxFifoCapacity)))
         
         _parameters.add(.readout("externalStatus", display: "External Status", type: .string))
         _parameters.add(.readout("externalResolution", display: "External Resolution", type: .string))
@@ -203,6 +227,11 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
         
         try setupRenderPipeline()
         
+        // Move the command pool onto the pipeline's node while nothing is in flight
+        if cmdPool.numaNode != numaNode && cmdPool.inUseCount == 0 {
+            cmdPool = CmdPool(initialSize: 8, maxSize: 16, numaNode: numaNode)
+        }
+        
         if config.enableAudioMonitoring {
             try setupAudioEngine()
         }
@@ -294,6 +323,17 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
                 }
             }
             
+        case "fifoCapacity":
+            if let capacity = value as? Int {
+                // The controller owns the video queue's depth when adaptive
+                if let controller = videoFifoController {
+                    controller.setCapacity(capacity)
+                } else {
+                    try? videoFifo.resize(to: capacity)
+                }
+                try? audioFifo.resize(to: capacity)
+            }
+            
         default:
             break
         }
@@ -305,6 +345,7 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
         guard videoFifo.flowEnabled else { return }
         
         guard videoFifo.tryWaitForWriteSpace() else {
+            videoFifoController?.overflow()
             droppedFrameCount += 1
             _parameters.updateReadOnly("droppedFrames", value: droppedFrameCount)
             return
@@ -315,16 +356,14 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
             return
         }
         
-        let retained = Unmanaged.passRetained(sampleBuffer as AnyObject)
-        cmd.ptr.pointee.type = FF_CMD_FRAME
-        cmd.ptr.pointee.data = retained.toOpaque()
-        cmd.ptr.pointee.pts = CMSampleBufferGetPresentationTimeStamp(sampleBuffer).value
+        cmd.initFrame(nil)
+        cmd.setPayload(sampleBuffer, sizeHint: CMSampleBufferGetTotalSampleSize(sampleBuffer))
+        cmd.pts = CMSampleBufferGetPresentationTimeStamp(sampleBuffer).value
         
         do {
             try videoFifo.write(cmd)
             _parameters.updateReadOnly("videoFifoCount", value: videoFifo.count)
         } catch {
-            retained.release()
             cmd.release()
         }
     }
@@ -334,15 +373,13 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
         guard audioFifo.tryWaitForWriteSpace() else { return }
         guard let cmd = cmdPool.acquire() else { return }
         
-        let retained = Unmanaged.passRetained(sampleBuffer as AnyObject)
-        cmd.ptr.pointee.type = FF_CMD_FRAME
-        cmd.ptr.pointee.data = retained.toOpaque()
-        cmd.ptr.pointee.pts = CMSampleBufferGetPresentationTimeStamp(sampleBuffer).value
+        cmd.initFrame(nil)
+        cmd.setPayload(sampleBuffer, sizeHint: CMSampleBufferGetTotalSampleSize(sampleBuffer))
+        cmd.pts = CMSampleBufferGetPresentationTimeStamp(sampleBuffer).value
         
         do {
             try audioFifo.write(cmd)
         } catch {
-            retained.release()
             cmd.release()
         }
     }
@@ -350,7 +387,10 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
     // MARK: - Consumer Threads
     
     private func startConsumerThreads() {
+        let node = numaNode
+        
         videoConsumerThread = Thread { [weak self] in
+            Numa.bindCurrentThread(to: node)
             self?.videoConsumerLoop()
         }
         videoConsumerThread?.name = "DisplaySink.VideoConsumer"
@@ -358,6 +398,7 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
         videoConsumerThread?.start()
         
         audioConsumerThread = Thread { [weak self] in
+            Numa.bindCurrentThread(to: node)
             self?.audioConsumerLoop()
         }
         audioConsumerThread?.name = "DisplaySink.AudioConsumer"
@@ -366,18 +407,44 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
     }
     
     private func videoConsumerLoop() {
+        // When the next frame is due (CmdFifo.clockMicros); nil until a frame
+        // with a known interval has been shown, and again after an underrun
+        // so one stall is reported once
+        var nextDeadline: Int64?
+        var lastPts: CMTime?
+        
         while shouldRun {
             do {
-                try videoFifo.waitForReadData()
+                if !videoFifo.tryWaitForReadData() {
+                    if let deadline = nextDeadline {
+                        do {
+                            try videoFifo.waitForReadData(until: deadline)
+                        } catch CmdFifoError.timeout {
+                            // The next frame is late: the display is starving
+                            videoFifoController?.underrun()
+                            nextDeadline = nil
+                            try videoFifo.waitForReadData()
+                        }
+                    } else {
+                        try videoFifo.waitForReadData()
+                    }
+                }
                 
                 guard let cmd = try videoFifo.read() else { continue }
                 defer { cmd.release() }
+                videoFifoController?.update()
                 
-                guard let dataPtr = cmd.data else { continue }
-                let sampleBuffer = Unmanaged<CMSampleBuffer>.fromOpaque(dataPtr).takeRetainedValue()
+                // The command owns the payload; releasing it releases the buffer
+                guard let payload = cmd.payloadObject else { continue }
+                let sampleBuffer = payload as! CMSampleBuffer
                 
+                let shownAt = CmdFifo.clockMicros
                 processVideoFrame(sampleBuffer)
                 
+                let pts = CMSampleBufferGetPresentationTimeStamp(sampleBuffer)
+                nextDeadline = Self.frameInterval(sampleBuffer, after: lastPts).map { shownAt + $0 }
+                lastPts = pts.isValid ? pts : nil
+                
             } catch CmdFifoError.flowDisabled {
                 break
             } catch {
@@ -394,8 +461,9 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
                 guard let cmd = try audioFifo.read() else { continue }
                 defer { cmd.release() }
                 
-                guard let dataPtr = cmd.data else { continue }
-                let sampleBuffer = Unmanaged<CMSampleBuffer>.fromOpaque(dataPtr).takeRetainedValue()
+                // The command owns the payload; releasing it releases the buffer
+                guard let payload = cmd.payloadObject else { continue }
+                let sampleBuffer = payload as! CMSampleBuffer
                 
                 processAudioFrame(sampleBuffer)
                 
@@ -409,6 +477,17 @@ public final class DisplaySink: NSObject, SinkComponent, @unchecked Sendable {
     
     // MARK: - Frame Processing
     
+    /// Microseconds until the frame after this one is due: its duration, or
+    /// the step from the previous frame's timestamp when it has none.
+    private static func frameInterval(_ sampleBuffer: CMSampleBuffer, after lastPts: CMTime?) -> Int64? {
+        var interval = CMSampleBufferGetDuration(sampleBuffer)
+        if !interval.isValid || interval.seconds <= 0, let lastPts {
+            interval = CMTimeSubtract(CMSampleBufferGetPresentationTimeStamp(sampleBuffer), lastPts)
+        }
+        guard interval.isValid, interval.seconds > 0 else { return nil }
+        return Int64(interval.seconds * 1_000_000)
+    }
+    
     private func processVideoFrame(_ sampleBuffer: CMSampleBuffer) {
         guard let pixelBuffer = CMSampleBufferGetImageBuffer(sampleBuffer) else { return }
         
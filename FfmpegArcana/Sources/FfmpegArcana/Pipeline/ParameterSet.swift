@@ -83,6 +83,8 @@ public class ParameterSet {
     private var definitions: [String: ParameterDefinition] = [:]
     private var values: [String: Any] = [:]
     private let lock = NSLock()
+    private var nativeStore: ParameterStore?
+    private var nativeIndices: [String: Int32] = [:]
     
     public var allDefinitions: [ParameterDefinition] {
         lock.lock()
@@ -103,6 +105,7 @@ public class ParameterSet {
         if values[definition.key] == nil {
             values[definition.key] = definition.defaultValue
         }
+        registerNative(definition)
     }
     
     public func definition(for key: String) -> ParameterDefinition? {
@@ -140,6 +143,7 @@ public class ParameterSet {
         }
         
         values[key] = value
+        publishNative(key, value: value)
     }
     
     /// Update a read-only value (internal use)
@@ -147,6 +151,81 @@ public class ParameterSet {
         lock.lock()
         defer { lock.unlock() }
         values[key] = value
+        publishNative(key, value: value)
+    }
+    
+    // MARK: Native mirror
+    
+    /// Mirror every parameter into a native store so media threads can read
+    /// them lock-free. Bools and ints are stored as ints, floats as doubles,
+    /// strings and enumerations as strings.
+    public func bind(to store: ParameterStore) {
+        lock.lock()
+        defer { lock.unlock() }
+        nativeStore = store
+        nativeIndices.removeAll()
+        for definition in definitions.values {
+            registerNative(definition)
+        }
+    }
+    
+    /// Index of a parameter in the bound store.
+    public func nativeIndex(for key: String) -> Int32? {
+        lock.lock()
+        defer { lock.unlock() }
+        return nativeIndices[key]
+    }
+    
+    private func registerNative(_ definition: ParameterDefinition) {
+        guard let store = nativeStore, nativeIndices[definition.key] == nil else { return }
+        let value = values[definition.key] ?? definition.defaultValue
+        let index: Int32?
+        if let existing = store.index(of: definition.key) {
+            index = existing
+        } else {
+            switch definition.type {
+            case .bool, .int:
+                index = try? store.add(definition.key, int: Self.nativeInt(value) ?? 0)
+            case .float:
+                index = try? store.add(definition.key, double: Self.nativeDouble(value) ?? 0)
+            case .string, .enumeration:
+                index = try? store.add(definition.key, string: value as? String ?? "")
+            }
+        }
+        if let index { nativeIndices[definition.key] = index }
+    }
+    
+    private func publishNative(_ key: String, value: Any) {
+        guard let store = nativeStore, let index = nativeIndices[key],
+              let type = definitions[key]?.type else { return }
+        switch type {
+        case .bool, .int:
+            if let v = Self.nativeInt(value) { try? store.set(index, int: v) }
+        case .float:
+            if let v = Self.nativeDouble(value) { try? store.set(index, double: v) }
+        case .string, .enumeration:
+            if let v = value as? String { try? store.set(index, string: v) }
+        }
+    }
+    
+    private static func nativeInt(_ value: Any) -> Int64? {
+        switch value {
+        case let v as Bool: return v ? 1 : 0
+        case let v as Int: return Int64(v)
+        case let v as Int32: return Int64(v)
+        case let v as Int64: return v
+        default: return nil
+        }
+    }
+    
+    private static func nativeDouble(_ value: Any) -> Double? {
+        switch value {
+        case let v as Double: return v
+        case let v as Float: return Double(v)
+        case let v as CGFloat: return Double(v)
+        case let v as Int: return Double(v)
+        default: return nil
+        }
     }
     
     private func validateType(_ value: Any, for definition: ParameterDefinition) throws {
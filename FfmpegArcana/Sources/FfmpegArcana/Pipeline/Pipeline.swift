@@ -29,11 +29,20 @@ public class Pipeline {
     public private(set) var state: State = .idle
     public var onStateChanged: ((State) -> Void)?
     
-    public init() {}
+    /// NUMA node this pipeline's threads, pools and buffers are kept on
+    public let numaNode: Int
+    
+    /// - Parameter numaNode: Node to run on; nil spreads pipelines across nodes round-robin
+    public init(numaNode: Int? = nil) {
+        self.numaNode = numaNode ?? Numa.nextNode()
+    }
     
     // MARK: - Construction
     
     public func add(_ component: PipelineComponent) {
+        if let placeable = component as? NumaPlaceable {
+            placeable.numaNode = numaNode
+        }
         components[component.id] = component
     }
     
@@ -102,3 +102,12 @@ public protocol SinkComponent: PipelineComponent {
 public protocol ProcessorComponent: PipelineComponent {
     // Processors transform media
 }
+
+// MARK: - NUMA Placement
+
+/// Component that owns worker threads or pooled memory and can keep them on
+/// one NUMA node. The owning pipeline assigns the node when the component is added.
+public protocol NumaPlaceable: AnyObject {
+    /// Node for threads and pools (Numa.anyNode = unplaced)
+    var numaNode: Int { get set }
+}
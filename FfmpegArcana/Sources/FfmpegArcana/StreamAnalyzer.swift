@@ -0,0 +1,71 @@
+/**
+ * StreamAnalyzer.swift
+ *
+ * Swift wrapper for decode-free bitstream analysis.
+ */
+
+import Foundation
+import CFfmpegWrapper
+
+// MARK: - Stream Analyzer
+
+/// Collects GOP structure, bit rate over time, frame types and timestamp
+/// anomalies for every stream of a demuxer, without decoding.
+public final class StreamAnalyzer: @unchecked Sendable {
+    internal let ptr: OpaquePointer
+    private let demuxer: Demuxer
+
+    /// - Parameters:
+    ///   - window: Bit rate sampling window in seconds
+    ///   - parseFrameTypes: Run codec parsers to classify I/P/B frames
+    public init(demuxer: Demuxer, window: Double = FF_ANALYZER_DEFAULT_WINDOW,
+                parseFrameTypes: Bool = true) throws {
+        let flags: UInt32 = parseFrameTypes ? 0 : UInt32(FF_ANALYZER_NO_PARSE)
+        guard let ptr = ff_analyzer_create(demuxer.internalContext, window, flags) else {
+            throw FFmpegError.invalidContext
+        }
+        self.ptr = ptr
+        self.demuxer = demuxer
+    }
+
+    deinit { ff_analyzer_destroy(ptr) }
+
+    /// Read the demuxer to the end, analysing every packet.
+    public func run() throws {
+        let result = ff_analyzer_run(ptr, demuxer.internalContext)
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+
+    /// Account for a packet read by the caller.
+    public func add(_ packet: Packet) throws {
+        let result = ff_analyzer_add_packet(ptr, packet.ptr)
+        if result < 0 { throw FFmpegError.ffmpegError(code: result, message: FFmpeg.errorString(result)) }
+    }
+
+    public var streamCount: Int { Int(ff_analyzer_stream_count(ptr)) }
+
+    public func stats(streamIndex: Int) throws -> FFStreamStats {
+        var stats = FFStreamStats()
+        let result = ff_analyzer_get_stats(ptr, Int32(streamIndex), &stats)
+        if result < 0 { throw FFmpegError.invalidContext }
+        return stats
+    }
+
+    /// Bits per second for each window, from the stream's first timestamp
+    public func bitRates(streamIndex: Int) -> [Double] {
+        let count = ff_analyzer_get_bitrate(ptr, Int32(streamIndex), nil, 0)
+        guard count > 0 else { return [] }
+        var rates = [Double](repeating: 0, count: Int(count))
+        _ = ff_analyzer_get_bitrate(ptr, Int32(streamIndex), &rates, count)
+        return rates
+    }
+
+    /// Packets per GOP, in stream order
+    public func gopLengths(streamIndex: Int) -> [Int] {
+        let count = ff_analyzer_get_gop_lengths(ptr, Int32(streamIndex), nil, 0)
+        guard count > 0 else { return [] }
+        var lengths = [Int32](repeating: 0, count: Int(count))
+        _ = ff_analyzer_get_gop_lengths(ptr, Int32(streamIndex), &lengths, count)
+        return lengths.map(Int.init)
+    }
+}
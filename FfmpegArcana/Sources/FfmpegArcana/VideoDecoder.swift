@@ -20,6 +20,7 @@ public final class VideoDecoder: @unchecked Sendable {
     private let demuxer: Demuxer
     private let decoder: Decoder
     private var scaler: Scaler?
+    private var outputPool: FramePool?
 
     public let videoInfo: VideoInfo
     public let useHardwareAcceleration: Bool
@@ -32,16 +33,28 @@ public final class VideoDecoder: @unchecked Sendable {
     public init(url: String,
                 outputFormat: PixelFormat = .bgra,
                 outputSize: (width: Int, height: Int)? = nil,
-                useHardware: Bool = true) throws {
+                useHardware: Bool = true,
+                useFramePools: Bool = false) throws {
 
         self.demuxer = try Demuxer(url: url)
         self.videoInfo = try demuxer.videoInfo()
-        self.decoder = try demuxer.createVideoDecoder(useHardware: useHardware)
+
+        // Software decodes draw their frames from a pool sized to the stream
+        var decodePool: FramePool?
+        if useFramePools && !videoInfo.pixelFormat.isHardware && videoInfo.pixelFormat != .unknown {
+            decodePool = try? FramePool(width: videoInfo.width, height: videoInfo.height,
+                                        pixelFormat: videoInfo.pixelFormat)
+        }
+        self.decoder = try demuxer.createVideoDecoder(useHardware: useHardware, framePool: decodePool)
         self.useHardwareAcceleration = decoder.isHardwareAccelerated
 
         self.outputFormat = outputFormat
         self.outputWidth = outputSize?.width ?? videoInfo.width
         self.outputHeight = outputSize?.height ?? videoInfo.height
+
+        if useFramePools {
+            self.outputPool = try? FramePool(width: outputWidth, height: outputHeight, pixelFormat: outputFormat)
+        }
     }
 
     public func decodeNextFrame() throws -> DecodedFrame? {
@@ -106,14 +119,24 @@ public final class VideoDecoder: @unchecked Sendable {
 
         guard needsConversion else { return sourceFrame }
 
-        if scaler == nil {
+        // The source can change size or format mid-stream (adaptive streams,
+        // camera reconfiguration); the scaler follows it
+        if let scaler {
+            try scaler.reconfigure(srcWidth: sourceFrame.width, srcHeight: sourceFrame.height,
+                                   srcFormat: sourceFrame.pixelFormat)
+        } else {
             scaler = try Scaler(
                 srcWidth: sourceFrame.width, srcHeight: sourceFrame.height, srcFormat: sourceFrame.pixelFormat,
                 dstWidth: outputWidth, dstHeight: outputHeight, dstFormat: outputFormat
             )
         }
 
-        let outputFrame = try Frame(width: outputWidth, height: outputHeight, pixelFormat: outputFormat)
+        let outputFrame: Frame
+        if let pool = outputPool {
+            outputFrame = try Frame(pool: pool, width: outputWidth, height: outputHeight, pixelFormat: outputFormat)
+        } else {
+            outputFrame = try Frame(width: outputWidth, height: outputHeight, pixelFormat: outputFormat)
+        }
         try scaler?.scale(from: sourceFrame, to: outputFrame)
 
         return outputFrame
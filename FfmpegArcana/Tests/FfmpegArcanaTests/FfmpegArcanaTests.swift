@@ -1,6 +1,23 @@
+import Foundation
 import Testing
+import CFfmpegWrapper
 @testable import FfmpegArcana
 
+/// Write a 4:2:0 Y4M clip (rawvideo, intra-only) to a temporary file.
+/// Frame i has a flat luma of i * 6, so decoded frames can be told apart.
+private func makeY4M(frames: Int, width: Int = 64, height: Int = 36) throws -> String {
+    var data = Data("YUV4MPEG2 W\(width) H\(height) F25:1 Ip A1:1 C420jpeg\n".utf8)
+    for i in 0..<frames {
+        data.append(Data("FRAME\n".utf8))
+        data.append(Data(repeating: UInt8(truncatingIfNeeded: i * 6), count: width * height))
+        data.append(Data(repeating: 128, count: 2 * ((width + 1) / 2) * ((height + 1) / 2)))
+    }
+    let url = FileManager.default.temporaryDirectory
+        .appendingPathComponent("arcana-\(UUID().uuidString).y4m")
+    try data.write(to: url)
+    return url.path
+}
+
 @Test func testVersions() {
     #expect(!FFmpeg.avcodecVersion.isEmpty)
     #expect(!FFmpeg.avformatVersion.isEmpty)
@@ -12,6 +29,7 @@ import Testing
     #expect(PixelFormat.bgra.description == "bgra")
     #expect(!PixelFormat.yuv420p.isHardware)
     #expect(PixelFormat.videoToolbox.isHardware)
+    #expect(PixelFormat(avFormat: FF_PIX_FMT_YUV420P10LE) == .yuv420p10le)
 }
 
 @Test func testFrameAllocation() throws {
@@ -28,6 +46,144 @@ import Testing
     #expect(frame.data(plane: 0) != nil)
 }
 
+@Test func testFramePoolRecycling() throws {
+    let pool = try FramePool(width: 1920, height: 1080, pixelFormat: .nv12, initialCount: 2, maxCount: 2)
+    #expect(pool.totalCount == 2)
+
+    var frame: Frame? = try Frame(pool: pool, width: 1920, height: 1080, pixelFormat: .nv12)
+    #expect(frame?.data(plane: 0) != nil)
+    #expect(frame?.data(plane: 1) != nil)
+    #expect(pool.inUseCount == 1)
+
+    frame = nil
+    #expect(pool.inUseCount == 0)
+    #expect(pool.freeCount == 2)
+}
+
+@Test func testNumaPlacedCmdPool() throws {
+    #expect(Numa.nodeCount >= 1)
+    let node = Numa.nextNode()
+    let pool = CmdPool(initialSize: 4, maxSize: 20, numaNode: node)
+    #expect(pool.numaNode == node)
+
+    let cmds = (0..<20).compactMap { _ in pool.acquire() }
+    #expect(cmds.count == 20)
+    #expect(pool.acquire() == nil)
+    for cmd in cmds { cmd.release() }
+    #expect(pool.freeCount == 20)
+}
+
+@Test func testArenaBackedObjects() throws {
+    let arena = try Arena(blockSize: 16 * 1024)
+    // The FIFO comes first, yet the pool outlives it: the arena tears pools
+    // down last, so commands still queued at teardown have somewhere to go
+    let fifo = CmdFifo(capacity: 4, mode: .blocking, arena: arena)
+    let pool = CmdPool(arena: arena, initialSize: 4, maxSize: 8)
+    _ = try Scaler(
+        srcWidth: 640, srcHeight: 360, srcFormat: .yuv420p,
+        dstWidth: 320, dstHeight: 180, dstFormat: .bgra,
+        arena: arena
+    )
+    #expect(arena.bytesUsed > 0)
+    #expect(arena.bytesReserved >= arena.bytesUsed)
+
+    fifo.flowEnabled = true
+    try fifo.write(try #require(pool.acquire()))
+    #expect(fifo.count == 1)
+    try #require(try fifo.read()).release()
+    #expect(pool.freeCount == 4)
+    try fifo.write(try #require(pool.acquire()))
+}
+
+@Test func testDecoderCacheEmpty() throws {
+    let cache = try DecoderCache(maxIdle: 4, maxIdleSeconds: 1)
+    #expect(cache.idleCount == 0)
+    #expect(cache.trim() == 0)
+    #expect(cache.hitCount == 0 && cache.missCount == 0)
+}
+
+@Test func testDecoderCacheMatchesTagAndProfile() throws {
+    let path = try makeY4M(frames: 1)
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let demuxer = try Demuxer(url: path)
+    let cache = try DecoderCache(maxIdle: 4, maxIdleSeconds: 0)
+    let index = demuxer.videoStreamIndex
+    let params = UnsafeMutablePointer(mutating: try #require(
+        ff_demux_get_codec_parameters(demuxer.internalContext, Int32(index))))
+
+    // The released decoder is parked and handed back for the same stream
+    _ = try demuxer.createDecoder(streamIndex: index, useHardware: false, cache: cache)
+    #expect(cache.missCount == 1 && cache.idleCount == 1)
+    _ = try demuxer.createDecoder(streamIndex: index, useHardware: false, cache: cache)
+    #expect(cache.hitCount == 1 && cache.idleCount == 1)
+
+    // Same codec and geometry but another tag or profile needs its own decoder
+    let (tag, profile) = (params.pointee.codec_tag, params.pointee.profile)
+    params.pointee.codec_tag = 0x3032_3449     // "I420"
+    _ = try demuxer.createDecoder(streamIndex: index, useHardware: false, cache: cache)
+    #expect(cache.hitCount == 1 && cache.missCount == 2)
+    params.pointee.codec_tag = tag
+    params.pointee.profile = profile + 1
+    _ = try demuxer.createDecoder(streamIndex: index, useHardware: false, cache: cache)
+    #expect(cache.hitCount == 1 && cache.missCount == 3)
+
+    params.pointee.profile = profile
+    _ = try demuxer.createDecoder(streamIndex: index, useHardware: false, cache: cache)
+    #expect(cache.hitCount == 2)
+}
+
+@Test func testDecoderReconfiguresAcrossResolutionChange() throws {
+    let (large, small) = (try makeY4M(frames: 1), try makeY4M(frames: 1, width: 32, height: 18))
+    defer {
+        try? FileManager.default.removeItem(atPath: large)
+        try? FileManager.default.removeItem(atPath: small)
+    }
+    let first = try Demuxer(url: large)
+    let second = try Demuxer(url: small)
+    let decoder = try first.createDecoder(streamIndex: first.videoStreamIndex, useHardware: false)
+    let frame = try Frame()
+
+    try decoder.send(try first.readPacket())
+    try decoder.receive(into: frame)
+    #expect(frame.width == 64 && frame.height == 36)
+    let scaler = try Scaler(srcWidth: frame.width, srcHeight: frame.height, srcFormat: frame.pixelFormat,
+                            dstWidth: 64, dstHeight: 36, dstFormat: .bgra)
+
+    // rawvideo does not follow in-band changes, so the context is swapped
+    #expect(try decoder.reconfigure(demuxer: second, streamIndex: second.videoStreamIndex) == .reopened)
+    #expect(try decoder.reconfigure(demuxer: second, streamIndex: second.videoStreamIndex) == .unchanged)
+    try decoder.send(try second.readPacket())
+    try decoder.receive(into: frame)
+    #expect(frame.width == 32 && frame.height == 18)
+
+    #expect(try scaler.reconfigure(srcWidth: frame.width, srcHeight: frame.height, srcFormat: frame.pixelFormat))
+    let output = try Frame(width: 64, height: 36, pixelFormat: .bgra)
+    try scaler.scale(from: frame, to: output)
+    #expect(output.width == 64 && output.height == 36)
+}
+
+@Test func testLowLatencyDecoderFlushForgetsInFlightPackets() throws {
+    let path = try makeY4M(frames: 2)
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let demuxer = try Demuxer(url: path)
+    let decoder = try demuxer.createLowLatencyDecoder(streamIndex: demuxer.videoStreamIndex, useHardware: false)
+    let packet = try demuxer.readPacket()
+    let frame = try Frame()
+
+    // A packet dropped by a flush must not be matched to the same pts sent after a seek
+    try decoder.send(packet)
+    #expect(try #require(decoder.latencyStats).inFlight == 1)
+    decoder.flush()
+    #expect(try #require(decoder.latencyStats).inFlight == 0)
+    try decoder.send(packet)
+    try decoder.receive(into: frame)
+    #expect(frame.ptr.pointee.pts == packet.ptr.pointee.pts)
+
+    let stats = try #require(decoder.latencyStats)
+    #expect(stats.frames == 1)
+    #expect(stats.inFlight == 0)
+}
+
 @Test func testPacketAllocation() throws {
     _ = try Packet()
 }
@@ -39,8 +195,844 @@ import Testing
     )
 }
 
+@Test func testScalerTenBitFastPath() throws {
+    let scaler = try Scaler(
+        srcWidth: 1920, srcHeight: 1080, srcFormat: .p010le,
+        dstWidth: 1920, dstHeight: 1080, dstFormat: .nv12
+    )
+    #expect(scaler.usesFastPath)
+    scaler.dither = .ordered
+
+    // A resize needs swscale; returning to the same size restores the fast path
+    try scaler.reconfigure(srcWidth: 3840, srcHeight: 2160, srcFormat: .p010le)
+    #expect(!scaler.usesFastPath)
+    try scaler.reconfigure(srcWidth: 1920, srcHeight: 1080, srcFormat: .p010le)
+    #expect(scaler.usesFastPath)
+
+    let other = try Scaler(
+        srcWidth: 1920, srcHeight: 1080, srcFormat: .yuv420p,
+        dstWidth: 1920, dstHeight: 1080, dstFormat: .bgra
+    )
+    #expect(!other.usesFastPath)
+}
+
+@Test func testScalerTenBitFastPathValues() throws {
+    // 44 wide: whole SIMD blocks plus a scalar tail on every plane
+    let width = 44, height = 4, chromaWidth = 22
+    let bayer = [[0, 8, 2, 10], [12, 4, 14, 6], [3, 11, 1, 9], [15, 7, 13, 5]]
+    func luma(_ x: Int) -> Int { 64 + x * 21 }
+    func cb(_ k: Int) -> Int { 100 + k * 37 }
+    func cr(_ k: Int) -> Int { 900 - k * 29 }
+    // Planes drop two bits, after adding the 2x2 Bayer core when dithering
+    func reduce(_ v: Int, _ x: Int, _ y: Int, _ ordered: Bool) -> UInt8 {
+        UInt8(min(255, (v + (ordered ? bayer[y & 3][x & 3] >> 2 : 0)) >> 2))
+    }
+    func clamp(_ v: Int) -> UInt8 { UInt8(max(0, min(255, v))) }
+
+    for srcFormat in [PixelFormat.p010le, .yuv420p10le] {
+        let source = try Frame(width: width, height: height, pixelFormat: srcFormat)
+        let shift = srcFormat == .p010le ? 6 : 0
+        for y in 0..<height {
+            let row = try #require(source.data(plane: 0)).advanced(by: y * source.linesize(plane: 0))
+            row.withMemoryRebound(to: UInt16.self, capacity: width) { p in
+                for x in 0..<width { p[x] = UInt16(luma(x) << shift) }
+            }
+        }
+        for y in 0..<height / 2 {
+            if srcFormat == .p010le {
+                let row = try #require(source.data(plane: 1)).advanced(by: y * source.linesize(plane: 1))
+                row.withMemoryRebound(to: UInt16.self, capacity: 2 * chromaWidth) { p in
+                    for k in 0..<chromaWidth {
+                        p[2 * k] = UInt16(cb(k) << 6)
+                        p[2 * k + 1] = UInt16(cr(k) << 6)
+                    }
+                }
+            } else {
+                for (plane, value) in [(1, cb), (2, cr)] {
+                    let row = try #require(source.data(plane: plane)).advanced(by: y * source.linesize(plane: plane))
+                    row.withMemoryRebound(to: UInt16.self, capacity: chromaWidth) { p in
+                        for k in 0..<chromaWidth { p[k] = UInt16(value(k)) }
+                    }
+                }
+            }
+        }
+
+        for dstFormat in [PixelFormat.nv12, .yuv420p, .bgra] {
+            for ordered in [false, true] {
+                let scaler = try Scaler(srcWidth: width, srcHeight: height, srcFormat: srcFormat,
+                                        dstWidth: width, dstHeight: height, dstFormat: dstFormat)
+                #expect(scaler.usesFastPath)
+                scaler.dither = ordered ? .ordered : .none
+                let destination = try Frame(width: width, height: height, pixelFormat: dstFormat)
+                try scaler.scale(from: source, to: destination)
+
+                func pixel(_ plane: Int, _ x: Int, _ y: Int) -> UInt8 {
+                    destination.data(plane: plane)![y * destination.linesize(plane: plane) + x]
+                }
+                if dstFormat == .bgra {
+                    // Untagged is BT.709 limited range: Q13 coefficients, plus a
+                    // rounding bias (or the full 4x4 Bayer threshold) before >> 15
+                    let (cy, rv, bu, gu, gv) = (9567, 14729, 17356, 1752, 4378)
+                    for y in 0..<height {
+                        for x in 0..<width {
+                            let u = cb(x / 2) - 512, v = cr(x / 2) - 512
+                            let bias = ordered ? (2 * bayer[y & 3][x & 3] + 1) * 1024 : 1 << 12
+                            let base = cy * (luma(x) - 64) + bias
+                            #expect(pixel(0, 4 * x, y) == clamp((base + bu * u) >> 15))
+                            #expect(pixel(0, 4 * x + 1, y) == clamp((base - gu * u - gv * v) >> 15))
+                            #expect(pixel(0, 4 * x + 2, y) == clamp((base + rv * v) >> 15))
+                            #expect(pixel(0, 4 * x + 3, y) == 255)
+                        }
+                    }
+                    continue
+                }
+                for y in 0..<height {
+                    for x in 0..<width {
+                        #expect(pixel(0, x, y) == reduce(luma(x), x, y, ordered))
+                    }
+                }
+                for y in 0..<height / 2 {
+                    for k in 0..<chromaWidth {
+                        let u = dstFormat == .nv12 ? pixel(1, 2 * k, y) : pixel(1, k, y)
+                        let v = dstFormat == .nv12 ? pixel(1, 2 * k + 1, y) : pixel(2, k, y)
+                        #expect(u == reduce(cb(k), k, y, ordered))
+                        #expect(v == reduce(cr(k), k, y, ordered))
+                    }
+                }
+            }
+        }
+    }
+}
+
+@Test func testToneMapperSetup() throws {
+    let mapper = try ToneMapper(width: 64, height: 36, srcFormat: .p010le, dstFormat: .nv12,
+                                curve: .hable, threads: 2)
+    mapper.curve = .bt2390
+    mapper.dither = .ordered
+    mapper.peakNits = 4000
+
+    // Untagged frames are SDR and are refused rather than mangled
+    let source = try Frame(width: 64, height: 36, pixelFormat: .p010le)
+    let destination = try Frame(width: 64, height: 36, pixelFormat: .nv12)
+    #expect(!source.isHDR)
+    #expect(throws: FFmpegError.self) {
+        try mapper.process(from: source, to: destination)
+    }
+
+    #expect(throws: FFmpegError.self) {
+        _ = try ToneMapper(width: 64, height: 36, srcFormat: .yuv420p, dstFormat: .nv12)
+    }
+}
+
+@Test func testToneMapperMapsReferenceLevels() throws {
+    // Left half PQ black, right half HDR reference white (203 cd/m2, PQ
+    // 0.58 = 573 in limited 10-bit), neutral chroma; 70 wide for a SIMD tail
+    let width = 70, height = 4, split = 32
+    let source = try Frame(width: width, height: height, pixelFormat: .p010le)
+    source.avFrame.pointee.color_trc = AVCOL_TRC_SMPTE2084
+    source.avFrame.pointee.color_primaries = AVCOL_PRI_BT2020
+    source.avFrame.pointee.colorspace = AVCOL_SPC_BT2020_NCL
+    #expect(source.isHDR)
+    for y in 0..<height {
+        let row = try #require(source.data(plane: 0)).advanced(by: y * source.linesize(plane: 0))
+        row.withMemoryRebound(to: UInt16.self, capacity: width) { p in
+            for x in 0..<width { p[x] = UInt16((x < split ? 64 : 573) << 6) }
+        }
+    }
+    for y in 0..<height / 2 {
+        let row = try #require(source.data(plane: 1)).advanced(by: y * source.linesize(plane: 1))
+        row.withMemoryRebound(to: UInt16.self, capacity: width) { p in
+            for i in 0..<width { p[i] = UInt16(512 << 6) }
+        }
+    }
+
+    // BT.2390 at the default 1000 cd/m2 peak keeps reference white below
+    // SDR white and black at black
+    for (dstFormat, black, white) in [(PixelFormat.nv12, UInt8(16), UInt8(221)), (.bgra, 0, 240)] {
+        let mapper = try ToneMapper(width: width, height: height, srcFormat: .p010le, dstFormat: dstFormat,
+                                    curve: .bt2390, threads: 2)
+        mapper.dither = .none
+        let destination = try Frame(width: width, height: height, pixelFormat: dstFormat)
+        try mapper.process(from: source, to: destination)
+
+        let frame = destination.avFrame.pointee
+        #expect(frame.color_trc == AVCOL_TRC_BT709)
+        #expect(frame.color_primaries == AVCOL_PRI_BT709)
+        let luma = try #require(destination.data(plane: 0))
+        let stride = destination.linesize(plane: 0)
+        for y in 0..<height {
+            for x in 0..<width {
+                let expected = x < split ? black : white
+                if dstFormat == .bgra {
+                    for c in 0..<3 { #expect(luma[y * stride + 4 * x + c] == expected) }
+                    #expect(luma[y * stride + 4 * x + 3] == 255)
+                } else {
+                    #expect(luma[y * stride + x] == expected)
+                }
+            }
+        }
+        if dstFormat == .nv12 {
+            #expect(frame.colorspace == AVCOL_SPC_BT709 && frame.color_range == AVCOL_RANGE_MPEG)
+            let chroma = try #require(destination.data(plane: 1))
+            for y in 0..<height / 2 {
+                for i in 0..<width { #expect(chroma[y * destination.linesize(plane: 1) + i] == 128) }
+            }
+        }
+    }
+}
+
+@Test func testDeinterlacerFieldRate() throws {
+    // Top field lines ramp up, bottom field lines ramp down; 70 wide so rows
+    // run through the SIMD kernels and a scalar tail
+    let width = 70, height = 12
+    func top(_ x: Int) -> UInt8 { UInt8(30 + 2 * x) }
+    func bottom(_ x: Int) -> UInt8 { UInt8(220 - x) }
+    let source = try Frame(width: width, height: height, pixelFormat: .yuv420p)
+    for y in 0..<height {
+        let row = try #require(source.data(plane: 0)).advanced(by: y * source.linesize(plane: 0))
+        for x in 0..<width { row[x] = y & 1 == 0 ? top(x) : bottom(x) }
+    }
+    for plane in 1...2 {
+        for y in 0..<height / 2 {
+            try #require(source.data(plane: plane)).advanced(by: y * source.linesize(plane: plane))
+                .update(repeating: 128, count: width / 2)
+        }
+    }
+    source.avFrame.pointee.pts = 1000
+    source.avFrame.pointee.duration = 40
+
+    for mode in [Deinterlacer.Mode.bob, .yadif] {
+        let deinterlacer = try Deinterlacer(mode: mode, doubleRate: true, threads: 2)
+        deinterlacer.fieldMode = .interlacedTopFirst
+        let output = try Frame()
+
+        try deinterlacer.send(source)
+        if mode == .yadif {
+            // YADIF needs the next frame before it can rebuild the current one
+            #expect(throws: FFmpegError.self) {
+                try deinterlacer.receive(into: output)
+            }
+            try deinterlacer.send(nil)
+        }
+
+        // Top field first, then the bottom one half the frame duration later
+        for field in 0..<2 {
+            try deinterlacer.receive(into: output)
+            #expect(output.width == width && output.height == height)
+            #expect(output.avFrame.pointee.pts == Int64(1000 + 20 * field))
+            #expect(output.avFrame.pointee.duration == 20)
+
+            let luma = try #require(output.data(plane: 0))
+            for y in 0..<height {
+                // A static comb is only seen by YADIF's spatial check, which
+                // needs two lines either side; at the edges it weaves
+                let kept = y & 1 == field
+                let rebuilt = mode == .bob || (y >= 2 && y + 2 < height)
+                for x in 0..<width {
+                    let woven = y & 1 == 0 ? top(x) : bottom(x)
+                    let expected = kept || !rebuilt ? woven : (field == 0 ? top(x) : bottom(x))
+                    #expect(luma[y * output.linesize(plane: 0) + x] == expected)
+                }
+            }
+            for plane in 1...2 {
+                let chroma = try #require(output.data(plane: plane))
+                for y in 0..<height / 2 {
+                    for x in 0..<width / 2 { #expect(chroma[y * output.linesize(plane: plane) + x] == 128) }
+                }
+            }
+        }
+        #expect(throws: FFmpegError.self) {
+            try deinterlacer.receive(into: output)
+        }
+    }
+}
+
 @Test func testDemuxerInvalidPath() {
     #expect(throws: FFmpegError.self) {
         _ = try Demuxer(url: "/nonexistent/video.mp4")
     }
 }
+
+@Test func testStreamAnalyzerSyntheticPackets() throws {
+    let path = try makeY4M(frames: 1)     // One video stream, 1/25 time base
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let demuxer = try Demuxer(url: path)
+    let analyzer = try StreamAnalyzer(demuxer: demuxer)
+    let index = demuxer.videoStreamIndex
+
+    // Keyframes at 0, 3 and 8; packet 4 has no pts, packet 7 repeats the dts
+    for i in 0..<10 {
+        let packet = try Packet()
+        packet.avPacket.pointee.stream_index = Int32(index)
+        packet.avPacket.pointee.pts = i == 4 ? FFmpeg.noPTS : Int64(i)
+        packet.avPacket.pointee.dts = Int64(i == 7 ? 6 : i)
+        packet.avPacket.pointee.duration = 1
+        if [0, 3, 8].contains(i) { packet.avPacket.pointee.flags |= AV_PKT_FLAG_KEY }
+        try analyzer.add(packet)
+    }
+
+    let stats = try analyzer.stats(streamIndex: index)
+    #expect(stats.packets == 10)
+    #expect(stats.keyframes == 3 && stats.i_frames == 3 && stats.unknown_frames == 7)
+    #expect(analyzer.gopLengths(streamIndex: index) == [3, 5, 2])
+    #expect(stats.gop_count == 3 && stats.min_gop_length == 2 && stats.max_gop_length == 5)
+    #expect(abs(stats.min_keyframe_interval - 0.12) < 1e-9)
+    #expect(abs(stats.max_keyframe_interval - 0.2) < 1e-9)
+    #expect(stats.missing_pts == 1 && stats.missing_dts == 0)
+    #expect(stats.dts_not_increasing == 1)
+    #expect(stats.pts_before_dts == 0 && stats.timestamp_gaps == 0)
+}
+
+@Test func testDemuxerCacheInvalidPath() throws {
+    let cache = try DemuxerCache(maxOpen: 4)
+    #expect(throws: FFmpegError.self) {
+        _ = try Demuxer(url: "/nonexistent/video.mp4", cache: cache)
+    }
+    #expect(cache.openCount == 0)
+}
+
+@Test func testDemuxerCacheEvictsLeastRecentlyUsed() throws {
+    let paths = try (0..<3).map { _ in try makeY4M(frames: 2) }
+    defer { for path in paths { try? FileManager.default.removeItem(atPath: path) } }
+    let cache = try DemuxerCache(maxOpen: 2)
+    func use(_ i: Int) throws -> UInt8 {
+        let demuxer = try Demuxer(url: paths[i], cache: cache)
+        let packet = try demuxer.readPacket()
+        return try #require(packet.avPacket.pointee.data).pointee
+    }
+
+    _ = try use(0)
+    _ = try use(1)
+    #expect(cache.missCount == 2 && cache.openCount == 2)
+
+    // A parked demuxer comes back rewound to the first frame
+    #expect(try use(0) == 0)
+    #expect(cache.hitCount == 1)
+
+    // Parking a third file evicts the least recently released one
+    _ = try use(2)
+    #expect(cache.missCount == 3 && cache.openCount == 2)
+    _ = try use(0)
+    #expect(cache.hitCount == 2)
+    _ = try use(1)
+    #expect(cache.hitCount == 2 && cache.missCount == 4)
+    #expect(cache.openCount == 2)
+}
+
+@Test func testReadAheadInvalidPath() throws {
+    #expect(throws: FFmpegError.self) {
+        _ = try Demuxer(path: "/nonexistent/video.mp4", readAhead: .default)
+    }
+}
+
+@Test func testReadAheadIngestMatchesBufferedReads() throws {
+    let path = try makeY4M(frames: 5, width: 320, height: 240)
+    defer { try? FileManager.default.removeItem(atPath: path) }
+
+    func packets(_ demuxer: Demuxer) throws -> [[UInt8]] {
+        var result: [[UInt8]] = []
+        while true {
+            let packet: Packet
+            do { packet = try demuxer.readPacket() } catch FFmpegError.endOfFile { break }
+            let pkt = packet.avPacket.pointee
+            result.append(Array(UnsafeBufferPointer(start: pkt.data, count: Int(pkt.size))))
+        }
+        return result
+    }
+
+    // Direct reads where the filesystem allows them, buffered reads that
+    // drop consumed blocks where it does not: the bytes are the same either way
+    let expected = try packets(try Demuxer(url: path))
+    #expect(expected.count == 5)
+    for readAhead in [ReadAhead.ingest, ReadAhead(blockSize: 4096, synchronous: true, direct: true)] {
+        #expect(try packets(try Demuxer(path: path, readAhead: readAhead)) == expected)
+    }
+}
+
+/// Bytes that change within and across blocks, so data from the wrong
+/// offset shows up.
+private func asyncPattern(_ count: Int) -> [UInt8] {
+    (0..<count).map { UInt8(truncatingIfNeeded: $0 &* 7 &+ ($0 >> 13)) }
+}
+
+private func readChunk(_ avio: UnsafeMutablePointer<AVIOContext>, _ count: Int) -> [UInt8] {
+    var chunk = [UInt8](repeating: 0, count: count)
+    let n = chunk.withUnsafeMutableBufferPointer { avio_read(avio, $0.baseAddress, Int32(count)) }
+    return Array(chunk.prefix(max(Int(n), 0)))
+}
+
+@Test func testAsyncIOReadsAndSeeks() throws {
+    let path = NSTemporaryDirectory() + "async-read-\(UUID().uuidString).bin"
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let expected = asyncPattern(300_077)
+    #expect(FileManager.default.createFile(atPath: path, contents: Data(expected)))
+
+    for flags in [UInt32(0), UInt32(FF_ASYNC_IO_SYNC)] {
+        // Small blocks and a short window, so most seeks restart it
+        let reader = try #require(ff_async_io_open_read(path, 16 * 1024, 2, flags))
+        defer { ff_async_io_close(reader) }
+        let avio = try #require(ff_async_io_avio(reader))
+
+        var sequential: [UInt8] = []
+        while true {
+            let chunk = readChunk(avio, 1000)
+            if chunk.isEmpty { break }
+            sequential += chunk
+        }
+        #expect(sequential == expected)
+
+        // Back to the start, to the end, and around the middle both ways
+        for position in [0, 299_500, 1_000, 250_000, 150_000, 149_000, 150_500] {
+            #expect(avio_seek(avio, Int64(position), SEEK_SET) == Int64(position))
+            let length = min(1000, expected.count - position)
+            #expect(readChunk(avio, 1000) == Array(expected[position..<position + length]))
+        }
+    }
+}
+
+@Test func testAsyncIOWriteThenReadBack() throws {
+    let path = NSTemporaryDirectory() + "async-write-\(UUID().uuidString).bin"
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let expected = asyncPattern(300_077)
+
+    for flags in [UInt32(0), UInt32(FF_ASYNC_IO_SYNC)] {
+        let writer = try #require(ff_async_io_open_write(path, 64 * 1024, 4, flags))
+        let output = try #require(ff_async_io_avio(writer))
+        // Odd-sized writes straddle the block boundaries
+        var offset = 0
+        while offset < expected.count {
+            let count = min(10_007, expected.count - offset)
+            expected[offset..<offset + count].withUnsafeBufferPointer {
+                avio_write(output, $0.baseAddress, Int32(count))
+            }
+            offset += count
+        }
+        #expect(ff_async_io_close(writer) == 0)
+
+        let reader = try #require(ff_async_io_open_read(path, 64 * 1024, 4, flags))
+        defer { ff_async_io_close(reader) }
+        #expect(readChunk(try #require(ff_async_io_avio(reader)), expected.count + 1) == expected)
+    }
+}
+
+@Test func testProbeBatchInvalidPaths() {
+    let results = MediaProbe.probe(["/nonexistent/a.mp4", "/nonexistent/b.mov"])
+    #expect(results.count == 2)
+    for result in results {
+        #expect(throws: FFmpegError.self) { _ = try result.get() }
+    }
+    #expect(MediaProbe.probe([]).isEmpty)
+}
+
+@Test func testParallelDecoderSkipsFramelessPackets() throws {
+    let path = try makeY4M(frames: 40)
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let demuxer = try Demuxer(url: path)
+    let stream = demuxer.videoStreamIndex
+    #expect(ParallelDecoder.isIntraOnly(demuxer: demuxer, streamIndex: stream))
+    let decoder = try ParallelDecoder(demuxer: demuxer, streamIndex: stream, instanceCount: 3)
+    #expect(decoder.instanceCount == 3)
+
+    // Discarded packets decode to nothing, without an error; later frames
+    // must keep their own slots and the window must not stall on the gaps
+    let discarded: Set<Int> = [2, 9, 10, 23, 39]
+    let frame = try Frame()
+    var luma: [UInt8] = []
+    func receiveReady() throws {
+        while true {
+            do { try decoder.receive(into: frame) } catch FFmpegError.needsMoreInput { return }
+            luma.append(try #require(frame.data(plane: 0)).pointee)
+        }
+    }
+
+    var index = 0
+    while true {
+        let packet: Packet
+        do { packet = try demuxer.readPacket() } catch FFmpegError.endOfFile { break }
+        guard packet.streamIndex == stream else { continue }
+        if discarded.contains(index) { packet.avPacket.pointee.flags |= AV_PKT_FLAG_DISCARD }
+        index += 1
+        while true {
+            do { try decoder.send(packet); break } catch FFmpegError.needsMoreInput { try receiveReady() }
+        }
+        try receiveReady()
+    }
+    try decoder.send(nil)
+    while true {
+        do { try decoder.receive(into: frame) } catch FFmpegError.endOfFile { break }
+        luma.append(try #require(frame.data(plane: 0)).pointee)
+    }
+
+    #expect(index == 40)
+    #expect(luma == (0..<40).filter { !discarded.contains($0) }.map { UInt8($0 * 6) })
+    #expect(decoder.errorCount == UInt64(discarded.count))
+}
+
+@Test func testInlineCmdFifoWraps() throws {
+    let pool = CmdPool(initialSize: 4)
+    let fifo = CmdFifo(capacity: 2, mode: .lockless)
+    fifo.flowEnabled = true
+
+    for round in 0..<5 {
+        for i in 0..<2 {
+            #expect(fifo.tryWaitForWriteSpace())
+            let cmd = try #require(pool.acquire())
+            cmd.initSeek(position: Double(round * 2 + i))
+            try fifo.write(cmd)
+        }
+        #expect(!fifo.tryWaitForWriteSpace())
+        for _ in 0..<2 {
+            #expect(fifo.tryWaitForReadData())
+            let cmd = try #require(try fifo.read())
+            #expect(cmd.type == .seek)
+            cmd.release()
+        }
+    }
+}
+
+@Test func testCmdFifoSkipToKeyframe() throws {
+    let pool = CmdPool(initialSize: 8)
+    let fifo = CmdFifo(capacity: 16, mode: .blocking)
+    fifo.flowEnabled = true
+
+    for (pts, key) in [(0, false), (1, false), (2, true), (3, false)] {
+        let cmd = try #require(pool.acquire())
+        cmd.initFrame(nil)
+        cmd.pts = Int64(pts)
+        if key { cmd.flags = UInt32(FF_CMD_FLAG_KEYFRAME) }
+        #expect(fifo.tryWaitForWriteSpace())
+        try fifo.write(cmd)
+    }
+
+    #expect(fifo.skipToKeyframe() == 2)
+    #expect(fifo.count == 2)
+    #expect(fifo.tryWaitForReadData())
+    let cmd = try #require(try fifo.read())
+    #expect(cmd.isKeyframe && cmd.pts == 2)
+    cmd.release()
+}
+
+@Test func testCmdFifoSkipIgnoresOtherStreamKeyframes() throws {
+    let pool = CmdPool(initialSize: 8)
+    let fifo = CmdFifo(capacity: 16, mode: .blocking)
+    fifo.flowEnabled = true
+
+    // Video on stream 0, audio (every packet key) on stream 1
+    for (pts, stream, key) in [(0, 0, false), (1, 1, true), (2, 0, false), (3, 1, true), (4, 0, true), (5, 0, false)] {
+        let cmd = try #require(pool.acquire())
+        cmd.initFrame(nil)
+        cmd.pts = Int64(pts)
+        cmd.streamIndex = UInt32(stream)
+        if key { cmd.flags = UInt32(FF_CMD_FLAG_KEYFRAME) }
+        #expect(fifo.tryWaitForWriteSpace())
+        try fifo.write(cmd)
+    }
+
+    #expect(fifo.skipToKeyframe() == 4)
+    #expect(fifo.tryWaitForReadData())
+    let cmd = try #require(try fifo.read())
+    #expect(cmd.isKeyframe && cmd.pts == 4 && cmd.streamIndex == 0)
+    cmd.release()
+    while fifo.tryWaitForReadData() {
+        try #require(try fifo.read()).release()
+    }
+}
+
+@Test func testCmdFifoResize() throws {
+    let pool = CmdPool(initialSize: 8)
+    let fifo = CmdFifo(capacity: 2, maxCapacity: 16, mode: .blocking)
+    fifo.flowEnabled = true
+
+    try fifo.resize(to: 4)
+    #expect(fifo.capacity == 4)
+    var written = 0
+    while fifo.tryWaitForWriteSpace() {
+        let cmd = try #require(pool.acquire())
+        cmd.initEOS()
+        try fifo.write(cmd)
+        written += 1
+    }
+    #expect(written == 4)
+    #expect(throws: CmdFifoError.self) { try fifo.resize(to: 32) }
+
+    // Shrinking keeps queued commands
+    try fifo.resize(to: 1)
+    #expect(fifo.count == 4)
+    while fifo.tryWaitForReadData() {
+        try #require(try fifo.read()).release()
+    }
+    #expect(fifo.tryWaitForWriteSpace())
+    #expect(!fifo.tryWaitForWriteSpace())
+}
+
+@Test func testFifoControllerTracksManualResizes() throws {
+    let fifo = CmdFifo(capacity: 3, maxCapacity: 8, mode: .blocking)
+    let controller = try FifoController(fifo: fifo, minCapacity: 1, maxCapacity: 8)
+    controller.setWindow(2)
+
+    // Any number of events between updates is one step up
+    controller.underrun()
+    controller.overflow()
+    #expect(controller.update() == 4 && fifo.capacity == 4)
+
+    // A manual depth is clamped and waits for the next update
+    controller.setCapacity(20)
+    #expect(controller.capacity == 4)
+    #expect(controller.update() == 8 && fifo.capacity == 8)
+
+    // Quiet reads shrink from the manual depth, not from a stale one
+    controller.update()
+    #expect(controller.update() == 7 && fifo.capacity == 7)
+
+    // Events from before a manual resize do not count against it
+    controller.setCapacity(2)
+    controller.underrun()
+    #expect(controller.update() == 2)
+    controller.update()
+    #expect(controller.update() == 1 && fifo.capacity == 1)
+}
+
+@Test func testCmdPayloadReleasedWithFifo() throws {
+    final class Buffer {}
+    weak var weakBuffer: Buffer?
+    let pool = CmdPool(initialSize: 4)
+    do {
+        let fifo = CmdFifo(capacity: 2, mode: .blocking)
+        fifo.flowEnabled = true
+        let buffer = Buffer()
+        weakBuffer = buffer
+        let cmd = try #require(pool.acquire())
+        cmd.initFrame(nil)
+        cmd.setPayload(buffer, sizeHint: 64)
+        #expect(cmd.payloadObject === buffer)
+        #expect(cmd.dataSize == 64)
+        try fifo.waitForWriteSpace()
+        try fifo.write(cmd)
+    }
+    // Destroying the FIFO released the queued command and its payload
+    #expect(weakBuffer == nil)
+}
+
+@Test func testCmdFifoClose() throws {
+    let pool = CmdPool(initialSize: 4)
+    let fifo = CmdFifo(capacity: 2, mode: .blocking)
+    fifo.flowEnabled = true
+    for _ in 0..<2 {
+        let cmd = try #require(pool.acquire())
+        cmd.initEOS()
+        try fifo.waitForWriteSpace()
+        try fifo.write(cmd)
+    }
+
+    #expect(fifo.close() == 2)
+    #expect(pool.inUseCount == 0)
+    #expect(fifo.isClosed)
+
+    // Waits return at once instead of blocking on the full or empty FIFO
+    #expect(throws: CmdFifoError.self) { try fifo.waitForReadData() }
+    #expect(throws: CmdFifoError.self) { try fifo.waitForWriteSpace() }
+    fifo.flowEnabled = true
+    #expect(!fifo.flowEnabled)
+}
+
+@Test func testCmdFifoMonotonicTimedWaits() throws {
+    let fifo = CmdFifo(capacity: 2, mode: .blocking)
+    fifo.flowEnabled = true
+
+    let start = CmdFifo.clockMicros
+    #expect(throws: CmdFifoError.self) { try fifo.waitForReadData(timeout: .microseconds(4200)) }
+    #expect(CmdFifo.clockMicros - start >= 4200)
+
+    // A deadline that has already passed only tries
+    #expect(throws: CmdFifoError.self) { try fifo.waitForReadData(until: CmdFifo.clockMicros - 1) }
+
+    // Fixed-period deadlines do not accumulate wake-up latency
+    var deadline = CmdFifo.clockMicros
+    for _ in 0..<5 {
+        deadline += 4167
+        #expect(throws: CmdFifoError.self) { try fifo.waitForReadData(until: deadline) }
+    }
+    #expect(CmdFifo.clockMicros >= deadline)
+}
+
+@Test func testCmdFifoPushDelivery() throws {
+    final class Tap { var pts: [Int64] = [] }
+    let tap = Tap()
+    let pool = CmdPool(initialSize: 4)
+    let fifo = CmdFifo(capacity: 2, mode: .lockless)
+    try fifo.setConsumer { cmd in
+        tap.pts.append(cmd.pts)
+        cmd.release()
+    }
+    fifo.flowEnabled = true
+
+    // More writes than capacity: each is delivered before the write returns
+    for i in 0..<6 {
+        let cmd = try #require(pool.acquire())
+        cmd.initEOS()
+        cmd.pts = Int64(i)
+        try fifo.waitForWriteSpace()
+        try fifo.write(cmd)
+    }
+    #expect(tap.pts == [0, 1, 2, 3, 4, 5])
+    #expect(fifo.count == 0)
+    #expect(pool.inUseCount == 0)
+
+    // A writer could still be inside the consumer while flow is enabled
+    #expect(throws: CmdFifoError.self) { try fifo.clearConsumer() }
+    fifo.flowEnabled = false
+    try fifo.clearConsumer()
+    fifo.flowEnabled = true
+    let cmd = try #require(pool.acquire())
+    cmd.initEOS()
+    try fifo.waitForWriteSpace()
+    try fifo.write(cmd)
+    #expect(fifo.count == 1)
+}
+
+@Test func testDecodeServiceThreads() throws {
+    let service = try DecodeService(threadCount: 2)
+    #expect(service.threadCount == 2)
+    #expect(service.streamCount == 0)
+}
+
+@Test func testDecodeStreamRemoval() throws {
+    let path = try makeY4M(frames: 2)
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let demuxer = try Demuxer(url: path)
+    let service = try DecodeService(threadCount: 1)
+    let output = CmdFifo(capacity: 4, mode: .blocking)
+
+    let stream = try service.addStream(demuxer: demuxer, streamIndex: demuxer.videoStreamIndex, output: output)
+    #expect(service.streamCount == 1)
+    #expect(stream.input != nil)
+
+    // Removal is idempotent and retires the input FIFO
+    service.remove(stream)
+    stream.remove()
+    #expect(stream.isRemoved)
+    #expect(stream.input == nil)
+    #expect(stream.packetCount == 0)
+    #expect(service.streamCount == 0)
+
+    // Releasing a stream removes it too
+    var dropped: DecodeStream? = try service.addStream(demuxer: demuxer, streamIndex: demuxer.videoStreamIndex,
+                                                       output: output)
+    #expect(service.streamCount == 1 && dropped != nil)
+    dropped = nil
+    #expect(service.streamCount == 0)
+}
+
+@Test func testDecodeStreamReportsFailedReconfigure() throws {
+    let path = try makeY4M(frames: 1)
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let demuxer = try Demuxer(url: path)
+    let service = try DecodeService(threadCount: 1)
+    let output = CmdFifo(capacity: 4, mode: .blocking)
+    output.flowEnabled = true
+    let stream = try service.addStream(demuxer: demuxer, streamIndex: demuxer.videoStreamIndex, output: output)
+    let input = try #require(stream.input)
+    let pool = CmdPool(initialSize: 2)
+
+    // Parameters the decoder can switch to go out as CONFIG; ones it cannot
+    // open (no codec) come back as an error and the decoder keeps going
+    for openable in [true, false] {
+        let cmd = try #require(pool.acquire())
+        try cmd.initConfig(demuxer: demuxer, streamIndex: demuxer.videoStreamIndex)
+        if !openable {
+            let params = try #require(cmd.data).assumingMemoryBound(to: AVCodecParameters.self)
+            params.pointee.codec_id = AV_CODEC_ID_NONE
+        }
+        try input.write(cmd)
+
+        try output.waitForReadData(timeout: 2000)
+        let result = try #require(try output.read())
+        if openable {
+            #expect(result.type == .config)
+        } else {
+            #expect(result.type == .error && result.errorCode < 0)
+            #expect(result.data == nil)
+        }
+        result.release()
+    }
+    stream.remove()
+}
+
+@Test func testFrameRateConverterForwardsEOS() throws {
+    let pool = CmdPool(initialSize: 4)
+    let output = CmdFifo(capacity: 4, mode: .blocking)
+    output.flowEnabled = true
+    let converter = try FrameRateConverter(inputTimeBase: (1, 1000), outputRate: (30, 1), cmdPool: pool)
+    #expect(converter.outputTimeBase.num == 1 && converter.outputTimeBase.den == 30)
+
+    let eos = try #require(pool.acquire())
+    eos.initEOS()
+    try converter.push(eos, to: output)
+
+    #expect(output.tryWaitForReadData())
+    let cmd = try #require(try output.read())
+    #expect(cmd.type == .eos)
+    cmd.release()
+    #expect(converter.outputCount == 0)
+}
+
+@Test func testFrameRateConverterMapsJitteredFrames() throws {
+    let path = try makeY4M(frames: 1)
+    defer { try? FileManager.default.removeItem(atPath: path) }
+    let demuxer = try Demuxer(url: path)
+    let pool = CmdPool(initialSize: 16)
+    let output = CmdFifo(capacity: 16, mode: .blocking)
+    output.flowEnabled = true
+    let converter = try FrameRateConverter(inputTimeBase: (1, 1000), outputRate: (30, 1), cmdPool: pool)
+    let source = try Frame(width: 16, height: 16, pixelFormat: .yuv420p)
+
+    // Milliseconds -> 30 fps slots 0, 1, 2, 2, 4, 5: the 70 ms frame is
+    // dropped and the 75 ms one repeated over slot 3. SEEK and CONFIG wait
+    // behind the held frame, so neither overtakes it
+    for pts in [0, 30, 70, 75, -1, 140, -2, 170] {
+        let cmd = try #require(pool.acquire())
+        if pts == -1 {
+            cmd.initSeek(position: 0)
+        } else if pts == -2 {
+            try cmd.initConfig(demuxer: demuxer, streamIndex: demuxer.videoStreamIndex)
+        } else {
+            cmd.initFrame(source.avFrame)
+            cmd.pts = Int64(pts)
+        }
+        try converter.push(cmd, to: output)
+    }
+    let eos = try #require(pool.acquire())
+    eos.initEOS()
+    try converter.push(eos, to: output)
+
+    var emitted: [String] = []
+    while output.count > 0 {
+        let cmd = try #require(try output.read())
+        emitted.append(cmd.type == .frame ? "\(cmd.pts)" : "\(cmd.type)")
+        cmd.release()
+    }
+    #expect(emitted == ["0", "1", "2", "3", "seek", "4", "config", "5", "eos"])
+    #expect(converter.droppedCount == 1 && converter.repeatedCount == 1)
+}
+
+@Test func testParameterSetMirrorsIntoStore() throws {
+    let store = try ParameterStore()
+    let params = ParameterSet()
+    params.add(.int("width", display: "Width", default: 640, range: 16...4096))
+    params.bind(to: store)
+    params.add(.bool("enabled", display: "Enabled", default: true))
+
+    let reader = try store.makeReader()
+    let width = try #require(params.nativeIndex(for: "width"))
+    let enabled = try #require(params.nativeIndex(for: "enabled"))
+    let before = reader.read()
+    #expect(before.int(width) == 640 && before.int(enabled) == 1)
+    // A snapshot is only valid until the reader's next read
+    let versionBefore = before.version
+
+    try params.set("width", value: 1280)
+    let after = reader.read()
+    #expect(!before.isValid && after.isValid)
+    #expect(after.int(width) == 1280)
+    #expect(after.version > versionBefore)
+}
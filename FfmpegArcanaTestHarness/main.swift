@@ -169,9 +169,8 @@ func testFifoPipeline(path: String, maxFrames: Int) {
                     }
                     
                     // Initialize as frame command
-                    // Note: We need to clone the frame since decoded.frame will be reused
-                    let frameClone = av_frame_clone(decoded.frame.avFrame)
-                    cmd.initFrame(frameClone)
+                    // The command takes its own reference, so decoded.frame can be reused
+                    cmd.initFrame(decoded.frame.avFrame)
                     cmd.pts = Int64(count)
                     cmd.streamIndex = 0
                     